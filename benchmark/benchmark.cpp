@@ -15,6 +15,8 @@ std::map<std::string, std::function<void()>> features {
    { "key", key_benchmarking },
    { "hash", hash_benchmarking },
    { "blake2", blake2_benchmarking },
+   { "multi_sha256", multi_sha256_benchmarking },
+   { "merkle", merkle_benchmarking },
 };
 
 // values to control cout format
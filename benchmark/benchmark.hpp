@@ -19,6 +19,8 @@ void modexp_benchmarking();
 void key_benchmarking();
 void hash_benchmarking();
 void blake2_benchmarking();
+void multi_sha256_benchmarking();
+void merkle_benchmarking();
 
 void benchmarking(std::string name, const std::function<void()>& func);
 
@@ -0,0 +1,39 @@
+#include <eosio/chain/merkle.hpp>
+#include <eosio/chain/thread_utils.hpp>
+
+#include <fc/crypto/sha256.hpp>
+
+#include <benchmark.hpp>
+
+using namespace eosio::chain;
+
+namespace benchmark {
+
+void merkle_benchmarking() {
+   named_thread_pool two_threads( "merkle", 2 );
+   named_thread_pool four_threads( "merkle", 4 );
+
+   for( size_t num_ids : { 1000, 10000, 100000 } ) {
+      deque<digest_type> ids;
+      for( size_t i = 0; i < num_ids; ++i )
+         ids.push_back( fc::sha256::hash( std::to_string( i ) ) );
+      const std::string suffix = " (" + std::to_string( num_ids ) + " ids)";
+
+      auto calling_thread = [&]() {
+         merkle( ids );
+      };
+      benchmarking( "merkle" + suffix, calling_thread );
+
+      auto pool_of_two = [&]() {
+         merkle( ids, two_threads.get_executor() );
+      };
+      benchmarking( "merkle 2 thr" + suffix, pool_of_two );
+
+      auto pool_of_four = [&]() {
+         merkle( ids, four_threads.get_executor() );
+      };
+      benchmarking( "merkle 4 thr" + suffix, pool_of_four );
+   }
+}
+
+} // benchmark
@@ -0,0 +1,39 @@
+#include <eosio/chain/multi_sha256.hpp>
+
+#include <fc/crypto/sha256.hpp>
+
+#include <benchmark.hpp>
+
+using namespace eosio::chain;
+
+namespace benchmark {
+
+void multi_sha256_benchmarking() {
+   // the 64 byte canonical pairs merkle() hashes, and transaction receipt sized messages
+   for( size_t message_size : { 64, 45 } ) {
+      constexpr size_t num_messages = 1024;
+      std::vector<std::string> inputs;
+      for( size_t i = 0; i < num_messages; ++i )
+         inputs.emplace_back( message_size, char( i ) );
+      std::vector<std::string_view> messages( inputs.begin(), inputs.end() );
+      std::vector<digest_type> digests( num_messages );
+      const std::string suffix = " (" + std::to_string( num_messages ) + " x " + std::to_string( message_size ) + " bytes)";
+
+      auto one_at_a_time = [&]() {
+         for( size_t i = 0; i < num_messages; ++i )
+            digests[i] = fc::sha256::hash( inputs[i] );
+      };
+      benchmarking( "sha256" + suffix, one_at_a_time );
+
+      for( auto kernel : { sha256_kernel::sha_ni, sha256_kernel::avx512, sha256_kernel::avx2, sha256_kernel::sse2, sha256_kernel::scalar } ) {
+         if( !is_supported( kernel ) )
+            continue;
+         auto many_at_once = [&]() {
+            multi_sha256( messages.data(), messages.size(), digests.data(), kernel );
+         };
+         benchmarking( std::string( to_string( kernel ) ) + suffix, many_at_once );
+      }
+   }
+}
+
+} // benchmark
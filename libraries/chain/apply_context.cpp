@@ -35,6 +35,7 @@ apply_context::apply_context(controller& con, transaction_context& trx_ctx, uint
 :control(con)
 ,db(con.mutable_db())
 ,trx_context(trx_ctx)
+,access_tracer(trx_ctx.access_tracer)
 ,recurse_depth(depth)
 ,first_receiver_action_ordinal(action_ordinal)
 ,action_ordinal(action_ordinal)
@@ -59,6 +60,15 @@ void apply_context::exec_one()
    const auto& cfg = control.get_global_properties().configuration;
    const account_metadata_object* receiver_account = nullptr;
 
+   if( intrinsic_usage_tracker::instance().enabled() ) {
+      if( intrinsic_usage )
+         intrinsic_usage->reset();
+      else
+         intrinsic_usage = std::make_unique<intrinsic_usage_counters>();
+   } else {
+      intrinsic_usage.reset();
+   }
+
    auto handle_exception = [&](const auto& e)
    {
       action_trace& trace = trx_context.get_action_trace( action_ordinal );
@@ -75,6 +85,8 @@ void apply_context::exec_one()
          if( !(context_free && control.skip_trx_checks()) ) {
             privileged = receiver_account->is_privileged();
             auto native = control.find_apply_handler( receiver, act->account, act->name );
+            // native handlers and privileged contracts modify state outside of the database intrinsics
+            if( native || privileged ) check_writable();
             if( native ) {
                if( trx_context.enforce_whiteblacklist && control.is_producing_block() ) {
                   control.check_contract_list( receiver );
@@ -198,6 +210,11 @@ void apply_context::finalize_trace( action_trace& trace, const fc::time_point& s
    _pending_console_output.clear();
 
    trace.elapsed = fc::time_point::now() - start;
+
+   if( intrinsic_usage ) {
+      trace.intrinsic_usage = intrinsic_usage->usage();
+      intrinsic_usage_tracker::instance().record( receiver, trace.intrinsic_usage );
+   }
 }
 
 void apply_context::exec()
@@ -427,6 +444,7 @@ void apply_context::execute_context_free_inline( action&& a ) {
 
 
 void apply_context::schedule_deferred_transaction( const uint128_t& sender_id, account_name payer, transaction&& trx, bool replace_existing ) {
+   check_writable();
    EOS_ASSERT( trx.context_free_actions.size() == 0, cfa_inside_generated_tx, "context free actions are not currently allowed in generated transactions" );
 
    bool enforce_actor_whitelist_blacklist = trx_context.enforce_whiteblacklist && control.is_producing_block()
@@ -627,6 +645,7 @@ void apply_context::schedule_deferred_transaction( const uint128_t& sender_id, a
 }
 
 bool apply_context::cancel_deferred_transaction( const uint128_t& sender_id, account_name sender ) {
+   check_writable();
    auto& generated_transaction_idx = db.get_mutable_index<generated_transaction_multi_index>();
    const auto* gto = db.find<generated_transaction_object,by_sender_id>(boost::make_tuple(sender, sender_id));
    if ( gto ) {
@@ -662,10 +681,14 @@ uint32_t apply_context::schedule_action( action&& act_to_schedule, account_name
 }
 
 const table_id_object* apply_context::find_table( name code, name scope, name table ) {
+   if( access_tracer )
+      access_tracer->on_table_read( code, scope, table );
    return db.find<table_id_object, by_code_scope_table>(boost::make_tuple(code, scope, table));
 }
 
 const table_id_object& apply_context::find_or_create_table( name code, name scope, name table, const account_name &payer ) {
+   if( access_tracer )
+      access_tracer->on_table_write( code, scope, table );
    const auto* existing_tid =  db.find<table_id_object, by_code_scope_table>(boost::make_tuple(code, scope, table));
    if (existing_tid != nullptr) {
       return *existing_tid;
@@ -736,6 +759,11 @@ void apply_context::update_db_usage( const account_name& payer, int64_t delta )
    add_ram_usage(payer, delta);
 }
 
+void apply_context::check_writable()const {
+   EOS_ASSERT( !trx_context.is_read_only_thread, read_only_thread_write_exception,
+               "contract ${r} attempted to modify state while executing on a read-only thread", ("r", receiver) );
+}
+
 
 int apply_context::get_action( uint32_t type, uint32_t index, char* buffer, size_t buffer_size )const
 {
@@ -783,6 +811,7 @@ int apply_context::db_store_i64( name scope, name table, const account_name& pay
 }
 
 int apply_context::db_store_i64( name code, name scope, name table, const account_name& payer, uint64_t id, const char* buffer, size_t buffer_size ) {
+   check_writable();
 //   require_write_lock( scope );
    const auto& tab = find_or_create_table( code, scope, table, payer );
    auto tableid = tab.id;
@@ -823,10 +852,13 @@ int apply_context::db_store_i64( name code, name scope, name table, const accoun
 }
 
 void apply_context::db_update_i64( int iterator, account_name payer, const char* buffer, size_t buffer_size ) {
+   check_writable();
    const key_value_object& obj = keyval_cache.get( iterator );
 
    const auto& table_obj = keyval_cache.get_table( obj.t_id );
    EOS_ASSERT( table_obj.code == receiver, table_access_violation, "db access violation" );
+   if( access_tracer )
+      access_tracer->on_table_write( table_obj.code, table_obj.scope, table_obj.table );
 
 //   require_write_lock( table_obj.scope );
 
@@ -879,10 +911,13 @@ void apply_context::db_update_i64( int iterator, account_name payer, const char*
 }
 
 void apply_context::db_remove_i64( int iterator ) {
+   check_writable();
    const key_value_object& obj = keyval_cache.get( iterator );
 
    const auto& table_obj = keyval_cache.get_table( obj.t_id );
    EOS_ASSERT( table_obj.code == receiver, table_access_violation, "db access violation" );
+   if( access_tracer )
+      access_tracer->on_table_write( table_obj.code, table_obj.scope, table_obj.table );
 
 //   require_write_lock( table_obj.scope );
 
@@ -1030,6 +1065,8 @@ int apply_context::db_end_i64( name code, name scope, name table ) {
 
 uint64_t apply_context::next_global_sequence() {
    const auto& p = control.get_dynamic_global_properties();
+   if( trx_context.is_read_only_thread ) // sequence numbers are not consumed by read-only transactions on read-only threads
+      return p.global_action_sequence + 1;
    db.modify( p, [&]( auto& dgp ) {
       ++dgp.global_action_sequence;
    });
@@ -1037,6 +1074,8 @@ uint64_t apply_context::next_global_sequence() {
 }
 
 uint64_t apply_context::next_recv_sequence( const account_metadata_object& receiver_account ) {
+   if( trx_context.is_read_only_thread )
+      return receiver_account.recv_sequence + 1;
    db.modify( receiver_account, [&]( auto& ra ) {
       ++ra.recv_sequence;
    });
@@ -1044,6 +1083,8 @@ uint64_t apply_context::next_recv_sequence( const account_metadata_object& recei
 }
 uint64_t apply_context::next_auth_sequence( account_name actor ) {
    const auto& amo = db.get<account_metadata_object,by_name>( actor );
+   if( trx_context.is_read_only_thread )
+      return amo.auth_sequence + 1;
    db.modify( amo, [&](auto& am ){
       ++am.auth_sequence;
    });
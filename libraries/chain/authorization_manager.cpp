@@ -11,6 +11,7 @@
 #include <eosio/chain/database_utils.hpp>
 #include <eosio/chain/protocol_state_object.hpp>
 #include <eosio/chain/deep_mind.hpp>
+#include <eosio/chain/phase_timing.hpp>
 
 
 namespace eosio { namespace chain {
@@ -146,6 +147,7 @@ namespace eosio { namespace chain {
          creation_time = _control.pending_block_time();
       }
 
+      increment_revision();
       const auto& perm_usage = _db.create<permission_usage_object>([&](auto& p) {
          p.last_used = creation_time;
       });
@@ -181,6 +183,7 @@ namespace eosio { namespace chain {
          creation_time = _control.pending_block_time();
       }
 
+      increment_revision();
       const auto& perm_usage = _db.create<permission_usage_object>([&](auto& p) {
          p.last_used = creation_time;
       });
@@ -205,6 +208,7 @@ namespace eosio { namespace chain {
          EOS_ASSERT(k.key.which() < _db.get<protocol_state_object>().num_supported_key_types, unactivated_key_type,
            "Unactivated key type used when modifying permission");
 
+      increment_revision();
       _db.modify( permission, [&](permission_object& po) {
          auto dm_logger = _control.get_deep_mind_logger();
 
@@ -228,6 +232,7 @@ namespace eosio { namespace chain {
       EOS_ASSERT( range.first == range.second, action_validate_exception,
                   "Cannot remove a permission which has children. Remove the children first.");
 
+      increment_revision();
       _db.get_mutable_index<permission_usage_index>().remove_object( permission.usage_id._id );
 
       if (auto dm_logger = _control.get_deep_mind_logger()) {
@@ -471,6 +476,7 @@ namespace eosio { namespace chain {
                                                const flat_set<permission_level>&    satisfied_authorizations
                                              )const
    {
+      scoped_phase_timer timer( timing_phase::authorization );
       const auto& checktime = ( static_cast<bool>(_checktime) ? _checktime : _noop_checktime );
 
       auto delay_max_limit = fc::seconds( _control.get_global_properties().configuration.max_transaction_delay );
@@ -574,6 +580,7 @@ namespace eosio { namespace chain {
                                                bool                                 allow_unused_keys
                                              )const
    {
+      scoped_phase_timer timer( timing_phase::authorization );
       const auto& checktime = ( static_cast<bool>(_checktime) ? _checktime : _noop_checktime );
 
       auto delay_max_limit = fc::seconds( _control.get_global_properties().configuration.max_transaction_delay );
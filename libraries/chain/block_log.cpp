@@ -1,9 +1,22 @@
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/bitutil.hpp>
 #include <fc/io/cfile.hpp>
 #include <fc/io/raw.hpp>
+#include <fc/log/logger_config.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <thread>
+
+#include <zlib.h>
 
 #define LOG_READ  (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
@@ -30,12 +43,300 @@ namespace eosio { namespace chain {
     *            this is in the form of an first_block_num that is written immediately after the version
     * Version 3: improvement on version 2 to not require the genesis state be provided when not starting
     *            from block 1
+    * Version 4: version 3 with a block_log_compression following the genesis state or chain id, every block
+    *            is stored as a compressed entry; only written for compressed logs
     */
-   const uint32_t block_log::max_supported_version = 3;
+   const uint32_t block_log::max_supported_version = 4;
 
    namespace detail {
       using unique_file = std::unique_ptr<FILE, decltype(&fclose)>;
 
+      constexpr uint32_t uncompressed_version = 3;
+      constexpr uint32_t compressed_version   = 4;
+
+      static bool is_compressed(const block_log_compression& compression) {
+         return compression.algorithm != block_log_compression::algorithm_type::none;
+      }
+
+      static uint32_t version_for(const block_log_compression& compression) {
+         return is_compressed(compression) ? compressed_version : uncompressed_version;
+      }
+
+      /*
+       *  @brief compresses blocks into the entries of a compressed block log and back
+       *
+       *  Each entry is deflated on its own, with the preset dictionary of the log, so any entry can be read without
+       *  the others. The z_streams are kept between entries, only reset, to avoid reallocating their state.
+       */
+      class block_codec {
+      public:
+         static constexpr size_t prefix_size = 46;   //timestamp, producer, confirmed and previous, see trim_data::blknum_offset
+         static constexpr size_t header_size = prefix_size + 2*sizeof(uint32_t);
+
+         explicit block_codec(block_log_compression compression) : _compression(std::move(compression)) {
+            EOS_ASSERT(_compression.algorithm <= block_log_compression::algorithm_type::zlib, block_log_exception,
+                       "Unsupported block log compression algorithm");
+            EOS_ASSERT(_compression.dictionary.size() <= std::numeric_limits<uInt>::max(), block_log_exception,
+                       "Block log compression dictionary is too large");
+         }
+         block_codec(const block_codec&) = delete;
+         block_codec& operator=(const block_codec&) = delete;
+
+         ~block_codec() {
+            if(_deflate)
+               deflateEnd(&*_deflate);
+            if(_inflate)
+               inflateEnd(&*_inflate);
+         }
+
+         const block_log_compression& compression() const { return _compression; }
+         bool enabled() const { return is_compressed(_compression); }
+
+         std::vector<char> compress(const char* packed_block, size_t size);
+         std::vector<char> decompress(const char* entry, size_t size);
+
+         /// reads the entry of a block from s, left at the end of the entry. The entry must fit in the max_size bytes
+         /// left in s, a size read from a damaged entry is not trusted to allocate its buffer
+         template <typename Stream>
+         std::vector<char> read_entry(Stream& s, uint64_t max_size = std::numeric_limits<uint64_t>::max()) {
+            EOS_ASSERT(max_size >= header_size, block_log_exception, "Compressed block in block log is incomplete");
+            std::vector<char> entry(header_size);
+            s.read(entry.data(), header_size);
+            uint32_t compressed_size;
+            memcpy(&compressed_size, entry.data() + prefix_size + sizeof(uint32_t), sizeof(compressed_size));
+            EOS_ASSERT(compressed_size <= max_size - header_size, block_log_exception,
+                       "Compressed block of ${s} bytes exceeds the ${m} bytes left in block log", ("s", compressed_size)("m", max_size));
+            entry.resize(header_size + compressed_size);
+            s.read(entry.data() + header_size, compressed_size);
+            return entry;
+         }
+
+      private:
+         const Bytef* dictionary() const { return reinterpret_cast<const Bytef*>(_compression.dictionary.data()); }
+
+         block_log_compression   _compression;
+         std::optional<z_stream> _deflate; //z_streams point to themselves, so are never moved once initialized
+         std::optional<z_stream> _inflate;
+      };
+
+      std::vector<char> block_codec::compress(const char* packed_block, size_t size) {
+         EOS_ASSERT(size > prefix_size && size <= std::numeric_limits<uint32_t>::max(), block_log_exception,
+                    "Cannot compress a block of ${s} bytes", ("s", size));
+         if(!_deflate) {
+            _deflate.emplace();
+            EOS_ASSERT(deflateInit2(&*_deflate, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK,
+                       block_log_exception, "Could not initialize block log compression");
+         } else {
+            deflateReset(&*_deflate);
+         }
+         z_stream& zs = *_deflate;
+         if(!_compression.dictionary.empty())
+            deflateSetDictionary(&zs, dictionary(), _compression.dictionary.size());
+
+         const uint32_t packed_size = size;
+         std::vector<char> entry(header_size + deflateBound(&zs, size - prefix_size));
+         memcpy(entry.data(), packed_block, prefix_size);
+         zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(packed_block + prefix_size));
+         zs.avail_in  = size - prefix_size;
+         zs.next_out  = reinterpret_cast<Bytef*>(entry.data() + header_size);
+         zs.avail_out = entry.size() - header_size;
+         EOS_ASSERT(deflate(&zs, Z_FINISH) == Z_STREAM_END, block_log_exception, "Could not compress block");
+
+         const uint32_t compressed_size = zs.total_out;
+         memcpy(entry.data() + prefix_size, &packed_size, sizeof(packed_size));
+         memcpy(entry.data() + prefix_size + sizeof(packed_size), &compressed_size, sizeof(compressed_size));
+         entry.resize(header_size + compressed_size);
+         return entry;
+      }
+
+      std::vector<char> block_codec::decompress(const char* entry, size_t size) {
+         uint32_t packed_size = 0, compressed_size = 0;
+         if(size >= header_size) {
+            memcpy(&packed_size, entry + prefix_size, sizeof(packed_size));
+            memcpy(&compressed_size, entry + prefix_size + sizeof(packed_size), sizeof(compressed_size));
+         }
+         EOS_ASSERT(size >= header_size && header_size + compressed_size == size && packed_size > prefix_size,
+                    block_log_exception, "Malformed compressed block of ${s} bytes in block log", ("s", size));
+         if(!_inflate) {
+            _inflate.emplace();
+            EOS_ASSERT(inflateInit2(&*_inflate, -MAX_WBITS) == Z_OK, block_log_exception, "Could not initialize block log decompression");
+         } else {
+            inflateReset(&*_inflate);
+         }
+         z_stream& zs = *_inflate;
+         if(!_compression.dictionary.empty())
+            inflateSetDictionary(&zs, dictionary(), _compression.dictionary.size());
+
+         std::vector<char> packed_block(packed_size);
+         memcpy(packed_block.data(), entry, prefix_size);
+         zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(entry + header_size));
+         zs.avail_in  = compressed_size;
+         zs.next_out  = reinterpret_cast<Bytef*>(packed_block.data() + prefix_size);
+         zs.avail_out = packed_size - prefix_size;
+         EOS_ASSERT(inflate(&zs, Z_FINISH) == Z_STREAM_END && zs.avail_out == 0, block_log_exception,
+                    "Compressed block in block log is corrupted");
+         return packed_block;
+      }
+
+      // reads what follows the first block number in the header of a log: its genesis state or chain id, and the
+      // compression of a compressed log
+      template <typename Stream>
+      block_log_compression unpack_chain_context(Stream& ds, uint32_t version, uint32_t first_block_num, fc::sha256& chain_id) {
+         if (block_log::contains_genesis_state(version, first_block_num)) {
+            genesis_state gs;
+            fc::raw::unpack(ds, gs);
+            chain_id = gs.compute_chain_id();
+         } else {
+            fc::raw::unpack(ds, chain_id);
+         }
+         block_log_compression compression;
+         if (version >= compressed_version)
+            fc::raw::unpack(ds, compression);
+         return compression;
+      }
+
+      template <typename T>
+      void unpack_block_at(fc::cfile& block_file, block_codec& codec, uint64_t pos, T& t) {
+         if (codec.enabled()) {
+            block_file.seek_end(0);
+            const uint64_t end = block_file.tellp();
+            EOS_ASSERT(pos <= end, block_log_exception, "Block position ${p} is past the end of the block log", ("p", pos));
+            block_file.seek(pos);
+            const auto entry = codec.read_entry(block_file, end - pos);
+            const auto packed_block = codec.decompress(entry.data(), entry.size());
+            fc::datastream<const char*> ds(packed_block.data(), packed_block.size());
+            fc::raw::unpack(ds, t);
+         } else {
+            block_file.seek(pos);
+            auto ds = block_file.create_datastream();
+            fc::raw::unpack(ds, t);
+         }
+      }
+
+      /// blocks first_block through last_block split off from blocks.log into a log of their own
+      struct block_log_part {
+         fc::path block_file;
+         fc::path index_file;
+         uint32_t first_block = 0;
+         uint32_t last_block  = 0;
+      };
+
+      fc::path part_file_name(const fc::path& dir, uint32_t first_block, uint32_t last_block, const char* extension) {
+         return dir / ("blocks-" + std::to_string(first_block) + "-" + std::to_string(last_block) + extension);
+      }
+
+      // the parts in dir, named blocks-<first block>-<last block>.log, in no particular order
+      std::vector<block_log_part> find_parts(const fc::path& dir) {
+         std::vector<block_log_part> parts;
+         if (!fc::is_directory(dir))
+            return parts;
+         static const std::regex part_name(R"(blocks-([0-9]+)-([0-9]+)\.log)");
+         for (boost::filesystem::directory_iterator itr(dir), end; itr != end; ++itr) {
+            const std::string name = itr->path().filename().string();
+            std::smatch match;
+            if (!std::regex_match(name, match, part_name))
+               continue;
+            block_log_part part;
+            part.first_block = std::stoul(match[1]);
+            part.last_block  = std::stoul(match[2]);
+            part.block_file  = dir / name;
+            part.index_file  = part_file_name(dir, part.first_block, part.last_block, ".index");
+            EOS_ASSERT(part.first_block > 0 && part.first_block <= part.last_block, block_log_exception,
+                       "Invalid block range in the name of block log part ${p}", ("p", part.block_file.generic_string()));
+            parts.push_back(std::move(part));
+         }
+         return parts;
+      }
+
+      /*
+       *  @brief reads blocks from one part at a time, keeping the files of the last part read open
+       */
+      class part_reader {
+      public:
+         void open(const block_log_part& part);
+         void close();
+
+         template <typename T>
+         void unpack(uint32_t block_num, T& t) {
+            unpack_block_at(_block_file, *_codec, block_pos(block_num), t);
+         }
+
+         std::vector<char> read_packed_block(uint32_t block_num);
+
+         const fc::sha256& chain_id() const { return _chain_id; }
+         const block_log_compression& compression() const { return _codec->compression(); }
+
+      private:
+         uint64_t block_pos(uint32_t block_num);
+
+         std::optional<block_log_part> _part;
+         fc::sha256                    _chain_id;
+         fc::cfile                     _block_file;
+         fc::cfile                     _index_file;
+         std::unique_ptr<block_codec>  _codec;
+      };
+
+      void part_reader::open(const block_log_part& part) {
+         if (_part && _part->block_file == part.block_file)
+            return;
+         close();
+         if (!fc::exists(part.index_file))
+            block_log::construct_index(part.block_file, part.index_file);
+         _block_file.set_file_path(part.block_file);
+         _index_file.set_file_path(part.index_file);
+         _block_file.open("rb");
+         _index_file.open("rb");
+
+         uint32_t version = 0;
+         uint32_t first_block_num = 1;
+         fc::raw::unpack(_block_file, version);
+         EOS_ASSERT(block_log::is_supported_version(version), block_log_unsupported_version,
+                    "Block log part ${p} has unsupported version ${v}", ("p", part.block_file.generic_string())("v", version));
+         if (version > 1)
+            fc::raw::unpack(_block_file, first_block_num);
+         EOS_ASSERT(first_block_num == part.first_block, block_log_exception,
+                    "Block log part ${p} starts at block ${n}", ("p", part.block_file.generic_string())("n", first_block_num));
+         auto ds = _block_file.create_datastream();
+         _codec = std::make_unique<block_codec>(unpack_chain_context(ds, version, first_block_num, _chain_id));
+         _part = part;
+      }
+
+      void part_reader::close() {
+         if (_block_file.is_open())
+            _block_file.close();
+         if (_index_file.is_open())
+            _index_file.close();
+         _part.reset();
+      }
+
+      uint64_t part_reader::block_pos(uint32_t block_num) {
+         EOS_ASSERT(_part && _part->first_block <= block_num && block_num <= _part->last_block, block_log_exception,
+                    "Block ${n} is not in the open block log part", ("n", block_num));
+         _index_file.seek(sizeof(uint64_t) * (block_num - _part->first_block));
+         uint64_t pos;
+         _index_file.read((char*)&pos, sizeof(pos));
+         return pos;
+      }
+
+      std::vector<char> part_reader::read_packed_block(uint32_t block_num) {
+         const uint64_t pos = block_pos(block_num);
+         uint64_t end;
+         if (block_num < _part->last_block) {
+            end = block_pos(block_num + 1);
+         } else {
+            _block_file.seek_end(0);
+            end = _block_file.tellp();
+         }
+         EOS_ASSERT(pos + sizeof(uint64_t) <= end, block_log_exception,
+                    "Invalid position for block ${n} in ${p}", ("n", block_num)("p", _part->index_file.generic_string()));
+         std::vector<char> entry(end - pos - sizeof(uint64_t));
+         _block_file.seek(pos);
+         _block_file.read(entry.data(), entry.size());
+         if (_codec->enabled())
+            return _codec->decompress(entry.data(), entry.size());
+         return entry;
+      }
+
       class block_log_impl {
          public:
             signed_block_ptr         head;
@@ -49,9 +350,47 @@ namespace eosio { namespace chain {
             uint32_t                 index_first_block_num = 0; //the first number in index & the log had it not been pruned
             std::optional<block_log_prune_config> prune_config;
             bool                     not_generate_block_log = false;
-
-            explicit block_log_impl(std::optional<block_log_prune_config> prune_conf) :
-              prune_config(prune_conf) {
+            std::unique_ptr<block_codec> codec = std::make_unique<block_codec>(block_log_compression{});
+            fc::sha256               chain_id;
+            std::optional<block_log_split_config> split_config;
+            std::map<uint32_t, block_log_part>    parts;        //parts split off from the log, by their last block
+            part_reader                           part_blocks;  //reads blocks from parts
+            std::shared_ptr<boost::interprocess::mapped_region> block_mapping; //read-only mapping of block_file, remapped as it grows
+            static constexpr uint64_t block_mapping_step = 1024*1024*1024; //how far block_mapping reaches past block_file
+
+            struct queued_block {
+               signed_block_ptr  block;
+               block_id_type     id;
+               std::vector<char> packed_block;
+            };
+            using queued_block_ptr = std::shared_ptr<const queued_block>;
+
+            // where the files ended after the blocks written so far, restored when writing the following ones fails
+            struct write_mark {
+               uint64_t         block_end = 0;
+               uint64_t         index_end = 0;
+               signed_block_ptr head;
+               block_id_type    head_id;
+            };
+
+            // asynchronous append: blocks are queued by the appending thread and written in order by writer
+            std::thread                  writer;
+            std::mutex                   queue_mtx;
+            std::condition_variable      queue_cond;
+            std::deque<queued_block_ptr> queue;                //appended blocks not yet written, guarded by queue_mtx
+            uint32_t                     max_queued_blocks = 0;
+            bool                         stop_writer = false;  //guarded by queue_mtx
+            std::exception_ptr           write_except;         //guarded by queue_mtx, set until the failed blocks are written
+            signed_block_ptr             queued_head;          //the head including queued blocks, used by the appending thread only
+            block_id_type                queued_head_id;
+            std::recursive_mutex         file_mtx;             //held while the files are used, by writer for a whole batch
+
+            block_log_impl(std::optional<block_log_prune_config> prune_conf, std::optional<block_log_split_config> split_conf) :
+              prune_config(prune_conf), split_config(std::move(split_conf)) {
+               if(split_config) {
+                  EOS_ASSERT(!prune_config, block_log_exception, "block log cannot be both pruned and split");
+                  EOS_ASSERT(split_config->stride > 0, block_log_exception, "block log stride must be greater than 0");
+               }
                if(prune_config) {
                   if (prune_config->prune_blocks == 0 ) {
                      // not to generate blocks.log
@@ -101,6 +440,20 @@ namespace eosio { namespace chain {
                if( index_file.is_open() )
                   index_file.close();
                open_files = false;
+               block_mapping.reset();
+            }
+
+            // maps block_file up to at least end, views handed out keep the mapping they were made from.
+            // The mapping reaches up to block_mapping_step past the end of the file, blocks appended later are
+            // seen through it once flushed, so the log is only remapped after growing by block_mapping_step.
+            const char* mapped_blocks(uint64_t end) {
+               block_file.flush();
+               if (!block_mapping || block_mapping->get_size() < end) {
+                  const uint64_t size = (end / block_mapping_step + 1) * block_mapping_step;
+                  boost::interprocess::file_mapping file(block_file.get_file_path().generic_string().c_str(), boost::interprocess::read_only);
+                  block_mapping = std::make_shared<boost::interprocess::mapped_region>(file, boost::interprocess::read_only, 0, size);
+               }
+               return static_cast<const char*>(block_mapping->get_address());
             }
 
             template<typename T>
@@ -112,9 +465,53 @@ namespace eosio { namespace chain {
 
             void write( const chain_id_type& chain_id );
 
+            void read_chain_context();
+
+            template<typename T>
+            void unpack_at( uint64_t pos, T& t ) { unpack_block_at(block_file, *codec, pos, t); }
+
+            void open_parts(const fc::path& data_dir);
+
+            bool resume_after_parts(const fc::path& data_dir);
+
+            uint32_t first_readable_block() const {
+               return parts.empty() ? first_block_num : parts.begin()->second.first_block;
+            }
+
+            const block_log_part* find_part( uint32_t block_num ) const;
+
+            template<typename T>
+            bool unpack_from_part( uint32_t block_num, T& t );
+
+            void split();
+
+            void begin_log_after(uint32_t block_num);
+
+            void archive_parts();
+
+            void remove_parts();
+
             void flush();
 
-            void append(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block);
+            void append(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block, bool flush_block = true);
+
+            void log_block(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block, bool flush_block);
+
+            void start_writer(uint32_t max_queued);
+
+            void stop_writing();
+
+            void enqueue(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block);
+
+            void write_queued_blocks();
+
+            void wait_until_written();
+
+            write_mark mark_written();
+
+            void roll_back_to(const write_mark& mark);
+
+            queued_block_ptr find_queued(uint32_t block_num);
 
             void update_head(const signed_block_ptr& b, const std::optional<block_id_type>& id={});
 
@@ -162,6 +559,7 @@ namespace eosio { namespace chain {
          uint64_t previous();
          uint32_t version() const { return _version; }
          uint32_t first_block_num() const { return _first_block_num; }
+         bool is_pruned() const { return _prune_block_limit.has_value(); }
          static uint32_t      _buf_len;
       private:
          void update_buffer();
@@ -196,6 +594,51 @@ namespace eosio { namespace chain {
          uint32_t                                          _blocks_remaining;
       };
 
+      /*
+       *  Reconstructs the index of a log which is not pruned from chunks of the file handled in parallel. The last block
+       *  ending in each chunk is found by looking for a position entry which points back to a block, itself preceded by
+       *  blocks with consecutive numbers each pointed to by the position entry before the next, and which is followed by
+       *  the next block. The blocks from each block found back to the one found in the chunk before are then walked
+       *  through by their position entries, which must lead exactly to it.
+       *
+       *  Entries are written to <index>.partial, renamed to the index once complete. The first block of a range is written
+       *  last, once the others are flushed, so a reconstruction which was interrupted skips the ranges already complete.
+       */
+      class index_builder {
+      public:
+         index_builder(const fc::path& block_file_name, uint32_t first_block_num);
+         void build(const fc::path& index_file_name, size_t num_threads);
+
+         static uint64_t _chunk_len;
+      private:
+         struct block_end {
+            uint64_t pos_offset = 0; //where the position entry following the block is
+            uint32_t block_num  = 0;
+         };
+
+         static constexpr uint64_t min_block_pos  = 2*sizeof(uint32_t);                      //after the version and first block number
+         static constexpr uint64_t min_block_size = trim_data::blknum_offset + sizeof(uint32_t);
+         static constexpr uint32_t chained_blocks = 16;  //blocks linked by their position entries for bytes to be taken as one
+
+         uint64_t read_pos(uint64_t offset) const {
+            uint64_t pos;
+            memcpy(&pos, _blocks + offset, sizeof(pos));
+            return pos;
+         }
+         uint32_t block_num_at(uint64_t block_pos) const;
+         bool is_block_at(uint64_t block_pos, uint32_t block_num, uint64_t limit) const;
+         std::optional<uint32_t> block_ending_at(uint64_t pos_offset) const;
+         std::optional<block_end> last_block_end(uint64_t begin, uint64_t end) const;
+
+         std::string                        _block_file_name;
+         boost::interprocess::file_mapping  _file;
+         boost::interprocess::mapped_region _region;
+         const char*                        _blocks          = nullptr;
+         uint64_t                           _end_of_blocks   = 0;
+         uint32_t                           _first_block_num = 0;
+         uint32_t                           _last_block_num  = 0;
+      };
+
       /*
        *  @brief datastream adapter that adapts FILE* for use with fc unpack
        *
@@ -230,8 +673,9 @@ namespace eosio { namespace chain {
       };
    }
 
-   block_log::block_log(const fc::path& data_dir, std::optional<block_log_prune_config> prune_config)
-   :my(new detail::block_log_impl(prune_config)) {
+   block_log::block_log(const fc::path& data_dir, std::optional<block_log_prune_config> prune_config,
+                        std::optional<block_log_split_config> split_config)
+   :my(new detail::block_log_impl(prune_config, std::move(split_config))) {
       open(data_dir);
    }
 
@@ -241,6 +685,7 @@ namespace eosio { namespace chain {
 
    block_log::~block_log() {
       if (my) {
+         my->stop_writing();
          flush();
          my->try_exit_vacuum();
          my->close();
@@ -256,6 +701,8 @@ namespace eosio { namespace chain {
 
       my->block_file.set_file_path( data_dir / "blocks.log" );
       my->index_file.set_file_path( data_dir / "blocks.index" );
+      if (my->split_config && my->split_config->archive_dir.is_relative() && !my->split_config->archive_dir.empty())
+         my->split_config->archive_dir = data_dir / my->split_config->archive_dir;
 
       my->reopen();
 
@@ -277,6 +724,9 @@ namespace eosio { namespace chain {
        *  - If the index file head is not in the log file, delete the index and replay.
        *  - If the index file head is in the log, but not up to date, replay from index head.
        */
+      if (!fc::file_size( my->block_file.get_file_path() ))
+         my->resume_after_parts(data_dir);
+
       auto log_size = fc::file_size( my->block_file.get_file_path() );
       auto index_size = fc::file_size( my->index_file.get_file_path() );
 
@@ -301,6 +751,8 @@ namespace eosio { namespace chain {
             my->first_block_num = 1;
          }
          my->index_first_block_num = my->first_block_num;
+         my->read_chain_context();
+         my->open_parts(data_dir);
 
          my->update_head(read_head());
 
@@ -353,6 +805,8 @@ namespace eosio { namespace chain {
          else if(is_currently_pruned && !my->prune_config) {
             my->vacuum();
          }
+
+         my->archive_parts();
       } else if (index_size) {
          ilog("Index is nonempty, remove and recreate it");
          my->close();
@@ -362,14 +816,208 @@ namespace eosio { namespace chain {
    }
 
    void block_log::append(const signed_block_ptr& b, const block_id_type& id) {
-      my->append(b, id, fc::raw::pack(*b));
+      append(b, id, fc::raw::pack(*b));
    }
 
    void block_log::append(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block) {
-      my->append(b, id, packed_block);
+      if (my->writer.joinable()) {
+         my->enqueue(b, id, packed_block);
+         return;
+      }
+      my->log_block(b, id, packed_block, true);
+   }
+
+   void detail::block_log_impl::log_block(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block, bool flush_block) {
+      append(b, id, packed_block, flush_block);
+      if (split_config && b->block_num() % split_config->stride == 0)
+         split();
    }
 
-   void detail::block_log_impl::append(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block) {
+   bool block_log::write_failed() const {
+      std::lock_guard<std::mutex> g(my->queue_mtx);
+      return my->write_except != nullptr;
+   }
+
+   void block_log::start_async_append(uint32_t max_queued_blocks) {
+      EOS_ASSERT(max_queued_blocks > 0, block_log_exception, "block log queue size must be greater than 0");
+      if (my->not_generate_block_log)
+         return;
+      my->start_writer(max_queued_blocks);
+   }
+
+   void detail::block_log_impl::start_writer(uint32_t max_queued) {
+      if (writer.joinable())
+         return;
+      max_queued_blocks = max_queued;
+      queued_head = head;
+      queued_head_id = head_id;
+      writer = std::thread([this]() {
+         fc::set_os_thread_name("blocklog");
+         write_queued_blocks();
+      });
+   }
+
+   // writes the blocks still queued, retrying those which failed to be written once, and ends the writer
+   void detail::block_log_impl::stop_writing() {
+      if (!writer.joinable())
+         return;
+      {
+         std::lock_guard<std::mutex> g(queue_mtx);
+         write_except = nullptr;
+         stop_writer = true;
+      }
+      queue_cond.notify_all();
+      writer.join();
+
+      std::lock_guard<std::mutex> g(queue_mtx);
+      if (write_except) {
+         elog("Block log writer failed, blocks ${b} to ${e} were not written to ${l}",
+              ("b", queue.front()->block->block_num())("e", queue.back()->block->block_num())
+              ("l", block_file.get_file_path().generic_string()));
+         queue.clear();
+         write_except = nullptr;
+      }
+      stop_writer = false;
+   }
+
+   // once writing failed, no block is appended until the failed ones are written and the head is the last block written
+   void detail::block_log_impl::enqueue(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block) {
+      EOS_ASSERT( genesis_written_to_block_log, block_log_append_fail, "Cannot append to block log until the genesis is first written" );
+      auto qb = std::make_shared<const queued_block>(queued_block{b, id, packed_block});
+      std::exception_ptr except;
+      {
+         std::unique_lock<std::mutex> g(queue_mtx);
+         queue_cond.wait(g, [this]() { return queue.size() < max_queued_blocks || write_except; });
+         except = write_except;
+         if (!except)
+            queue.push_back(std::move(qb));
+      }
+      if (except) {
+         std::lock_guard<std::recursive_mutex> f(file_mtx);
+         queued_head = head;
+         queued_head_id = head_id;
+         std::rethrow_exception(except);
+      }
+      queue_cond.notify_all();
+      queued_head = b;
+      queued_head_id = id;
+   }
+
+   // runs on writer, everything queued when a batch begins is written with a single flush. When writing fails, the files
+   // are rolled back to the last block flushed and the blocks after it stay queued until flush() or stop_writing()
+   void detail::block_log_impl::write_queued_blocks() {
+      std::unique_lock<std::mutex> g(queue_mtx);
+      while (true) {
+         queue_cond.wait(g, [this]() { return (!queue.empty() && !write_except) || stop_writer; });
+         if (queue.empty() || write_except)
+            return;
+         const std::vector<queued_block_ptr> batch(queue.begin(), queue.end());
+         g.unlock();
+
+         size_t written = 0;
+         std::exception_ptr except;
+         {
+            std::lock_guard<std::recursive_mutex> f(file_mtx);
+            std::optional<write_mark> mark;
+            try {
+               mark = mark_written();
+               size_t appended = 0;
+               for (const auto& qb : batch) {
+                  append(qb->block, qb->id, qb->packed_block, false);
+                  ++appended;
+                  if (split_config && qb->block->block_num() % split_config->stride == 0) {
+                     flush();
+                     written = appended;
+                     // the block is in the part whether or not splitting succeeds
+                     mark.reset();
+                     split();
+                     mark = mark_written();
+                  }
+               }
+               flush();
+               written = appended;
+            } catch (const fc::exception& e) {
+               elog("Block log writer failed to write block ${n} to ${l}: ${e}",
+                    ("n", batch[written]->block->block_num())("l", block_file.get_file_path().generic_string())("e", e.to_detail_string()));
+               except = std::current_exception();
+            } catch (const std::exception& e) {
+               elog("Block log writer failed to write block ${n} to ${l}: ${e}",
+                    ("n", batch[written]->block->block_num())("l", block_file.get_file_path().generic_string())("e", e.what()));
+               except = std::current_exception();
+            } catch (...) {
+               except = std::current_exception();
+            }
+            if (except && mark)
+               roll_back_to(*mark);
+         }
+
+         g.lock();
+         // from now on the written blocks are read from the log
+         queue.erase(queue.begin(), queue.begin() + written);
+         write_except = except;
+         queue_cond.notify_all();
+      }
+   }
+
+   // the blocks which failed to be written are written again first
+   void detail::block_log_impl::wait_until_written() {
+      std::exception_ptr except;
+      {
+         std::unique_lock<std::mutex> g(queue_mtx);
+         if (write_except && !queue.empty()) {
+            write_except = nullptr;
+            queue_cond.notify_all();
+         }
+         queue_cond.wait(g, [this]() { return queue.empty() || write_except; });
+         except = write_except;
+      }
+      if (except) {
+         std::lock_guard<std::recursive_mutex> f(file_mtx);
+         queued_head = head;
+         queued_head_id = head_id;
+         std::rethrow_exception(except);
+      }
+   }
+
+   detail::block_log_impl::write_mark detail::block_log_impl::mark_written() {
+      check_open_files();
+      block_file.seek_end(0);
+      index_file.seek_end(0);
+      return write_mark{block_file.tellp(), index_file.tellp(), head, head_id};
+   }
+
+   // drops what was written after mark, a block partially written before the failure included
+   void detail::block_log_impl::roll_back_to(const write_mark& mark) {
+      try {
+         close();
+         fc::resize_file(block_file.get_file_path(), mark.block_end);
+         fc::resize_file(index_file.get_file_path(), mark.index_end);
+         update_head(mark.head, mark.head_id);
+         if (prune_config && head) {
+            // the count of blocks after the head may have been pruned since mark
+            reopen();
+            block_file.seek_end(-sizeof(uint32_t));
+            const uint32_t num_blocks_in_log = chain::block_header::num_from_id(head_id) - first_block_num + 1;
+            fc::raw::pack(block_file, num_blocks_in_log);
+            block_file.flush();
+         }
+      } FC_LOG_AND_DROP()
+   }
+
+   // queued blocks follow each other, the oldest first
+   detail::block_log_impl::queued_block_ptr detail::block_log_impl::find_queued(uint32_t block_num) {
+      if (!writer.joinable())
+         return {};
+      std::lock_guard<std::mutex> g(queue_mtx);
+      if (queue.empty())
+         return {};
+      const uint32_t first_queued = queue.front()->block->block_num();
+      if (block_num < first_queued || block_num - first_queued >= queue.size())
+         return {};
+      return queue[block_num - first_queued];
+   }
+
+   void detail::block_log_impl::append(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block, bool flush_block) {
       try {
          EOS_ASSERT( genesis_written_to_block_log, block_log_append_fail, "Cannot append to block log until the genesis is first written" );
 
@@ -392,7 +1040,12 @@ namespace eosio { namespace chain {
                    "Append to index file occuring at wrong position.",
                    ("position", (uint64_t) index_file.tellp())
                    ("expected", (b->block_num() - index_first_block_num) * sizeof(uint64_t)));
-         block_file.write(packed_block.data(), packed_block.size());
+         if (codec->enabled()) {
+            const auto entry = codec->compress(packed_block.data(), packed_block.size());
+            block_file.write(entry.data(), entry.size());
+         } else {
+            block_file.write(packed_block.data(), packed_block.size());
+         }
          block_file.write((char*)&pos, sizeof(pos));
          const uint64_t end = block_file.tellp();
          index_file.write((char*)&pos, sizeof(pos));
@@ -407,7 +1060,8 @@ namespace eosio { namespace chain {
             fc::raw::pack(block_file, num_blocks_in_log);
          }
 
-         flush();
+         if (flush_block)
+            flush();
       }
       FC_LOG_AND_RETHROW()
    }
@@ -434,11 +1088,12 @@ namespace eosio { namespace chain {
 
       const uint32_t prune_to_num = head_num - prune_config->prune_blocks + 1;
 
-      static_assert( block_log::max_supported_version == 3, "Code was written to support version 3 format, need to update this code for latest format." );
+      static_assert( block_log::max_supported_version == 4, "Code was written to support version 4 format, need to update this code for latest format." );
       const genesis_state gs;
       const size_t max_header_size_v1  = sizeof(uint32_t) + fc::raw::pack_size(gs) + sizeof(uint64_t);
       const size_t max_header_size_v23 = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(chain_id_type) + sizeof(uint64_t);
-      const auto max_header_size = std::max(max_header_size_v1, max_header_size_v23);
+      const size_t max_header_size_v4  = codec->enabled() ? max_header_size_v1 + sizeof(uint32_t) + fc::raw::pack_size(codec->compression()) : 0;
+      const auto max_header_size = std::max({max_header_size_v1, max_header_size_v23, max_header_size_v4});
 
       block_file.punch_hole(max_header_size, get_block_pos(prune_to_num));
 
@@ -454,6 +1109,8 @@ namespace eosio { namespace chain {
       if (my->not_generate_block_log) {
          return;
       }
+      my->wait_until_written();
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
       my->flush();
    }
 
@@ -479,7 +1136,7 @@ namespace eosio { namespace chain {
          fc::raw::unpack(ds, gs);
 
          block_file.seek(0);
-         fc::raw::pack(block_file, block_log::max_supported_version);
+         fc::raw::pack(block_file, version_for(codec->compression()));
          fc::raw::pack(block_file, first_block_num);
          if(first_block_num == 1) {
             EOS_ASSERT(old_first_block_num == 1, block_log_exception, "expected an old first blocknum of 1");
@@ -487,6 +1144,8 @@ namespace eosio { namespace chain {
          }
          else
             fc::raw::pack(block_file, gs.compute_chain_id());
+         if(codec->enabled())
+            fc::raw::pack(block_file, codec->compression());
          fc::raw::pack(block_file, totem);
       }
       else {
@@ -495,9 +1154,11 @@ namespace eosio { namespace chain {
          fc::raw::unpack(block_file, chainid);
 
          block_file.seek(0);
-         fc::raw::pack(block_file, block_log::max_supported_version);
+         fc::raw::pack(block_file, version_for(codec->compression()));
          fc::raw::pack(block_file, first_block_num);
          fc::raw::pack(block_file, chainid);
+         if(codec->enabled())
+            fc::raw::pack(block_file, codec->compression());
          fc::raw::pack(block_file, totem);
       }
 
@@ -509,7 +1170,7 @@ namespace eosio { namespace chain {
       // block recovery can get through some blocks.
       size_t copy_to_pos = convert_existing_header_to_vacuumed();
 
-      version = block_log::max_supported_version;
+      version = version_for(codec->compression());
       prune_config.reset();
 
       //if there is no head block though, bail now, otherwise first_block_num won't actually be available
@@ -577,6 +1238,7 @@ namespace eosio { namespace chain {
    template<typename T>
    void detail::block_log_impl::reset( const T& t, const signed_block_ptr& first_block, uint32_t first_bnum ) {
       close();
+      remove_parts();
 
       fc::remove_all( block_file.get_file_path() );
       fc::remove_all( index_file.get_file_path() );
@@ -591,6 +1253,8 @@ namespace eosio { namespace chain {
       block_file.write((char*)&first_block_num, sizeof(first_block_num));
 
       write(t);
+      if (codec->enabled())
+         fc::raw::pack(block_file, codec->compression());
       genesis_written_to_block_log = true;
 
       // append a totem to indicate the division between blocks and header
@@ -611,17 +1275,22 @@ namespace eosio { namespace chain {
       static_assert( block_log::max_supported_version > 0, "a version number of zero is not supported" );
 
       // going back to write correct version to indicate that all block log header data writes completed successfully
-      version = block_log::max_supported_version;
+      version = version_for(codec->compression());
       if(prune_config)
          version |= pruned_version_flag;
       block_file.seek( 0 );
       block_file.write( (char*)&version, sizeof(version) );
       block_file.seek( pos );
       flush();
+
+      queued_head = head;
+      queued_head_id = head_id;
    }
 
    void block_log::reset( const genesis_state& gs, const signed_block_ptr& first_block ) {
       // At startup, OK to be called in no blocks.log mode from controller.cpp
+      my->wait_until_written();
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
       my->reset(gs, first_block, 1);
    }
 
@@ -629,6 +1298,8 @@ namespace eosio { namespace chain {
       // At startup, OK to be called in no blocks.log mode from controller.cpp
       EOS_ASSERT( first_block_num > 1, block_log_exception,
                   "Block log version ${ver} needs to be created with a genesis state if starting from block number 1." );
+      my->wait_until_written();
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
       my->reset(chain_id, signed_block_ptr(), first_block_num);
    }
 
@@ -642,16 +1313,177 @@ namespace eosio { namespace chain {
    }
 
    void block_log::remove() {
+      my->wait_until_written();
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
       my->remove();
    }
 
    void detail::block_log_impl::write( const genesis_state& gs ) {
       auto data = fc::raw::pack(gs);
       block_file.write(data.data(), data.size());
+      chain_id = gs.compute_chain_id();
+   }
+
+   void detail::block_log_impl::write( const chain_id_type& id ) {
+      block_file << id;
+      chain_id = id;
    }
 
-   void detail::block_log_impl::write( const chain_id_type& chain_id ) {
-      block_file << chain_id;
+   // reads the chain id and compression of the log, block_file is left right after the first block number
+   void detail::block_log_impl::read_chain_context() {
+      auto ds = block_file.create_datastream();
+      codec = std::make_unique<block_codec>(unpack_chain_context(ds, version, first_block_num, chain_id));
+   }
+
+   // catalogs the parts which lead without a gap to the first block of blocks.log, from data_dir and the archive
+   void detail::block_log_impl::open_parts(const fc::path& data_dir) {
+      part_blocks.close();
+      parts.clear();
+
+      std::map<uint32_t, block_log_part> found;
+      for (auto& part : find_parts(data_dir))
+         found.emplace(part.last_block, std::move(part));
+      if (split_config && !split_config->archive_dir.empty()) {
+         for (auto& part : find_parts(split_config->archive_dir))
+            found.emplace(part.last_block, std::move(part));
+      }
+
+      for (uint32_t next = first_block_num; next > 1;) {
+         auto itr = found.find(next - 1);
+         if (itr == found.end())
+            break;
+         next = itr->second.first_block;
+         parts.insert(found.extract(itr));
+      }
+      if (!found.empty())
+         wlog("Ignoring ${n} block log part(s) not followed by the blocks of ${log}",
+              ("n", found.size())("log", block_file.get_file_path().generic_string()));
+      if (!parts.empty())
+         ilog("Block log parts hold blocks ${b}-${e}", ("b", parts.begin()->second.first_block)("e", parts.rbegin()->first));
+   }
+
+   // a split interrupted after blocks.log was renamed to a part leaves no blocks.log, begins it again after the last part
+   bool detail::block_log_impl::resume_after_parts(const fc::path& data_dir) {
+      const auto found = find_parts(data_dir);
+      if (found.empty())
+         return false;
+      const auto& last = *std::max_element(found.begin(), found.end(), [](const block_log_part& a, const block_log_part& b) {
+         return a.last_block < b.last_block;
+      });
+      part_blocks.open(last);
+      chain_id = part_blocks.chain_id();
+      codec = std::make_unique<block_codec>(part_blocks.compression());
+      part_blocks.close();
+
+      wlog("No blocks.log next to block log part ${p}, beginning a new one", ("p", last.block_file.generic_string()));
+      begin_log_after(last.last_block);
+      return true;
+   }
+
+   const detail::block_log_part* detail::block_log_impl::find_part( uint32_t block_num ) const {
+      auto itr = parts.lower_bound(block_num);
+      if (itr == parts.end() || block_num < itr->second.first_block)
+         return nullptr;
+      return &itr->second;
+   }
+
+   template<typename T>
+   bool detail::block_log_impl::unpack_from_part( uint32_t block_num, T& t ) {
+      const block_log_part* part = find_part(block_num);
+      if (!part)
+         return false;
+      part_blocks.open(*part);
+      part_blocks.unpack(block_num, t);
+      return true;
+   }
+
+   // renames blocks.log and blocks.index to a part holding the blocks up to the head, and begins a new blocks.log
+   void detail::block_log_impl::split() {
+      const uint32_t head_num = block_header::num_from_id(head_id);
+      const fc::path data_dir = block_file.get_file_path().parent_path();
+      block_log_part part{part_file_name(data_dir, first_block_num, head_num, ".log"),
+                          part_file_name(data_dir, first_block_num, head_num, ".index"), first_block_num, head_num};
+
+      close();
+      fc::rename(block_file.get_file_path(), part.block_file);
+      fc::rename(index_file.get_file_path(), part.index_file);
+      ilog("Split blocks ${b}-${e} off to ${p}", ("b", first_block_num)("e", head_num)("p", part.block_file.generic_string()));
+      parts.emplace(head_num, std::move(part));
+
+      begin_log_after(head_num);
+      archive_parts();
+   }
+
+   // writes the header of an empty blocks.log whose first block follows block_num, the head is kept
+   void detail::block_log_impl::begin_log_after(uint32_t block_num) {
+      reopen();
+
+      version = 0; // as in reset(), a version of zero indicates the header was not completely written
+      index_first_block_num = first_block_num = block_num + 1;
+
+      block_file.seek_end(0);
+      block_file.write((char*)&version, sizeof(version));
+      block_file.write((char*)&first_block_num, sizeof(first_block_num));
+      fc::raw::pack(block_file, chain_id);
+      if (codec->enabled())
+         fc::raw::pack(block_file, codec->compression());
+      auto totem = block_log::npos;
+      block_file.write((char*)&totem, sizeof(totem));
+      auto pos = block_file.tellp();
+
+      version = version_for(codec->compression());
+      block_file.seek( 0 );
+      block_file.write( (char*)&version, sizeof(version) );
+      block_file.seek( pos );
+      flush();
+   }
+
+   // moves the oldest parts beyond max_retained_files next to blocks.log to the archive, or deletes them
+   void detail::block_log_impl::archive_parts() {
+      if (!split_config)
+         return;
+      const fc::path data_dir = block_file.get_file_path().parent_path();
+      size_t retained = std::count_if(parts.begin(), parts.end(), [&](const auto& p) {
+         return p.second.block_file.parent_path() == data_dir;
+      });
+
+      for (auto itr = parts.begin(); retained > split_config->max_retained_files && itr != parts.end();) {
+         block_log_part& part = itr->second;
+         if (part.block_file.parent_path() != data_dir) {
+            ++itr;
+            continue;
+         }
+         part_blocks.close();
+         if (split_config->archive_dir.empty()) {
+            fc::remove(part.block_file);
+            fc::remove(part.index_file);
+            ilog("Removed block log part ${p}", ("p", part.block_file.generic_string()));
+            // the parts before it no longer lead to blocks.log
+            itr = parts.erase(parts.begin(), std::next(itr));
+         } else {
+            fc::create_directories(split_config->archive_dir);
+            const fc::path block_file_name = split_config->archive_dir / part.block_file.filename();
+            const fc::path index_file_name = split_config->archive_dir / part.index_file.filename();
+            fc::rename(part.block_file, block_file_name);
+            fc::rename(part.index_file, index_file_name);
+            ilog("Archived block log part ${p}", ("p", block_file_name.generic_string()));
+            part.block_file = block_file_name;
+            part.index_file = index_file_name;
+            ++itr;
+         }
+         --retained;
+      }
+   }
+
+   // removes the parts next to blocks.log, archived parts are left alone
+   void detail::block_log_impl::remove_parts() {
+      part_blocks.close();
+      const fc::path data_dir = block_file.get_file_path().parent_path();
+      for (const auto& part : find_parts(data_dir)) {
+         fc::remove(part.block_file);
+         fc::remove(part.index_file);
+      }
+      parts.clear();
    }
 
    signed_block_ptr block_log::read_block(uint64_t pos)const {
@@ -659,12 +1491,11 @@ namespace eosio { namespace chain {
          return nullptr;
       }
 
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
       my->check_open_files();
 
-      my->block_file.seek(pos);
       signed_block_ptr result = std::make_shared<signed_block>();
-      auto ds = my->block_file.create_datastream();
-      fc::raw::unpack(ds, *result);
+      my->unpack_at(pos, *result);
       return result;
    }
 
@@ -673,11 +1504,10 @@ namespace eosio { namespace chain {
          return;
       }
 
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
       my->check_open_files();
 
-      my->block_file.seek(pos);
-      auto ds = my->block_file.create_datastream();
-      fc::raw::unpack(ds, bh);
+      my->unpack_at(pos, bh);
    }
 
    signed_block_ptr block_log::read_block_by_num(uint32_t block_num)const {
@@ -688,10 +1518,19 @@ namespace eosio { namespace chain {
             // No blocks exist. Avoid cascading failures if going further.
             return b;
          }
+         if (auto qb = my->find_queued(block_num))
+            return qb->block;
 
+         std::lock_guard<std::recursive_mutex> g(my->file_mtx);
          uint64_t pos = get_block_pos(block_num);
          if (pos != npos) {
             b = read_block(pos);
+         } else if (block_num < my->first_block_num) {
+            auto part_block = std::make_shared<signed_block>();
+            if (my->unpack_from_part(block_num, *part_block))
+               b = std::move(part_block);
+         }
+         if (b) {
             EOS_ASSERT(b->block_num() == block_num, reversible_blocks_exception,
                       "Wrong block was read from block log.", ("returned", b->block_num())("expected", block_num));
          }
@@ -704,18 +1543,153 @@ namespace eosio { namespace chain {
          if (my->not_generate_block_log) {
             return {};
          }
+         if (auto qb = my->find_queued(block_num))
+            return qb->id;
+
+         std::lock_guard<std::recursive_mutex> g(my->file_mtx);
          uint64_t pos = get_block_pos(block_num);
+         block_header bh;
          if (pos != npos) {
-            block_header bh;
             read_block_header(bh, pos);
-            EOS_ASSERT(bh.block_num() == block_num, reversible_blocks_exception,
-                       "Wrong block header was read from block log.", ("returned", bh.block_num())("expected", block_num));
-            return bh.calculate_id();
+         } else if (block_num >= my->first_block_num || !my->unpack_from_part(block_num, bh)) {
+            return {};
          }
-         return {};
+         EOS_ASSERT(bh.block_num() == block_num, reversible_blocks_exception,
+                    "Wrong block header was read from block log.", ("returned", bh.block_num())("expected", block_num));
+         return bh.calculate_id();
       } FC_LOG_AND_RETHROW()
    }
 
+   void block_log::read_serialized_blocks( uint32_t first_block_num, uint32_t last_block_num,
+                                           const std::function<bool(uint32_t, std::vector<char>&&)>& cb )const {
+      if( my->not_generate_block_log )
+         return;
+      // the log is read with handles of its own, once every block is in it
+      my->wait_until_written();
+      if( !my->head )
+         return;
+
+      const uint32_t head_num = block_header::num_from_id( my->head_id );
+      first_block_num = std::max( first_block_num, my->first_readable_block() );
+      last_block_num = std::min( last_block_num, head_num );
+      if( first_block_num > last_block_num )
+         return;
+
+      // parts are read a block at a time, they are contiguous up to the first block of blocks.log
+      if( first_block_num < my->first_block_num ) {
+         detail::part_reader reader;
+         for( auto itr = my->parts.lower_bound( first_block_num ); itr != my->parts.end() && first_block_num <= last_block_num; ++itr ) {
+            reader.open( itr->second );
+            for( ; first_block_num <= std::min( last_block_num, itr->first ); ++first_block_num ) {
+               if( !cb( first_block_num, reader.read_packed_block( first_block_num ) ) )
+                  return;
+            }
+         }
+         if( first_block_num > last_block_num )
+            return;
+      }
+
+      fc::cfile block_file;
+      fc::cfile index_file;
+      block_file.set_file_path( my->block_file.get_file_path() );
+      index_file.set_file_path( my->index_file.get_file_path() );
+      block_file.open( "rb" );
+      index_file.open( "rb" );
+      // the head block is followed by its position in the log, and the block count trailer of a pruned log
+      block_file.seek_end( 0 );
+      uint64_t end_of_blocks = block_file.tellp();
+      if( my->prune_config )
+         end_of_blocks -= sizeof(uint32_t);
+      detail::block_codec codec( my->codec->compression() );
+
+      constexpr uint32_t max_blocks_per_read = 256;
+      constexpr uint64_t max_bytes_per_read  = 16*1024*1024;
+      std::vector<uint64_t> positions;
+      std::vector<char>     buffer;
+      for( uint32_t batch_first = first_block_num; batch_first <= last_block_num; ) {
+         const uint32_t batch_last = batch_first + std::min( max_blocks_per_read, last_block_num - batch_first + 1 ) - 1;
+         // the position of the block following the batch marks where the batch ends
+         const uint32_t num_positions = batch_last - batch_first + 1 + (batch_last < head_num ? 1 : 0);
+         positions.resize( num_positions );
+         index_file.seek( sizeof(uint64_t) * (batch_first - my->index_first_block_num) );
+         index_file.read( reinterpret_cast<char*>( positions.data() ), sizeof(uint64_t) * num_positions );
+         if( batch_last == head_num ) // every block is followed by its position in the log
+            positions.push_back( end_of_blocks );
+
+         // don't read more than max_bytes_per_read at once unless a single block is larger
+         uint32_t read_last = batch_last;
+         while( read_last > batch_first && positions[read_last - batch_first + 1] - positions[0] > max_bytes_per_read )
+            --read_last;
+
+         const uint64_t start = positions[0];
+         buffer.resize( positions[read_last - batch_first + 1] - start );
+         block_file.seek( start );
+         block_file.read( buffer.data(), buffer.size() );
+
+         for( uint32_t n = batch_first; n <= read_last; ++n ) {
+            const uint64_t begin = positions[n - batch_first] - start;
+            const uint64_t end   = positions[n - batch_first + 1] - start - sizeof(uint64_t);
+            EOS_ASSERT( begin <= end && end <= buffer.size(), block_log_exception,
+                        "Invalid position for block ${n} in block log index", ("n", n) );
+            std::vector<char> packed_block = codec.enabled() ? codec.decompress( buffer.data() + begin, end - begin )
+                                                             : std::vector<char>( buffer.data() + begin, buffer.data() + end );
+            if( !cb( n, std::move( packed_block ) ) )
+               return;
+         }
+         batch_first = read_last + 1;
+      }
+   }
+
+   serialized_block_view block_log::read_serialized_block_by_num(uint32_t block_num)const {
+      if (my->not_generate_block_log)
+         return {};
+
+      if (auto qb = my->find_queued(block_num))
+         return {qb, std::string_view(qb->packed_block.data(), qb->packed_block.size())};
+
+      auto buffered = [](std::vector<char>&& packed_block) {
+         auto buffer = std::make_shared<std::vector<char>>(std::move(packed_block));
+         return serialized_block_view{buffer, std::string_view(buffer->data(), buffer->size())};
+      };
+
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
+      const uint64_t pos = get_block_pos(block_num);
+      if (pos == npos) {
+         const detail::block_log_part* part = block_num < my->first_block_num ? my->find_part(block_num) : nullptr;
+         if (!part)
+            return {};
+         my->part_blocks.open(*part);
+         return buffered(my->part_blocks.read_packed_block(block_num));
+      }
+
+      // every block is followed by its position in the log, the head block also by the block count of a pruned log
+      uint64_t end;
+      if (block_num < block_header::num_from_id(my->head_id)) {
+         end = my->get_block_pos(block_num + 1);
+      } else {
+         my->block_file.seek_end(0);
+         end = my->block_file.tellp();
+         if (my->prune_config)
+            end -= sizeof(uint32_t);
+      }
+      EOS_ASSERT( pos + sizeof(uint64_t) < end, block_log_exception,
+                  "Invalid position for block ${n} in block log index", ("n", block_num) );
+      end -= sizeof(uint64_t);
+
+      if (my->prune_config || my->codec->enabled()) {
+         // a pruned log punches holes over old blocks, so they are not viewed in place
+         std::vector<char> entry(end - pos);
+         my->block_file.seek(pos);
+         my->block_file.read(entry.data(), entry.size());
+         if (my->codec->enabled())
+            entry = my->codec->decompress(entry.data(), entry.size());
+         return buffered(std::move(entry));
+      }
+
+      const char* blocks = my->mapped_blocks(end);
+      return {my->block_mapping, std::string_view(blocks + pos, end - pos)};
+   }
+
    uint64_t detail::block_log_impl::get_block_pos(uint32_t block_num) {
       check_open_files();
       if (!(head && block_num <= block_header::num_from_id(head_id) && block_num >= first_block_num))
@@ -730,6 +1704,7 @@ namespace eosio { namespace chain {
       if (my->not_generate_block_log) {
          return block_log::npos;
       }
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
       return my->get_block_pos(block_num);
    }
 
@@ -738,6 +1713,7 @@ namespace eosio { namespace chain {
          return {};
       }
 
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
       my->check_open_files();
 
       uint64_t pos;
@@ -761,19 +1737,31 @@ namespace eosio { namespace chain {
       fc::raw::unpack(my->block_file, pos);
       if (pos != npos)
          return read_block(pos);
+
+      // blocks.log was begun after its head block was split off
+      if (!my->parts.empty()) {
+         auto last_block = std::make_shared<signed_block>();
+         my->unpack_from_part(my->parts.rbegin()->first, *last_block);
+         return last_block;
+      }
       return {};
    }
 
    const signed_block_ptr& block_log::head()const {
-      return my->head;
+      return my->writer.joinable() ? my->queued_head : my->head;
    }
 
    const block_id_type&    block_log::head_id()const {
-      return my->head_id;
+      return my->writer.joinable() ? my->queued_head_id : my->head_id;
    }
 
    uint32_t block_log::first_block_num() const {
-      return my->first_block_num;
+      std::lock_guard<std::recursive_mutex> g(my->file_mtx);
+      return my->first_readable_block();
+   }
+
+   const block_log_compression& block_log::compression() const {
+      return my->codec->compression();
    }
 
    void block_log::construct_index() {
@@ -797,7 +1785,7 @@ namespace eosio { namespace chain {
       my->reopen();
    } // construct_index
 
-   void block_log::construct_index(const fc::path& block_file_name, const fc::path& index_file_name) {
+   void block_log::construct_index(const fc::path& block_file_name, const fc::path& index_file_name, uint32_t num_threads) {
       detail::reverse_iterator block_log_iter;
 
       ilog("Will read existing blocks.log file ${file}", ("file", block_file_name.generic_string()));
@@ -815,6 +1803,21 @@ namespace eosio { namespace chain {
       ilog("first block= ${first}         last block= ${last}",
            ("first", block_log_iter.first_block_num())("last", (block_log_iter.first_block_num() + num_blocks)));
 
+      // the blocks of a pruned log are not all there to be found, it is walked from its end
+      if (!block_log_iter.is_pruned()) {
+         if (num_threads == 0)
+            num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+         try {
+            detail::index_builder builder(block_file_name, block_log_iter.first_block_num());
+            builder.build(index_file_name, num_threads);
+            return;
+         } catch (const block_log_exception& e) {
+            wlog("Could not reconstruct the index from parts of ${file} in parallel, reading it from its end: ${e}",
+                 ("file", block_file_name.generic_string())("e", e.to_string()));
+            fc::remove(index_file_name.generic_string() + ".partial");
+         }
+      }
+
       detail::index_writer index(index_file_name, num_blocks);
       uint64_t position;
       while ((position = block_log_iter.previous()) != npos) {
@@ -826,6 +1829,9 @@ namespace eosio { namespace chain {
       ilog("Recovering Block Log...");
       EOS_ASSERT( fc::is_directory(data_dir) && fc::is_regular_file(data_dir / "blocks.log"), block_log_not_found,
                  "Block log not found in '${blocks_dir}'", ("blocks_dir", data_dir)          );
+      EOS_ASSERT( detail::find_parts(data_dir).empty(), block_log_exception,
+                  "Block log in '${blocks_dir}' is split into parts, they must be merged into a single log to be repaired",
+                  ("blocks_dir", data_dir) );
 
       auto now = fc::time_point::now();
 
@@ -908,6 +1914,15 @@ namespace eosio { namespace chain {
                     ("file", (backup_dir / "blocks.log").generic_string())("ver", version)("fbn", first_block_num));
       }
 
+      block_log_compression compression;
+      if (version >= detail::compressed_version) {
+         fc::raw::unpack(old_block_stream, compression);
+
+         auto data = fc::raw::pack( compression );
+         new_block_stream.write( data.data(), data.size() );
+      }
+      detail::block_codec codec( compression );
+
       if (version != 1) {
          auto expected_totem = npos;
          std::decay_t<decltype(npos)> actual_totem;
@@ -929,13 +1944,25 @@ namespace eosio { namespace chain {
 
       uint64_t pos = old_block_stream.tellg();
       while( pos < end_pos ) {
-         signed_block tmp;
+         signed_block      tmp;
+         std::vector<char> entry;
 
          try {
-            fc::raw::unpack(old_block_stream, tmp);
+            if( codec.enabled() ) {
+               // a size past the end of the log is where it was truncated
+               entry = codec.read_entry( old_block_stream, end_pos - pos );
+               EOS_ASSERT( old_block_stream, block_log_exception, "Compressed block is incomplete" );
+               const auto packed_block = codec.decompress( entry.data(), entry.size() );
+               fc::datastream<const char*> ds( packed_block.data(), packed_block.size() );
+               fc::raw::unpack(ds, tmp);
+            } else {
+               fc::raw::unpack(old_block_stream, tmp);
+            }
          } catch( ... ) {
             except_ptr = std::current_exception();
             incomplete_block_data.resize( end_pos - pos );
+            old_block_stream.clear();
+            old_block_stream.seekg( pos );
             old_block_stream.read( incomplete_block_data.data(), incomplete_block_data.size() );
             break;
          }
@@ -962,7 +1989,7 @@ namespace eosio { namespace chain {
             break;
          }
 
-         auto data = fc::raw::pack(tmp);
+         auto data = codec.enabled() ? std::move(entry) : fc::raw::pack(tmp);
          new_block_stream.write( data.data(), data.size() );
          new_block_stream.write( reinterpret_cast<char*>(&pos), sizeof(pos) );
          block_num = tmp.block_num();
@@ -1235,6 +2262,153 @@ namespace eosio { namespace chain {
          ilog("blocks remaining to index: ${blocks_left}      position in log file: ${pos}", ("blocks_left", _blocks_remaining)("pos",pos));
    }
 
+   uint64_t detail::index_builder::_chunk_len = 1U << 26;
+
+   detail::index_builder::index_builder(const fc::path& block_file_name, uint32_t first_block_num)
+   : _block_file_name(block_file_name.generic_string())
+   , _file(_block_file_name.c_str(), boost::interprocess::read_only)
+   , _region(_file, boost::interprocess::read_only)
+   , _blocks(static_cast<const char*>(_region.get_address()))
+   , _end_of_blocks(_region.get_size())
+   , _first_block_num(first_block_num) {
+      const uint64_t head_pos_offset = _end_of_blocks - sizeof(uint64_t);
+      const uint64_t head_pos = read_pos(head_pos_offset);
+      EOS_ASSERT( head_pos >= min_block_pos && head_pos < head_pos_offset && head_pos_offset - head_pos >= min_block_size, block_log_exception,
+                  "Block log file at '${blocks_log}' indicates its last block at an invalid position ${pos}",
+                  ("blocks_log", _block_file_name)("pos", head_pos) );
+      _last_block_num = block_num_at(head_pos);
+   }
+
+   uint32_t detail::index_builder::block_num_at(uint64_t block_pos) const {
+      uint32_t previous_num; //big endian number of the previous block
+      memcpy(&previous_num, _blocks + block_pos + trim_data::blknum_offset, sizeof(previous_num));
+      return fc::endian_reverse_u32(previous_num) + 1;
+   }
+
+   // whether block block_num can start at block_pos and end before limit
+   bool detail::index_builder::is_block_at(uint64_t block_pos, uint32_t block_num, uint64_t limit) const {
+      return block_pos >= min_block_pos && block_pos < limit && limit - block_pos >= min_block_size &&
+             block_num_at(block_pos) == block_num;
+   }
+
+   // the number of the block followed by a position entry at pos_offset, if the bytes there are one
+   std::optional<uint32_t> detail::index_builder::block_ending_at(uint64_t pos_offset) const {
+      const uint64_t block_pos = read_pos(pos_offset);
+      if (block_pos < min_block_pos || block_pos >= pos_offset || pos_offset - block_pos < min_block_size)
+         return {};
+      const uint32_t block_num = block_num_at(block_pos);
+      if (block_num < _first_block_num || block_num > _last_block_num)
+         return {};
+      // the next block follows the position entry, bytes pointing to the start of some block are not enough
+      const uint64_t next_pos = pos_offset + sizeof(uint64_t);
+      if (block_num == _last_block_num) {
+         if (next_pos != _end_of_blocks)
+            return {};
+      } else if (_end_of_blocks - next_pos < min_block_size || block_num_at(next_pos) != block_num + 1) {
+         return {};
+      }
+      // the blocks before it each end right before the next one
+      uint64_t pos = block_pos;
+      for (uint32_t n = block_num; n > _first_block_num && block_num - n < chained_blocks; --n) {
+         const uint64_t previous_pos_offset = pos - sizeof(uint64_t);
+         pos = read_pos(previous_pos_offset);
+         if (!is_block_at(pos, n - 1, previous_pos_offset))
+            return {};
+      }
+      return block_num;
+   }
+
+   // the last block whose position entry starts in [begin, end)
+   std::optional<detail::index_builder::block_end> detail::index_builder::last_block_end(uint64_t begin, uint64_t end) const {
+      end = std::min(end, _end_of_blocks - sizeof(uint64_t) + 1);
+      for (uint64_t pos_offset = end; pos_offset-- > begin;) {
+         if (auto block_num = block_ending_at(pos_offset))
+            return block_end{pos_offset, *block_num};
+      }
+      return {};
+   }
+
+   void detail::index_builder::build(const fc::path& index_file_name, size_t num_threads) {
+      named_thread_pool thread_pool("index", num_threads);
+
+      const uint64_t num_chunks = (_end_of_blocks + _chunk_len - 1) / _chunk_len;
+      std::vector<std::optional<block_end>> chunk_ends(num_chunks);
+      parallel_for(thread_pool.get_executor(), num_chunks, [&](size_t chunk) {
+         chunk_ends[chunk] = last_block_end(chunk * _chunk_len, (chunk + 1) * _chunk_len);
+      });
+
+      // each range of blocks ends with a block found, the head block ends the last one
+      std::vector<block_end> ends;
+      for (const auto& e : chunk_ends) {
+         if (!e)
+            continue;
+         EOS_ASSERT( ends.empty() || e->block_num > ends.back().block_num, block_log_exception,
+                     "Block log file at '${blocks_log}' has block ${b} after block ${a}",
+                     ("blocks_log", _block_file_name)("a", ends.back().block_num)("b", e->block_num) );
+         ends.push_back(*e);
+      }
+      EOS_ASSERT( !ends.empty() && ends.back().pos_offset == _end_of_blocks - sizeof(uint64_t), block_log_exception,
+                  "Block log file at '${blocks_log}' does not end with its last block", ("blocks_log", _block_file_name) );
+
+      const fc::path partial_file_name = index_file_name.generic_string() + ".partial";
+      const uint64_t index_size = sizeof(uint64_t) * (_last_block_num - _first_block_num + 1);
+      const bool resuming = fc::exists(partial_file_name) && fc::file_size(partial_file_name) == index_size;
+      if (resuming) {
+         ilog("Resuming the reconstruction of ${index}", ("index", index_file_name.generic_string()));
+      } else {
+         fc::remove(partial_file_name);
+         fc::cfile file;
+         file.set_file_path(partial_file_name);
+         file.open(LOG_WRITE_C);
+         file.close();
+         fc::resize_file(partial_file_name, index_size);
+      }
+
+      {
+         boost::interprocess::file_mapping  index_file(partial_file_name.generic_string().c_str(), boost::interprocess::read_write);
+         boost::interprocess::mapped_region index_region(index_file, boost::interprocess::read_write);
+         uint64_t* const index = static_cast<uint64_t*>(index_region.get_address());
+         auto entry = [&](uint32_t block_num) -> uint64_t& { return index[block_num - _first_block_num]; };
+
+         std::atomic<size_t> ranges_indexed{0};
+         parallel_for(thread_pool.get_executor(), ends.size(), [&](size_t i) {
+            const uint32_t first_num = i ? ends[i-1].block_num + 1 : _first_block_num;
+            uint64_t pos_offset = ends[i].pos_offset;
+            if (resuming && entry(ends[i].block_num) == read_pos(pos_offset) &&
+                is_block_at(entry(first_num), first_num, pos_offset))
+               return;
+
+            uint64_t first_pos = 0;
+            for (uint32_t block_num = ends[i].block_num; ; --block_num) {
+               const uint64_t pos = read_pos(pos_offset);
+               EOS_ASSERT( is_block_at(pos, block_num, pos_offset), block_log_exception,
+                           "Block log file at '${blocks_log}' indicates block ${b} at position ${pos}, where it is not",
+                           ("blocks_log", _block_file_name)("b", block_num)("pos", pos) );
+               pos_offset = pos - sizeof(uint64_t);
+               if (block_num == first_num) {
+                  first_pos = pos;
+                  break;
+               }
+               entry(block_num) = pos;
+            }
+            EOS_ASSERT( i == 0 || pos_offset == ends[i-1].pos_offset, block_log_exception,
+                        "Block log file at '${blocks_log}' has block ${b} at two positions",
+                        ("blocks_log", _block_file_name)("b", ends[i-1].block_num) );
+
+            // the first entry of the range marks it as complete
+            const uint64_t range_offset = sizeof(uint64_t) * (first_num - _first_block_num);
+            index_region.flush(range_offset, sizeof(uint64_t) * (ends[i].block_num - first_num + 1), false);
+            entry(first_num) = first_pos;
+
+            const size_t indexed = ++ranges_indexed;
+            if (indexed % 1024 == 0)
+               ilog("indexed ${n} of ${t} ranges of blocks", ("n", indexed)("t", ends.size()));
+         });
+         index_region.flush(0, 0, false);
+      }
+      fc::rename(partial_file_name, index_file_name);
+   }
+
    bool block_log::contains_genesis_state(uint32_t version, uint32_t first_block_num) {
       return version <= 2 || first_block_num == 1;
    }
@@ -1288,9 +2462,9 @@ namespace eosio { namespace chain {
       new_block_file.close();
       new_block_file.open( LOG_RW_C );
 
-      static_assert( block_log::max_supported_version == 3,
-                     "Code was written to support version 3 format, need to update this code for latest format." );
-      uint32_t version = block_log::max_supported_version;
+      static_assert( block_log::max_supported_version == 4,
+                     "Code was written to support version 4 format, need to update this code for latest format." );
+      uint32_t version = detail::version_for(original_block_log.compression);
       new_block_file.seek(0);
       new_block_file.write((char*)&version, sizeof(version));
       new_block_file.write((char*)&start, sizeof(start));
@@ -1300,6 +2474,10 @@ namespace eosio { namespace chain {
       } else {
          fc::raw::pack(new_block_file, original_block_log.gs);
       }
+      // entries are copied as they are, so keep their compression
+      if (detail::is_compressed(original_block_log.compression)) {
+         fc::raw::pack(new_block_file, original_block_log.compression);
+      }
 
       // append a totem to indicate the division between blocks and header
       auto totem = block_log::npos;
@@ -1392,13 +2570,246 @@ namespace eosio { namespace chain {
       return true;
    }
 
-   trim_data::trim_data(fc::path block_dir) {
+   namespace {
+      uint64_t file_end(FILE* f, const fc::path& file_name) {
+         auto status = fseek(f, 0, SEEK_END);
+         EOS_ASSERT( status == 0, block_log_exception, "cannot seek to ${file} end", ("file", file_name.string()) );
+         return ftell(f);
+      }
+
+      // reads the entry of a block as stored in the log, from its position to the position of the next block, and
+      // checks it is followed by its position
+      std::vector<char> read_entry(trim_data& log, uint64_t pos, uint64_t next_pos) {
+         EOS_ASSERT( pos + sizeof(uint64_t) <= next_pos, block_log_exception,
+                     "Invalid block positions ${p} and ${n} in ${file}", ("p", pos)("n", next_pos)("file", log.index_file_name.string()) );
+         std::vector<char> entry(next_pos - pos - sizeof(uint64_t));
+         uint64_t trailer = 0;
+         if (static_cast<uint64_t>(ftell(log.blk_in)) != pos) {
+            auto status = fseek(log.blk_in, pos, SEEK_SET);
+            EOS_ASSERT( status == 0, block_log_exception, "cannot seek to ${file} ${pos}", ("file", log.block_file_name.string())("pos", pos) );
+         }
+         EOS_ASSERT( fread(entry.data(), entry.size(), 1, log.blk_in) == 1 && fread(&trailer, sizeof(trailer), 1, log.blk_in) == 1,
+                     block_log_exception, "${file} read fails", ("file", log.block_file_name.string()) );
+         EOS_ASSERT( trailer == pos, block_log_exception, "Block at ${pos} in ${file} is not followed by its position",
+                     ("pos", pos)("file", log.block_file_name.string()) );
+         return entry;
+      }
+
+      void create_log_file(fc::cfile& file, const fc::path& file_name) {
+         fc::remove(file_name);
+         file.set_file_path(file_name);
+         file.open( LOG_WRITE_C );
+      }
+
+      // writes the header of a log whose first block is first_block, of the chain of source
+      void write_log_header(fc::cfile& log, uint32_t first_block, const trim_data& source, const block_log_compression& compression) {
+         const uint32_t version = detail::version_for(compression);
+         log.write((char*)&version, sizeof(version));
+         log.write((char*)&first_block, sizeof(first_block));
+         if (block_log::contains_genesis_state(version, first_block)) {
+            EOS_ASSERT( source.first_block == 1, block_log_exception,
+                        "No genesis state in ${file} to begin a log with block 1", ("file", source.block_file_name.string()) );
+            fc::raw::pack(log, source.gs);
+         } else {
+            log << source.chain_id;
+         }
+         if (detail::is_compressed(compression)) {
+            fc::raw::pack(log, compression);
+         }
+         auto totem = block_log::npos;
+         log.write((char*)&totem, sizeof(totem));
+      }
+
+      bool same_compression(const block_log_compression& a, const block_log_compression& b) {
+         return a.algorithm == b.algorithm && a.dictionary == b.dictionary;
+      }
+
+      // appends blocks first through last of source to log and index, reading both files of source in order;
+      // entries are only recoded when the compressions differ
+      void copy_blocks(trim_data& source, detail::block_codec& decoder, uint32_t first, uint32_t last,
+                       fc::cfile& log, fc::cfile& index, detail::block_codec& encoder) {
+         if (first > last)
+            return;
+         const bool recode = !same_compression(decoder.compression(), encoder.compression());
+         const uint64_t end_of_blocks = file_end(source.blk_in, source.block_file_name);
+         auto status = fseek(source.ind_in, source.block_index(first), SEEK_SET);
+         EOS_ASSERT( status == 0, block_log_exception, "cannot seek to ${file} entry for block ${b}", ("file", source.index_file_name.string())("b", first) );
+         uint64_t pos;
+         auto size = fread((void*)&pos, sizeof(pos), 1, source.ind_in);
+         EOS_ASSERT( size == 1 && (first != source.first_block || pos == source.first_block_pos), block_log_exception,
+                     "${file} entry for block ${b} is invalid", ("file", source.index_file_name.string())("b", first) );
+         for (uint32_t n = first; n <= last; ++n) {
+            uint64_t next_pos = end_of_blocks;
+            if (n < source.last_block) {
+               size = fread((void*)&next_pos, sizeof(next_pos), 1, source.ind_in);
+               EOS_ASSERT( size == 1, block_log_exception, "cannot read ${file} entry for block ${b}", ("file", source.index_file_name.string())("b", n + 1) );
+            }
+
+            std::vector<char> entry = read_entry(source, pos, next_pos);
+            // the block number is at the same offset in compressed entries
+            EOS_ASSERT( entry.size() > trim_data::blknum_offset + sizeof(uint32_t), block_log_exception,
+                        "Block ${b} in ${file} is truncated", ("b", n)("file", source.block_file_name.string()) );
+            const uint32_t prior_blknum = fc::endian_reverse_u32(read_buffer<uint32_t>(entry.data() + trim_data::blknum_offset));
+            EOS_ASSERT( prior_blknum + 1 == n, block_log_exception, "At position ${pos} in ${file} expected to find ${exp_bnum} but found ${act_bnum}",
+                        ("pos", pos)("file", source.block_file_name.string())("exp_bnum", n)("act_bnum", prior_blknum + 1) );
+            if (recode) {
+               if (decoder.enabled())
+                  entry = decoder.decompress(entry.data(), entry.size());
+               if (encoder.enabled())
+                  entry = encoder.compress(entry.data(), entry.size());
+            }
+
+            const uint64_t new_pos = log.tellp();
+            log.write(entry.data(), entry.size());
+            log.write((char*)&new_pos, sizeof(new_pos));
+            index.write((char*)&new_pos, sizeof(new_pos));
+
+            if ((n & 0xfffff) == 0)
+               ilog("copied block ${n}, ${m} bytes written to ${file}", ("n", n)("m", new_pos)("file", log.get_file_path().generic_string()));
+            pos = next_pos;
+         }
+      }
+
+      // writes blocks first through last of source to a new log in block_file_name and index_file_name
+      void write_log(trim_data& source, detail::block_codec& decoder, uint32_t first, uint32_t last,
+                     const fc::path& block_file_name, const fc::path& index_file_name, detail::block_codec& encoder) {
+         fc::cfile log;
+         fc::cfile index;
+         create_log_file(log, block_file_name);
+         create_log_file(index, index_file_name);
+         write_log_header(log, first, source, encoder.compression());
+         copy_blocks(source, decoder, first, last, log, index, encoder);
+         log.flush();
+         index.flush();
+      }
+   }
+
+   void block_log::convert_log(const fc::path& block_dir, const fc::path& output_dir, const block_log_compression& compression) {
+      EOS_ASSERT( block_dir != output_dir, block_log_exception, "block_dir and output_dir need to be different directories" );
+      trim_data original_block_log(block_dir);
+      detail::block_codec decoder(original_block_log.compression);
+      detail::block_codec encoder(compression);
+      ilog("In directory ${output} will create new ${c} block log with blocks ${start}-${end}",
+           ("output", output_dir.generic_string())("c", encoder.enabled() ? "compressed" : "uncompressed")
+           ("start", original_block_log.first_block)("end", original_block_log.last_block));
+
+      fc::create_directories(output_dir);
+      const fc::path new_block_filename = output_dir / "blocks.log";
+      write_log(original_block_log, decoder, original_block_log.first_block, original_block_log.last_block,
+                new_block_filename, output_dir / "blocks.index", encoder);
+
+      ilog("Converted ${b} bytes of blocks.log into ${n} bytes",
+           ("b", fc::file_size(original_block_log.block_file_name))("n", fc::file_size(new_block_filename)));
+   }
+
+   void block_log::split_log(const fc::path& block_dir, const fc::path& output_dir, uint32_t stride) {
+      EOS_ASSERT( block_dir != output_dir, block_log_exception, "block_dir and output_dir need to be different directories" );
+      EOS_ASSERT( stride > 0, block_log_exception, "block log stride must be greater than 0" );
+      trim_data original_block_log(block_dir);
+      detail::block_codec decoder(original_block_log.compression);
+      detail::block_codec encoder(original_block_log.compression);
+      fc::create_directories(output_dir);
+
+      uint32_t first = original_block_log.first_block;
+      for (;;) {
+         // parts end at multiples of the stride
+         const uint64_t last = (uint64_t(first - 1) / stride + 1) * stride;
+         if (last > original_block_log.last_block)
+            break;
+         ilog("Writing blocks ${b}-${e}", ("b", first)("e", last));
+         write_log(original_block_log, decoder, first, last, detail::part_file_name(output_dir, first, last, ".log"),
+                   detail::part_file_name(output_dir, first, last, ".index"), encoder);
+         first = last + 1;
+      }
+      ilog("Writing blocks ${b}-${e} to blocks.log", ("b", first)("e", original_block_log.last_block));
+      write_log(original_block_log, decoder, first, original_block_log.last_block, output_dir / "blocks.log",
+                output_dir / "blocks.index", encoder);
+   }
+
+   void block_log::merge_logs(const fc::path& block_dir, const fc::path& output_dir) {
+      EOS_ASSERT( block_dir != output_dir, block_log_exception, "block_dir and output_dir need to be different directories" );
+      auto parts = detail::find_parts(block_dir);
+      std::sort(parts.begin(), parts.end(), [](const detail::block_log_part& a, const detail::block_log_part& b) {
+         return a.first_block < b.first_block;
+      });
+      trim_data current_log(block_dir);
+      detail::block_codec encoder(current_log.compression);
+      for (size_t i = 0; i < parts.size(); ++i) {
+         const uint32_t next_block = i + 1 < parts.size() ? parts[i + 1].first_block : current_log.first_block;
+         EOS_ASSERT( parts[i].last_block + 1 == next_block, block_log_exception,
+                     "Block log part ${p} is not followed by block ${n}",
+                     ("p", parts[i].block_file.generic_string())("n", parts[i].last_block + 1) );
+         if (!fc::exists(parts[i].index_file))
+            construct_index(parts[i].block_file, parts[i].index_file);
+      }
+
+      fc::create_directories(output_dir);
+      fc::cfile log;
+      fc::cfile index;
+      create_log_file(log, output_dir / "blocks.log");
+      create_log_file(index, output_dir / "blocks.index");
+      if (parts.empty()) {
+         write_log_header(log, current_log.first_block, current_log, encoder.compression());
+      } else {
+         trim_data first_part(parts.front().block_file, parts.front().index_file);
+         write_log_header(log, first_part.first_block, first_part, encoder.compression());
+      }
+      for (const auto& part : parts) {
+         ilog("Merging blocks ${b}-${e}", ("b", part.first_block)("e", part.last_block));
+         trim_data part_log(part.block_file, part.index_file);
+         detail::block_codec decoder(part_log.compression);
+         EOS_ASSERT( part_log.first_block == part.first_block && part_log.last_block == part.last_block, block_log_exception,
+                     "Block log part ${p} holds blocks ${b}-${e}",
+                     ("p", part.block_file.generic_string())("b", part_log.first_block)("e", part_log.last_block) );
+         copy_blocks(part_log, decoder, part.first_block, part.last_block, log, index, encoder);
+      }
+      detail::block_codec decoder(current_log.compression);
+      copy_blocks(current_log, decoder, current_log.first_block, current_log.last_block, log, index, encoder);
+      log.flush();
+      index.flush();
+   }
+
+   std::vector<char> block_log::sample_compression_dictionary(const fc::path& block_dir, size_t size) {
+      trim_data log(block_dir);
+      detail::block_codec decoder(log.compression);
+      std::vector<char> dictionary;
+      if (size == 0)
+         return dictionary;
+
+      // pieces of the transactions of blocks spread evenly across the log, the block headers are mostly hashes
+      // and signatures which nothing else repeats
+      constexpr uint32_t max_samples = 64;
+      const uint32_t num_blocks = log.last_block - log.first_block + 1;
+      const uint32_t samples = std::min(max_samples, num_blocks);
+      const size_t piece_size = std::max<size_t>(size / samples, 1);
+      const uint64_t end_of_blocks = file_end(log.blk_in, log.block_file_name);
+      for (uint32_t i = 0; i < samples && dictionary.size() < size; ++i) {
+         const uint32_t n = log.first_block + uint64_t(num_blocks) * i / samples;
+         const uint64_t pos = log.block_pos(n);
+         const uint64_t next_pos = n < log.last_block ? log.block_pos(n + 1) : end_of_blocks;
+         std::vector<char> packed_block = read_entry(log, pos, next_pos);
+         if (decoder.enabled())
+            packed_block = decoder.decompress(packed_block.data(), packed_block.size());
+
+         fc::datastream<const char*> ds(packed_block.data(), packed_block.size());
+         signed_block_header header;
+         fc::raw::unpack(ds, header);
+         const size_t begin = ds.tellp();
+         const size_t end = std::min({packed_block.size(), begin + piece_size, begin + size - dictionary.size()});
+         dictionary.insert(dictionary.end(), packed_block.data() + begin, packed_block.data() + end);
+      }
+      return dictionary;
+   }
+
+   trim_data::trim_data(fc::path block_dir)
+   : trim_data(block_dir / "blocks.log", block_dir / "blocks.index") {}
+
+   trim_data::trim_data(fc::path block_file, fc::path index_file)
+   : block_file_name(std::move(block_file)), index_file_name(std::move(index_file)) {
 
       // code should follow logic in block_log::repair_log
 
       using namespace std;
-      block_file_name = block_dir / "blocks.log";
-      index_file_name = block_dir / "blocks.index";
       blk_in = FC_FOPEN(block_file_name.generic_string().c_str(), "rb");
       EOS_ASSERT( blk_in != nullptr, block_log_not_found, "cannot read file ${file}", ("file",block_file_name.string()) );
       ind_in = FC_FOPEN(index_file_name.generic_string().c_str(), "rb");
@@ -1434,6 +2845,9 @@ namespace eosio { namespace chain {
                        "a genesis_state nor a chain_id.",
                        ("file", block_file_name.string())("ver", version)("first_block", first_block));
          }
+         if (version >= detail::compressed_version) {
+            fc::raw::unpack(ds, compression);
+         }
 
          const auto expected_totem = block_log::npos;
          std::decay_t<decltype(block_log::npos)> actual_totem;
@@ -1518,3 +2932,8 @@ namespace eosio { namespace chain {
 void block_log_set_buff_len(uint64_t len){
     eosio::chain::detail::reverse_iterator::_buf_len = len;
 }
+
+// used only for unit test to adjust the size of the chunks the index is reconstructed from
+void block_log_set_index_chunk_len(uint64_t len){
+    eosio::chain::detail::index_builder::_chunk_len = len;
+}
@@ -9,6 +9,7 @@
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/block_summary_object.hpp>
 #include <eosio/chain/eosio_contract.hpp>
+#include <eosio/chain/contract_types.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/protocol_state_object.hpp>
 #include <eosio/chain/contract_table_objects.hpp>
@@ -25,6 +26,10 @@
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/platform_timer.hpp>
 #include <eosio/chain/deep_mind.hpp>
+#include <eosio/chain/phase_timing.hpp>
+#include <eosio/chain/event_tracer.hpp>
+#include <eosio/chain/wasm_module_cache.hpp>
+#include <eosio/chain/multi_sha256.hpp>
 
 #include <chainbase/chainbase.hpp>
 #include <eosio/vm/allocator.hpp>
@@ -33,12 +38,46 @@
 #include <fc/scoped_exit.hpp>
 #include <fc/variant_object.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <new>
+#include <thread>
 
 namespace eosio { namespace chain {
 
 using resource_limits::resource_limits_manager;
 
+/**
+ *  State of a thread that executes read-only transactions concurrently with other read-only threads. Everything
+ *  that is mutated while running a contract must be local to the thread.
+ */
+struct read_only_thread_data {
+   read_only_thread_data( const controller& c, const controller::config& cfg, const chainbase::database& db, wasm_module_cache* module_cache )
+   :owner(&c)
+   ,wasmif( cfg.wasm_runtime, false, db, cfg.state_dir, cfg.eosvmoc_config, !cfg.profile_accounts.empty(), module_cache )
+   {}
+
+   // the wasm interface does not see setcode or irreversible blocks, catch up on them while the main thread waits
+   void current_lib( uint32_t lib, uint32_t head_block_num ) {
+      if( lib <= synced_lib )
+         return;
+      wasmif.removed_code_block_num_last_used( head_block_num + 1 );
+      wasmif.current_lib( lib );
+      synced_lib = lib;
+   }
+
+   const controller*  owner;
+   wasm_interface     wasmif;
+   platform_timer     timer;
+   uint32_t           synced_lib = 0;
+#if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
+   vm::wasm_allocator wasm_alloc;
+#endif
+};
+
+static thread_local std::unique_ptr<read_only_thread_data> read_only_thread;
+
 using controller_index_set = index_set<
    account_index,
    account_metadata_index,
@@ -207,6 +246,143 @@ struct pending_state {
    }
 };
 
+/**
+ *  Feeds the irreversible blocks of the block log to replay: a reader thread reads serialized blocks in large
+ *  sequential chunks while the chain thread pool unpacks them and, when authorizations are checked, recovers the keys
+ *  of their transactions. At most max_blocks_ahead blocks are read ahead of the one being applied.
+ */
+class replay_block_pipeline {
+public:
+   struct prepared_block {
+      signed_block_ptr block;
+      /// one entry per packed transaction of block, in order
+      std::vector<std::tuple<transaction_metadata_ptr, recover_keys_future>> trx_metas;
+      size_t next_lookup = 0;
+
+      /// for use as the trx_meta_cache_lookup of apply_block, which looks transactions up in block order
+      transaction_metadata_ptr lookup( const transaction_id_type& id ) {
+         for( size_t n = 0; n < trx_metas.size(); ++n ) {
+            const size_t i = (next_lookup + n) % trx_metas.size();
+            auto& [meta, fut] = trx_metas[i];
+            if( !meta && fut.valid() ) {
+               try {
+                  meta = fut.get();
+               } catch( ... ) {
+                  // apply_block recovers the keys again and reports the failure
+               }
+            }
+            if( meta && meta->id() == id ) {
+               next_lookup = i + 1;
+               return meta;
+            }
+         }
+         return {};
+      }
+   };
+   using prepared_block_ptr = std::shared_ptr<prepared_block>;
+
+   replay_block_pipeline( const block_log& blog, uint32_t first_block_num, uint32_t last_block_num, uint32_t max_blocks_ahead,
+                          boost::asio::io_context& thread_pool, const chain_id_type& chain_id, bool recover_keys )
+   :thread_pool( thread_pool )
+   ,chain_id( chain_id )
+   ,recover_keys( recover_keys )
+   ,max_blocks_ahead( max_blocks_ahead )
+   {
+      reader = std::thread( [this, &blog, first_block_num, last_block_num]() {
+         fc::set_os_thread_name( "replay" );
+         try {
+            blog.read_serialized_blocks( first_block_num, last_block_num, [this]( uint32_t, std::vector<char>&& packed_block ) {
+               std::unique_lock<std::mutex> g( mtx );
+               cond.wait( g, [this]() { return queue.size() < this->max_blocks_ahead || stopping; } );
+               if( stopping ) return false;
+               queue.emplace_back( async_thread_pool( this->thread_pool, [this, packed_block{std::move( packed_block )}]() {
+                  return prepare( packed_block );
+               } ) );
+               g.unlock();
+               cond.notify_all();
+               return true;
+            } );
+         } catch( ... ) {
+            std::lock_guard<std::mutex> g( mtx );
+            reader_except = std::current_exception();
+         }
+         {
+            std::lock_guard<std::mutex> g( mtx );
+            reader_done = true;
+         }
+         cond.notify_all();
+      } );
+   }
+
+   ~replay_block_pipeline() {
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         stopping = true;
+      }
+      cond.notify_all();
+      reader.join();
+      // blocks still being prepared reference this
+      for( auto& f : queue ) {
+         f.wait();
+      }
+   }
+
+   /// @return the next block in order, or nullptr after the last one; rethrows read and unpack failures
+   prepared_block_ptr next() {
+      std::future<prepared_block_ptr> f;
+      {
+         std::unique_lock<std::mutex> g( mtx );
+         cond.wait( g, [this]() { return !queue.empty() || reader_done; } );
+         if( queue.empty() ) {
+            if( reader_except ) std::rethrow_exception( reader_except );
+            return {};
+         }
+         f = std::move( queue.front() );
+         queue.pop_front();
+      }
+      cond.notify_all();
+      return f.get();
+   }
+
+private:
+   prepared_block_ptr prepare( const std::vector<char>& packed_block ) const {
+      auto b = std::make_shared<signed_block>();
+      fc::datastream<const char*> ds( packed_block.data(), packed_block.size() );
+      fc::raw::unpack( ds, *b );
+
+      auto result = std::make_shared<prepared_block>();
+      result->trx_metas.reserve( b->transactions.size() );
+      for( const auto& receipt : b->transactions ) {
+         if( std::holds_alternative<packed_transaction>( receipt.trx ) ) {
+            packed_transaction_ptr ptrx( b, &std::get<packed_transaction>( receipt.trx ) ); // alias signed_block_ptr
+            if( recover_keys ) {
+               result->trx_metas.emplace_back( transaction_metadata_ptr{},
+                     transaction_metadata::start_recover_keys( std::move( ptrx ), thread_pool, chain_id,
+                                                               fc::microseconds::maximum(), transaction_metadata::trx_type::input ) );
+            } else {
+               result->trx_metas.emplace_back(
+                     transaction_metadata::create_no_recover_keys( std::move( ptrx ), transaction_metadata::trx_type::input ),
+                     recover_keys_future{} );
+            }
+         }
+      }
+      result->block = std::move( b );
+      return result;
+   }
+
+   boost::asio::io_context&                    thread_pool;
+   const chain_id_type                         chain_id;
+   const bool                                  recover_keys;
+   const uint32_t                              max_blocks_ahead;
+   std::thread                                 reader;
+   std::mutex                                  mtx;
+   std::condition_variable                     cond;
+   std::deque<std::future<prepared_block_ptr>> queue;
+   std::exception_ptr                          reader_except;
+   bool                                        reader_done = false;
+   bool                                        stopping = false;
+};
+
 struct controller_impl {
 
    // LLVM sets the new handler, we need to reset this to throw a bad_alloc exception so we can possibly exit cleanly
@@ -223,6 +399,7 @@ struct controller_impl {
    std::optional<pending_state>    pending;
    block_state_ptr                 head;
    fork_database                   fork_db;
+   std::unique_ptr<wasm_module_cache> module_cache;
    wasm_interface                  wasmif;
    resource_limits_manager         resource_limits;
    authorization_manager           authorization;
@@ -238,6 +415,7 @@ struct controller_impl {
    named_thread_pool               thread_pool;
    platform_timer                  timer;
    deep_mind_handler*              deep_mind_logger = nullptr;
+   state_access_tracer*            access_tracer = nullptr;
    bool                            okay_to_print_integrity_hash_on_stop = false;
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
    vm::wasm_allocator               wasm_alloc;
@@ -291,9 +469,12 @@ struct controller_impl {
     db( cfg.state_dir,
         cfg.read_only ? database::read_only : database::read_write,
         cfg.state_size, false, cfg.db_map_mode ),
-    blog( cfg.blocks_dir, cfg.prune_config ),
+    blog( cfg.blocks_dir, cfg.prune_config, cfg.split_config ),
     fork_db( cfg.blocks_dir / config::reversible_blocks_dir_name ),
-    wasmif( cfg.wasm_runtime, cfg.eosvmoc_tierup, db, cfg.state_dir, cfg.eosvmoc_config, !cfg.profile_accounts.empty() ),
+    module_cache( cfg.wasm_module_cache_size && !cfg.read_only
+                  ? std::make_unique<wasm_module_cache>( cfg.state_dir / "wasm_module_cache.bin", cfg.wasm_module_cache_size )
+                  : nullptr ),
+    wasmif( cfg.wasm_runtime, cfg.eosvmoc_tierup, db, cfg.state_dir, cfg.eosvmoc_config, !cfg.profile_accounts.empty(), module_cache.get() ),
     resource_limits( db, [&s]() { return s.get_deep_mind_logger(); }),
     authorization( s, db ),
     protocol_features( std::move(pfs), [&s]() { return s.get_deep_mind_logger(); } ),
@@ -308,6 +489,9 @@ struct controller_impl {
                            { check_protocol_features( timestamp, cur_features, new_features ); }
       );
 
+      if( cfg.block_log_queue_size > 0 )
+         blog.start_async_append( cfg.block_log_queue_size );
+
       set_activation_handler<builtin_protocol_feature_t::preactivate_feature>();
       set_activation_handler<builtin_protocol_feature_t::replace_deferred>();
       set_activation_handler<builtin_protocol_feature_t::get_sender>();
@@ -385,6 +569,15 @@ struct controller_impl {
    void log_irreversible() {
       EOS_ASSERT( fork_db.root(), fork_database_exception, "fork database not properly initialized" );
 
+      if( blog.write_failed() ) {
+         // the fork database root is past the blocks the block log writer failed to write, they are written again
+         // when the block log is flushed on shutdown
+         elog( "block log writer failed to write irreversible blocks, shutting down" );
+         if( shutdown )
+            shutdown();
+         EOS_THROW( block_log_append_fail, "block log writer failed to write irreversible blocks" );
+      }
+
       const auto& log_head = blog.head();
 
       auto lib_num = log_head ? log_head->block_num() : (blog.first_block_num() - 1);
@@ -425,7 +618,11 @@ struct controller_impl {
 
             // blog.append could fail due to failures like running out of space.
             // Do it before commit so that in case it throws, DB can be rolled back.
-            blog.append( (*bitr)->block, (*bitr)->id, it->get() );
+            // When blocks are queued for the block log writer, the failure is thrown by a following append.
+            {
+               scoped_phase_timer timer( timing_phase::block_log_append );
+               blog.append( (*bitr)->block, (*bitr)->id, it->get() );
+            }
             ++it;
 
             db.commit( (*bitr)->block_num );
@@ -493,12 +690,25 @@ struct controller_impl {
          ilog( "existing block log, attempting to replay from ${s} to ${n} blocks",
                ("s", start_block_num)("n", blog_head->block_num()) );
          try {
-            while( auto next = blog.read_block_by_num( head->block_num + 1 ) ) {
-               replay_push_block( next, controller::block_status::irreversible );
-               if( check_shutdown() ) break;
+            auto replay_irreversible_block = [&]( const signed_block_ptr& next, const trx_meta_cache_lookup& trx_lookup ) {
+               replay_push_block( next, controller::block_status::irreversible, trx_lookup );
+               if( check_shutdown() ) return false;
                if( next->block_num() % 500 == 0 ) {
                   ilog( "${n} of ${head}", ("n", next->block_num())("head", blog_head->block_num()) );
                }
+               return true;
+            };
+            if( conf.replay_read_ahead_blocks > 0 && start_block_num >= blog.first_block_num() ) {
+               replay_block_pipeline pipeline( blog, start_block_num, blog_head->block_num(), conf.replay_read_ahead_blocks,
+                                               thread_pool.get_executor(), chain_id, conf.force_all_checks );
+               while( auto next = pipeline.next() ) {
+                  if( !replay_irreversible_block( next->block, [&next]( const transaction_id_type& id ) { return next->lookup( id ); } ) )
+                     break;
+               }
+            } else {
+               while( auto next = blog.read_block_by_num( head->block_num + 1 ) ) {
+                  if( !replay_irreversible_block( next, trx_meta_cache_lookup{} ) ) break;
+               }
             }
          } catch(  const database_guard_exception& e ) {
             except_ptr = std::current_exception();
@@ -742,6 +952,10 @@ struct controller_impl {
    ~controller_impl() {
       thread_pool.stop();
       pending.reset();
+      // irreversible blocks still queued for the block log are written before the fork database is closed
+      try {
+         blog.flush();
+      } FC_LOG_AND_DROP();
       //only log this not just if configured to, but also if initialization made it to the point we'd log the startup too
       if(okay_to_print_integrity_hash_on_stop && conf.integrity_hash_on_stop)
          ilog( "chain database stopped with hash: ${hash}", ("hash", calculate_integrity_hash()) );
@@ -1481,14 +1695,18 @@ struct controller_impl {
                                            fc::microseconds max_transaction_time,
                                            uint32_t billed_cpu_time_us,
                                            bool explicit_billed_cpu_time,
-                                           int64_t subjective_cpu_bill_us )
+                                           int64_t subjective_cpu_bill_us,
+                                           bool auth_prechecked = false )
    {
       EOS_ASSERT(block_deadline != fc::time_point(), transaction_exception, "deadline cannot be uninitialized");
+      const bool on_read_only_thread = self.is_read_only_thread();
+      EOS_ASSERT(!on_read_only_thread || trx->read_only, transaction_exception,
+                 "only read-only transactions can be pushed from a read-only thread");
 
       transaction_trace_ptr trace;
       try {
          auto start = fc::time_point::now();
-         const bool check_auth = !self.skip_auth_check() && !trx->implicit;
+         const bool check_auth = !self.skip_auth_check() && !trx->implicit && !auth_prechecked;
          const fc::microseconds sig_cpu_usage = trx->signature_cpu_usage();
 
          if( !explicit_billed_cpu_time ) {
@@ -1502,8 +1720,8 @@ struct controller_impl {
          }
 
          const signed_transaction& trn = trx->packed_trx()->get_signed_transaction();
-         transaction_checktime_timer trx_timer(timer);
-         transaction_context trx_context(self, *trx->packed_trx(), std::move(trx_timer), start, trx->read_only);
+         transaction_checktime_timer trx_timer(on_read_only_thread ? read_only_thread->timer : timer);
+         transaction_context trx_context(self, *trx->packed_trx(), std::move(trx_timer), start, trx->read_only, on_read_only_thread);
          if ((bool)subjective_cpu_leeway && pending->_block_status == controller::block_status::incomplete) {
             trx_context.leeway = *subjective_cpu_leeway;
          }
@@ -1549,6 +1767,16 @@ struct controller_impl {
             trx_context.exec();
             trx_context.finalize(); // Automatically rounds up network and CPU usage in trace and bills payers if successful
 
+            if( on_read_only_thread ) {
+               // nothing was written, and the pending block must not be touched from this thread
+               transaction_receipt_header r;
+               r.status = transaction_receipt::executed;
+               r.cpu_usage_us = trx_context.billed_cpu_time_us;
+               r.net_usage_words = trace->net_usage / 8;
+               trace->receipt = r;
+               return trace;
+            }
+
             auto restore = make_block_restore_point();
 
             if (!trx->implicit) {
@@ -1787,22 +2015,25 @@ struct controller_impl {
       EOS_ASSERT( pending, block_validate_exception, "it is not valid to finalize when there is no pending block");
       EOS_ASSERT( std::holds_alternative<building_block>(pending->_block_stage), block_validate_exception, "already called finalize_block");
 
+      scoped_phase_timer timer( timing_phase::block_finalize );
+      scoped_trace_event trace_event( "chain", "finalize_block" );
       try {
 
       auto& pbhs = pending->get_pending_block_header_state();
 
       auto& bb = std::get<building_block>(pending->_block_stage);
 
+      // large blocks have the levels of their merkle trees hashed in parallel on the thread pool as well
       auto action_merkle_fut = async_thread_pool( thread_pool.get_executor(),
-                                                  [ids{std::move( bb._action_receipt_digests )}]() mutable {
-                                                     return merkle( std::move( ids ) );
+                                                  [ids{std::move( bb._action_receipt_digests )}, &pool=thread_pool.get_executor()]() mutable {
+                                                     return merkle( std::move( ids ), pool );
                                                   } );
       const bool calc_trx_merkle = !std::holds_alternative<checksum256_type>(bb._trx_mroot_or_receipt_digests);
       std::future<checksum256_type> trx_merkle_fut;
       if( calc_trx_merkle ) {
          trx_merkle_fut = async_thread_pool( thread_pool.get_executor(),
-                                             [ids{std::move( std::get<digests_t>(bb._trx_mroot_or_receipt_digests) )}]() mutable {
-                                                return merkle( std::move( ids ) );
+                                             [ids{std::move( std::get<digests_t>(bb._trx_mroot_or_receipt_digests) )}, &pool=thread_pool.get_executor()]() mutable {
+                                                return merkle( std::move( ids ), pool );
                                              } );
       }
 
@@ -1859,6 +2090,7 @@ struct controller_impl {
     * @post regardless of the success of commit block there is no active pending block
     */
    void commit_block( bool add_to_fork_db ) {
+      scoped_trace_event trace_event( "chain", "commit_block" );
       auto reset_pending_on_exit = fc::make_scoped_exit([this]{
          pending.reset();
       });
@@ -1979,6 +2211,62 @@ struct controller_impl {
    }
 
 
+   /**
+    *  Result of checking the authorizations of a block's input transactions against the state at the start of the
+    *  block. A result only holds for as long as nothing the check depends on has been modified by the transactions
+    *  applied before it; otherwise the transaction is checked again when it is applied.
+    */
+   struct parallel_auth_check {
+      std::vector<char> satisfied; // one per input transaction, char so it can be written concurrently
+      uint64_t          authorization_revision = 0;
+      uint32_t          max_transaction_delay = 0;
+      uint16_t          max_authority_depth = 0;
+
+      bool is_satisfied( size_t idx, const controller_impl& impl )const {
+         const auto& cfg = impl.self.get_global_properties().configuration;
+         return satisfied.at( idx ) && authorization_revision == impl.authorization.revision()
+                && max_transaction_delay == cfg.max_transaction_delay && max_authority_depth == cfg.max_authority_depth;
+      }
+   };
+
+   // Checks the authorizations of trxs on the thread pool. The calling thread waits for the checks to complete so the
+   // chain state is not modified while they run.
+   parallel_auth_check check_authorizations( const std::vector<transaction_metadata_ptr>& trxs ) {
+      const auto& cfg = self.get_global_properties().configuration;
+      parallel_auth_check result;
+      result.satisfied.resize( trxs.size(), 0 );
+      result.authorization_revision = authorization.revision();
+      result.max_transaction_delay = cfg.max_transaction_delay;
+      result.max_authority_depth = cfg.max_authority_depth;
+
+      const size_t num_tasks = std::min<size_t>( conf.thread_pool_size, trxs.size() );
+      std::vector<std::future<void>> tasks;
+      tasks.reserve( num_tasks );
+      for( size_t t = 0; t < num_tasks; ++t ) {
+         tasks.emplace_back( async_thread_pool( thread_pool.get_executor(), [this, &trxs, &result, t, num_tasks]() {
+            for( size_t i = t; i < trxs.size(); i += num_tasks ) {
+               const signed_transaction& trn = trxs[i]->packed_trx()->get_signed_transaction();
+               // canceldelay authorization depends on deferred transactions that may be created earlier in the block
+               const bool cancels_delay = std::any_of( trn.actions.begin(), trn.actions.end(), []( const action& a ) {
+                  return a.account == config::system_account_name && a.name == canceldelay::get_name();
+               } );
+               if( cancels_delay )
+                  continue;
+               try {
+                  authorization.check_authorization( trn.actions, trxs[i]->recovered_keys(), {}, fc::seconds(trn.delay_sec) );
+                  result.satisfied[i] = 1;
+               } catch( ... ) {
+                  // checked again when applied, which reports the failure
+               }
+            }
+         } ) );
+      }
+      for( auto& t : tasks ) {
+         t.get();
+      }
+      return result;
+   }
+
    void apply_block( controller::block_report& br, const block_state_ptr& bsp, controller::block_status s,
                      const trx_meta_cache_lookup& trx_lookup )
    { try {
@@ -2024,6 +2312,24 @@ struct controller_impl {
             }
          }
 
+         std::optional<parallel_auth_check> prechecked_auths;
+         if( conf.parallel_auth_validation && !skip_auth_checks ) {
+            const size_t num_packed_trxs = use_bsp_cached ? bsp->trxs_metas().size() : trx_metas.size();
+            std::vector<transaction_metadata_ptr> packed_trxs;
+            packed_trxs.reserve( num_packed_trxs );
+            for( size_t i = 0; i < num_packed_trxs; ++i ) {
+               if( use_bsp_cached ) {
+                  packed_trxs.push_back( bsp->trxs_metas().at( i ) );
+               } else {
+                  auto& [meta, fut] = trx_metas.at( i );
+                  if( !meta ) meta = fut.get();
+                  packed_trxs.push_back( meta );
+               }
+            }
+            if( packed_trxs.size() > 1 )
+               prechecked_auths = check_authorizations( packed_trxs );
+         }
+
          transaction_trace_ptr trace;
 
          size_t packed_idx = 0;
@@ -2035,7 +2341,10 @@ struct controller_impl {
                                                        : ( !!std::get<0>( trx_metas.at( packed_idx ) ) ?
                                                              std::get<0>( trx_metas.at( packed_idx ) )
                                                              : std::get<1>( trx_metas.at( packed_idx ) ).get() ) );
-               trace = push_transaction( trx_meta, fc::time_point::maximum(), fc::microseconds::maximum(), receipt.cpu_usage_us, true, 0 );
+               const bool auth_prechecked = prechecked_auths && prechecked_auths->is_satisfied( packed_idx, *this );
+               trace = push_transaction( trx_meta, fc::time_point::maximum(), fc::microseconds::maximum(), receipt.cpu_usage_us, true, 0, auth_prechecked );
+               if( auth_prechecked )
+                  ++br.total_auth_prechecked_trxs;
                ++packed_idx;
             } else if( std::holds_alternative<transaction_id_type>(receipt.trx) ) {
                trace = push_scheduled_transaction( std::get<transaction_id_type>(receipt.trx), fc::time_point::maximum(), fc::microseconds::maximum(), receipt.cpu_usage_us, true );
@@ -2106,7 +2415,50 @@ struct controller_impl {
       }
    } FC_CAPTURE_AND_RETHROW() } /// apply_block
 
-   std::future<block_state_ptr> create_block_state_future( const block_id_type& id, const signed_block_ptr& b ) {
+   /**
+    *  Starts recovering the keys of every packed transaction of a received block on the thread pool, except for
+    *  transactions whose keys were already recovered when they were received on their own: those of the pending block
+    *  and those found with trx_lookup. Returns nothing when the block's authorizations will not be checked.
+    */
+   std::vector<std::tuple<transaction_metadata_ptr, recover_keys_future>>
+   start_recover_block_keys( const signed_block_ptr& b, const trx_meta_cache_lookup& trx_lookup ) {
+      std::vector<std::tuple<transaction_metadata_ptr, recover_keys_future>> result;
+      if( conf.block_validation_mode == validation_mode::LIGHT || self.is_trusted_producer( b->producer ) )
+         return result;
+
+      std::map<transaction_id_type, transaction_metadata_ptr> pending_trx_metas;
+      if( pending && std::holds_alternative<building_block>( pending->_block_stage ) ) {
+         for( const auto& meta : std::get<building_block>( pending->_block_stage )._pending_trx_metas ) {
+            pending_trx_metas.emplace( meta->id(), meta );
+         }
+      }
+
+      result.reserve( b->transactions.size() );
+      for( const auto& receipt : b->transactions ) {
+         if( !std::holds_alternative<packed_transaction>( receipt.trx ) ) continue;
+         const auto& pt = std::get<packed_transaction>( receipt.trx );
+         transaction_metadata_ptr meta;
+         if( auto itr = pending_trx_metas.find( pt.id() ); itr != pending_trx_metas.end() )
+            meta = itr->second;
+         else if( trx_lookup )
+            meta = trx_lookup( pt.id() );
+         if( meta && ( *meta->packed_trx() != pt || meta->recovered_keys().empty() ) )
+            meta = nullptr;
+
+         if( meta ) {
+            result.emplace_back( std::move( meta ), recover_keys_future{} );
+         } else {
+            packed_transaction_ptr ptrx( b, &pt ); // alias signed_block_ptr
+            result.emplace_back( transaction_metadata_ptr{},
+                                 transaction_metadata::start_recover_keys( std::move( ptrx ), thread_pool.get_executor(), chain_id,
+                                                                           microseconds::maximum(), transaction_metadata::trx_type::input ) );
+         }
+      }
+      return result;
+   }
+
+   std::future<block_state_ptr> create_block_state_future( const block_id_type& id, const signed_block_ptr& b,
+                                                           const trx_meta_cache_lookup& trx_lookup ) {
       EOS_ASSERT( b, block_validate_exception, "null block" );
 
       // no reason for a block_state if fork_db already knows about block
@@ -2117,10 +2469,13 @@ struct controller_impl {
       EOS_ASSERT( prev, unlinkable_block_exception,
                   "unlinkable block ${id}", ("id", id)("previous", b->previous) );
 
-      return async_thread_pool( thread_pool.get_executor(), [b, prev, id, control=this]() {
+      // posted to the thread pool before the task below, so waiting on them from it cannot starve the pool
+      auto trx_metas = start_recover_block_keys( b, trx_lookup );
+
+      return async_thread_pool( thread_pool.get_executor(), [b, prev, id, control=this, trx_metas{std::move( trx_metas )}]() mutable {
          const bool skip_validate_signee = false;
 
-         auto trx_mroot = calculate_trx_merkle( b->transactions );
+         auto trx_mroot = calculate_trx_merkle( b->transactions, control->thread_pool.get_executor() );
          EOS_ASSERT( b->transaction_mroot == trx_mroot, block_validate_exception,
                      "invalid block transaction merkle root ${b} != ${c}", ("b", b->transaction_mroot)("c", trx_mroot) );
 
@@ -2137,6 +2492,18 @@ struct controller_impl {
 
          EOS_ASSERT( id == bsp->id, block_validate_exception,
                      "provided id ${id} does not match block id ${bid}", ("id", id)("bid", bsp->id) );
+
+         if( !trx_metas.empty() ) {
+            try {
+               deque<transaction_metadata_ptr> metas;
+               for( auto& [meta, fut] : trx_metas ) {
+                  metas.emplace_back( meta ? std::move( meta ) : fut.get() );
+               }
+               bsp->set_trxs_metas( std::move( metas ), true );
+            } catch( ... ) {
+               // apply_block recovers the keys again and reports the failure
+            }
+         }
          return bsp;
       } );
    }
@@ -2180,7 +2547,7 @@ struct controller_impl {
       } FC_LOG_AND_RETHROW( )
    }
 
-   void replay_push_block( const signed_block_ptr& b, controller::block_status s ) {
+   void replay_push_block( const signed_block_ptr& b, controller::block_status s, const trx_meta_cache_lookup& trx_lookup = {} ) {
       self.validate_db_available_size();
 
       EOS_ASSERT(!pending, block_validate_exception, "it is not valid to push a block when there is a pending block");
@@ -2218,7 +2585,7 @@ struct controller_impl {
 
          controller::block_report br;
          if( s == controller::block_status::irreversible ) {
-            apply_block( br, bsp, s, trx_meta_cache_lookup{} );
+            apply_block( br, bsp, s, trx_lookup );
             head = bsp;
 
             // On replay, log_irreversible is not called and so no irreversible_block signal is emitted.
@@ -2336,12 +2703,20 @@ struct controller_impl {
       return applied_trxs;
    }
 
-   static checksum256_type calculate_trx_merkle( const deque<transaction_receipt>& trxs ) {
-      deque<digest_type> trx_digests;
+   static checksum256_type calculate_trx_merkle( const deque<transaction_receipt>& trxs, boost::asio::io_context& thread_pool ) {
+      // the receipt digests are independent, they are computed many at once
+      vector<vector<char>> digest_inputs;
+      digest_inputs.reserve( trxs.size() );
       for( const auto& a : trxs )
-         trx_digests.emplace_back( a.digest() );
+         digest_inputs.push_back( a.digest_input() );
+      vector<std::string_view> messages;
+      messages.reserve( digest_inputs.size() );
+      for( const auto& input : digest_inputs )
+         messages.emplace_back( input.data(), input.size() );
+      vector<digest_type> trx_digests( messages.size() );
+      multi_sha256( messages.data(), messages.size(), trx_digests.data() );
 
-      return merkle( move(trx_digests) );
+      return merkle( deque<digest_type>( trx_digests.begin(), trx_digests.end() ), thread_pool );
    }
 
    void update_producers_authority() {
@@ -2864,8 +3239,9 @@ boost::asio::io_context& controller::get_thread_pool() {
    return my->thread_pool.get_executor();
 }
 
-std::future<block_state_ptr> controller::create_block_state_future( const block_id_type& id, const signed_block_ptr& b ) {
-   return my->create_block_state_future( id, b );
+std::future<block_state_ptr> controller::create_block_state_future( const block_id_type& id, const signed_block_ptr& b,
+                                                                    const trx_meta_cache_lookup& trx_lookup ) {
+   return my->create_block_state_future( id, b, trx_lookup );
 }
 
 void controller::push_block( controller::block_report& br,
@@ -3066,6 +3442,16 @@ signed_block_ptr controller::fetch_block_by_number( uint32_t block_num )const  {
    return my->blog.read_block_by_num(block_num);
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
+serialized_block_view controller::fetch_serialized_block_by_number( uint32_t block_num )const  { try {
+   auto blk_state = fetch_block_state_by_number( block_num );
+   if( blk_state ) {
+      auto packed_block = std::make_shared<std::vector<char>>( fc::raw::pack( *blk_state->block ) );
+      return { packed_block, std::string_view( packed_block->data(), packed_block->size() ) };
+   }
+
+   return my->blog.read_serialized_block_by_num(block_num);
+} FC_CAPTURE_AND_RETHROW( (block_num) ) }
+
 block_state_ptr controller::fetch_block_state_by_id( block_id_type id )const {
    auto state = my->fork_db.get_block(id);
    return state;
@@ -3283,9 +3669,24 @@ const apply_handler* controller::find_apply_handler( account_name receiver, acco
    return nullptr;
 }
 wasm_interface& controller::get_wasm_interface() {
+   if( is_read_only_thread() )
+      return read_only_thread->wasmif;
    return my->wasmif;
 }
 
+void controller::init_read_only_thread() {
+   if( !is_read_only_thread() ) {
+      EOS_ASSERT( my->conf.wasm_runtime != wasm_interface::vm_type::eos_vm_oc, misc_exception,
+                  "read-only threads are not supported with the eos-vm-oc runtime" );
+      read_only_thread = std::make_unique<read_only_thread_data>( *this, my->conf, my->db, my->module_cache.get() );
+   }
+   read_only_thread->current_lib( last_irreversible_block_num(), head_block_num() );
+}
+
+bool controller::is_read_only_thread()const {
+   return read_only_thread && read_only_thread->owner == this;
+}
+
 const account_object& controller::get_account( account_name name )const
 { try {
    return my->db.get<account_object, by_name>(name);
@@ -3447,6 +3848,14 @@ deep_mind_handler* controller::get_deep_mind_logger()const {
    return my->get_deep_mind_logger();
 }
 
+state_access_tracer* controller::get_state_access_tracer()const {
+   return my->access_tracer;
+}
+
+void controller::set_state_access_tracer(state_access_tracer* tracer) {
+   my->access_tracer = tracer;
+}
+
 void controller::enable_deep_mind(deep_mind_handler* logger) {
    EOS_ASSERT( logger != nullptr, misc_exception, "Invalid logger passed into enable_deep_mind, must be set" );
    my->deep_mind_logger = logger;
@@ -3457,6 +3866,8 @@ uint32_t controller::earliest_available_block_num() const{
 }
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
 vm::wasm_allocator& controller::get_wasm_allocator() {
+   if( is_read_only_thread() )
+      return read_only_thread->wasm_alloc;
    return my->wasm_alloc;
 }
 #endif
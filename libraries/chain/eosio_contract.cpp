@@ -68,6 +68,10 @@ void apply_eosio_newaccount(apply_context& context) {
    auto create = context.get_action().data_as<newaccount>();
    try {
    context.require_authorization(create.creator);
+   if( context.access_tracer ) {
+      context.access_tracer->on_account_read( create.creator );
+      context.access_tracer->on_account_write( create.name );
+   }
 //   context.require_write_lock( config::eosio_auth_scope );
    auto& authorization = context.control.get_mutable_authorization_manager();
 
@@ -132,6 +136,8 @@ void apply_eosio_setcode(apply_context& context) {
    auto& db = context.db;
    auto  act = context.get_action().data_as<setcode>();
    context.require_authorization(act.account);
+   if( context.access_tracer )
+      context.access_tracer->on_account_write( act.account );
 
    EOS_ASSERT( act.vmtype == 0, invalid_contract_vm_type, "code should be 0" );
    EOS_ASSERT( act.vmversion == 0, invalid_contract_vm_version, "version should be 0" );
@@ -216,6 +222,8 @@ void apply_eosio_setabi(apply_context& context) {
    auto  act = context.get_action().data_as<setabi>();
 
    context.require_authorization(act.account);
+   if( context.access_tracer )
+      context.access_tracer->on_account_write( act.account );
 
    const auto& account = db.get<account_object,by_name>(act.account);
 
@@ -253,6 +261,8 @@ void apply_eosio_updateauth(apply_context& context) {
 
    auto update = context.get_action().data_as<updateauth>();
    context.require_authorization(update.account); // only here to mark the single authority on this action as used
+   if( context.access_tracer )
+      context.access_tracer->on_account_write( update.account );
 
    auto& authorization = context.control.get_mutable_authorization_manager();
    auto& db = context.db;
@@ -326,6 +336,8 @@ void apply_eosio_deleteauth(apply_context& context) {
 
    auto remove = context.get_action().data_as<deleteauth>();
    context.require_authorization(remove.account); // only here to mark the single authority on this action as used
+   if( context.access_tracer )
+      context.access_tracer->on_account_write( remove.account );
 
    EOS_ASSERT(remove.permission != config::active_name, action_validate_exception, "Cannot delete active authority");
    EOS_ASSERT(remove.permission != config::owner_name, action_validate_exception, "Cannot delete owner authority");
@@ -364,6 +376,8 @@ void apply_eosio_linkauth(apply_context& context) {
       EOS_ASSERT(!requirement.requirement.empty(), action_validate_exception, "Required permission cannot be empty");
 
       context.require_authorization(requirement.account); // only here to mark the single authority on this action as used
+      if( context.access_tracer )
+         context.access_tracer->on_account_write( requirement.account );
 
       auto& db = context.db;
       const auto *account = db.find<account_object, by_name>(requirement.account);
@@ -389,6 +403,7 @@ void apply_eosio_linkauth(apply_context& context) {
       auto link_key = boost::make_tuple(requirement.account, requirement.code, requirement.type);
       auto link = db.find<permission_link_object, by_action_name>(link_key);
 
+      context.control.get_mutable_authorization_manager().increment_revision();
       if( link ) {
          EOS_ASSERT(link->required_permission != requirement.requirement, action_validate_exception,
                     "Attempting to update required authority, but new requirement is same as old");
@@ -423,10 +438,13 @@ void apply_eosio_unlinkauth(apply_context& context) {
    auto unlink = context.get_action().data_as<unlinkauth>();
 
    context.require_authorization(unlink.account); // only here to mark the single authority on this action as used
+   if( context.access_tracer )
+      context.access_tracer->on_account_write( unlink.account );
 
    auto link_key = boost::make_tuple(unlink.account, unlink.code, unlink.type);
    auto link = db.find<permission_link_object, by_action_name>(link_key);
    EOS_ASSERT(link != nullptr, action_validate_exception, "Attempting to unlink authority, but no link found");
+   context.control.get_mutable_authorization_manager().increment_revision();
 
    if (auto dm_logger = context.control.get_deep_mind_logger()) {
       dm_logger->on_ram_trace(RAM_EVENT_ID("${id}", ("id", link->id)), "auth_link", "remove", "unlinkauth");
@@ -443,6 +461,9 @@ void apply_eosio_unlinkauth(apply_context& context) {
 void apply_eosio_canceldelay(apply_context& context) {
    auto cancel = context.get_action().data_as<canceldelay>();
    context.require_authorization(cancel.canceling_auth.actor); // only here to mark the single authority on this action as used
+   // the deferred transaction cancelled was authorized by the canceling actor
+   if( context.access_tracer )
+      context.access_tracer->on_account_write( cancel.canceling_auth.actor );
 
    const auto& trx_id = cancel.trx_id;
 
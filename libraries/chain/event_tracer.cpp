@@ -0,0 +1,170 @@
+#include <eosio/chain/event_tracer.hpp>
+
+#include <fc/variant_object.hpp>
+
+#include <pthread.h>
+
+namespace eosio { namespace chain {
+
+namespace {
+   thread_local void* this_thread_buffer = nullptr;
+
+   std::string current_thread_name() {
+      char name[64] = {};
+      if( pthread_getname_np( pthread_self(), name, sizeof(name) ) != 0 )
+         return {};
+      return name;
+   }
+}
+
+event_tracer& event_tracer::instance() {
+   static event_tracer tracer;
+   return tracer;
+}
+
+void event_tracer::set_buffer_size( size_t buffer_size ) {
+   std::lock_guard g( _buffers_mtx );
+   _enabled.store( false, std::memory_order_relaxed );
+   _buffer_size = buffer_size;
+   for( auto& b : _buffers ) {
+      std::lock_guard bg( b->mtx );
+      b->events.clear();
+      b->events.shrink_to_fit();
+      b->events.resize( buffer_size );
+      b->next = 0;
+      b->wrapped = false;
+   }
+   _enabled.store( buffer_size > 0, std::memory_order_relaxed );
+}
+
+size_t event_tracer::buffer_size()const {
+   std::lock_guard g( _buffers_mtx );
+   return _buffer_size;
+}
+
+event_tracer::thread_buffer& event_tracer::buffer_for_this_thread() {
+   if( !this_thread_buffer ) {
+      auto b = std::make_unique<thread_buffer>();
+      b->thread_name = current_thread_name();
+      std::lock_guard g( _buffers_mtx );
+      b->tid = _buffers.size() + 1;
+      b->events.resize( _buffer_size );
+      this_thread_buffer = b.get();
+      _buffers.emplace_back( std::move( b ) );
+   }
+   return *static_cast<thread_buffer*>( this_thread_buffer );
+}
+
+void event_tracer::record( const event& e ) {
+   auto& b = buffer_for_this_thread();
+   std::lock_guard g( b.mtx );
+   if( b.events.empty() )
+      return;
+   b.events[b.next] = e;
+   if( ++b.next == b.events.size() ) {
+      b.next = 0;
+      b.wrapped = true;
+   }
+}
+
+void event_tracer::complete( const char* category, const char* name, clock::time_point start, clock::time_point end,
+                             const char* arg_name, int64_t arg ) {
+   if( !enabled() )
+      return;
+   event e;
+   e.category = category;
+   e.name     = name;
+   e.arg_name = arg_name;
+   e.arg      = arg;
+   e.ts_ns    = since_epoch_ns( start );
+   e.dur_ns   = std::chrono::duration_cast<std::chrono::nanoseconds>( end - start ).count();
+   record( e );
+}
+
+event_tracer::handoff event_tracer::start_handoff( const char* name ) {
+   if( !enabled() )
+      return {};
+   handoff h{ _next_flow_id.fetch_add( 1, std::memory_order_relaxed ), clock::now() };
+   event e;
+   e.category = "handoff";
+   e.name     = name;
+   e.ts_ns    = since_epoch_ns( h.posted );
+   e.flow_id  = h.id;
+   e.phase    = 's';
+   record( e );
+   return h;
+}
+
+void event_tracer::end_handoff( const handoff& h, const char* name ) {
+   if( !h.id || !enabled() )
+      return;
+   const auto now = clock::now();
+   // the wait is recorded first so that the flow end binds to it
+   complete( "handoff", name, h.posted, now );
+   event e;
+   e.category = "handoff";
+   e.name     = name;
+   e.ts_ns    = since_epoch_ns( now );
+   e.flow_id  = h.id;
+   e.phase    = 'f';
+   record( e );
+}
+
+fc::variant event_tracer::get_trace( bool clear ) {
+   struct thread_events {
+      uint32_t           tid;
+      std::string        thread_name;
+      std::vector<event> events;
+   };
+   // the events are only copied while a thread's buffer is locked, they are formatted once no recording waits on it
+   std::vector<thread_events> threads;
+   {
+      std::lock_guard g( _buffers_mtx );
+      threads.reserve( _buffers.size() );
+      for( const auto& b : _buffers ) {
+         auto& t = threads.emplace_back( thread_events{ b->tid, b->thread_name, {} } );
+         std::lock_guard bg( b->mtx );
+         if( b->wrapped )
+            t.events.insert( t.events.end(), b->events.begin() + b->next, b->events.end() );
+         t.events.insert( t.events.end(), b->events.begin(), b->events.begin() + b->next );
+         if( clear ) {
+            b->next = 0;
+            b->wrapped = false;
+         }
+      }
+   }
+
+   fc::variants events;
+   for( const auto& t : threads ) {
+      events.emplace_back( fc::mutable_variant_object()
+                           ( "name", "thread_name" )( "ph", "M" )( "pid", 1 )( "tid", t.tid )
+                           ( "args", fc::mutable_variant_object()( "name", t.thread_name ) ) );
+      for( const auto& e : t.events ) {
+         fc::mutable_variant_object o;
+         o( "name", e.name )( "cat", e.category )( "ph", std::string( 1, e.phase ) )
+          ( "ts", e.ts_ns / 1000.0 )( "pid", 1 )( "tid", t.tid );
+         if( e.phase == 'X' )
+            o( "dur", e.dur_ns / 1000.0 );
+         if( e.flow_id ) {
+            o( "id", e.flow_id );
+            if( e.phase == 'f' )
+               o( "bp", "e" );
+         }
+         if( e.arg_name )
+            o( "args", fc::mutable_variant_object()( e.arg_name, e.arg ) );
+         events.emplace_back( std::move( o ) );
+      }
+   }
+   return fc::variant( fc::mutable_variant_object()( "traceEvents", std::move( events ) )( "displayTimeUnit", "ms" ) );
+}
+
+void event_tracer::clear() {
+   std::lock_guard g( _buffers_mtx );
+   for( auto& b : _buffers ) {
+      std::lock_guard bg( b->mtx );
+      b->next = 0;
+      b->wrapped = false;
+   }
+}
+
+} } // eosio::chain
@@ -1,5 +1,6 @@
 #include <eosio/chain/fork_database.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/phase_timing.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -334,6 +335,7 @@ namespace eosio { namespace chain {
    }
 
    void fork_database::add( const block_state_ptr& n, bool ignore_duplicate ) {
+      scoped_phase_timer timer( timing_phase::fork_db_insert );
       my->add( n, ignore_duplicate, false,
                []( block_timestamp_type timestamp,
                    const flat_set<digest_type>& cur_features,
@@ -542,6 +542,8 @@ namespace impl {
          mvo("account_ram_deltas", act_trace.account_ram_deltas);
          mvo("except", act_trace.except);
          mvo("error_code", act_trace.error_code);
+         if (!act_trace.intrinsic_usage.empty())
+            mvo("intrinsic_usage", act_trace.intrinsic_usage);
 
          mvo("return_value_hex_data", act_trace.return_value);
          auto act = act_trace.act;
@@ -3,6 +3,8 @@
 #include <eosio/chain/transaction.hpp>
 #include <eosio/chain/contract_table_objects.hpp>
 #include <eosio/chain/deep_mind.hpp>
+#include <eosio/chain/state_access_tracer.hpp>
+#include <eosio/chain/intrinsic_usage.hpp>
 #include <fc/utility.hpp>
 #include <sstream>
 #include <algorithm>
@@ -177,6 +179,7 @@ class apply_context {
             int store( uint64_t scope, uint64_t table, const account_name& payer,
                        uint64_t id, secondary_key_proxy_const_type value )
             {
+               context.check_writable();
                EOS_ASSERT( payer != account_name(), invalid_table_payer, "must specify a valid account to pay for new record" );
 
 //               context.require_write_lock( scope );
@@ -211,10 +214,13 @@ class apply_context {
             }
 
             void remove( int iterator ) {
+               context.check_writable();
                const auto& obj = itr_cache.get( iterator );
 
                const auto& table_obj = itr_cache.get_table( obj.t_id );
                EOS_ASSERT( table_obj.code == context.receiver, table_access_violation, "db access violation" );
+               if( context.access_tracer )
+                  context.access_tracer->on_table_write( table_obj.code, table_obj.scope, table_obj.table );
 
                if (auto dm_logger = context.control.get_deep_mind_logger()) {
                   std::string event_id = RAM_EVENT_ID("${code}:${scope}:${table}:${index_name}",
@@ -243,10 +249,13 @@ class apply_context {
             }
 
             void update( int iterator, account_name payer, secondary_key_proxy_const_type secondary ) {
+               context.check_writable();
                const auto& obj = itr_cache.get( iterator );
 
                const auto& table_obj = itr_cache.get_table( obj.t_id );
                EOS_ASSERT( table_obj.code == context.receiver, table_access_violation, "db access violation" );
+               if( context.access_tracer )
+                  context.access_tracer->on_table_write( table_obj.code, table_obj.scope, table_obj.table );
 
 //               context.require_write_lock( table_obj.scope );
 
@@ -553,6 +562,12 @@ class apply_context {
 
       void update_db_usage( const account_name& payer, int64_t delta );
 
+      /**
+       * Throws read_only_thread_write_exception if executing on a read-only thread, where there is no
+       * undo session to revert a modification of the database.
+       */
+      void check_writable()const;
+
       int  db_store_i64( name scope, name table, const account_name& payer, uint64_t id, const char* buffer, size_t buffer_size );
       void db_update_i64( int iterator, account_name payer, const char* buffer, size_t buffer_size );
       void db_remove_i64( int iterator );
@@ -601,6 +616,7 @@ class apply_context {
       controller&                   control;
       chainbase::database&          db;  ///< database where state is stored
       transaction_context&          trx_context; ///< transaction context in which the action is running
+      state_access_tracer* const    access_tracer; ///< trx_context.access_tracer, nullptr when state accesses are not traced
 
    private:
       const action*                 act = nullptr; ///< action being applied
@@ -614,6 +630,7 @@ class apply_context {
 
    public:
       std::vector<char>             action_return_value;
+      std::unique_ptr<intrinsic_usage_counters> intrinsic_usage; ///< set while host function usage accounting is enabled
       generic_index<index64_object>                                  idx64;
       generic_index<index128_object>                                 idx128;
       generic_index<index256_object, uint128_t*, const uint128_t*>   idx256;
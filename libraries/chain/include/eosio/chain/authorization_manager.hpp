@@ -47,6 +47,13 @@ namespace eosio { namespace chain {
 
          void update_permission_usage( const permission_object& permission );
 
+         /**
+          * Incremented whenever a permission or permission link is created, modified or removed. Allows detecting
+          * whether an authorization check done against an earlier state still holds. Not part of the chain state.
+          */
+         uint64_t revision()const { return _revision; }
+         void     increment_revision() { ++_revision; }
+
          fc::time_point get_permission_last_used( const permission_object& permission )const;
 
          const permission_object*  find_permission( const permission_level& level )const;
@@ -118,6 +125,7 @@ namespace eosio { namespace chain {
       private:
          const controller&    _control;
          chainbase::database& _db;
+         uint64_t             _revision = 0;
 
          void             check_updateauth_authorization( const updateauth& update, const vector<permission_level>& auths )const;
          void             check_deleteauth_authorization( const deleteauth& del, const vector<permission_level>& auths )const;
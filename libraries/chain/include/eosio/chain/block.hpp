@@ -40,15 +40,34 @@ namespace eosio { namespace chain {
 
       digest_type digest()const {
          digest_type::encoder enc;
-         fc::raw::pack( enc, status );
-         fc::raw::pack( enc, cpu_usage_us );
-         fc::raw::pack( enc, net_usage_words );
-         if( std::holds_alternative<transaction_id_type>(trx) )
-            fc::raw::pack( enc, std::get<transaction_id_type>(trx) );
-         else
-            fc::raw::pack( enc, std::get<packed_transaction>(trx).packed_digest() );
+         pack_digest_input( enc, trx_digest() );
          return enc.result();
       }
+
+      /// what digest() hashes, for the digests of many receipts to be computed at once
+      vector<char> digest_input()const {
+         // status, cpu_usage_us, net_usage_words of at most 5 bytes and the transaction digest
+         vector<char> input( sizeof(uint8_t) + sizeof(uint32_t) + 5 + sizeof(digest_type) );
+         fc::datastream<char*> ds( input.data(), input.size() );
+         pack_digest_input( ds, trx_digest() );
+         input.resize( ds.tellp() );
+         return input;
+      }
+
+   private:
+      digest_type trx_digest()const {
+         if( std::holds_alternative<transaction_id_type>(trx) )
+            return std::get<transaction_id_type>(trx);
+         return std::get<packed_transaction>(trx).packed_digest();
+      }
+
+      template<typename Stream>
+      void pack_digest_input( Stream& s, const digest_type& trx_id_or_digest )const {
+         fc::raw::pack( s, status );
+         fc::raw::pack( s, cpu_usage_us );
+         fc::raw::pack( s, net_usage_words );
+         fc::raw::pack( s, trx_id_or_digest );
+      }
    };
 
    struct additional_block_signatures_extension : fc::reflect_init {
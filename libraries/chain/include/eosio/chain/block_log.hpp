@@ -3,6 +3,8 @@
 #include <eosio/chain/block.hpp>
 #include <eosio/chain/genesis_state.hpp>
 
+#include <string_view>
+
 namespace eosio { namespace chain {
 
    namespace detail { class block_log_impl; }
@@ -34,24 +36,80 @@ namespace eosio { namespace chain {
     * An optional "pruned" mode can be activated which stores a 4 byte trailer on the log file indicating
     * how many blocks at the end of the log are valid. Any earlier blocks in the log are assumed destroyed
     * and unreadable due to reclamation for purposes of saving space.
+    *
+    * A compressed log (version 4) stores its block_log_compression in the header, before the totem, and each
+    * block as a self-contained entry in place of its serialization:
+    *
+    * +------------------------------+-------------+-------------------+-----------------------------+
+    * | First 46 bytes of the block  | Packed size | Compressed size   | Rest of the block, deflated |
+    * +------------------------------+-------------+-------------------+-----------------------------+
+    *
+    * The first 46 bytes (timestamp, producer, confirmed and previous) are kept as is so the block number can be
+    * read from an entry exactly as from an uncompressed block. Positions and the index file are unchanged, so
+    * blocks remain accessible at random; reading one decompresses only its own entry.
+    *
+    * A split log is made of blocks.log and parts, each a complete log with its own index, named after the range of
+    * blocks it holds: blocks-<first block>-<last block>.log and .index. Whenever the head block number becomes a
+    * multiple of the stride, blocks.log and blocks.index are renamed to a part and a new blocks.log starting at the
+    * next block is begun. Only the latest parts are retained next to blocks.log, older ones are moved to the archive
+    * directory, where they remain readable, or deleted when there is none.
+    *
+    * Appending may be handed to a writer thread (see start_async_append), in which case blocks are queued and written
+    * in batches, each flushed once. Queued blocks are already the head and are read from the queue until written.
     */
 
+   struct block_log_compression {
+      enum class algorithm_type {
+         none = 0,
+         zlib = 1,
+      };
+
+      fc::enum_type<uint8_t,algorithm_type> algorithm = algorithm_type::none;
+      std::vector<char>                     dictionary; //preset dictionary of every entry, typically sampled from the log
+   };
+
    struct block_log_prune_config {
       uint32_t                prune_blocks;                  //number of blocks to prune to when doing a prune
       size_t                  prune_threshold = 4*1024*1024; //(approximately) how many bytes need to be added before a prune is performed
       std::optional<size_t>   vacuum_on_close;               //when set, a vacuum is performed on dtor if log contains less than this many live bytes
    };
 
+   struct block_log_split_config {
+      uint32_t                stride = std::numeric_limits<uint32_t>::max();             //number of blocks in each part
+      uint32_t                max_retained_files = std::numeric_limits<uint32_t>::max(); //number of parts kept next to blocks.log
+      fc::path                archive_dir;                                               //where older parts are moved, they are deleted when empty
+   };
+
+   /// the serialization of a block, whose bytes stay valid as long as owner is held
+   struct serialized_block_view {
+      std::shared_ptr<const void> owner;
+      std::string_view            data;
+
+      explicit operator bool()const { return !data.empty(); }
+   };
+
    class block_log {
       public:
-         block_log(const fc::path& data_dir, std::optional<block_log_prune_config> prune_config);
+         block_log(const fc::path& data_dir, std::optional<block_log_prune_config> prune_config,
+                   std::optional<block_log_split_config> split_config = {});
          block_log(block_log&& other);
          ~block_log();
 
          void append(const signed_block_ptr& b, const block_id_type& id);
          void append(const signed_block_ptr& b, const block_id_type& id, const std::vector<char>& packed_block);
 
-         void flush();
+         /**
+          * From now on, appended blocks are queued and written on a thread of the block log, up to max_queued_blocks
+          * wait to be written before append blocks. When writing fails, the files are rolled back to the last block
+          * written, which becomes the head again, and the failure is rethrown by the following appends until flush
+          * writes the failed blocks. They are retried once more when the block log is destroyed.
+          */
+         void start_async_append(uint32_t max_queued_blocks);
+
+         /// the writer failed to write queued blocks, which have not been written since
+         bool write_failed() const;
+
+         void flush(); // waits for queued blocks to be written
          void reset( const genesis_state& gs, const signed_block_ptr& genesis_block );
          void reset( const chain_id_type& chain_id, uint32_t first_block_num );
          void remove(); // remove blocks.log and blocks.index
@@ -64,6 +122,21 @@ namespace eosio { namespace chain {
             return read_block_by_num(block_header::num_from_id(id));
          }
 
+         /**
+          * Reads the serialized blocks first_block_num through last_block_num in order, in large sequential chunks,
+          * calling cb with each; stops early if cb returns false. Uses its own file handles so it can run on another
+          * thread as long as the log is not appended to or modified in the meantime.
+          */
+         void read_serialized_blocks( uint32_t first_block_num, uint32_t last_block_num,
+                                      const std::function<bool(uint32_t block_num, std::vector<char>&& packed_block)>& cb )const;
+
+         /**
+          * Returns the serialized block block_num without unpacking it, or an empty view if it is not in the log.
+          * Blocks of blocks.log are viewed in place through a read-only memory mapping of the file, which the view
+          * keeps alive; the blocks of compressed and pruned logs and of parts are read into a buffer instead.
+          */
+         serialized_block_view read_serialized_block_by_num(uint32_t block_num)const;
+
          /**
           * Return offset of block in file, or block_log::npos if it does not exist.
           */
@@ -72,6 +145,7 @@ namespace eosio { namespace chain {
          const signed_block_ptr& head()const;
          const block_id_type&    head_id()const;
          uint32_t                first_block_num() const;
+         const block_log_compression& compression() const;
 
          static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
@@ -84,7 +158,11 @@ namespace eosio { namespace chain {
 
          static chain_id_type extract_chain_id( const fc::path& data_dir );
 
-         static void construct_index(const fc::path& block_file_name, const fc::path& index_file_name);
+         /**
+          * Writes the index of the log in block_file_name, finding the blocks of a log which is not pruned on num_threads
+          * threads, all cores when 0. An interrupted reconstruction of the same index is resumed.
+          */
+         static void construct_index(const fc::path& block_file_name, const fc::path& index_file_name, uint32_t num_threads = 0);
 
          static bool contains_genesis_state(uint32_t version, uint32_t first_block_num);
 
@@ -96,6 +174,28 @@ namespace eosio { namespace chain {
 
          static bool extract_block_range(const fc::path& block_dir, const fc::path&output_dir, block_num_type& start, block_num_type& end, bool rename_input=false);
 
+         /**
+          * Writes the blocks of the log in block_dir to a new log in output_dir, compressed as given, or uncompressed
+          * when the algorithm is none. The log in block_dir must not be pruned.
+          */
+         static void convert_log(const fc::path& block_dir, const fc::path& output_dir, const block_log_compression& compression);
+
+         /**
+          * Returns a preset dictionary of up to size bytes made of pieces of blocks sampled across the log in block_dir.
+          */
+         static std::vector<char> sample_compression_dictionary(const fc::path& block_dir, size_t size);
+
+         /**
+          * Splits the log in block_dir into parts of stride blocks written to output_dir, in the layout of a split
+          * log; the blocks after the last multiple of stride are left in blocks.log. The log must not be pruned.
+          */
+         static void split_log(const fc::path& block_dir, const fc::path& output_dir, uint32_t stride);
+
+         /**
+          * Joins the parts in block_dir and the blocks.log following them into a single log written to output_dir.
+          */
+         static void merge_logs(const fc::path& block_dir, const fc::path& output_dir);
+
    private:
          void open(const fc::path& data_dir);
          void construct_index();
@@ -111,6 +211,7 @@ namespace eosio { namespace chain {
 
    struct trim_data {            //used by trim_blocklog_front(), trim_blocklog_end(), and smoke_test()
       trim_data(fc::path block_dir);
+      trim_data(fc::path block_file, fc::path index_file);
       ~trim_data();
       uint64_t block_index(uint32_t n) const;
       uint64_t block_pos(uint32_t n);
@@ -124,7 +225,11 @@ namespace eosio { namespace chain {
       uint64_t first_block_pos = 0;                      //file position in blocks.log for the first block in the log
       genesis_state gs;
       chain_id_type chain_id;
+      block_log_compression compression;
 
       static constexpr int blknum_offset{14};            //offset from start of block to 4 byte block number, valid for the only allowed versions
    };
 } }
+
+FC_REFLECT_ENUM( eosio::chain::block_log_compression::algorithm_type, (none)(zlib) )
+FC_REFLECT( eosio::chain::block_log_compression, (algorithm)(dictionary) )
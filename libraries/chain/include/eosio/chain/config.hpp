@@ -80,6 +80,9 @@ const static uint16_t   default_max_auth_depth                       = 6;
 const static uint32_t   default_sig_cpu_bill_pct                     = 50 * percent_1; // billable percentage of signature recovery
 const static uint32_t   default_block_cpu_effort_pct                 = 80 * percent_1; // percentage of block time used for producing block
 const static uint16_t   default_controller_thread_pool_size          = 2;
+const static uint32_t   default_replay_read_ahead_blocks             = 256;
+const static uint32_t   default_recovered_key_cache_size             = 64 * 1024; // public keys recovered from signatures kept for reuse
+const static uint64_t   default_wasm_module_cache_size               = 256*1024*1024ull; // parsed modules persisted across restarts
 const static uint32_t   default_max_variable_signature_length        = 16384u;
 const static uint32_t   default_max_nonprivileged_inline_action_size = 4 * 1024; // 4 KB
 const static uint32_t   default_max_action_return_value_size         = 256;
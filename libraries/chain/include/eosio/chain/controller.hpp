@@ -39,6 +39,7 @@ namespace eosio { namespace chain {
    class permission_object;
    class account_object;
    class deep_mind_handler;
+   class state_access_tracer;
    using resource_limits::resource_limits_manager;
    using apply_handler = std::function<void(apply_context&)>;
    using forked_branch_callback = std::function<void(const branch_type&)>;
@@ -71,15 +72,19 @@ namespace eosio { namespace chain {
             flat_set<public_key_type> key_blacklist;
             path                     blocks_dir             =  chain::config::default_blocks_dir_name;
             std::optional<block_log_prune_config>  prune_config;
+            std::optional<block_log_split_config>  split_config;
+            uint32_t                 block_log_queue_size   =  0; //< blocks queued for the block log writer thread, 0 to append on the calling thread
             path                     state_dir              =  chain::config::default_state_dir_name;
             uint64_t                 state_size             =  chain::config::default_state_size;
             uint64_t                 state_guard_size       =  chain::config::default_state_guard_size;
             uint32_t                 sig_cpu_bill_pct       =  chain::config::default_sig_cpu_bill_pct;
             uint16_t                 thread_pool_size       =  chain::config::default_controller_thread_pool_size;
+            uint32_t                 replay_read_ahead_blocks = chain::config::default_replay_read_ahead_blocks; //< blocks read and prepared on other threads ahead of the one being replayed, 0 to read them inline
             uint32_t   max_nonprivileged_inline_action_size =  chain::config::default_max_nonprivileged_inline_action_size;
             bool                     read_only              =  false;
             bool                     force_all_checks       =  false;
             bool                     disable_replay_opts    =  false;
+            bool                     parallel_auth_validation = false; //< check authorizations of a received block's transactions on the thread pool before applying them
             bool                     contracts_console      =  false;
             bool                     allow_ram_billing_in_notify = false;
             uint32_t                 maximum_variable_signature_length = chain::config::default_max_variable_signature_length;
@@ -91,6 +96,7 @@ namespace eosio { namespace chain {
             wasm_interface::vm_type  wasm_runtime = chain::config::default_wasm_runtime;
             eosvmoc::config          eosvmoc_config;
             bool                     eosvmoc_tierup         = false;
+            uint64_t                 wasm_module_cache_size = chain::config::default_wasm_module_cache_size; //< 0 disables the wasm module cache
 
             db_read_mode             read_mode              = db_read_mode::SPECULATIVE;
             validation_mode          block_validation_mode  = validation_mode::FULL;
@@ -156,6 +162,18 @@ namespace eosio { namespace chain {
                                                  uint32_t billed_cpu_time_us, bool explicit_billed_cpu_time,
                                                  int64_t subjective_cpu_bill_us );
 
+         /**
+          * Prepares the calling thread to execute read-only transactions via push_transaction() concurrently with
+          * other read-only threads. Each such thread gets its own wasm runtime, checktime timer and allocator.
+          * Transactions pushed from a read-only thread must be read-only, are executed without an undo session and
+          * are not added to the pending block; the caller must guarantee the main thread does not modify state while
+          * they run. Not supported with the eos-vm-oc runtime. Calling it again on the same thread, which must also be
+          * done while the main thread does not modify state, evicts the modules cached by the thread which are no longer
+          * used as of the LIB.
+          */
+         void init_read_only_thread();
+         bool is_read_only_thread()const;
+
          /**
           * Attempt to execute a specific transaction in our deferred trx database
           *
@@ -168,13 +186,19 @@ namespace eosio { namespace chain {
          void sign_block( const signer_callback_type& signer_callback );
          void commit_block();
 
-         std::future<block_state_ptr> create_block_state_future( const block_id_type& id, const signed_block_ptr& b );
+         /**
+          * Validates the block header and recovers the keys of the block's transactions on the thread pool
+          * @param trx_lookup user provided lookup function for externally cached transaction_metadata whose recovered keys are reused
+          */
+         std::future<block_state_ptr> create_block_state_future( const block_id_type& id, const signed_block_ptr& b,
+                                                                 const trx_meta_cache_lookup& trx_lookup = {} );
 
          struct block_report {
             size_t             total_net_usage = 0;
             size_t             total_cpu_usage_us = 0;
             fc::microseconds   total_elapsed_time{};
             fc::microseconds   total_time{};
+            size_t             total_auth_prechecked_trxs = 0; //< applied without a serial authorization check, see parallel_auth_validation
          };
          /**
           * @param br returns statistics for block
@@ -249,6 +273,8 @@ namespace eosio { namespace chain {
          time_point last_irreversible_block_time() const;
 
          signed_block_ptr fetch_block_by_number( uint32_t block_num )const;
+         /// serialized block, irreversible blocks are viewed straight from the block log without unpacking them
+         serialized_block_view fetch_serialized_block_by_number( uint32_t block_num )const;
          signed_block_ptr fetch_block_by_id( block_id_type id )const;
 
          block_state_ptr fetch_block_state_by_number( uint32_t block_num )const;
@@ -317,6 +343,8 @@ namespace eosio { namespace chain {
 
          deep_mind_handler* get_deep_mind_logger() const;
          void enable_deep_mind( deep_mind_handler* logger );
+         state_access_tracer* get_state_access_tracer() const;
+         void set_state_access_tracer( state_access_tracer* tracer ); ///< nullptr to stop tracing
          uint32_t earliest_available_block_num() const;
 
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <fc/variant.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+/**
+ *  Opt-in, in-process tracer of the block production loop and of the handoffs of work between threads. Events are
+ *  recorded into a fixed size ring buffer per thread, so tracing never allocates or blocks on other threads, and the
+ *  most recent events are dumped in the Chrome trace event format which chrome://tracing and Perfetto load.
+ *
+ *  Event names, categories and argument names must be string literals, or otherwise outlive the tracer.
+ */
+class event_tracer {
+public:
+   using clock = std::chrono::steady_clock;
+
+   /// work posted from one thread to be run on another, see start_handoff()
+   struct handoff {
+      uint64_t          id = 0; ///< 0 when tracing was disabled when posted
+      clock::time_point posted;
+   };
+
+   static event_tracer& instance();
+
+   bool enabled()const { return _enabled.load( std::memory_order_relaxed ); }
+
+   /// enables tracing keeping the last buffer_size events of each thread, 0 disables tracing and drops all events
+   void set_buffer_size( size_t buffer_size );
+   size_t buffer_size()const;
+
+   /// records a slice of the calling thread from start to end
+   void complete( const char* category, const char* name, clock::time_point start, clock::time_point end,
+                  const char* arg_name = nullptr, int64_t arg = 0 );
+
+   /// records the posting of work on the calling thread, pass the result to end_handoff() on the thread running it
+   handoff start_handoff( const char* name );
+
+   /// records the link to the posting thread and the time the work waited to run on the calling thread
+   void end_handoff( const handoff& h, const char* name );
+
+   /// @return the recorded events as a Chrome trace event format JSON object
+   /// @param clear drop the returned events, those recorded while dumping are kept
+   fc::variant get_trace( bool clear = false );
+
+   void clear();
+
+private:
+   struct event {
+      const char* category = nullptr;
+      const char* name = nullptr;
+      const char* arg_name = nullptr;
+      int64_t     arg = 0;
+      int64_t     ts_ns = 0;
+      int64_t     dur_ns = 0;
+      uint64_t    flow_id = 0;
+      char        phase = 'X';
+   };
+
+   struct thread_buffer {
+      std::mutex         mtx; ///< only contended while dumping or resizing
+      uint32_t           tid = 0;
+      std::string        thread_name;
+      std::vector<event> events;
+      size_t             next = 0;
+      bool               wrapped = false;
+   };
+
+   thread_buffer& buffer_for_this_thread();
+   void record( const event& e );
+   int64_t since_epoch_ns( clock::time_point t )const { return std::chrono::duration_cast<std::chrono::nanoseconds>( t - _epoch ).count(); }
+
+   const clock::time_point                      _epoch = clock::now();
+   std::atomic<bool>                            _enabled{false};
+   std::atomic<uint64_t>                        _next_flow_id{1};
+   mutable std::mutex                           _buffers_mtx;
+   size_t                                       _buffer_size = 0; ///< guarded by _buffers_mtx
+   std::vector<std::unique_ptr<thread_buffer>>  _buffers;         ///< guarded by _buffers_mtx, never shrinks
+};
+
+/// records the time until it goes out of scope as a slice of the calling thread, when tracing is enabled
+class scoped_trace_event {
+public:
+   scoped_trace_event( const char* category, const char* name )
+   : _category( category ), _name( name ) {
+      if( event_tracer::instance().enabled() ) {
+         _started = true;
+         _start = event_tracer::clock::now();
+      }
+   }
+
+   ~scoped_trace_event() {
+      if( _started )
+         event_tracer::instance().complete( _category, _name, _start, event_tracer::clock::now(), _arg_name, _arg );
+   }
+
+   void set_arg( const char* arg_name, int64_t arg ) {
+      _arg_name = arg_name;
+      _arg = arg;
+   }
+
+   scoped_trace_event( const scoped_trace_event& ) = delete;
+   scoped_trace_event& operator=( const scoped_trace_event& ) = delete;
+
+private:
+   const char*                     _category;
+   const char*                     _name;
+   const char*                     _arg_name = nullptr;
+   int64_t                         _arg = 0;
+   bool                            _started = false;
+   event_tracer::clock::time_point _start;
+};
+
+} } // eosio::chain
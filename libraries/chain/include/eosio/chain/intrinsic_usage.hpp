@@ -0,0 +1,113 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/intrinsic_mapping.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+/// calls an action made to a host function and the time they took
+struct intrinsic_usage_entry {
+   string   intrinsic;
+   uint64_t calls = 0;
+   uint64_t time_ns = 0;
+};
+
+/**
+ *  Counts the calls to each host function of an action and the time spent in them. Host functions are identified by
+ *  their index in eosvmoc::get_intrinsic_table(), which lists all of them whatever the runtime.
+ */
+class intrinsic_usage_counters {
+public:
+   using clock = std::chrono::steady_clock;
+
+   void call_started( size_t intrinsic ) {
+      _current = intrinsic;
+      _started = clock::now();
+   }
+
+   /// the host function started last returned or threw
+   void call_finished() {
+      if( _current == no_call )
+         return;
+      counter& c = _counters[_current];
+      ++c.calls;
+      c.time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now() - _started ).count();
+      _current = no_call;
+   }
+
+   void reset();
+
+   /// the host functions called, the most time spent first
+   std::vector<intrinsic_usage_entry> usage()const;
+
+private:
+   struct counter {
+      uint64_t calls = 0;
+      uint64_t time_ns = 0;
+   };
+
+   static constexpr size_t no_call = std::numeric_limits<size_t>::max();
+
+   std::array<counter, eosvmoc::intrinsic_table_size()> _counters{};
+   size_t                                                _current = no_call;
+   clock::time_point                                     _started;
+};
+
+/**
+ *  Opt-in accounting of host function usage. When enabled, each action trace carries the calls its action made to
+ *  each host function and the time spent in them, and the usage of all actions is aggregated per receiver over a
+ *  sliding window, in one second buckets.
+ */
+class intrinsic_usage_tracker {
+public:
+   struct account_usage {
+      account_name                        account;
+      uint64_t                            calls = 0;
+      uint64_t                            time_ns = 0;
+      std::vector<intrinsic_usage_entry>  intrinsics; ///< the most time spent first
+   };
+
+   static intrinsic_usage_tracker& instance();
+
+   bool enabled()const { return _enabled.load( std::memory_order_relaxed ); }
+
+   /// enables accounting aggregated over the last window_sec seconds, 0 disables accounting and drops the aggregates
+   void set_window( uint32_t window_sec );
+   uint32_t window()const;
+
+   void record( account_name receiver, const std::vector<intrinsic_usage_entry>& usage );
+
+   /// usage over the window of account, or of the limit receivers which spent the most time in host functions
+   std::vector<account_usage> get_usage( const std::optional<account_name>& account, uint32_t limit )const;
+
+private:
+   using clock = std::chrono::steady_clock;
+
+   struct bucket {
+      int64_t                                                         second = 0;
+      std::map<account_name, std::map<string, intrinsic_usage_entry>> usage;
+   };
+
+   int64_t current_second()const;
+   void expire( int64_t now_second )const;
+
+   std::atomic<bool>       _enabled{false};
+   mutable std::mutex      _mtx;
+   uint32_t                _window_sec = 0; ///< guarded by _mtx
+   mutable std::deque<bucket> _buckets;     ///< guarded by _mtx, oldest first
+};
+
+} } // eosio::chain
+
+FC_REFLECT( eosio::chain::intrinsic_usage_entry, (intrinsic)(calls)(time_ns) )
+FC_REFLECT( eosio::chain::intrinsic_usage_tracker::account_usage, (account)(calls)(time_ns)(intrinsics) )
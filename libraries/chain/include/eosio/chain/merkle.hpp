@@ -1,6 +1,8 @@
 #pragma once
 #include <eosio/chain/types.hpp>
 
+namespace boost { namespace asio { class io_context; } }
+
 namespace eosio { namespace chain {
 
    digest_type make_canonical_left(const digest_type& val);
@@ -19,4 +21,10 @@ namespace eosio { namespace chain {
     */
    digest_type merkle( deque<digest_type> ids );
 
+   /**
+    *  Calculates the same merkle root, the levels of more than a couple thousand digests are hashed in parallel
+    *  chunks on thread_pool and the calling thread, which may be a thread of thread_pool.
+    */
+   digest_type merkle( deque<digest_type> ids, boost::asio::io_context& thread_pool );
+
 } } /// eosio::chain
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace eosio { namespace chain { namespace metrics {
+
+enum class metric_type {
+   counter,
+   gauge,
+   histogram
+};
+
+const char* metric_type_name( metric_type t );
+
+using labels = std::vector<std::pair<std::string, std::string>>;
+
+class metric {
+public:
+   virtual ~metric() = default;
+
+   /// appends the samples of this metric in the Prometheus text exposition format
+   virtual void write( std::string& out, const std::string& name, const std::string& label_str )const = 0;
+};
+
+/// monotonically increasing value
+class counter : public metric {
+public:
+   void inc( uint64_t n = 1 ) { _value.fetch_add( n, std::memory_order_relaxed ); }
+   uint64_t value()const { return _value.load( std::memory_order_relaxed ); }
+
+   void write( std::string& out, const std::string& name, const std::string& label_str )const override;
+
+private:
+   std::atomic<uint64_t> _value{0};
+};
+
+/// value that can go up and down
+class gauge : public metric {
+public:
+   void set( double v ) { _value.store( v, std::memory_order_relaxed ); }
+   double value()const { return _value.load( std::memory_order_relaxed ); }
+
+   void write( std::string& out, const std::string& name, const std::string& label_str )const override;
+
+private:
+   std::atomic<double> _value{0};
+};
+
+/**
+ *  Distribution of durations. Observations are in microseconds and are exposed in seconds, bucketed by powers of two
+ *  microseconds: bucket i holds durations of at most 2^i us, durations above the last bound only count towards +Inf.
+ */
+class histogram : public metric {
+public:
+   static constexpr size_t num_buckets = 28;
+
+   void observe_us( uint64_t us );
+
+   uint64_t count()const { return _count.load( std::memory_order_relaxed ); }
+   uint64_t sum_us()const { return _sum_us.load( std::memory_order_relaxed ); }
+
+   void write( std::string& out, const std::string& name, const std::string& label_str )const override;
+
+private:
+   std::array<std::atomic<uint64_t>, num_buckets> _buckets{};
+   std::atomic<uint64_t>                          _count{0};
+   std::atomic<uint64_t>                          _sum_us{0};
+};
+
+/**
+ *  Receives the samples emitted by a registry collector. Samples with the same name are exposed as one metric family,
+ *  so the help text and type given for a name should be the same on every call.
+ */
+class sample_writer {
+public:
+   virtual ~sample_writer() = default;
+
+   virtual void write_counter( const std::string& name, const std::string& help, uint64_t value, const labels& l = {} ) = 0;
+   virtual void write_gauge( const std::string& name, const std::string& help, double value, const labels& l = {} ) = 0;
+};
+
+/**
+ *  Process wide set of metrics exposed by the prometheus_plugin.
+ *
+ *  Metrics are created once, typically while a plugin initializes, and the returned references stay valid for the
+ *  life of the process. Updating a metric is a relaxed atomic operation, so plugins update them on their hot paths
+ *  whether or not anything is scraping. The registry mutex is only taken to create metrics, to add or remove
+ *  collectors and to render.
+ *
+ *  Collectors are called on every render for values which are cheaper to read on demand, e.g. per connection
+ *  statistics. They are called from the rendering thread and must only read thread safe state.
+ */
+class registry {
+public:
+   using collector = std::function<void( sample_writer& )>;
+   using collector_handle = uint64_t;
+
+   static registry& instance();
+
+   /// @return the metric with the given name and labels, created on first use
+   counter& make_counter( const std::string& name, const std::string& help, const labels& l = {} );
+   gauge& make_gauge( const std::string& name, const std::string& help, const labels& l = {} );
+   histogram& make_histogram( const std::string& name, const std::string& help, const labels& l = {} );
+
+   collector_handle add_collector( collector c );
+   void remove_collector( collector_handle h );
+
+   /// @return all metrics and collected samples in the Prometheus text exposition format, version 0.0.4
+   std::string render()const;
+
+   static std::string format_labels( const labels& l );
+
+private:
+   struct family {
+      metric_type                                     type;
+      std::string                                     help;
+      std::map<std::string, std::unique_ptr<metric>>  series; ///< keyed by formatted labels
+   };
+
+   template<typename M>
+   M& make( metric_type type, const std::string& name, const std::string& help, const labels& l );
+
+   mutable std::mutex                      _mtx;
+   std::map<std::string, family>           _families;
+   std::map<collector_handle, collector>   _collectors;
+   collector_handle                        _next_handle = 0;
+};
+
+} } } // eosio::chain::metrics
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <string_view>
+
+namespace eosio { namespace chain {
+
+   /// implementations of multi_sha256, the fastest on most CPUs first
+   enum class sha256_kernel {
+      sha_ni,  ///< SHA extensions, two messages interleaved
+      avx512,  ///< sixteen messages, one per 32 bit lane of the zmm registers
+      avx2,    ///< eight messages, one per lane of the ymm registers
+      sse2,    ///< four messages, one per lane of the xmm registers
+      scalar   ///< one message at a time, the portable fallback
+   };
+
+   const char* to_string( sha256_kernel kernel );
+
+   bool is_supported( sha256_kernel kernel );
+
+   /// the fastest kernel the CPU supports, picked once
+   sha256_kernel default_sha256_kernel();
+
+   /**
+    *  Computes the SHA-256 digests of many independent messages at once, as fc::sha256::hash would one at a time.
+    *  Single-buffer SHA-256 is bound by the latency of its rounds; running the rounds of several messages side by side
+    *  keeps the execution units busy. Messages of any lengths may be mixed, a message which ends early leaves its lane
+    *  to the next message.
+    */
+   void multi_sha256( const std::string_view* messages, size_t count, digest_type* digests,
+                      sha256_kernel kernel = default_sha256_kernel() );
+
+} } /// eosio::chain
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+/// phases of block and transaction processing whose durations are recorded by phase_timings
+enum class timing_phase : uint8_t {
+   signature_recovery,
+   authorization,
+   wasm_instantiation,
+   wasm_execution,
+   undo_session,
+   resource_accounting,
+   block_finalize,
+   block_log_append,
+   fork_db_insert,
+   num_phases
+};
+
+const char* timing_phase_name( timing_phase p );
+
+/**
+ *  Process wide histograms of the time spent in each timing_phase. Recording is lock free and only done while
+ *  enabled, so a disabled scoped_phase_timer costs a single relaxed load.
+ *
+ *  Durations are bucketed by powers of two microseconds. Phases can nest, e.g. authorization of inline actions
+ *  happens during wasm_execution, in which case the inner time is also counted in the outer phase.
+ */
+class phase_timings {
+public:
+   static constexpr size_t num_buckets = 28; ///< bucket i holds durations below 2^i us, the last one everything else
+
+   struct bucket {
+      uint64_t below_us = 0; ///< durations of the bucket are below this many us
+      uint64_t count = 0;
+   };
+
+   struct phase_stats {
+      std::string         phase;
+      uint64_t            count = 0;
+      uint64_t            total_us = 0;
+      std::vector<bucket> buckets; ///< only non-empty buckets
+   };
+
+   static phase_timings& instance();
+
+   bool enabled()const { return _enabled.load( std::memory_order_relaxed ); }
+   void set_enabled( bool e ) { _enabled.store( e, std::memory_order_relaxed ); }
+
+   void record( timing_phase p, std::chrono::nanoseconds duration );
+
+   std::vector<phase_stats> get_stats()const;
+   void reset();
+
+private:
+   struct histogram {
+      std::atomic<uint64_t>                           count{0};
+      std::atomic<uint64_t>                           total_ns{0};
+      std::array<std::atomic<uint64_t>, num_buckets>  buckets{};
+   };
+
+   std::atomic<bool>                                                        _enabled{false};
+   std::array<histogram, static_cast<size_t>(timing_phase::num_phases)>    _histograms;
+};
+
+/// records the time until it goes out of scope into phase_timings::instance(), when enabled
+class scoped_phase_timer {
+public:
+   explicit scoped_phase_timer( timing_phase p )
+   : _phase( p ) {
+      if( phase_timings::instance().enabled() ) {
+         _started = true;
+         _start = std::chrono::steady_clock::now();
+      }
+   }
+
+   ~scoped_phase_timer() {
+      if( _started )
+         phase_timings::instance().record( _phase, std::chrono::steady_clock::now() - _start );
+   }
+
+   scoped_phase_timer( const scoped_phase_timer& ) = delete;
+   scoped_phase_timer& operator=( const scoped_phase_timer& ) = delete;
+
+private:
+   const timing_phase                    _phase;
+   bool                                  _started = false;
+   std::chrono::steady_clock::time_point _start;
+};
+
+} } // eosio::chain
+
+FC_REFLECT( eosio::chain::phase_timings::bucket, (below_us)(count) )
+FC_REFLECT( eosio::chain::phase_timings::phase_stats, (phase)(count)(total_us)(buckets) )
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <eosio/chain/config.hpp>
+#include <eosio/chain/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace eosio { namespace chain {
+
+/**
+ *  Bounded, thread safe cache of the public keys recovered from (digest, signature) pairs.
+ *
+ *  Transaction signature recovery and the recover_key/assert_recover_key intrinsics go through the process wide
+ *  instance(), so a transaction executed speculatively does not have its signatures recovered again when it is
+ *  applied as part of a block, even when its transaction_metadata is not reused. Entries are split over shards by
+ *  key and each shard evicts its least recently used entries.
+ */
+class recovered_key_cache {
+public:
+   struct stats {
+      uint64_t hits      = 0;
+      uint64_t misses    = 0;
+      uint64_t evictions = 0;
+      uint64_t size      = 0;
+      uint64_t capacity  = 0;
+   };
+
+   static constexpr size_t num_shards = 16;
+
+   explicit recovered_key_cache( size_t capacity = config::default_recovered_key_cache_size );
+
+   /// cache shared by all recoveries of the process
+   static recovered_key_cache& instance();
+
+   /// @return the public key recovered from sig and digest, only recovering it when not cached
+   public_key_type recover( const signature_type& sig, const digest_type& digest, bool check_canonical );
+
+   /// maximum number of cached keys, 0 disables the cache
+   void set_capacity( size_t capacity );
+
+   stats get_stats()const;
+
+   void clear();
+
+private:
+   using cache_key = fc::sha256;
+
+   struct cache_key_hash {
+      size_t operator()( const cache_key& k )const { return k._hash[0]; }
+   };
+
+   struct entry {
+      cache_key       key;
+      public_key_type pub_key;
+      bool            canonical = false; ///< recovered with the canonical signature check
+   };
+
+   struct shard {
+      mutable std::mutex                                                         mtx;
+      std::list<entry>                                                           lru; ///< most recently used first
+      std::unordered_map<cache_key, std::list<entry>::iterator, cache_key_hash> index;
+   };
+
+   shard& shard_for( const cache_key& k ) { return shards[k._hash[1] % num_shards]; }
+   void   evict( shard& s, size_t max_size );
+
+   std::atomic<size_t>              shard_capacity;
+   std::atomic<uint64_t>            hits{0};
+   std::atomic<uint64_t>            misses{0};
+   std::atomic<uint64_t>            evictions{0};
+   std::array<shard, num_shards>    shards;
+};
+
+} } // eosio::chain
+
+FC_REFLECT( eosio::chain::recovered_key_cache::stats, (hits)(misses)(evictions)(size)(capacity) )
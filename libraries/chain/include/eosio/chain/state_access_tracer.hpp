@@ -0,0 +1,78 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <tuple>
+
+namespace eosio::chain {
+
+/**
+ *  Records which parts of the chain state are read and written while transactions execute, for offline analysis of
+ *  how much of the history could have been executed in parallel. Installed with controller::set_state_access_tracer().
+ *
+ *  Accesses are tracked at the granularity of contract tables (code, scope, table), accounts read or modified by
+ *  native actions, and per-account resource usage rows. Counters that are incremented by every action or transaction
+ *  (global/recv/auth sequences, block resource totals) are not recorded since a parallel scheduler would assign them
+ *  in block order when committing.
+ */
+class state_access_tracer {
+public:
+   enum class access_kind : uint8_t {
+      table,
+      account,
+      resource
+   };
+
+   struct state_key {
+      access_kind kind = access_kind::table;
+      name        code;
+      name        scope;
+      name        table;
+
+      friend bool operator<( const state_key& a, const state_key& b ) {
+         return std::tie( a.kind, a.code, a.scope, a.table ) < std::tie( b.kind, b.code, b.scope, b.table );
+      }
+      friend bool operator==( const state_key& a, const state_key& b ) {
+         return std::tie( a.kind, a.code, a.scope, a.table ) == std::tie( b.kind, b.code, b.scope, b.table );
+      }
+   };
+
+   struct access_set {
+      flat_set<state_key> reads;
+      flat_set<state_key> writes;
+   };
+
+   void on_read( const state_key& k ) {
+      if( !_current.writes.count( k ) )
+         _current.reads.insert( k );
+   }
+
+   void on_write( const state_key& k ) {
+      _current.reads.erase( k );
+      _current.writes.insert( k );
+   }
+
+   void on_table_read( name code, name scope, name table )  { on_read( {access_kind::table, code, scope, table} ); }
+   void on_table_write( name code, name scope, name table ) { on_write( {access_kind::table, code, scope, table} ); }
+   void on_account_read( name account )                     { on_read( {access_kind::account, account} ); }
+   void on_account_write( name account )                    { on_write( {access_kind::account, account} ); }
+   void on_resource_write( name account )                   { on_write( {access_kind::resource, account} ); }
+
+   /// accesses recorded since the previous call, i.e. by the transaction that just finished executing
+   access_set take_accesses() {
+      access_set result = std::move( _current );
+      _current = access_set{};
+      return result;
+   }
+
+   /// drops accesses recorded since the previous call
+   void reset() { _current = access_set{}; }
+
+private:
+   access_set _current;
+};
+
+} // namespace eosio::chain
+
+FC_REFLECT_ENUM( eosio::chain::state_access_tracer::access_kind, (table)(account)(resource) )
+FC_REFLECT( eosio::chain::state_access_tracer::state_key, (kind)(code)(scope)(table) )
@@ -3,8 +3,12 @@
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/thread_pool.hpp>
 #include <boost/asio/post.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 
 namespace eosio { namespace chain {
@@ -44,6 +48,44 @@ namespace eosio { namespace chain {
       return task->get_future();
    }
 
+   // calls f(i) for each i in [0, count) on thread_pool and the calling thread, rethrows the first exception thrown.
+   // The calling thread runs what the pool has not started rather than waiting for it, so it may be a thread of
+   // thread_pool itself without starving the pool.
+   template<typename F>
+   void parallel_for( boost::asio::io_context& thread_pool, size_t count, const F& f ) {
+      struct shared_state {
+         std::atomic<size_t>     next{0};
+         size_t                  finished = 0; // guarded by mtx
+         std::exception_ptr      except;       // guarded by mtx
+         std::mutex              mtx;
+         std::condition_variable cv;
+      };
+      auto state = std::make_shared<shared_state>();
+      // f is only used for an index claimed before the calling thread returns
+      auto work = [state, &f, count]() {
+         for( size_t i = state->next++; i < count; i = state->next++ ) {
+            std::exception_ptr except;
+            try {
+               f( i );
+            } catch( ... ) {
+               except = std::current_exception();
+            }
+            std::lock_guard g( state->mtx );
+            if( except && !state->except )
+               state->except = except;
+            if( ++state->finished == count )
+               state->cv.notify_all();
+         }
+      };
+      for( size_t i = 1; i < count; ++i )
+         boost::asio::post( thread_pool, work );
+      work();
+      std::unique_lock g( state->mtx );
+      state->cv.wait( g, [&]() { return state->finished == count; } );
+      if( state->except )
+         std::rethrow_exception( state->except );
+   }
+
 } } // eosio::chain
 
 
@@ -3,6 +3,7 @@
 #include <eosio/chain/action.hpp>
 #include <eosio/chain/action_receipt.hpp>
 #include <eosio/chain/block.hpp>
+#include <eosio/chain/intrinsic_usage.hpp>
 
 namespace eosio { namespace chain {
 
@@ -45,6 +46,7 @@ namespace eosio { namespace chain {
       std::optional<fc::exception>    except;
       std::optional<uint64_t>         error_code;
       std::vector<char>               return_value;
+      std::vector<intrinsic_usage_entry> intrinsic_usage; ///< empty unless intrinsic usage accounting is enabled, see intrinsic_usage_tracker
    };
 
    struct transaction_trace {
@@ -89,6 +91,7 @@ FC_REFLECT( eosio::chain::action_trace,
                (action_ordinal)(creator_action_ordinal)(closest_unnotified_ancestor_action_ordinal)(receipt)
                (receiver)(act)(context_free)(elapsed)(console)(trx_id)(block_num)(block_time)
                (producer_block_id)(account_ram_deltas)(except)(error_code)(return_value) )
+// @ignore intrinsic_usage, it is added to the JSON form of traces by abi_serializer and kept out of their binary form
 
 // @ignore except_ptr
 FC_REFLECT( eosio::chain::transaction_trace, (id)(block_num)(block_time)(producer_block_id)
@@ -39,7 +39,8 @@ namespace eosio { namespace chain {
                               const packed_transaction& t,
                               transaction_checktime_timer&& timer,
                               fc::time_point start = fc::time_point::now(),
-                              bool read_only=false);
+                              bool read_only=false,
+                              bool read_only_thread=false);
          ~transaction_context();
 
          void init_for_implicit_trx( uint64_t initial_net_usage = 0 );
@@ -150,6 +151,10 @@ namespace eosio { namespace chain {
          transaction_checktime_timer   transaction_timer;
 
          const bool                    is_read_only;
+         /// executing on a read-only worker thread: no undo session is available so state must not be modified
+         const bool                    is_read_only_thread;
+         /// the controller's state_access_tracer when the transaction started, nullptr when state accesses are not traced
+         state_access_tracer* const    access_tracer;
    private:
          bool                          is_initialized = false;
 
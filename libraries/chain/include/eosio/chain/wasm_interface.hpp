@@ -12,6 +12,7 @@ namespace eosio { namespace chain {
    class apply_context;
    class wasm_runtime_interface;
    class controller;
+   class wasm_module_cache;
    namespace eosvmoc { struct config; }
 
    struct wasm_exit {
@@ -42,7 +43,9 @@ namespace eosio { namespace chain {
              }
          }
 
-         wasm_interface(vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile);
+         //module_cache, when given, must outlive the wasm_interface
+         wasm_interface(vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                        wasm_module_cache* module_cache = nullptr);
          ~wasm_interface();
 
          //call before dtor to skip what can be minutes of dtor overhead with some runtimes; can cause leaks
@@ -54,9 +57,16 @@ namespace eosio { namespace chain {
          //indicate that a particular code probably won't be used after given block_num
          void code_block_num_last_used(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, const uint32_t& block_num);
 
+         //indicate that code no longer in the database probably won't be used after given block_num. for a
+         //wasm_interface which does not execute setcode itself, e.g. of a read-only thread
+         void removed_code_block_num_last_used(const uint32_t& block_num);
+
          //indicate the current LIB. evicts old cache entries
          void current_lib(const uint32_t lib);
 
+         //number of instantiated modules cached
+         size_t cached_modules()const;
+
          //Calls apply or error on a given code
          void apply(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, apply_context& context);
 
@@ -8,6 +8,7 @@
 #endif
 #include <eosio/chain/webassembly/runtime_interface.hpp>
 #include <eosio/chain/wasm_eosio_injection.hpp>
+#include <eosio/chain/wasm_module_cache.hpp>
 #include <eosio/chain/transaction_context.hpp>
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/global_property_object.hpp>
@@ -58,7 +59,8 @@ namespace eosio { namespace chain {
       };
 #endif
 
-      wasm_interface_impl(wasm_interface::vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile) : db(d), wasm_runtime_time(vm) {
+      wasm_interface_impl(wasm_interface::vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                          wasm_module_cache* module_cache) : db(d), wasm_runtime_time(vm), module_cache(module_cache) {
 #ifdef EOSIO_EOS_VM_RUNTIME_ENABLED
          if(vm == wasm_interface::vm_type::eos_vm)
             runtime_interface = std::make_unique<webassembly::eos_vm_runtime::eos_vm_runtime<eosio::vm::interpreter>>();
@@ -120,8 +122,22 @@ namespace eosio { namespace chain {
             });
       }
 
+      void removed_code_block_num_last_used(uint32_t block_num) {
+         //only code still in use is unmarked, marking moves the entry ahead of the iteration
+         auto& by_last = wasm_instantiation_cache.get<by_last_block_num>();
+         for(auto it = by_last.lower_bound(UINT32_MAX); it != by_last.end();) {
+            auto next = std::next(it);
+            if(!db.find<code_object,by_code_hash>(boost::make_tuple(it->code_hash, it->vm_type, it->vm_version)))
+               by_last.modify(it, [block_num](wasm_cache_entry& e) {
+                  e.last_block_num_used = block_num;
+               });
+            it = next;
+         }
+      }
+
       void current_lib(uint32_t lib) {
-         //anything last used before or on the LIB can be evicted
+         //anything last used before or on the LIB can be evicted, and a compile of it still queued or running cancelled:
+         //until then a replaced code may still run, e.g. when the setcode is forked out or other accounts use it too
          const auto first_it = wasm_instantiation_cache.get<by_last_block_num>().begin();
          const auto last_it  = wasm_instantiation_cache.get<by_last_block_num>().upper_bound(lib);
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
@@ -158,24 +174,34 @@ namespace eosio { namespace chain {
                trx_context.resume_billing_timer();
             });
             trx_context.pause_billing_timer();
-            IR::Module module;
             std::vector<U8> bytes = {
                 (const U8*)codeobject->code.data(),
                 (const U8*)codeobject->code.data() + codeobject->code.size()};
-            try {
-               Serialization::MemoryInputStream stream((const U8*)bytes.data(),
-                                                       bytes.size());
-               WASM::scoped_skip_checks no_check;
-               WASM::serialize(stream, module);
-               module.userSections.clear();
-            } catch (const Serialization::FatalSerializationException& e) {
-               EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
-            } catch (const IR::ValidationException& e) {
-               EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+
+            //a module which parsed before, possibly in a previous run, parses the same way again
+            std::optional<std::vector<uint8_t>> initial_memory;
+            if(module_cache)
+               initial_memory = module_cache->find(code_hash, vm_type, vm_version);
+            if(!initial_memory) {
+               IR::Module module;
+               try {
+                  Serialization::MemoryInputStream stream((const U8*)bytes.data(),
+                                                          bytes.size());
+                  WASM::scoped_skip_checks no_check;
+                  WASM::serialize(stream, module);
+                  module.userSections.clear();
+               } catch (const Serialization::FatalSerializationException& e) {
+                  EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+               } catch (const IR::ValidationException& e) {
+                  EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
+               }
+               initial_memory = parse_initial_memory(module);
+               if(module_cache)
+                  module_cache->insert(code_hash, vm_type, vm_version, *initial_memory);
             }
 
             wasm_instantiation_cache.modify(it, [&](auto& c) {
-               c.module = runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), parse_initial_memory(module), code_hash, vm_type, vm_version);
+               c.module = runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), std::move(*initial_memory), code_hash, vm_type, vm_version);
             });
          }
          return it->module;
@@ -202,6 +228,7 @@ namespace eosio { namespace chain {
 
       const chainbase::database& db;
       const wasm_interface::vm_type wasm_runtime_time;
+      wasm_module_cache* const module_cache;
 
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
       std::optional<eosvmoc_tier> eosvmoc;
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <fc/io/cfile.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+/**
+ *  Persistent cache of what instantiating a module derives from its wasm, keyed by (code_hash, vm_type, vm_version).
+ *
+ *  A module missing from the in-memory cache of a wasm_interface has its wasm parsed to check its data segments and to
+ *  build its initial memory before the runtime instantiates it. Modules which parsed successfully are recorded here
+ *  with their initial memory so that they are not parsed again, including after a restart: the file is mapped on
+ *  startup and new entries are appended to it. Failures are not recorded, a module fails the same way on every parse.
+ *  Each entry carries a sha256 of its contents, checked the first time it is found, and appends are synced to disk,
+ *  so that an entry damaged by a crash is parsed again rather than instantiated with the wrong memory.
+ *
+ *  When the file would grow past its max size it is compacted: rewritten with the most recently used entries filling
+ *  up to half of it, least recently used first, so that the order of the file carries their recency across restarts.
+ *
+ *  One cache is shared by the wasm_interface of the main thread and those of the read-only threads.
+ */
+class wasm_module_cache {
+public:
+   /// max_size is the size the file stops growing at
+   wasm_module_cache( const fc::path& file, uint64_t max_size );
+
+   wasm_module_cache( const wasm_module_cache& ) = delete;
+   wasm_module_cache& operator=( const wasm_module_cache& ) = delete;
+
+   /// @return the initial memory of the module, empty when the module has not been recorded or its entry is corrupt
+   std::optional<std::vector<uint8_t>> find( const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version );
+
+   /// records a module which parsed successfully
+   void insert( const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version, const std::vector<uint8_t>& initial_memory );
+
+   size_t size()const;
+
+private:
+   struct cache_key {
+      digest_type code_hash;
+      uint8_t     vm_type = 0;
+      uint8_t     vm_version = 0;
+
+      bool operator==( const cache_key& o )const {
+         return code_hash == o.code_hash && vm_type == o.vm_type && vm_version == o.vm_version;
+      }
+   };
+
+   struct cache_key_hash {
+      size_t operator()( const cache_key& k )const { return k.code_hash._hash[0]; }
+   };
+
+   /// record of an entry, either in the mapping of the file or in _appended, followed by its initial memory
+   struct cached_memory {
+      const char* record = nullptr;
+      size_t      size = 0;
+      bool        verified = false; ///< checksum matched
+      uint64_t    last_used = 0;    ///< _use_count when last found or inserted, entries loaded count in file order
+   };
+
+   void load();
+   void create();
+   void compact();
+
+   const fc::path                                                 _file_path;
+   const uint64_t                                                 _max_size;
+
+   mutable std::mutex                                             _mtx;
+   std::optional<boost::interprocess::file_mapping>               _file_mapping;
+   std::optional<boost::interprocess::mapped_region>              _mapped_region; ///< entries found on startup
+   std::deque<std::vector<char>>                                  _appended;      ///< entries added since startup
+   std::unordered_map<cache_key, cached_memory, cache_key_hash>   _index;
+   fc::cfile                                                      _file;
+   uint64_t                                                       _file_size = 0;
+   uint64_t                                                       _use_count = 0;
+};
+
+} } // eosio::chain
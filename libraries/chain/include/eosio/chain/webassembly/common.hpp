@@ -63,6 +63,12 @@ namespace eosio { namespace chain {
       using base_type::from_wasm;
       using base_type::to_wasm;
 
+      // ends the host function call intrinsic_usage_check started, whether it returned or threw
+      ~basic_type_converter() {
+         if( auto& counters = this->get_host().get_context().intrinsic_usage )
+            counters->call_finished();
+      }
+
       EOS_VM_FROM_WASM(bool, (uint32_t value)) { return value ? 1 : 0; }
 
       EOS_VM_FROM_WASM(memcpy_params, (vm::wasm_ptr_t dst, vm::wasm_ptr_t src, vm::wasm_size_t size)) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <eosio/chain/webassembly/common.hpp>
+#include <eosio/chain/webassembly/interface.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/webassembly/runtime_interface.hpp>
 #include <eosio/chain/apply_context.hpp>
@@ -332,8 +333,21 @@ struct result_resolver {
    eos_vm_oc_type_converter& tc;
 };
 
+// ends the host function call intrinsic_usage_check started. Called explicitly rather than from a destructor since
+// the frames of a host function are left by siglongjmp when it faults
+inline void end_intrinsic_call(apply_context& ctx) {
+   if(auto& counters = ctx.intrinsic_usage)
+      counters->call_finished();
+}
+
 template<auto F, typename Interface, typename Preconditions, bool is_injected, typename... A>
 auto fn(A... a) {
+   constexpr int cb_ctx_ptr_offset = OFFSET_OF_CONTROL_BLOCK_MEMBER(ctx);
+   apply_context* ctx;
+   asm("mov %%gs:%c[applyContextOffset], %[cPtr]\n"
+       : [cPtr] "=r" (ctx)
+       : [applyContextOffset] "i" (cb_ctx_ptr_offset)
+       );
    try {
       if constexpr(!is_injected) {
          constexpr int cb_current_call_depth_remaining_segment_offset = OFFSET_OF_CONTROL_BLOCK_MEMBER(current_call_depth_remaining);
@@ -350,19 +364,25 @@ auto fn(A... a) {
       }
       using native_args = vm::flatten_parameters_t<AUTO_PARAM_WORKAROUND(F)>;
       eosio::vm::native_value stack[] = { a... };
-      constexpr int cb_ctx_ptr_offset = OFFSET_OF_CONTROL_BLOCK_MEMBER(ctx);
-      apply_context* ctx;
-      asm("mov %%gs:%c[applyContextOffset], %[cPtr]\n"
-          : [cPtr] "=r" (ctx)
-          : [applyContextOffset] "i" (cb_ctx_ptr_offset)
-          );
       Interface host(*ctx);
       eos_vm_oc_type_converter tc{&host, eos_vm_oc_execution_interface{stack + sizeof...(A)}};
-      return result_resolver{tc}, eosio::vm::invoke_with_host<F, Preconditions, native_args>(tc, &host, std::make_index_sequence<sizeof...(A)>());
+      auto invoke = [&]() {
+         return result_resolver{tc}, eosio::vm::invoke_with_host<F, Preconditions, native_args>(tc, &host, std::make_index_sequence<sizeof...(A)>());
+      };
+      if constexpr(std::is_void_v<decltype(invoke())>) {
+         invoke();
+         end_intrinsic_call(*ctx);
+         return;
+      } else {
+         auto result = invoke();
+         end_intrinsic_call(*ctx);
+         return result;
+      }
    }
    catch(...) {
       *reinterpret_cast<std::exception_ptr*>(eos_vm_oc_get_exception_ptr()) = std::current_exception();
    }
+   end_intrinsic_call(*ctx);
    siglongjmp(*eos_vm_oc_get_jmp_buf(), EOSVMOC_EXIT_EXCEPTION);
    __builtin_unreachable();
 }
@@ -1,9 +1,8 @@
 #pragma once
 
-#include <boost/lockfree/spsc_queue.hpp>
-
 #include <eosio/chain/webassembly/eos-vm-oc/eos-vm-oc.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/ipc_helpers.hpp>
+#include <eosio/chain/metrics.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
@@ -14,7 +13,10 @@
 #include <boost/asio/local/datagram_protocol.hpp>
 
 
+#include <functional>
+#include <mutex>
 #include <thread>
+#include <tuple>
 
 namespace std {
     template<> struct hash<eosio::chain::eosvmoc::code_tuple> {
@@ -36,6 +38,59 @@ using allocator_t = bip::rbtree_best_fit<bip::null_mutex_family, bip::offset_ptr
 
 struct config;
 
+/// how much a code has been executed, recorded across restarts to prioritize tier-up of the busiest codes
+struct code_hotness {
+   uint64_t executions = 0;
+   uint64_t cpu_us     = 0; ///< time spent executing the code, whichever runtime it ran on
+
+   bool hotter_than(const code_hotness& o) const {
+      return std::tie(cpu_us, executions) > std::tie(o.cpu_us, o.executions);
+   }
+
+   /// order in which the compile monitor starts queued compiles
+   uint64_t priority() const { return cpu_us + executions; }
+};
+
+using code_hotness_map = std::unordered_map<code_tuple, code_hotness>;
+
+/// reads what save_code_hotness() wrote, halved so that codes which are no longer used give way to current ones.
+/// Empty when the file is missing or can't be read
+code_hotness_map load_code_hotness(const bfs::path& file);
+
+/// writes the max_codes hottest codes of hotness to file
+void save_code_hotness(const bfs::path& file, const code_hotness_map& hotness, size_t max_codes);
+
+/// @return up to max_codes codes of hotness for which include returns true, hottest first
+std::vector<code_tuple> hottest_codes(const code_hotness_map& hotness, size_t max_codes,
+                                      const std::function<bool(const code_tuple&)>& include);
+
+/**
+ * Greedy-Dual-Size-Frequency eviction: an entry's priority is its number of hits divided by its size, on top of the
+ * priority of the last evicted entry so that entries which are no longer hit age out. Entries with the lowest priority
+ * are evicted first, so small frequently executed code is kept over large code executed once.
+ */
+class gdsf_eviction_policy {
+   public:
+      void insert(const code_tuple& ct, size_t size);
+      void hit(const code_tuple& ct);
+      void erase(const code_tuple& ct);
+
+      /// removes the lowest priority entries until at least bytes_to_free were freed, keeping at least one entry
+      /// @return the removed entries with their sizes, lowest priority first
+      std::vector<std::pair<code_tuple, size_t>> evict(size_t bytes_to_free);
+
+      size_t size() const { return _entries.size(); }
+
+   private:
+      struct entry_stats {
+         size_t   size = 0; ///< bytes of compiled code and initial memory in the cache
+         uint64_t hits = 0;
+         double   priority = 0;
+      };
+      std::unordered_map<code_tuple, entry_stats> _entries;
+      double _floor = 0;
+};
+
 class code_cache_base {
    public:
       code_cache_base(const bfs::path data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db);
@@ -73,12 +128,42 @@ class code_cache_base {
 
       //these are really only useful to the async code cache, but keep them here so
       //free_code can be shared
-      std::unordered_set<code_tuple> _queued_compiles;
-      std::unordered_map<code_tuple, bool> _outstanding_compiles_and_poison;
+      struct outstanding_compile {
+         bool     poisoned = false; ///< the code is no longer used, don't insert it in to the cache when done
+         uint64_t priority = 0;     ///< last priority sent to the compile monitor
+      };
+      std::unordered_map<code_tuple, outstanding_compile> _outstanding_compiles;
+      code_hotness_map _hotness;
+
+      gdsf_eviction_policy _eviction_policy;
+      void on_cache_insert(const code_tuple& ct, size_t size);
+      void on_cache_hit(const code_tuple& ct);
+
+      struct cache_metrics {
+         using registry = metrics::registry;
+         metrics::counter& hits = registry::instance().make_counter(
+               "nodeos_eosvmoc_cache_hits_total", "Executions of code found in the EOS VM OC code cache" );
+         metrics::counter& misses = registry::instance().make_counter(
+               "nodeos_eosvmoc_cache_misses_total", "Executions of code not in the EOS VM OC code cache" );
+         metrics::counter& evictions = registry::instance().make_counter(
+               "nodeos_eosvmoc_cache_evictions_total", "Codes evicted from the EOS VM OC code cache to make room" );
+         metrics::counter& evicted_bytes = registry::instance().make_counter(
+               "nodeos_eosvmoc_cache_evicted_bytes_total", "Bytes evicted from the EOS VM OC code cache to make room" );
+         metrics::gauge&   entries = registry::instance().make_gauge(
+               "nodeos_eosvmoc_cache_entries", "Codes in the EOS VM OC code cache" );
+         metrics::gauge&   free_bytes = registry::instance().make_gauge(
+               "nodeos_eosvmoc_cache_free_bytes", "Free bytes of the EOS VM OC code cache as of the last compile" );
+         metrics::counter& compiles_cancelled = registry::instance().make_counter(
+               "nodeos_eosvmoc_compiles_cancelled_total", "EOS VM OC compiles cancelled because the code was no longer used" );
+         metrics::histogram& compile_time = registry::instance().make_histogram(
+               "nodeos_eosvmoc_compile_time_seconds", "Time spent compiling code with EOS VM OC" );
+         metrics::histogram& compile_queue_time = registry::instance().make_histogram(
+               "nodeos_eosvmoc_compile_queue_time_seconds", "Time EOS VM OC compiles waited for a free compile worker" );
+      } _metrics;
 
       size_t _free_bytes_eviction_threshold;
       void check_eviction_threshold(size_t free_bytes);
-      void run_eviction_round();
+      void run_eviction_round(size_t free_bytes);
 
       void set_on_disk_region_dirty(bool);
 
@@ -96,13 +181,23 @@ class code_cache_async : public code_cache_base {
       //otherwise: return nullptr
       const code_descriptor* const get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version);
 
+      //Records an execution of code in any runtime; queued compiles are started hottest first
+      void record_execution(const digest_type& code_id, const uint8_t& vm_version, const fc::microseconds& cpu);
+
    private:
       std::thread _monitor_reply_thread;
-      boost::lockfree::spsc_queue<wasm_compilation_result_message> _result_queue;
+      std::mutex _result_queue_mutex;
+      std::vector<wasm_compilation_result_message> _result_queue; //guarded by _result_queue_mutex
       void wait_on_compile_monitor_message();
       std::tuple<size_t, size_t> consume_compile_thread_queue();
       std::unordered_set<code_tuple> _blacklist;
-      size_t _threads;
+
+      bfs::path _hotness_file_path;
+      size_t _warmup_compiles;
+      bool _warmup_pending = true;
+      void queue_warmup_compiles();
+      uint64_t compile_priority(const code_tuple& ct) const;
+      bool start_compile(const code_tuple& ct);
 };
 
 class code_cache_sync : public code_cache_base {
@@ -114,4 +209,6 @@ class code_cache_sync : public code_cache_base {
       const code_descriptor* const get_descriptor_for_code_sync(const digest_type& code_id, const uint8_t& vm_version);
 };
 
-}}}
\ No newline at end of file
+}}}
+
+FC_REFLECT(eosio::chain::eosvmoc::code_hotness, (executions)(cpu_us))
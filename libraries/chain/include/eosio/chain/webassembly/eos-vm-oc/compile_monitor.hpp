@@ -4,9 +4,64 @@
 
 #include <boost/asio/local/datagram_protocol.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/ipc_helpers.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/ipc_protocol.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <vector>
 
 namespace eosio { namespace chain { namespace eosvmoc {
 
-wrapped_fd get_connection_to_compile_monitor(int cache_fd);
+//compiles waiting in the compile monitor for a compile slot. Pending has a code and a priority member; the highest
+// priority is started first, and of equal priorities the one queued first
+template<typename Pending>
+class compile_queue {
+   public:
+      bool empty() const { return _queue.empty(); }
+      size_t size() const { return _queue.size(); }
+
+      void push(Pending&& p) { _queue.push_back(std::move(p)); }
+
+      //returns false when code isn't queued
+      bool reprioritize(const code_tuple& code, uint64_t priority) {
+         auto it = find(code);
+         if(it == _queue.end())
+            return false;
+         it->priority = priority;
+         return true;
+      }
+
+      //removes the queued compile of code, if any
+      std::optional<Pending> remove(const code_tuple& code) {
+         auto it = find(code);
+         if(it == _queue.end())
+            return std::nullopt;
+         std::optional<Pending> p(std::move(*it));
+         _queue.erase(it);
+         return p;
+      }
+
+      //removes the next compile to start, the queue must not be empty
+      Pending pop() {
+         auto nextup = std::max_element(_queue.begin(), _queue.end(), [](const Pending& a, const Pending& b) {
+            return a.priority < b.priority;
+         });
+         Pending p = std::move(*nextup);
+         _queue.erase(nextup);
+         return p;
+      }
+
+   private:
+      typename std::vector<Pending>::iterator find(const code_tuple& code) {
+         return std::find_if(_queue.begin(), _queue.end(), [&](const Pending& p) { return p.code == code; });
+      }
+
+      std::vector<Pending> _queue;
+};
+
+wrapped_fd get_connection_to_compile_monitor(int cache_fd, const initialize_message& init);
+
+//creates the shared cache directory owner-only, throws when it could be written by other users
+void check_shared_cache_dir(const boost::filesystem::path& dir);
 
 }}}
\ No newline at end of file
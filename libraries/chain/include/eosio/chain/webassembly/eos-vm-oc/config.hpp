@@ -13,6 +13,8 @@ namespace eosio { namespace chain { namespace eosvmoc {
 struct config {
    uint64_t cache_size = 1024u*1024u*1024u;
    uint64_t threads    = 1u;
+   uint64_t warmup_compiles = 100u; ///< number of the hottest codes of the previous run compiled when tier-up starts
+   boost::filesystem::path shared_cache_dir; ///< when set, compiled code is shared through it with other nodeos on the host
 };
 
 }}}
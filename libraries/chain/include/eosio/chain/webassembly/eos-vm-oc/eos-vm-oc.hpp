@@ -41,6 +41,14 @@ struct code_descriptor {
    size_t initdata_begin;
    unsigned initdata_size;
    unsigned initdata_prologue_size;
+   unsigned function_table_offset; //from code_begin, also the size of the code
+   unsigned function_count;
+};
+
+//the function table follows the code of each function: the wasm functions defined by the module, ordered by code offset
+struct function_table_entry {
+   uint32_t code_offset;
+   uint32_t function_index; //index in the wasm as deployed, imports included
 };
 
 enum eosvmoc_exitcode : int {
@@ -50,13 +58,13 @@ enum eosvmoc_exitcode : int {
    EOSVMOC_EXIT_EXCEPTION
 };
 
-static constexpr uint8_t current_codegen_version = 1;
+static constexpr uint8_t current_codegen_version = 2;
 
 }}}
 
 FC_REFLECT(eosio::chain::eosvmoc::no_offset, );
 FC_REFLECT(eosio::chain::eosvmoc::code_offset, (offset));
 FC_REFLECT(eosio::chain::eosvmoc::intrinsic_ordinal, (ordinal));
-FC_REFLECT(eosio::chain::eosvmoc::code_descriptor, (code_hash)(vm_version)(codegen_version)(code_begin)(start)(apply_offset)(starting_memory_pages)(initdata_begin)(initdata_size)(initdata_prologue_size));
+FC_REFLECT(eosio::chain::eosvmoc::code_descriptor, (code_hash)(vm_version)(codegen_version)(code_begin)(start)(apply_offset)(starting_memory_pages)(initdata_begin)(initdata_size)(initdata_prologue_size)(function_table_offset)(function_count));
 
 #define EOSVMOC_INTRINSIC_INIT_PRIORITY __attribute__((init_priority(198)))
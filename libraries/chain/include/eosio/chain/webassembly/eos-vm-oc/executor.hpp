@@ -8,6 +8,7 @@
 #include <setjmp.h>
 
 #include <list>
+#include <memory>
 #include <vector>
 #include <cstddef>
 
@@ -19,6 +20,7 @@ namespace eosvmoc {
 
 class code_cache_base;
 class memory;
+class profile_sampler;
 struct code_descriptor;
 
 class executor {
@@ -38,6 +40,7 @@ class executor {
       std::list<std::vector<std::byte>> executors_bounce_buffers;
       std::vector<std::byte> globals_buffer;
       execution_stack stack;
+      std::unique_ptr<profile_sampler> sampler; //created when first running code of a profiled account
 };
 
 }}}
@@ -7,6 +7,8 @@
 namespace eosio { namespace chain { namespace eosvmoc {
 
 struct initialize_message {
+   std::string shared_cache_dir; //empty when compiled code is not shared with other processes
+   uint64_t max_concurrent_compiles = 1;
    //Two sent fds: 1) communication socket for this instance  2) the cache file 
 };
 
@@ -22,7 +24,13 @@ struct code_tuple {
 
 struct compile_wasm_message {
    code_tuple code;
-   //Two sent fd: 1) communication socket for result, 2) the wasm to compile
+   uint64_t priority = 0; //queued compiles with the highest priority start first
+   //To the compile monitor: one sent fd, the wasm to compile. No sent fd updates the priority of a queued compile
+   //To the compile trampoline: two sent fds: 1) communication socket for result, 2) the wasm to compile
+};
+
+struct cancel_compile_message {
+   code_tuple code;
 };
 
 struct evict_wasms_message {
@@ -34,21 +42,28 @@ struct code_compilation_result_message {
    unsigned apply_offset;
    int starting_memory_pages;
    unsigned initdata_prologue_size;
-   //Two sent fds: 1) wasm code, 2) initial memory snapshot
+   unsigned function_table_offset;
+   unsigned function_count;
+   //Two sent fds: 1) wasm code followed by the function table, 2) initial memory snapshot
 };
 
 
 struct compilation_result_unknownfailure {};
 struct compilation_result_toofull {};
+struct compilation_result_cancelled {};
 
 using wasm_compilation_result = std::variant<code_descriptor,  //a successful compile
                                              compilation_result_unknownfailure,
-                                             compilation_result_toofull>;
+                                             compilation_result_toofull,
+                                             compilation_result_cancelled>;
 
 struct wasm_compilation_result_message {
    code_tuple code;
    wasm_compilation_result result;
    size_t cache_free_bytes;
+   size_t code_size = 0; //bytes taken in the cache by a successful compile
+   uint64_t queue_time_us = 0;
+   uint64_t compile_time_us = 0;
 };
 
 using eosvmoc_message = std::variant<initialize_message,
@@ -56,15 +71,18 @@ using eosvmoc_message = std::variant<initialize_message,
                                      compile_wasm_message,
                                      evict_wasms_message,
                                      code_compilation_result_message,
-                                     wasm_compilation_result_message>;
+                                     wasm_compilation_result_message,
+                                     cancel_compile_message>;
 }}}
 
-FC_REFLECT(eosio::chain::eosvmoc::initialize_message, )
+FC_REFLECT(eosio::chain::eosvmoc::initialize_message, (shared_cache_dir)(max_concurrent_compiles))
 FC_REFLECT(eosio::chain::eosvmoc::initalize_response_message, (error_message))
 FC_REFLECT(eosio::chain::eosvmoc::code_tuple, (code_id)(vm_version))
-FC_REFLECT(eosio::chain::eosvmoc::compile_wasm_message, (code))
+FC_REFLECT(eosio::chain::eosvmoc::compile_wasm_message, (code)(priority))
+FC_REFLECT(eosio::chain::eosvmoc::cancel_compile_message, (code))
 FC_REFLECT(eosio::chain::eosvmoc::evict_wasms_message, (codes))
-FC_REFLECT(eosio::chain::eosvmoc::code_compilation_result_message, (start)(apply_offset)(starting_memory_pages)(initdata_prologue_size))
+FC_REFLECT(eosio::chain::eosvmoc::code_compilation_result_message, (start)(apply_offset)(starting_memory_pages)(initdata_prologue_size)(function_table_offset)(function_count))
 FC_REFLECT(eosio::chain::eosvmoc::compilation_result_unknownfailure, )
 FC_REFLECT(eosio::chain::eosvmoc::compilation_result_toofull, )
-FC_REFLECT(eosio::chain::eosvmoc::wasm_compilation_result_message, (code)(result)(cache_free_bytes))
+FC_REFLECT(eosio::chain::eosvmoc::compilation_result_cancelled, )
+FC_REFLECT(eosio::chain::eosvmoc::wasm_compilation_result_message, (code)(result)(cache_free_bytes)(code_size)(queue_time_us)(compile_time_us))
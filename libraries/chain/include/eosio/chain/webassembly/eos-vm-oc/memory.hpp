@@ -8,6 +8,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <algorithm>
+
 namespace eosio { namespace chain { namespace eosvmoc {
 
 class memory {
@@ -30,6 +32,12 @@ class memory {
       memory& operator=(const memory&) = delete;
       void reset(uint64_t max_pages);
 
+      //prepares the linear memory for an execution starting with starting_size bytes of memory: zeroes what earlier
+      // executions wrote, except for the first initial_data_size bytes which the caller overwrites with the initial data
+      void reset_linear_memory(uint64_t initial_data_size, uint64_t starting_size);
+      //records that an execution may have written to the first size bytes of the linear memory
+      void linear_memory_written(uint64_t size) { written_extent = std::max(written_extent, size); }
+
       uint8_t* const zero_page_memory_base() const { return zeropage_base; }
       uint8_t* const full_page_memory_base() const { return fullpage_base; }
 
@@ -61,6 +69,10 @@ class memory {
 
       uint8_t* zeropage_base;
       uint8_t* fullpage_base;
+
+      int memfd;
+      //the linear memory past this is all zero
+      uint64_t written_extent = 0;
 };
 
 }}}
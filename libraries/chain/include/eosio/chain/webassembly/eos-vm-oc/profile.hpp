@@ -0,0 +1,87 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <time.h>
+
+namespace eosio { namespace chain {
+
+class apply_context;
+
+namespace eosvmoc {
+
+struct code_descriptor;
+
+/**
+ * Samples where EOS VM OC spends time running the code of an action of an account given to --profile-account.
+ *
+ * While the action runs, a timer interrupts the executing thread every sampling_interval_us and the instruction it
+ * was interrupted at is recorded. The compiled code keeps no frame pointers to unwind, so only the wasm function a
+ * sample was taken in is known; samples taken outside of the compiled code, in host functions, are counted apart.
+ */
+class profile_sampler {
+   public:
+      static constexpr uint32_t sampling_interval_us = 200;
+      static constexpr size_t   max_samples = 64*1024; //per action, later samples are dropped
+
+      profile_sampler();
+      ~profile_sampler();
+
+      //samples the calling thread until stop()
+      void start(const uint8_t* code, size_t code_size);
+      void stop();
+
+      //offsets in the code of the samples taken in it
+      const uint32_t* code_samples() const { return _samples.data(); }
+      size_t code_sample_count() const { return _sample_count; }
+      uint64_t host_samples() const { return _host_samples; }
+
+   private:
+      static void signal_handler(int sig, siginfo_t* info, void* ctx);
+
+      std::vector<uint32_t> _samples;
+      volatile size_t       _sample_count = 0;
+      volatile uint64_t     _host_samples = 0;
+      uintptr_t             _code = 0;
+      size_t                _code_size = 0;
+      timer_t               _timer;
+      volatile bool         _running = false;
+};
+
+/**
+ * Samples of all threads, counted per wasm function of each action of each profiled code. The profile of each code is
+ * written as folded stacks, "receiver;action;function samples" lines, to <account>.<code sequence>.oc.folded in the
+ * working directory, which flamegraph.pl, inferno and speedscope load. Functions are named from the name section of
+ * the wasm when it has one.
+ */
+class profiles {
+   public:
+      static profiles& instance();
+
+      //attributes the samples taken while running an action of code to the functions of the code
+      void record(apply_context& context, const code_descriptor& code, const uint8_t* code_mapping, const profile_sampler& sampler);
+
+      //writes the profiles of all codes recorded so far
+      void write();
+
+   private:
+      //function index samples outside the compiled code are counted under
+      static constexpr uint32_t host_function = UINT32_MAX;
+
+      struct code_profile {
+         std::string                                   basename;
+         std::vector<std::string>                      function_names; //by function index, missing from the wasm when empty
+         std::map<std::pair<name, uint32_t>, uint64_t> samples;        //by action and function index
+      };
+
+      std::mutex                                                _mtx;
+      std::map<std::pair<name, digest_type>, code_profile>      _profiles; //by receiver and code hash
+};
+
+}}}
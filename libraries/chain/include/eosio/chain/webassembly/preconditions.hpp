@@ -118,6 +118,17 @@ namespace eosio { namespace chain { namespace webassembly {
                        "${code} does not have permission to call this API", ("code", ctx.get_host().get_context().get_receiver()));
          }));
 
+   // starts accounting a call to the host function at index Intrinsic of the intrinsic table, the type converter
+   // of the call ends it
+   template <std::size_t Intrinsic>
+   struct intrinsic_usage_check {
+      EOS_VM_PRECONDITION(check,
+            EOS_VM_INVOKE_ONCE([&](auto&&...) {
+               if( auto& counters = ctx.get_host().get_context().intrinsic_usage )
+                  counters->call_started(Intrinsic);
+            }));
+   };
+
    namespace detail {
       template<typename T>
       vm::span<const char> to_span(const vm::argument_proxy<T*>& val) {
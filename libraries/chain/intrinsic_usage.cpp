@@ -0,0 +1,126 @@
+#include <eosio/chain/intrinsic_usage.hpp>
+
+#include <algorithm>
+#include <string_view>
+#include <tuple>
+
+namespace eosio { namespace chain {
+
+namespace {
+   bool more_time( const intrinsic_usage_entry& a, const intrinsic_usage_entry& b ) {
+      return std::tie( a.time_ns, a.calls ) > std::tie( b.time_ns, b.calls );
+   }
+
+   /// host functions are reported by their name alone unless imported from another module than env
+   string intrinsic_name( std::string_view table_name ) {
+      constexpr std::string_view env_prefix = "env.";
+      if( table_name.substr( 0, env_prefix.size() ) == env_prefix )
+         table_name.remove_prefix( env_prefix.size() );
+      return string( table_name );
+   }
+}
+
+void intrinsic_usage_counters::reset() {
+   _counters.fill( counter{} );
+   _current = no_call;
+}
+
+std::vector<intrinsic_usage_entry> intrinsic_usage_counters::usage()const {
+   constexpr auto table = eosvmoc::get_intrinsic_table();
+   std::vector<intrinsic_usage_entry> result;
+   for( size_t i = 0; i < _counters.size(); ++i ) {
+      if( _counters[i].calls )
+         result.push_back( intrinsic_usage_entry{ intrinsic_name( table[i] ), _counters[i].calls, _counters[i].time_ns } );
+   }
+   std::sort( result.begin(), result.end(), more_time );
+   return result;
+}
+
+intrinsic_usage_tracker& intrinsic_usage_tracker::instance() {
+   static intrinsic_usage_tracker tracker;
+   return tracker;
+}
+
+void intrinsic_usage_tracker::set_window( uint32_t window_sec ) {
+   std::lock_guard g( _mtx );
+   _window_sec = window_sec;
+   if( window_sec == 0 )
+      _buckets.clear();
+   _enabled.store( window_sec > 0, std::memory_order_relaxed );
+}
+
+uint32_t intrinsic_usage_tracker::window()const {
+   std::lock_guard g( _mtx );
+   return _window_sec;
+}
+
+int64_t intrinsic_usage_tracker::current_second()const {
+   return std::chrono::duration_cast<std::chrono::seconds>( clock::now().time_since_epoch() ).count();
+}
+
+void intrinsic_usage_tracker::expire( int64_t now_second )const {
+   while( !_buckets.empty() && _buckets.front().second + _window_sec <= now_second )
+      _buckets.pop_front();
+}
+
+void intrinsic_usage_tracker::record( account_name receiver, const std::vector<intrinsic_usage_entry>& usage ) {
+   if( usage.empty() )
+      return;
+   const int64_t now_second = current_second();
+   std::lock_guard g( _mtx );
+   if( _window_sec == 0 )
+      return;
+   expire( now_second );
+   if( _buckets.empty() || _buckets.back().second != now_second )
+      _buckets.emplace_back().second = now_second;
+   auto& account_usage = _buckets.back().usage[receiver];
+   for( const auto& u : usage ) {
+      auto& e = account_usage[u.intrinsic];
+      e.calls += u.calls;
+      e.time_ns += u.time_ns;
+   }
+}
+
+std::vector<intrinsic_usage_tracker::account_usage>
+intrinsic_usage_tracker::get_usage( const std::optional<account_name>& account, uint32_t limit )const {
+   std::map<account_name, std::map<string, intrinsic_usage_entry>> totals;
+   {
+      const int64_t now_second = current_second();
+      std::lock_guard g( _mtx );
+      expire( now_second );
+      for( const auto& b : _buckets ) {
+         for( const auto& [receiver, intrinsics] : b.usage ) {
+            if( account && *account != receiver )
+               continue;
+            auto& account_totals = totals[receiver];
+            for( const auto& [intrinsic, u] : intrinsics ) {
+               auto& e = account_totals[intrinsic];
+               e.calls += u.calls;
+               e.time_ns += u.time_ns;
+            }
+         }
+      }
+   }
+
+   std::vector<account_usage> result;
+   result.reserve( totals.size() );
+   for( auto& [receiver, intrinsics] : totals ) {
+      account_usage& a = result.emplace_back();
+      a.account = receiver;
+      for( auto& [intrinsic, u] : intrinsics ) {
+         u.intrinsic = intrinsic;
+         a.calls += u.calls;
+         a.time_ns += u.time_ns;
+         a.intrinsics.push_back( std::move( u ) );
+      }
+      std::sort( a.intrinsics.begin(), a.intrinsics.end(), more_time );
+   }
+   std::sort( result.begin(), result.end(), []( const account_usage& a, const account_usage& b ) {
+      return std::tie( a.time_ns, a.calls ) > std::tie( b.time_ns, b.calls );
+   } );
+   if( result.size() > limit )
+      result.resize( limit );
+   return result;
+}
+
+} } // eosio::chain
@@ -1,6 +1,11 @@
 #include <eosio/chain/merkle.hpp>
+#include <eosio/chain/multi_sha256.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/io/raw.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace eosio { namespace chain {
 
 /**
@@ -32,21 +37,65 @@ bool is_canonical_right(const digest_type& val) {
 }
 
 
-digest_type merkle(deque<digest_type> ids) {
+namespace {
+
+constexpr size_t digest_size = sizeof(digest_type::_hash);
+static_assert( sizeof(digest_type) == digest_size );
+
+// pairs hashed by a task of a level hashed in parallel, about 70us of hashing
+constexpr size_t merkle_chunk_pairs = 1024;
+
+// hashes pair_count pairs of level from first_pair into next, many at once; a pair hashes as
+// digest_type::hash(make_canonical_pair(left, right)) would, the two digests packed one after the other
+void hash_pairs( const vector<digest_type>& level, size_t first_pair, size_t pair_count, vector<digest_type>& next ) {
+   vector<char> pairs( pair_count * 2 * digest_size );
+   vector<std::string_view> messages( pair_count );
+   for (size_t i = 0; i < pair_count; i++) {
+      const size_t p = first_pair + i;
+      const auto canonical = make_canonical_pair(level[2 * p], level[(2 * p) + 1]);
+      char* pair = pairs.data() + i * 2 * digest_size;
+      memcpy( pair, canonical.first.data(), digest_size );
+      memcpy( pair + digest_size, canonical.second.data(), digest_size );
+      messages[i] = std::string_view( pair, 2 * digest_size );
+   }
+   multi_sha256( messages.data(), pair_count, next.data() + first_pair );
+}
+
+digest_type merkle_root( const deque<digest_type>& ids, boost::asio::io_context* thread_pool ) {
    if( 0 == ids.size() ) { return digest_type(); }
 
-   while( ids.size() > 1 ) {
-      if( ids.size() % 2 )
-         ids.push_back(ids.back());
+   vector<digest_type> level( ids.begin(), ids.end() );
+   vector<digest_type> next;
+   while( level.size() > 1 ) {
+      if( level.size() % 2 )
+         level.push_back(level.back());
 
-      for (size_t i = 0; i < ids.size() / 2; i++) {
-         ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+      const size_t pair_count = level.size() / 2;
+      next.resize( pair_count );
+      const size_t chunk_count = thread_pool ? (pair_count + merkle_chunk_pairs - 1) / merkle_chunk_pairs : 1;
+      if( chunk_count > 1 ) {
+         parallel_for( *thread_pool, chunk_count, [&]( size_t chunk ) {
+            const size_t first_pair = chunk * merkle_chunk_pairs;
+            hash_pairs( level, first_pair, std::min( merkle_chunk_pairs, pair_count - first_pair ), next );
+         } );
+      } else {
+         hash_pairs( level, 0, pair_count, next );
       }
 
-      ids.resize(ids.size() / 2);
+      std::swap( level, next );
    }
 
-   return ids.front();
+   return level.front();
+}
+
+} // namespace
+
+digest_type merkle(deque<digest_type> ids) {
+   return merkle_root( ids, nullptr );
+}
+
+digest_type merkle(deque<digest_type> ids, boost::asio::io_context& thread_pool) {
+   return merkle_root( ids, &thread_pool );
 }
 
 } } // eosio::chain
@@ -0,0 +1,207 @@
+#include <eosio/chain/metrics.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace eosio { namespace chain { namespace metrics {
+
+namespace {
+
+std::string format_value( double v ) {
+   if( std::isnan( v ) )
+      return "NaN";
+   if( std::isinf( v ) )
+      return v > 0 ? "+Inf" : "-Inf";
+   char buf[32];
+   std::snprintf( buf, sizeof(buf), "%.15g", v );
+   return buf;
+}
+
+/// seconds with microsecond precision, the unit of histogram bounds and sums
+std::string format_us_as_seconds( uint64_t us ) {
+   char buf[32];
+   std::snprintf( buf, sizeof(buf), "%llu.%06llu", static_cast<unsigned long long>( us / 1000000 ),
+                  static_cast<unsigned long long>( us % 1000000 ) );
+   return buf;
+}
+
+void append_sample( std::string& out, const std::string& name, const std::string& label_str, const std::string& value ) {
+   out += name;
+   if( !label_str.empty() ) {
+      out += '{';
+      out += label_str;
+      out += '}';
+   }
+   out += ' ';
+   out += value;
+   out += '\n';
+}
+
+void append_help_and_type( std::string& out, const std::string& name, const std::string& help, metric_type type ) {
+   out += "# HELP " + name + ' ';
+   for( char c : help ) {
+      if( c == '\\' )      out += "\\\\";
+      else if( c == '\n' ) out += "\\n";
+      else                 out += c;
+   }
+   out += "\n# TYPE " + name + ' ' + metric_type_name( type ) + '\n';
+}
+
+/// samples of one family rendered for a scrape
+struct rendered_family {
+   metric_type type;
+   std::string help;
+   std::string samples;
+};
+
+class render_writer : public sample_writer {
+public:
+   explicit render_writer( std::map<std::string, rendered_family>& families )
+   : _families( families ) {}
+
+   void write_counter( const std::string& name, const std::string& help, uint64_t value, const labels& l ) override {
+      append_sample( family_for( name, help, metric_type::counter ), name, registry::format_labels( l ), std::to_string( value ) );
+   }
+
+   void write_gauge( const std::string& name, const std::string& help, double value, const labels& l ) override {
+      append_sample( family_for( name, help, metric_type::gauge ), name, registry::format_labels( l ), format_value( value ) );
+   }
+
+private:
+   std::string& family_for( const std::string& name, const std::string& help, metric_type type ) {
+      auto& f = _families.try_emplace( name, rendered_family{type, help, {}} ).first->second;
+      return f.samples;
+   }
+
+   std::map<std::string, rendered_family>& _families;
+};
+
+} // anonymous namespace
+
+const char* metric_type_name( metric_type t ) {
+   switch( t ) {
+      case metric_type::counter:   return "counter";
+      case metric_type::gauge:     return "gauge";
+      case metric_type::histogram: return "histogram";
+   }
+   return "untyped";
+}
+
+void counter::write( std::string& out, const std::string& name, const std::string& label_str )const {
+   append_sample( out, name, label_str, std::to_string( value() ) );
+}
+
+void gauge::write( std::string& out, const std::string& name, const std::string& label_str )const {
+   append_sample( out, name, label_str, format_value( value() ) );
+}
+
+void histogram::observe_us( uint64_t us ) {
+   // index of the first power of two at or above us
+   const size_t b = us <= 1 ? 0 : 64 - __builtin_clzll( us - 1 );
+   if( b < num_buckets )
+      _buckets[b].fetch_add( 1, std::memory_order_relaxed );
+   _sum_us.fetch_add( us, std::memory_order_relaxed );
+   _count.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void histogram::write( std::string& out, const std::string& name, const std::string& label_str )const {
+   const std::string bucket_name = name + "_bucket";
+   const std::string le_prefix = label_str.empty() ? "le=\"" : label_str + ",le=\"";
+   // count is loaded first so that concurrent observations can not make a bucket exceed +Inf
+   const uint64_t total = count();
+   uint64_t cumulative = 0;
+   for( size_t b = 0; b < num_buckets; ++b ) {
+      cumulative += _buckets[b].load( std::memory_order_relaxed );
+      append_sample( out, bucket_name, le_prefix + format_us_as_seconds( uint64_t(1) << b ) + '"',
+                     std::to_string( std::min( cumulative, total ) ) );
+   }
+   append_sample( out, bucket_name, le_prefix + "+Inf\"", std::to_string( total ) );
+   append_sample( out, name + "_sum", label_str, format_us_as_seconds( sum_us() ) );
+   append_sample( out, name + "_count", label_str, std::to_string( total ) );
+}
+
+registry& registry::instance() {
+   static registry r;
+   return r;
+}
+
+template<typename M>
+M& registry::make( metric_type type, const std::string& name, const std::string& help, const labels& l ) {
+   std::lock_guard g( _mtx );
+   auto& f = _families.try_emplace( name, family{type, help, {}} ).first->second;
+   EOS_ASSERT( f.type == type, misc_exception, "metric ${n} already registered as a ${t}",
+               ("n", name)("t", metric_type_name( f.type )) );
+   auto& m = f.series[format_labels( l )];
+   if( !m )
+      m = std::make_unique<M>();
+   return static_cast<M&>( *m );
+}
+
+counter& registry::make_counter( const std::string& name, const std::string& help, const labels& l ) {
+   return make<counter>( metric_type::counter, name, help, l );
+}
+
+gauge& registry::make_gauge( const std::string& name, const std::string& help, const labels& l ) {
+   return make<gauge>( metric_type::gauge, name, help, l );
+}
+
+histogram& registry::make_histogram( const std::string& name, const std::string& help, const labels& l ) {
+   return make<histogram>( metric_type::histogram, name, help, l );
+}
+
+registry::collector_handle registry::add_collector( collector c ) {
+   std::lock_guard g( _mtx );
+   const auto h = ++_next_handle;
+   _collectors.emplace( h, std::move( c ) );
+   return h;
+}
+
+void registry::remove_collector( collector_handle h ) {
+   std::lock_guard g( _mtx );
+   _collectors.erase( h );
+}
+
+std::string registry::render()const {
+   std::map<std::string, rendered_family> families;
+   std::lock_guard g( _mtx );
+   for( const auto& [name, f] : _families ) {
+      auto& r = families.try_emplace( name, rendered_family{f.type, f.help, {}} ).first->second;
+      for( const auto& [label_str, m] : f.series )
+         m->write( r.samples, name, label_str );
+   }
+
+   render_writer w( families );
+   for( const auto& c : _collectors ) {
+      try {
+         c.second( w );
+      } FC_LOG_AND_DROP()
+   }
+
+   std::string out;
+   for( const auto& [name, r] : families ) {
+      append_help_and_type( out, name, r.help, r.type );
+      out += r.samples;
+   }
+   return out;
+}
+
+std::string registry::format_labels( const labels& l ) {
+   std::string out;
+   for( const auto& [k, v] : l ) {
+      if( !out.empty() )
+         out += ',';
+      out += k + "=\"";
+      for( char c : v ) {
+         if( c == '\\' )      out += "\\\\";
+         else if( c == '"' )  out += "\\\"";
+         else if( c == '\n' ) out += "\\n";
+         else                 out += c;
+      }
+      out += '"';
+   }
+   return out;
+}
+
+} } } // eosio::chain::metrics
@@ -0,0 +1,347 @@
+#include <eosio/chain/multi_sha256.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace eosio { namespace chain {
+
+namespace {
+
+constexpr uint32_t round_constants[64] = {
+   0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+   0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+   0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+   0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+   0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+   0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+   0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t initial_state[8] = {
+   0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+inline uint32_t load_be32( const uint8_t* p ) {
+   return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+inline void store_be32( uint8_t* p, uint32_t v ) {
+   p[0] = uint8_t(v >> 24);
+   p[1] = uint8_t(v >> 16);
+   p[2] = uint8_t(v >> 8);
+   p[3] = uint8_t(v);
+}
+
+/// a message as 64 byte blocks: its full blocks, read in place, then one or two blocks of its tail, padding and length
+struct message_blocks {
+   const uint8_t* data = nullptr;
+   size_t         full_blocks = 0;
+   size_t         total_blocks = 0;
+   size_t         next = 0;
+   uint8_t        tail[128];
+
+   void reset( std::string_view message ) {
+      data = reinterpret_cast<const uint8_t*>( message.data() );
+      full_blocks = message.size() / 64;
+      const size_t rest = message.size() % 64;
+      const size_t tail_size = rest < 56 ? 64 : 128;
+      total_blocks = full_blocks + tail_size / 64;
+      next = 0;
+      memset( tail, 0, tail_size );
+      if( rest )
+         memcpy( tail, data + full_blocks * 64, rest );
+      tail[rest] = 0x80;
+      const uint64_t bits = uint64_t(message.size()) * 8;
+      for( size_t i = 0; i < 8; ++i )
+         tail[tail_size - 1 - i] = uint8_t(bits >> (8 * i));
+   }
+
+   bool done()const { return next == total_blocks; }
+
+   const uint8_t* next_block() {
+      const uint8_t* b = next < full_blocks ? data + next * 64 : tail + (next - full_blocks) * 64;
+      ++next;
+      return b;
+   }
+};
+
+constexpr uint8_t idle_block[64] = {};
+
+/**
+ *  Runs the messages through the lanes of Kernel: each lane hashes one message at a time and takes the next message
+ *  when its message ends, lanes left without a message hash a dummy block until all lanes are done.
+ */
+template <typename Kernel>
+__attribute__((always_inline)) inline void hash_lanes( const std::string_view* messages, size_t count, digest_type* digests ) {
+   constexpr size_t lanes = Kernel::lanes;
+   typename Kernel::state state;
+   message_blocks jobs[lanes];
+   size_t         job_message[lanes];
+   bool           busy[lanes];
+   size_t         next_message = 0;
+   size_t         active = 0;
+
+   const auto start = [&]( size_t lane ) {
+      busy[lane] = next_message < count;
+      if( !busy[lane] )
+         return;
+      jobs[lane].reset( messages[next_message] );
+      job_message[lane] = next_message++;
+      Kernel::start( state, lane );
+      ++active;
+   };
+   for( size_t lane = 0; lane < lanes; ++lane )
+      start( lane );
+
+   while( active ) {
+      const uint8_t* blocks[lanes];
+      for( size_t lane = 0; lane < lanes; ++lane )
+         blocks[lane] = busy[lane] ? jobs[lane].next_block() : idle_block;
+      Kernel::compress( state, blocks );
+      for( size_t lane = 0; lane < lanes; ++lane ) {
+         if( busy[lane] && jobs[lane].done() ) {
+            Kernel::finish( state, lane, reinterpret_cast<uint8_t*>( digests[job_message[lane]].data() ) );
+            --active;
+            start( lane );
+         }
+      }
+   }
+}
+
+/// the 64 rounds of SHA-256 on words T, either one message per uint32_t or one message per lane of a vector
+// a macro rather than a function, vector arguments of functions built for the default target would not be in registers
+#define ROTR( x, n ) (T((x) >> (n)) | T((x) << (32 - (n))))
+
+template <typename T>
+__attribute__((always_inline)) inline void compress_words( T s[8], T w[16] ) {
+   T a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+   for( size_t i = 0; i < 64; ++i ) {
+      if( i >= 16 ) {
+         const T w15 = w[(i - 15) & 15];
+         const T w2  = w[(i - 2) & 15];
+         w[i & 15] += (ROTR( w15, 7 ) ^ ROTR( w15, 18 ) ^ T(w15 >> 3)) + w[(i - 7) & 15]
+                    + (ROTR( w2, 17 ) ^ ROTR( w2, 19 ) ^ T(w2 >> 10));
+      }
+      const T t1 = h + (ROTR( e, 6 ) ^ ROTR( e, 11 ) ^ ROTR( e, 25 )) + ((e & f) ^ (~e & g)) + round_constants[i] + w[i & 15];
+      const T t2 = (ROTR( a, 2 ) ^ ROTR( a, 13 ) ^ ROTR( a, 22 )) + ((a & b) ^ (a & c) ^ (b & c));
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+   }
+   s[0] += a; s[1] += b; s[2] += c; s[3] += d; s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+#undef ROTR
+
+struct scalar_kernel {
+   static constexpr size_t lanes = 1;
+   using state = uint32_t[8];
+
+   static void start( state& s, size_t ) {
+      memcpy( s, initial_state, sizeof(s) );
+   }
+   static void compress( state& s, const uint8_t* const* blocks ) {
+      uint32_t w[16];
+      for( size_t i = 0; i < 16; ++i )
+         w[i] = load_be32( blocks[0] + 4 * i );
+      compress_words( s, w );
+   }
+   static void finish( const state& s, size_t, uint8_t* out ) {
+      for( size_t i = 0; i < 8; ++i )
+         store_be32( out + 4 * i, s[i] );
+   }
+};
+
+#if defined(__x86_64__)
+
+typedef uint32_t u32x4  __attribute__((vector_size(16)));
+typedef uint32_t u32x8  __attribute__((vector_size(32)));
+typedef uint32_t u32x16 __attribute__((vector_size(64)));
+
+/// one message per 32 bit lane of Vector, the instructions used are those of the caller's target
+template <typename Vector>
+struct vector_kernel {
+   static constexpr size_t lanes = sizeof(Vector) / sizeof(uint32_t);
+   using state = Vector[8];
+
+   __attribute__((always_inline)) static void start( state& s, size_t lane ) {
+      for( size_t i = 0; i < 8; ++i )
+         s[i][lane] = initial_state[i];
+   }
+   __attribute__((always_inline)) static void compress( state& s, const uint8_t* const* blocks ) {
+      Vector w[16];
+      for( size_t i = 0; i < 16; ++i )
+         for( size_t lane = 0; lane < lanes; ++lane )
+            w[i][lane] = load_be32( blocks[lane] + 4 * i );
+      compress_words( s, w );
+   }
+   __attribute__((always_inline)) static void finish( const state& s, size_t lane, uint8_t* out ) {
+      for( size_t i = 0; i < 8; ++i )
+         store_be32( out + 4 * i, s[i][lane] );
+   }
+};
+
+// not inlined in hash_lanes, which is built for the default target before being inlined in hash_sha_ni
+#define SHA_NI_TARGET __attribute__((target("sha,sse4.1")))
+
+/// two messages interleaved through the SHA extensions, which hides most of the latency of their rounds
+struct sha_ni_kernel {
+   static constexpr size_t lanes = 2;
+   /// per message, ABEF and CDGH as laid out by sha256rnds2
+   struct state {
+      __m128i abef[2];
+      __m128i cdgh[2];
+   };
+
+   SHA_NI_TARGET static void start( state& s, size_t lane ) {
+      // DCBA and HGFE as stored
+      const __m128i dcba = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &initial_state[0] ) );
+      const __m128i hgfe = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &initial_state[4] ) );
+      const __m128i cdab = _mm_shuffle_epi32( dcba, 0xB1 );
+      const __m128i efgh = _mm_shuffle_epi32( hgfe, 0x1B );
+      s.abef[lane] = _mm_alignr_epi8( cdab, efgh, 8 );
+      s.cdgh[lane] = _mm_blend_epi16( efgh, cdab, 0xF0 );
+   }
+
+   SHA_NI_TARGET static void compress( state& s, const uint8_t* const* blocks ) {
+      const __m128i byte_swap = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+      __m128i m[2][4];
+      __m128i abef[2], cdgh[2];
+      for( size_t lane = 0; lane < 2; ++lane ) {
+         for( size_t j = 0; j < 4; ++j )
+            m[lane][j] = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( blocks[lane] + 16 * j ) ), byte_swap );
+         abef[lane] = s.abef[lane];
+         cdgh[lane] = s.cdgh[lane];
+      }
+      // unrolled so the message words stay in registers
+#pragma GCC unroll 16
+      for( size_t g = 0; g < 16; ++g ) {
+         const __m128i k = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &round_constants[4 * g] ) );
+#pragma GCC unroll 2
+         for( size_t lane = 0; lane < 2; ++lane ) {
+            __m128i* ml = m[lane];
+            if( g >= 4 ) {
+               // words 4g..4g+3 from those 16, 15, 7 and 2 rounds before
+               const __m128i w7 = _mm_alignr_epi8( ml[(g + 3) & 3], ml[(g + 2) & 3], 4 );
+               ml[g & 3] = _mm_sha256msg2_epu32( _mm_add_epi32( _mm_sha256msg1_epu32( ml[g & 3], ml[(g + 1) & 3] ), w7 ),
+                                                 ml[(g + 3) & 3] );
+            }
+            __m128i wk = _mm_add_epi32( ml[g & 3], k );
+            cdgh[lane] = _mm_sha256rnds2_epu32( cdgh[lane], abef[lane], wk );
+            wk = _mm_shuffle_epi32( wk, 0x0E );
+            abef[lane] = _mm_sha256rnds2_epu32( abef[lane], cdgh[lane], wk );
+         }
+      }
+      for( size_t lane = 0; lane < 2; ++lane ) {
+         s.abef[lane] = _mm_add_epi32( s.abef[lane], abef[lane] );
+         s.cdgh[lane] = _mm_add_epi32( s.cdgh[lane], cdgh[lane] );
+      }
+   }
+
+   SHA_NI_TARGET static void finish( const state& s, size_t lane, uint8_t* out ) {
+      const __m128i feba = _mm_shuffle_epi32( s.abef[lane], 0x1B );
+      const __m128i dchg = _mm_shuffle_epi32( s.cdgh[lane], 0xB1 );
+      uint32_t words[8];
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( &words[0] ), _mm_blend_epi16( feba, dchg, 0xF0 ) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( &words[4] ), _mm_alignr_epi8( dchg, feba, 8 ) );
+      for( size_t i = 0; i < 8; ++i )
+         store_be32( out + 4 * i, words[i] );
+   }
+};
+
+#undef SHA_NI_TARGET
+
+__attribute__((target("sha,sse4.1")))
+void hash_sha_ni( const std::string_view* messages, size_t count, digest_type* digests ) {
+   hash_lanes<sha_ni_kernel>( messages, count, digests );
+}
+
+__attribute__((target("avx512f")))
+void hash_avx512( const std::string_view* messages, size_t count, digest_type* digests ) {
+   hash_lanes<vector_kernel<u32x16>>( messages, count, digests );
+}
+
+__attribute__((target("avx2")))
+void hash_avx2( const std::string_view* messages, size_t count, digest_type* digests ) {
+   hash_lanes<vector_kernel<u32x8>>( messages, count, digests );
+}
+
+void hash_sse2( const std::string_view* messages, size_t count, digest_type* digests ) {
+   hash_lanes<vector_kernel<u32x4>>( messages, count, digests );
+}
+
+bool cpu_has_sha_ni() {
+   unsigned int eax, ebx, ecx, edx;
+   if( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+      return false;
+   return (ebx & bit_SHA) && __builtin_cpu_supports( "sse4.1" );
+}
+
+#endif
+
+void hash_scalar( const std::string_view* messages, size_t count, digest_type* digests ) {
+   hash_lanes<scalar_kernel>( messages, count, digests );
+}
+
+} // namespace
+
+const char* to_string( sha256_kernel kernel ) {
+   switch( kernel ) {
+      case sha256_kernel::sha_ni: return "sha_ni";
+      case sha256_kernel::avx512: return "avx512";
+      case sha256_kernel::avx2:   return "avx2";
+      case sha256_kernel::sse2:   return "sse2";
+      case sha256_kernel::scalar: return "scalar";
+   }
+   return "unknown";
+}
+
+bool is_supported( sha256_kernel kernel ) {
+   switch( kernel ) {
+#if defined(__x86_64__)
+      case sha256_kernel::sha_ni: return cpu_has_sha_ni();
+      case sha256_kernel::avx512: return __builtin_cpu_supports( "avx512f" );
+      case sha256_kernel::avx2:   return __builtin_cpu_supports( "avx2" );
+      case sha256_kernel::sse2:   return true;
+#endif
+      case sha256_kernel::scalar: return true;
+      default:                    return false;
+   }
+}
+
+sha256_kernel default_sha256_kernel() {
+   static const sha256_kernel kernel = []() {
+      for( auto k : { sha256_kernel::sha_ni, sha256_kernel::avx512, sha256_kernel::avx2, sha256_kernel::sse2 } ) {
+         if( is_supported( k ) )
+            return k;
+      }
+      return sha256_kernel::scalar;
+   }();
+   return kernel;
+}
+
+void multi_sha256( const std::string_view* messages, size_t count, digest_type* digests, sha256_kernel kernel ) {
+   EOS_ASSERT( is_supported( kernel ), misc_exception, "SHA-256 kernel ${k} is not supported by this CPU", ("k", to_string( kernel )) );
+   switch( kernel ) {
+#if defined(__x86_64__)
+      case sha256_kernel::sha_ni: hash_sha_ni( messages, count, digests ); return;
+      case sha256_kernel::avx512: hash_avx512( messages, count, digests ); return;
+      case sha256_kernel::avx2:   hash_avx2( messages, count, digests ); return;
+      case sha256_kernel::sse2:   hash_sse2( messages, count, digests ); return;
+#endif
+      default:                    hash_scalar( messages, count, digests ); return;
+   }
+}
+
+} } /// eosio::chain
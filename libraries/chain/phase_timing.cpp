@@ -0,0 +1,69 @@
+#include <eosio/chain/phase_timing.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace eosio { namespace chain {
+
+const char* timing_phase_name( timing_phase p ) {
+   switch( p ) {
+      case timing_phase::signature_recovery:  return "signature_recovery";
+      case timing_phase::authorization:       return "authorization";
+      case timing_phase::wasm_instantiation:  return "wasm_instantiation";
+      case timing_phase::wasm_execution:      return "wasm_execution";
+      case timing_phase::undo_session:        return "undo_session";
+      case timing_phase::resource_accounting: return "resource_accounting";
+      case timing_phase::block_finalize:      return "block_finalize";
+      case timing_phase::block_log_append:    return "block_log_append";
+      case timing_phase::fork_db_insert:      return "fork_db_insert";
+      case timing_phase::num_phases:          break;
+   }
+   return "unknown";
+}
+
+phase_timings& phase_timings::instance() {
+   static phase_timings timings;
+   return timings;
+}
+
+void phase_timings::record( timing_phase p, std::chrono::nanoseconds duration ) {
+   const uint64_t ns = duration.count() > 0 ? duration.count() : 0;
+   const uint64_t us = ns / 1000;
+   // index of the first power of two above us
+   const size_t b = std::min<size_t>( us ? 64 - __builtin_clzll( us ) : 0, num_buckets - 1 );
+
+   auto& h = _histograms[static_cast<size_t>( p )];
+   h.count.fetch_add( 1, std::memory_order_relaxed );
+   h.total_ns.fetch_add( ns, std::memory_order_relaxed );
+   h.buckets[b].fetch_add( 1, std::memory_order_relaxed );
+}
+
+std::vector<phase_timings::phase_stats> phase_timings::get_stats()const {
+   std::vector<phase_stats> result;
+   result.reserve( _histograms.size() );
+   for( size_t p = 0; p < _histograms.size(); ++p ) {
+      const auto& h = _histograms[p];
+      phase_stats s;
+      s.phase    = timing_phase_name( static_cast<timing_phase>( p ) );
+      s.count    = h.count.load( std::memory_order_relaxed );
+      s.total_us = h.total_ns.load( std::memory_order_relaxed ) / 1000;
+      for( size_t b = 0; b < num_buckets; ++b ) {
+         const uint64_t c = h.buckets[b].load( std::memory_order_relaxed );
+         if( c )
+            s.buckets.push_back( bucket{ b + 1 < num_buckets ? (uint64_t(1) << b) : std::numeric_limits<uint64_t>::max(), c } );
+      }
+      result.emplace_back( std::move( s ) );
+   }
+   return result;
+}
+
+void phase_timings::reset() {
+   for( auto& h : _histograms ) {
+      h.count = 0;
+      h.total_ns = 0;
+      for( auto& b : h.buckets )
+         b = 0;
+   }
+}
+
+} } // eosio::chain
@@ -0,0 +1,92 @@
+#include <eosio/chain/recovered_key_cache.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+
+namespace eosio { namespace chain {
+
+recovered_key_cache::recovered_key_cache( size_t capacity )
+: shard_capacity( (capacity + num_shards - 1) / num_shards )
+{}
+
+recovered_key_cache& recovered_key_cache::instance() {
+   static recovered_key_cache cache;
+   return cache;
+}
+
+public_key_type recovered_key_cache::recover( const signature_type& sig, const digest_type& digest, bool check_canonical ) {
+   if( shard_capacity.load( std::memory_order_relaxed ) == 0 )
+      return public_key_type( sig, digest, check_canonical );
+
+   fc::sha256::encoder enc;
+   fc::raw::pack( enc, digest );
+   fc::raw::pack( enc, sig );
+   const cache_key key = enc.result();
+   shard& s = shard_for( key );
+
+   {
+      std::lock_guard<std::mutex> g( s.mtx );
+      auto itr = s.index.find( key );
+      // a key recovered without the canonical check may not pass it
+      if( itr != s.index.end() && ( itr->second->canonical || !check_canonical ) ) {
+         s.lru.splice( s.lru.begin(), s.lru, itr->second );
+         hits.fetch_add( 1, std::memory_order_relaxed );
+         return itr->second->pub_key;
+      }
+   }
+
+   misses.fetch_add( 1, std::memory_order_relaxed );
+   public_key_type pub_key( sig, digest, check_canonical ); // throws on failure, which is not cached
+
+   std::lock_guard<std::mutex> g( s.mtx );
+   auto itr = s.index.find( key );
+   if( itr != s.index.end() ) {
+      itr->second->canonical = itr->second->canonical || check_canonical;
+      s.lru.splice( s.lru.begin(), s.lru, itr->second );
+   } else {
+      s.lru.push_front( entry{ key, pub_key, check_canonical } );
+      s.index.emplace( key, s.lru.begin() );
+      evict( s, shard_capacity.load( std::memory_order_relaxed ) );
+   }
+   return pub_key;
+}
+
+void recovered_key_cache::evict( shard& s, size_t max_size ) {
+   while( s.lru.size() > max_size ) {
+      s.index.erase( s.lru.back().key );
+      s.lru.pop_back();
+      evictions.fetch_add( 1, std::memory_order_relaxed );
+   }
+}
+
+void recovered_key_cache::set_capacity( size_t capacity ) {
+   const size_t per_shard = (capacity + num_shards - 1) / num_shards;
+   shard_capacity = per_shard;
+   for( auto& s : shards ) {
+      std::lock_guard<std::mutex> g( s.mtx );
+      evict( s, per_shard );
+   }
+}
+
+recovered_key_cache::stats recovered_key_cache::get_stats()const {
+   stats result;
+   result.hits      = hits.load( std::memory_order_relaxed );
+   result.misses    = misses.load( std::memory_order_relaxed );
+   result.evictions = evictions.load( std::memory_order_relaxed );
+   result.capacity  = shard_capacity.load( std::memory_order_relaxed ) * num_shards;
+   for( const auto& s : shards ) {
+      std::lock_guard<std::mutex> g( s.mtx );
+      result.size += s.lru.size();
+   }
+   return result;
+}
+
+void recovered_key_cache::clear() {
+   for( auto& s : shards ) {
+      std::lock_guard<std::mutex> g( s.mtx );
+      s.index.clear();
+      s.lru.clear();
+   }
+}
+
+} } // eosio::chain
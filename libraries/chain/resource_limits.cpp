@@ -4,6 +4,7 @@
 #include <eosio/chain/transaction_metadata.hpp>
 #include <eosio/chain/transaction.hpp>
 #include <eosio/chain/deep_mind.hpp>
+#include <eosio/chain/phase_timing.hpp>
 #include <boost/tuple/tuple_io.hpp>
 #include <eosio/chain/database_utils.hpp>
 #include <algorithm>
@@ -123,6 +124,7 @@ void resource_limits_manager::set_block_parameters(const elastic_limit_parameter
 }
 
 void resource_limits_manager::update_account_usage(const flat_set<account_name>& accounts, uint32_t time_slot ) {
+   scoped_phase_timer timer( timing_phase::resource_accounting );
    const auto& config = _db.get<resource_limits_config_object>();
    for( const auto& a : accounts ) {
       const auto& usage = _db.get<resource_usage_object,by_owner>( a );
@@ -134,6 +136,7 @@ void resource_limits_manager::update_account_usage(const flat_set<account_name>&
 }
 
 void resource_limits_manager::add_transaction_usage(const flat_set<account_name>& accounts, uint64_t cpu_usage, uint64_t net_usage, uint32_t time_slot ) {
+   scoped_phase_timer timer( timing_phase::resource_accounting );
    const auto& state = _db.get<resource_limits_state_object>();
    const auto& config = _db.get<resource_limits_config_object>();
 
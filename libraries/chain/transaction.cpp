@@ -9,6 +9,8 @@
 
 #include <eosio/chain/config.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/phase_timing.hpp>
+#include <eosio/chain/recovered_key_cache.hpp>
 #include <eosio/chain/transaction.hpp>
 
 namespace eosio { namespace chain {
@@ -60,6 +62,7 @@ fc::microseconds transaction::get_signature_keys( const vector<signature_type>&
       const chain_id_type& chain_id, fc::time_point deadline, const vector<bytes>& cfd,
       flat_set<public_key_type>& recovered_pub_keys, bool allow_duplicate_keys)const
 { try {
+   scoped_phase_timer timer( timing_phase::signature_recovery );
    auto start = fc::time_point::now();
    recovered_pub_keys.clear();
    const digest_type digest = sig_digest(chain_id, cfd);
@@ -68,7 +71,7 @@ fc::microseconds transaction::get_signature_keys( const vector<signature_type>&
       auto now = fc::time_point::now();
       EOS_ASSERT( now < deadline, tx_cpu_usage_exceeded, "transaction signature verification executed for too long ${time}us",
                   ("time", now - start)("now", now)("deadline", deadline)("start", start) );
-      auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( sig, digest );
+      auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( recovered_key_cache::instance().recover( sig, digest, true ) );
       EOS_ASSERT( allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
                   "transaction includes more than one signature signed using the same key associated with public key: ${key}",
                   ("key", *itr ) );
@@ -7,6 +7,7 @@
 #include <eosio/chain/transaction_object.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/deep_mind.hpp>
+#include <eosio/chain/phase_timing.hpp>
 
 #pragma push_macro("N")
 #undef N
@@ -48,7 +49,8 @@ namespace eosio { namespace chain {
                                              const packed_transaction& t,
                                              transaction_checktime_timer&& tmr,
                                              fc::time_point s,
-                                             bool read_only)
+                                             bool read_only,
+                                             bool read_only_thread)
    :control(c)
    ,packed_trx(t)
    ,undo_session()
@@ -56,10 +58,14 @@ namespace eosio { namespace chain {
    ,start(s)
    ,transaction_timer(std::move(tmr))
    ,is_read_only(read_only)
+   ,is_read_only_thread(read_only_thread)
+   ,access_tracer(c.get_state_access_tracer())
    ,net_usage(trace->net_usage)
    ,pseudo_start(s)
    {
-      if (!c.skip_db_sessions()) {
+      EOS_ASSERT( !read_only_thread || read_only, transaction_exception, "only read-only transactions can run on a read-only thread" );
+      if (!c.skip_db_sessions() && !read_only_thread) {
+         scoped_phase_timer timer( timing_phase::undo_session );
          undo_session.emplace(c.mutable_db().start_undo_session(true));
       }
       trace->id = packed_trx.id();
@@ -152,8 +158,15 @@ namespace eosio { namespace chain {
       }
       validate_ram_usage.reserve( bill_to_accounts.size() );
 
+      if( access_tracer ) {
+         for( const auto& a : bill_to_accounts )
+            access_tracer->on_resource_write( a );
+      }
+
       // Update usage values of accounts to reflect new time
-      rl.update_account_usage( bill_to_accounts, block_timestamp_type(control.pending_block_time()).slot );
+      // Not possible on a read-only thread; limits are then computed from the last recorded usage
+      if( !is_read_only_thread )
+         rl.update_account_usage( bill_to_accounts, block_timestamp_type(control.pending_block_time()).slot );
 
       // Calculate the highest network usage and CPU time that all of the billed accounts can afford to be billed
       int64_t account_net_limit = 0;
@@ -272,7 +285,7 @@ namespace eosio { namespace chain {
          validate_referenced_accounts( trx, enforce_whiteblacklist && control.is_producing_block() );
       }
       init( initial_net_usage);
-      if (!skip_recording)
+      if (!skip_recording && !is_read_only_thread)
          record_transaction( packed_trx.id(), trx.expiration ); /// checks for dupes
    }
 
@@ -323,7 +336,7 @@ namespace eosio { namespace chain {
    void transaction_context::finalize() {
       EOS_ASSERT( is_initialized, transaction_exception, "must first initialize" );
 
-      if( is_input ) {
+      if( is_input && !is_read_only_thread ) {
          const transaction& trx = packed_trx.get_transaction();
          auto& am = control.get_mutable_authorization_manager();
          for( const auto& act : trx.actions ) {
@@ -372,15 +385,19 @@ namespace eosio { namespace chain {
 
       validate_cpu_usage_to_bill( billed_cpu_time_us, account_cpu_limit, true, subjective_cpu_bill_us );
 
-      rl.add_transaction_usage( bill_to_accounts, static_cast<uint64_t>(billed_cpu_time_us), net_usage,
-                                block_timestamp_type(control.pending_block_time()).slot ); // Should never fail
+      if( !is_read_only_thread ) {
+         rl.add_transaction_usage( bill_to_accounts, static_cast<uint64_t>(billed_cpu_time_us), net_usage,
+                                   block_timestamp_type(control.pending_block_time()).slot ); // Should never fail
+      }
    }
 
    void transaction_context::squash() {
+      scoped_phase_timer timer( timing_phase::undo_session );
       if (undo_session) undo_session->squash();
    }
 
    void transaction_context::undo() {
+      scoped_phase_timer timer( timing_phase::undo_session );
       if (undo_session) undo_session->undo();
    }
 
@@ -559,6 +576,8 @@ namespace eosio { namespace chain {
    void transaction_context::add_ram_usage( account_name account, int64_t ram_delta ) {
       auto& rl = control.get_mutable_resource_limits_manager();
       rl.add_pending_ram_usage( account, ram_delta );
+      if( access_tracer )
+         access_tracer->on_resource_write( account );
       if( ram_delta > 0 ) {
          validate_ram_usage.insert( account );
       }
@@ -689,6 +708,7 @@ namespace eosio { namespace chain {
 
 
    void transaction_context::schedule_transaction() {
+      EOS_ASSERT( !is_read_only_thread, read_only_thread_write_exception, "cannot schedule a delayed transaction on a read-only thread" );
       // Charge ahead of time for the additional net usage needed to retire the delayed transaction
       // whether that be by successfully executing, soft failure, hard failure, or expiration.
       const transaction& trx = packed_trx.get_transaction();
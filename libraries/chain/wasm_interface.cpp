@@ -15,10 +15,12 @@
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/protocol_state_object.hpp>
 #include <eosio/chain/account_object.hpp>
+#include <eosio/chain/phase_timing.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/crypto/sha256.hpp>
 #include <fc/crypto/sha1.hpp>
 #include <fc/io/raw.hpp>
+#include <fc/scoped_exit.hpp>
 
 #include <softfloat.hpp>
 #include <compiler_builtins.hpp>
@@ -33,8 +35,9 @@
 
 namespace eosio { namespace chain {
 
-   wasm_interface::wasm_interface(vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile)
-     : my( new wasm_interface_impl(vm, eosvmoc_tierup, d, data_dir, eosvmoc_config, profile) ) {}
+   wasm_interface::wasm_interface(vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                                  wasm_module_cache* module_cache)
+     : my( new wasm_interface_impl(vm, eosvmoc_tierup, d, data_dir, eosvmoc_config, profile, module_cache) ) {}
 
    wasm_interface::~wasm_interface() {}
 
@@ -74,14 +77,28 @@ namespace eosio { namespace chain {
       my->code_block_num_last_used(code_hash, vm_type, vm_version, block_num);
    }
 
+   void wasm_interface::removed_code_block_num_last_used(const uint32_t& block_num) {
+      my->removed_code_block_num_last_used(block_num);
+   }
+
    void wasm_interface::current_lib(const uint32_t lib) {
       my->current_lib(lib);
    }
 
+   size_t wasm_interface::cached_modules()const {
+      return my->wasm_instantiation_cache.size();
+   }
+
    void wasm_interface::apply( const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, apply_context& context ) {
       if(substitute_apply && substitute_apply(code_hash, vm_type, vm_version, context))
          return;
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      //execution time in whichever runtime ends up running the code drives the order codes are tiered-up in
+      const fc::time_point start = my->eosvmoc ? fc::time_point::now() : fc::time_point();
+      auto record_execution = fc::make_scoped_exit([&]() {
+         if(my->eosvmoc)
+            my->eosvmoc->cc.record_execution(code_hash, vm_version, fc::time_point::now() - start);
+      });
       if(my->eosvmoc) {
          const chain::eosvmoc::code_descriptor* cd = nullptr;
          try {
@@ -96,12 +113,19 @@ namespace eosio { namespace chain {
             once_is_enough = true;
          }
          if(cd) {
+            scoped_phase_timer timer( timing_phase::wasm_execution );
             my->eosvmoc->exec.execute(*cd, my->eosvmoc->mem, context);
             return;
          }
       }
 #endif
-      my->get_instantiated_module(code_hash, vm_type, vm_version, context.trx_context)->apply(context);
+      const std::unique_ptr<wasm_instantiated_module_interface>* module = nullptr;
+      {
+         scoped_phase_timer timer( timing_phase::wasm_instantiation );
+         module = &my->get_instantiated_module(code_hash, vm_type, vm_version, context.trx_context);
+      }
+      scoped_phase_timer timer( timing_phase::wasm_execution );
+      (*module)->apply(context);
    }
 
    void wasm_interface::exit() {
@@ -0,0 +1,253 @@
+#include <eosio/chain/wasm_module_cache.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace eosio { namespace chain {
+
+namespace {
+   constexpr uint32_t module_cache_magic   = 0x444f4d57; //"WMOD" little endian
+   constexpr uint32_t module_cache_version = 2;
+   constexpr size_t   header_size          = sizeof(module_cache_magic) + sizeof(module_cache_version);
+   /// code_hash, vm_type, vm_version and the size of the initial memory which follows
+   constexpr size_t   record_fields_size   = sizeof(digest_type) + 2 * sizeof(uint8_t) + sizeof(uint32_t);
+   /// the fields followed by the checksum of the record
+   constexpr size_t   record_header_size   = record_fields_size + sizeof(digest_type);
+
+   /// sha256 of the fields and the initial memory of a record
+   digest_type record_checksum( const char* record, size_t memory_size ) {
+      digest_type::encoder enc;
+      enc.write( record, record_fields_size );
+      enc.write( record + record_header_size, memory_size );
+      return enc.result();
+   }
+}
+
+wasm_module_cache::wasm_module_cache( const fc::path& file, uint64_t max_size )
+: _file_path( file )
+, _max_size( max_size ) {
+   auto discard = [&]( const std::string& why ) {
+      wlog( "discarding wasm module cache ${f}: ${e}", ("f", _file_path.generic_string())("e", why) );
+      _index.clear();
+      _mapped_region.reset();
+      _file_mapping.reset();
+      create();
+   };
+   try {
+      load();
+   } catch( const fc::exception& e ) {
+      discard( e.to_string() );
+   } catch( const std::exception& e ) {
+      discard( e.what() );
+   }
+   ilog( "wasm module cache ${f} loaded with ${n} modules", ("f", _file_path.generic_string())("n", _index.size()) );
+}
+
+void wasm_module_cache::load() {
+   if( !fc::exists( _file_path ) || fc::file_size( _file_path ) < header_size ) {
+      create();
+      return;
+   }
+
+   _file_mapping.emplace( _file_path.generic_string().c_str(), boost::interprocess::read_only );
+   _mapped_region.emplace( *_file_mapping, boost::interprocess::read_only );
+   fc::datastream<const char*> ds( static_cast<const char*>( _mapped_region->get_address() ), _mapped_region->get_size() );
+
+   uint32_t magic = 0, version = 0;
+   fc::raw::unpack( ds, magic );
+   fc::raw::unpack( ds, version );
+   EOS_ASSERT( magic == module_cache_magic && version == module_cache_version, misc_exception,
+               "unknown wasm module cache format" );
+
+   // a crash may have left the last record partially written, the contents of the others are checked by find()
+   size_t valid_size = ds.tellp();
+   while( ds.remaining() >= record_header_size ) {
+      const char* record = ds.pos();
+      cache_key k;
+      uint32_t size = 0;
+      fc::raw::unpack( ds, k.code_hash );
+      fc::raw::unpack( ds, k.vm_type );
+      fc::raw::unpack( ds, k.vm_version );
+      fc::raw::unpack( ds, size );
+      ds.skip( sizeof(digest_type) );
+      if( ds.remaining() < size )
+         break;
+      _index[k] = cached_memory{ record, size, false, ++_use_count };
+      ds.skip( size );
+      valid_size = ds.tellp();
+   }
+   if( valid_size < _mapped_region->get_size() ) {
+      wlog( "dropping ${n} bytes of a partially written entry at the end of wasm module cache ${f}",
+            ("n", _mapped_region->get_size() - valid_size)("f", _file_path.generic_string()) );
+      fc::resize_file( _file_path, valid_size );
+   }
+   _file_size = valid_size;
+
+   _file.set_file_path( _file_path );
+   _file.open( fc::cfile::create_or_update_rw_mode );
+
+   // the max size was lowered since the file was written
+   if( _file_size > _max_size )
+      compact();
+}
+
+void wasm_module_cache::compact() {
+   std::vector<std::pair<uint64_t, cache_key>> by_recency;
+   by_recency.reserve( _index.size() );
+   for( const auto& [k, m] : _index )
+      by_recency.emplace_back( m.last_used, k );
+   std::sort( by_recency.begin(), by_recency.end(), []( const auto& a, const auto& b ) { return a.first > b.first; } );
+
+   size_t kept = 0;
+   uint64_t kept_size = header_size;
+   for( ; kept < by_recency.size(); ++kept ) {
+      const uint64_t record_size = record_header_size + _index[by_recency[kept].second].size;
+      if( kept_size + record_size > _max_size / 2 )
+         break;
+      kept_size += record_size;
+   }
+   by_recency.resize( kept );
+   std::reverse( by_recency.begin(), by_recency.end() );
+
+   // the file is replaced as a whole, a crash leaves either the old or the new one
+   const fc::path tmp_path = _file_path.generic_string() + ".tmp";
+   auto compact_failed = [&]( const std::string& why ) {
+      // the entries are still read from where they were, nothing more is cached until the next restart
+      elog( "failed to compact wasm module cache ${f}: ${e}", ("f", _file_path.generic_string())("e", why) );
+      std::remove( tmp_path.generic_string().c_str() );
+      _file.close();
+   };
+   std::vector<uint64_t> offsets;
+   try {
+      fc::cfile tmp;
+      tmp.set_file_path( tmp_path );
+      tmp.open( fc::cfile::truncate_rw_mode );
+      tmp.write( reinterpret_cast<const char*>( &module_cache_magic ), sizeof(module_cache_magic) );
+      tmp.write( reinterpret_cast<const char*>( &module_cache_version ), sizeof(module_cache_version) );
+      uint64_t offset = header_size;
+      for( const auto& [last_used, k] : by_recency ) {
+         const cached_memory& m = _index[k];
+         tmp.write( m.record, record_header_size + m.size );
+         offsets.push_back( offset );
+         offset += record_header_size + m.size;
+      }
+      tmp.flush();
+      tmp.sync();
+      tmp.close();
+      _file.close();
+      fc::rename( tmp_path, _file_path );
+
+      // the records kept are read from the new file, entries dropped are parsed again when next instantiated
+      auto file_mapping = std::make_optional<boost::interprocess::file_mapping>( _file_path.generic_string().c_str(), boost::interprocess::read_only );
+      auto mapped_region = std::make_optional<boost::interprocess::mapped_region>( *file_mapping, boost::interprocess::read_only );
+      const char* base = static_cast<const char*>( mapped_region->get_address() );
+      std::unordered_map<cache_key, cached_memory, cache_key_hash> index;
+      for( size_t i = 0; i < by_recency.size(); ++i ) {
+         cached_memory m = _index[by_recency[i].second];
+         m.record = base + offsets[i];
+         index[by_recency[i].second] = m;
+      }
+
+      _file.set_file_path( _file_path );
+      _file.open( fc::cfile::create_or_update_rw_mode );
+      ilog( "compacted wasm module cache ${f} from ${n} to ${k} modules", ("f", _file_path.generic_string())("n", _index.size())("k", index.size()) );
+      _index.swap( index );
+      _appended.clear();
+      _mapped_region = std::move( mapped_region );
+      _file_mapping = std::move( file_mapping );
+      _file_size = offset;
+   } catch( const fc::exception& e ) {
+      compact_failed( e.to_string() );
+   } catch( const std::exception& e ) {
+      compact_failed( e.what() );
+   }
+}
+
+void wasm_module_cache::create() {
+   try {
+      _file.set_file_path( _file_path );
+      _file.open( fc::cfile::truncate_rw_mode );
+      _file.write( reinterpret_cast<const char*>( &module_cache_magic ), sizeof(module_cache_magic) );
+      _file.write( reinterpret_cast<const char*>( &module_cache_version ), sizeof(module_cache_version) );
+      _file.flush();
+      _file.sync();
+      _file_size = header_size;
+   } catch( const std::exception& e ) {
+      elog( "unable to create wasm module cache ${f}, modules will not be cached: ${e}",
+            ("f", _file_path.generic_string())("e", e.what()) );
+      _file.close();
+   }
+}
+
+std::optional<std::vector<uint8_t>> wasm_module_cache::find( const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version ) {
+   std::lock_guard g( _mtx );
+   auto it = _index.find( cache_key{ code_hash, vm_type, vm_version } );
+   if( it == _index.end() )
+      return {};
+   cached_memory& m = it->second;
+   if( !m.verified ) {
+      // the contents of a record found on startup may have been lost to a crash although its length is right
+      digest_type stored;
+      memcpy( stored.data(), m.record + record_fields_size, sizeof(digest_type) );
+      if( record_checksum( m.record, m.size ) != stored ) {
+         wlog( "dropping corrupt entry for code ${h} from wasm module cache ${f}", ("h", code_hash)("f", _file_path.generic_string()) );
+         _index.erase( it );
+         return {};
+      }
+      m.verified = true;
+   }
+   m.last_used = ++_use_count;
+   const uint8_t* data = reinterpret_cast<const uint8_t*>( m.record + record_header_size );
+   return std::vector<uint8_t>( data, data + m.size );
+}
+
+void wasm_module_cache::insert( const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version, const std::vector<uint8_t>& initial_memory ) {
+   std::lock_guard g( _mtx );
+   const cache_key k{ code_hash, vm_type, vm_version };
+   const size_t record_size = record_header_size + initial_memory.size();
+   if( !_file.is_open() || _index.count( k ) || header_size + record_size > _max_size / 2 )
+      return;
+   if( _file_size + record_size > _max_size ) {
+      compact();
+      if( !_file.is_open() )
+         return;
+   }
+
+   std::vector<char> record( record_size );
+   fc::datastream<char*> ds( record.data(), record.size() );
+   fc::raw::pack( ds, code_hash );
+   fc::raw::pack( ds, vm_type );
+   fc::raw::pack( ds, vm_version );
+   fc::raw::pack( ds, static_cast<uint32_t>( initial_memory.size() ) );
+   ds.skip( sizeof(digest_type) );
+   ds.write( reinterpret_cast<const char*>( initial_memory.data() ), initial_memory.size() );
+   const digest_type checksum = record_checksum( record.data(), initial_memory.size() );
+   memcpy( record.data() + record_fields_size, checksum.data(), sizeof(digest_type) );
+
+   try {
+      _file.write( record.data(), record.size() );
+      _file.flush();
+      _file.sync();
+   } catch( const std::exception& e ) {
+      // later records would follow a partial one, stop appending until the next restart discards it
+      elog( "failed to append to wasm module cache ${f}: ${e}", ("f", _file_path.generic_string())("e", e.what()) );
+      _file.close();
+      return;
+   }
+   _file_size += record_size;
+
+   const std::vector<char>& appended = _appended.emplace_back( std::move( record ) );
+   _index[k] = cached_memory{ appended.data(), initial_memory.size(), true, ++_use_count };
+}
+
+size_t wasm_module_cache::size()const {
+   std::lock_guard g( _mtx );
+   return _index.size();
+}
+
+} } // eosio::chain
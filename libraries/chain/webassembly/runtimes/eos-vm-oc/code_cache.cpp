@@ -9,6 +9,9 @@
 #include <eosio/chain/webassembly/eos-vm-oc/compile_monitor.hpp>
 #include <eosio/chain/exceptions.hpp>
 
+#include <algorithm>
+#include <fstream>
+
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <sys/mman.h>
@@ -27,7 +30,7 @@ namespace eosio { namespace chain { namespace eosvmoc {
 static constexpr size_t header_offset = 512u;
 static constexpr size_t header_size = 512u;
 static constexpr size_t total_header_size = header_offset + header_size;
-static constexpr uint64_t header_id = 0x32434f4d56534f45ULL; //"EOSVMOC2" little endian
+static constexpr uint64_t header_id = 0x33434f4d56534f45ULL; //"EOSVMOC3" little endian
 
 struct code_cache_header {
    uint64_t id = header_id;
@@ -39,12 +42,19 @@ static constexpr size_t descriptor_ptr_from_file_start = header_offset + offseto
 
 static_assert(sizeof(code_cache_header) <= header_size, "code_cache_header too big");
 
+//hotness is kept apart from the code cache so that it survives the cache being wiped or rebuilt
+static constexpr uint32_t hotness_magic = 0x544f4853; //"SHOT" little endian
+static constexpr uint32_t hotness_version = 1;
+static constexpr size_t max_persisted_hotness = 10000;
+
 code_cache_async::code_cache_async(const bfs::path data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
    code_cache_base(data_dir, eosvmoc_config, db),
-   _result_queue(eosvmoc_config.threads * 2),
-   _threads(eosvmoc_config.threads)
+   _hotness_file_path(data_dir/"code_cache_hotness.bin"),
+   _warmup_compiles(eosvmoc_config.warmup_compiles)
 {
-   FC_ASSERT(_threads, "EOS VM OC requires at least 1 compile thread");
+   FC_ASSERT(eosvmoc_config.threads, "EOS VM OC requires at least 1 compile thread");
+
+   _hotness = load_code_hotness(_hotness_file_path);
 
    wait_on_compile_monitor_message();
 
@@ -58,6 +68,133 @@ code_cache_async::~code_cache_async() {
    _compile_monitor_write_socket.shutdown(local::datagram_protocol::socket::shutdown_send);
    _monitor_reply_thread.join();
    consume_compile_thread_queue();
+   save_code_hotness(_hotness_file_path, _hotness, max_persisted_hotness);
+}
+
+code_hotness_map load_code_hotness(const bfs::path& file) {
+   code_hotness_map hotness;
+   if(!bfs::exists(file))
+      return hotness;
+   try {
+      std::ifstream in(file.generic_string(), std::ios::binary);
+      std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+      fc::datastream<const char*> ds(content.data(), content.size());
+
+      uint32_t magic = 0, version = 0;
+      fc::raw::unpack(ds, magic);
+      fc::raw::unpack(ds, version);
+      if(magic != hotness_magic || version != hotness_version) {
+         wlog("ignoring EOS VM OC code hotness file ${f} of an unknown format", ("f", file.generic_string()));
+         return hotness;
+      }
+
+      unsigned_int size;
+      fc::raw::unpack(ds, size);
+      for(uint32_t i = 0; i < size.value; ++i) {
+         code_tuple ct;
+         code_hotness h;
+         fc::raw::unpack(ds, ct);
+         fc::raw::unpack(ds, h);
+         //age what was recorded by previous runs so that codes which are no longer used give way to current ones
+         h.executions /= 2;
+         h.cpu_us /= 2;
+         hotness[ct] = h;
+      }
+   } catch(const fc::exception& e) {
+      wlog("failed to load EOS VM OC code hotness from ${f}: ${e}", ("f", file.generic_string())("e", e.to_detail_string()));
+      hotness.clear();
+   }
+   return hotness;
+}
+
+void save_code_hotness(const bfs::path& file, const code_hotness_map& hotness, size_t max_codes) {
+   try {
+      std::vector<std::pair<code_tuple, code_hotness>> entries(hotness.begin(), hotness.end());
+      if(entries.size() > max_codes) {
+         std::nth_element(entries.begin(), entries.begin() + max_codes, entries.end(), [](const auto& a, const auto& b) {
+            return a.second.hotter_than(b.second);
+         });
+         entries.resize(max_codes);
+      }
+
+      std::ofstream out(file.generic_string(), std::ios::out | std::ios::binary | std::ofstream::trunc);
+      fc::raw::pack(out, hotness_magic);
+      fc::raw::pack(out, hotness_version);
+      fc::raw::pack(out, unsigned_int(entries.size()));
+      for(const auto& [ct, h] : entries) {
+         fc::raw::pack(out, ct);
+         fc::raw::pack(out, h);
+      }
+   } catch(const fc::exception& e) {
+      elog("failed to save EOS VM OC code hotness to ${f}: ${e}", ("f", file.generic_string())("e", e.to_detail_string()));
+   } catch(const std::exception& e) {
+      elog("failed to save EOS VM OC code hotness to ${f}: ${e}", ("f", file.generic_string())("e", e.what()));
+   }
+}
+
+std::vector<code_tuple> hottest_codes(const code_hotness_map& hotness, size_t max_codes,
+                                      const std::function<bool(const code_tuple&)>& include) {
+   std::vector<std::pair<code_tuple, code_hotness>> candidates;
+   for(const auto& [ct, h] : hotness) {
+      if(include(ct))
+         candidates.emplace_back(ct, h);
+   }
+   const size_t n = std::min<size_t>(max_codes, candidates.size());
+   std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(), [](const auto& a, const auto& b) {
+      return a.second.hotter_than(b.second);
+   });
+
+   std::vector<code_tuple> codes;
+   codes.reserve(n);
+   for(size_t i = 0; i < n; ++i)
+      codes.push_back(candidates[i].first);
+   return codes;
+}
+
+void code_cache_async::record_execution(const digest_type& code_id, const uint8_t& vm_version, const fc::microseconds& cpu) {
+   code_hotness& h = _hotness[code_tuple{code_id, vm_version}];
+   ++h.executions;
+   h.cpu_us += cpu.count();
+}
+
+//compiles the hottest codes of previous runs which are not in the cache, e.g. after the cache was wiped. Done on first
+// use rather than on construction since the chain state may not be loaded yet, e.g. when starting from a snapshot
+void code_cache_async::queue_warmup_compiles() {
+   const std::vector<code_tuple> warmup = hottest_codes(_hotness, _warmup_compiles, [&](const code_tuple& ct) {
+      return !_cache_index.get<by_hash>().count(boost::make_tuple(ct.code_id, ct.vm_version)) && !_blacklist.count(ct);
+   });
+
+   //the compile monitor queues what it can't start right away, hottest first
+   size_t queued = 0;
+   for(const code_tuple& ct : warmup) {
+      if(_outstanding_compiles.count(ct))
+         continue;
+      if(!start_compile(ct)) {
+         _hotness.erase(ct);
+         continue;
+      }
+      ++queued;
+   }
+   if(queued)
+      ilog("EOS VM OC warming up ${n} of the most executed codes", ("n", queued));
+}
+
+uint64_t code_cache_async::compile_priority(const code_tuple& ct) const {
+   auto it = _hotness.find(ct);
+   return it == _hotness.end() ? 0 : it->second.priority();
+}
+
+bool code_cache_async::start_compile(const code_tuple& ct) {
+   const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(ct.code_id, 0, ct.vm_version));
+   if(!codeobject)
+      return false;
+
+   const uint64_t priority = compile_priority(ct);
+   _outstanding_compiles.emplace(ct, outstanding_compile{false, priority});
+   std::vector<wrapped_fd> fds_to_pass;
+   fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
+   FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct, priority }, fds_to_pass), "EOS VM failed to communicate to OOP manager");
+   return true;
 }
 
 //remember again: wait_on_compile_monitor_message's callback is non-main thread!
@@ -74,7 +211,10 @@ void code_cache_async::wait_on_compile_monitor_message() {
          return;
       }
 
-      _result_queue.push(std::get<wasm_compilation_result_message>(message));
+      {
+         std::lock_guard g(_result_queue_mutex);
+         _result_queue.emplace_back(std::move(std::get<wasm_compilation_result_message>(message)));
+      }
 
       wait_on_compile_monitor_message();
    });
@@ -83,85 +223,83 @@ void code_cache_async::wait_on_compile_monitor_message() {
 
 //number processed, bytes available (only if number processed > 0)
 std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
+   std::vector<wasm_compilation_result_message> results;
+   {
+      std::lock_guard g(_result_queue_mutex);
+      results.swap(_result_queue);
+   }
+
    size_t bytes_remaining = 0;
-   size_t gotsome = _result_queue.consume_all([&](const wasm_compilation_result_message& result) {
-      if(_outstanding_compiles_and_poison[result.code] == false) {
+   for(const wasm_compilation_result_message& result : results) {
+      if(std::holds_alternative<compilation_result_cancelled>(result.result))
+         _metrics.compiles_cancelled.inc();
+      else {
+         _metrics.compile_time.observe_us(result.compile_time_us);
+         _metrics.compile_queue_time.observe_us(result.queue_time_us);
+      }
+      if(_outstanding_compiles[result.code].poisoned == false) {
          std::visit(overloaded {
             [&](const code_descriptor& cd) {
                _cache_index.push_front(cd);
+               on_cache_insert(result.code, result.code_size);
             },
             [&](const compilation_result_unknownfailure&) {
                wlog("code ${c} failed to tier-up with EOS VM OC", ("c", result.code.code_id));
                _blacklist.emplace(result.code);
             },
             [&](const compilation_result_toofull&) {
-               run_eviction_round();
-            }
+               run_eviction_round(result.cache_free_bytes);
+            },
+            [&](const compilation_result_cancelled&) {}
          }, result.result);
       }
-      _outstanding_compiles_and_poison.erase(result.code);
+      _outstanding_compiles.erase(result.code);
       bytes_remaining = result.cache_free_bytes;
-   });
+      _metrics.free_bytes.set(bytes_remaining);
+   }
 
-   return {gotsome, bytes_remaining};
+   return {results.size(), bytes_remaining};
 }
 
 const code_descriptor* const code_cache_async::get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version) {
+   if(_warmup_pending) {
+      _warmup_pending = false;
+      queue_warmup_compiles();
+   }
+
    //if there are any outstanding compiles, process the result queue now
-   if(_outstanding_compiles_and_poison.size()) {
+   if(_outstanding_compiles.size()) {
       auto [count_processed, bytes_remaining] = consume_compile_thread_queue();
 
       if(count_processed)
          check_eviction_threshold(bytes_remaining);
-
-      while(count_processed && _queued_compiles.size()) {
-         auto nextup = _queued_compiles.begin();
-
-         //it's not clear this check is required: if apply() was called for code then it existed in the code_index; and then
-         // if we got notification of it no longer existing we would have removed it from queued_compiles
-         const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(nextup->code_id, 0, nextup->vm_version));
-         if(codeobject) {
-            _outstanding_compiles_and_poison.emplace(*nextup, false);
-            std::vector<wrapped_fd> fds_to_pass;
-            fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-            FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ *nextup }, fds_to_pass), "EOS VM failed to communicate to OOP manager");
-            --count_processed;
-         }
-         _queued_compiles.erase(nextup);
-      }
    }
 
    //check for entry in cache
    code_cache_index::index<by_hash>::type::iterator it = _cache_index.get<by_hash>().find(boost::make_tuple(code_id, vm_version));
    if(it != _cache_index.get<by_hash>().end()) {
       _cache_index.relocate(_cache_index.begin(), _cache_index.project<0>(it));
+      on_cache_hit({code_id, vm_version});
       return &*it;
    }
+   _metrics.misses.inc();
 
    const code_tuple ct = code_tuple{code_id, vm_version};
 
    if(_blacklist.find(ct) != _blacklist.end())
       return nullptr;
-   if(auto it = _outstanding_compiles_and_poison.find(ct); it != _outstanding_compiles_and_poison.end()) {
-      it->second = false;
-      return nullptr;
-   }
-   if(_queued_compiles.find(ct) != _queued_compiles.end())
-      return nullptr;
-
-   if(_outstanding_compiles_and_poison.size() >= _threads) {
-      _queued_compiles.emplace(ct);
+   if(auto it = _outstanding_compiles.find(ct); it != _outstanding_compiles.end()) {
+      it->second.poisoned = false;
+      //the code got a lot hotter while waiting for a compile worker, let it move up the compile monitor's queue
+      const uint64_t priority = compile_priority(ct);
+      if(priority > it->second.priority * 2) {
+         it->second.priority = priority;
+         write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct, priority });
+      }
       return nullptr;
    }
 
-   const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(code_id, 0, vm_version));
-   if(!codeobject) //should be impossible right?
-      return nullptr;
-
-   _outstanding_compiles_and_poison.emplace(ct, false);
-   std::vector<wrapped_fd> fds_to_pass;
-   fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-   write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct }, fds_to_pass);
+   start_compile(ct);
    return nullptr;
 }
 
@@ -179,8 +317,10 @@ const code_descriptor* const code_cache_sync::get_descriptor_for_code_sync(const
    code_cache_index::index<by_hash>::type::iterator it = _cache_index.get<by_hash>().find(boost::make_tuple(code_id, vm_version));
    if(it != _cache_index.get<by_hash>().end()) {
       _cache_index.relocate(_cache_index.begin(), _cache_index.project<0>(it));
+      on_cache_hit({code_id, vm_version});
       return &*it;
    }
+   _metrics.misses.inc();
 
    const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(code_id, 0, vm_version));
    if(!codeobject) //should be impossible right?
@@ -197,9 +337,12 @@ const code_descriptor* const code_cache_sync::get_descriptor_for_code_sync(const
    wasm_compilation_result_message result = std::get<wasm_compilation_result_message>(message);
    EOS_ASSERT(std::holds_alternative<code_descriptor>(result.result), wasm_execution_error, "failed to compile wasm");
 
+   _metrics.free_bytes.set(result.cache_free_bytes);
    check_eviction_threshold(result.cache_free_bytes);
 
-   return &*_cache_index.push_front(std::move(std::get<code_descriptor>(result.result))).first;
+   const code_descriptor* cd = &*_cache_index.push_front(std::move(std::get<code_descriptor>(result.result))).first;
+   on_cache_insert(result.code, result.code_size);
+   return cd;
 }
 
 code_cache_base::code_cache_base(const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
@@ -267,17 +410,24 @@ code_cache_base::code_cache_base(const boost::filesystem::path data_dir, const e
             allocator->deallocate(code_mapping + cd.initdata_begin);
             continue;
          }
+         const size_t size = allocator->size(code_mapping + cd.code_begin) + allocator->size(code_mapping + cd.initdata_begin);
+         const code_tuple ct{cd.code_hash, cd.vm_version};
          _cache_index.push_back(std::move(cd));
+         on_cache_insert(ct, size);
       }
       allocator->deallocate(code_mapping + cache_header.serialized_descriptor_index);
 
       ilog("EOS VM Optimized Compiler code cache loaded with ${c} entries; ${f} of ${t} bytes free", ("c", number_entries)("f", allocator->get_free_memory())("t", allocator->get_size()));
    }
+   _metrics.free_bytes.set(allocator->get_free_memory());
    munmap(code_mapping, eosvmoc_config.cache_size);
 
    _free_bytes_eviction_threshold = eosvmoc_config.cache_size * .1;
 
-   wrapped_fd compile_monitor_conn = get_connection_to_compile_monitor(_cache_fd);
+   if(!eosvmoc_config.shared_cache_dir.empty())
+      check_shared_cache_dir(eosvmoc_config.shared_cache_dir);
+   wrapped_fd compile_monitor_conn = get_connection_to_compile_monitor(_cache_fd, initialize_message{eosvmoc_config.shared_cache_dir.generic_string(),
+                                                                                                     eosvmoc_config.threads});
 
    //okay, let's do this by the book: we're not allowed to write & read on different threads to the same asio socket. So create two fds
    //representing the same unix socket. we'll read on one and write on the other
@@ -355,31 +505,95 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
    if(it != _cache_index.get<by_hash>().end()) {
       write_message_with_fds(_compile_monitor_write_socket, evict_wasms_message{ {*it} });
       _cache_index.get<by_hash>().erase(it);
+      _eviction_policy.erase({code_id, vm_version});
+      _metrics.entries.set(_cache_index.size());
    }
 
-   //if it's in the queued list, erase it
-   _queued_compiles.erase({code_id, vm_version});
+   _hotness.erase({code_id, vm_version});
+
+   //if it's queued or being compiled ask the compile monitor to cancel it, and in case the compile completes before
+   //the cancel is seen set a poison boolean that indicates not to insert the code in to the cache
+   const auto compiling_it = _outstanding_compiles.find({code_id, vm_version});
+   if(compiling_it != _outstanding_compiles.end()) {
+      compiling_it->second.poisoned = true;
+      write_message_with_fds(_compile_monitor_write_socket, cancel_compile_message{ {code_id, vm_version} });
+   }
+}
+
+void gdsf_eviction_policy::insert(const code_tuple& ct, size_t size) {
+   entry_stats& stats = _entries[ct];
+   stats.size = std::max<size_t>(size, 1);
+   stats.hits = 1;
+   stats.priority = _floor + 1.0 / stats.size;
+}
+
+void gdsf_eviction_policy::hit(const code_tuple& ct) {
+   entry_stats& stats = _entries[ct];
+   stats.size = std::max<size_t>(stats.size, 1);
+   ++stats.hits;
+   stats.priority = _floor + double(stats.hits) / stats.size;
+}
 
-   //however, if it's currently being compiled there is no way to cancel the compile,
-   //so instead set a poison boolean that indicates not to insert the code in to the cache
-   //once the compile is complete
-   const std::unordered_map<code_tuple, bool>::iterator compiling_it = _outstanding_compiles_and_poison.find({code_id, vm_version});
-   if(compiling_it != _outstanding_compiles_and_poison.end())
-      compiling_it->second = true;
+void gdsf_eviction_policy::erase(const code_tuple& ct) {
+   _entries.erase(ct);
 }
 
-void code_cache_base::run_eviction_round() {
+std::vector<std::pair<code_tuple, size_t>> gdsf_eviction_policy::evict(size_t bytes_to_free) {
+   std::vector<std::pair<double, code_tuple>> candidates;
+   candidates.reserve(_entries.size());
+   for(const auto& [ct, stats] : _entries)
+      candidates.emplace_back(stats.priority, ct);
+   std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+   std::vector<std::pair<code_tuple, size_t>> evicted;
+   size_t freed = 0;
+   for(const auto& [priority, ct] : candidates) {
+      if(freed >= bytes_to_free || _entries.size() <= 1)
+         break;
+      const size_t size = _entries[ct].size;
+      freed += size;
+      _floor = std::max(_floor, priority);
+      evicted.emplace_back(ct, size);
+      _entries.erase(ct);
+   }
+   return evicted;
+}
+
+void code_cache_base::on_cache_insert(const code_tuple& ct, size_t size) {
+   _eviction_policy.insert(ct, size);
+   _metrics.entries.set(_cache_index.size());
+}
+
+void code_cache_base::on_cache_hit(const code_tuple& ct) {
+   _metrics.hits.inc();
+   _eviction_policy.hit(ct);
+}
+
+void code_cache_base::run_eviction_round(size_t free_bytes) {
+   //free what is missing to get back above the threshold plus some headroom, so rounds don't run back to back
+   const size_t bytes_to_free = (free_bytes < _free_bytes_eviction_threshold ? _free_bytes_eviction_threshold - free_bytes : 0) +
+                                _free_bytes_eviction_threshold / 4;
+
    evict_wasms_message evict_msg;
-   for(unsigned int i = 0; i < 25 && _cache_index.size() > 1; ++i) {
-      evict_msg.codes.emplace_back(_cache_index.back());
-      _cache_index.pop_back();
+   size_t freed = 0;
+   for(const auto& [ct, size] : _eviction_policy.evict(bytes_to_free)) {
+      code_cache_index::index<by_hash>::type::iterator it = _cache_index.get<by_hash>().find(boost::make_tuple(ct.code_id, ct.vm_version));
+      if(it == _cache_index.get<by_hash>().end())
+         continue;
+      freed += size;
+      evict_msg.codes.emplace_back(*it);
+      _cache_index.get<by_hash>().erase(it);
    }
    write_message_with_fds(_compile_monitor_write_socket, evict_msg);
+
+   _metrics.evictions.inc(evict_msg.codes.size());
+   _metrics.evicted_bytes.inc(freed);
+   _metrics.entries.set(_cache_index.size());
 }
 
 void code_cache_base::check_eviction_threshold(size_t free_bytes) {
    if(free_bytes < _free_bytes_eviction_threshold)
-      run_eviction_round();
+      run_eviction_round(free_bytes);
 }
 
 }}}
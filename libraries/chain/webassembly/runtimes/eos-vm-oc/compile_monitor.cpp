@@ -9,9 +9,21 @@
 
 #include <eosio/chain/exceptions.hpp>
 
+#include <fc/crypto/sha256.hpp>
+
 #include <boost/asio/local/datagram_protocol.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/signals2.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
 namespace eosio { namespace chain { namespace eosvmoc {
 
 using namespace boost::asio;
@@ -33,12 +45,103 @@ static void copy_memfd_contents_to_pointer(void* dst, int fd) {
    munmap(contents, st.st_size);
 }
 
+//Compiled code shared between the nodeos instances of a host: whichever compile monitor first needs a code takes an
+// exclusive lock on the code's lock file, compiles it and publishes the result as an immutable file; others wait for the
+// file and copy it into their own code cache instead of compiling. Lock files are flock()ed so a compiler that dies
+// releases its lock. The directory and its files are only accessible to the user running nodeos, files are synced before
+// they are published and carry a sha256 of their contents, checked before they are installed.
+static constexpr uint64_t shared_code_magic = 0x4853434f4d56534fULL; //"OSVMOCSH" little endian
+static constexpr std::chrono::milliseconds shared_code_wait_interval{100};
+static constexpr unsigned shared_code_max_waits = 600;
+//installing a code refreshes the modification time of its file, files unused for that long are removed
+static constexpr std::chrono::hours shared_code_max_age{24*7};
+
+struct shared_code {
+   uint64_t magic = shared_code_magic;
+   uint8_t codegen_version = current_codegen_version;
+   code_compilation_result_message result;
+   std::vector<uint8_t> code;
+   std::vector<uint8_t> initdata;
+   fc::sha256 checksum;
+};
+
+}}}
+
+FC_REFLECT(eosio::chain::eosvmoc::shared_code, (magic)(codegen_version)(result)(code)(initdata)(checksum))
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+static fc::sha256 shared_code_checksum(const shared_code& shared) {
+   fc::sha256::encoder enc;
+   fc::raw::pack(enc, shared.magic);
+   fc::raw::pack(enc, shared.codegen_version);
+   fc::raw::pack(enc, shared.result);
+   fc::raw::pack(enc, shared.code);
+   fc::raw::pack(enc, shared.initdata);
+   return enc.result();
+}
+
+//true when only the user running this process can have written the file or directory
+static bool owner_only_writable(const struct stat& st) {
+   return st.st_uid == geteuid() && !(st.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+void check_shared_cache_dir(const boost::filesystem::path& dir) {
+   if(!bfs::exists(dir)) {
+      if(dir.has_parent_path())
+         bfs::create_directories(dir.parent_path());
+      EOS_ASSERT(::mkdir(dir.c_str(), 0700) == 0 || errno == EEXIST, misc_exception,
+                 "failed to create EOS VM OC shared cache directory ${d}", ("d", dir.generic_string()));
+   }
+   struct stat st;
+   EOS_ASSERT(::stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode), misc_exception,
+              "EOS VM OC shared cache directory ${d} is not a directory", ("d", dir.generic_string()));
+   EOS_ASSERT(owner_only_writable(st), misc_exception,
+              "EOS VM OC shared cache directory ${d} must be owned by the user running nodeos and not be writable by others, "
+              "the code in it is executed", ("d", dir.generic_string()));
+}
+
+using compile_clock = std::chrono::steady_clock;
+
+static uint64_t elapsed_us(compile_clock::time_point from, compile_clock::time_point to) {
+   return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
 struct compile_monitor_session {
-   compile_monitor_session(boost::asio::io_context& context, local::datagram_protocol::socket&& n, wrapped_fd&& c, wrapped_fd& t) :
+   //compiles requested by nodeos wait here until one of the _max_concurrent_compiles slots frees, highest priority first
+   struct pending_compile {
+      code_tuple                  code;
+      uint64_t                    priority = 0;
+      wrapped_fd                  wasm_code;
+      compile_clock::time_point   queued;
+      unsigned                    shared_code_waits = 0; //times it waited on another process compiling it
+   };
+   //waits on another process compiling a shared code don't take a compile slot
+   struct shared_code_wait {
+      shared_code_wait(boost::asio::io_context& ctx, pending_compile&& p) :
+         timer(ctx, shared_code_wait_interval), pc(std::move(p)) {}
+
+      boost::asio::steady_timer timer;
+      pending_compile           pc;
+   };
+   struct running_compile {
+      running_compile(const code_tuple& c, local::datagram_protocol::socket&& s, compile_clock::time_point q) :
+         code(c), socket(std::move(s)), queued(q) {}
+
+      code_tuple                       code;
+      local::datagram_protocol::socket socket;
+      compile_clock::time_point        queued;
+      compile_clock::time_point        started = compile_clock::now();
+      bool                             cancelled = false;
+   };
+
+   compile_monitor_session(boost::asio::io_context& context, local::datagram_protocol::socket&& n, wrapped_fd&& c, wrapped_fd& t, const initialize_message& init) :
       _ctx(context),
       _nodeos_instance_socket(std::move(n)),
       _cache_fd(std::move(c)),
-      _trampoline_socket(t) {
+      _trampoline_socket(t),
+      _max_concurrent_compiles(std::max<uint64_t>(init.max_concurrent_compiles, 1)),
+      _shared_cache_dir(init.shared_cache_dir) {
 
       struct stat st;
       FC_ASSERT(fstat(_cache_fd, &st) == 0, "failed to stat cache fd");
@@ -46,6 +149,9 @@ struct compile_monitor_session {
       _code_mapping = (char*)mmap(nullptr, _code_size, PROT_READ|PROT_WRITE, MAP_SHARED, _cache_fd, 0);
       FC_ASSERT(_code_mapping != MAP_FAILED, "failed to mmap cache file");
       _allocator = reinterpret_cast<allocator_t*>(_code_mapping);
+
+      if(!_shared_cache_dir.empty())
+         remove_stale_shared_code();
       
       read_message_from_nodeos();
    }
@@ -67,11 +173,19 @@ struct compile_monitor_session {
          }
          std::visit(overloaded {
             [&, &fds=fds](const compile_wasm_message& compile) {
+               if(fds.size() == 0) {
+                  //a new priority for a code already requested
+                  _pending_compiles.reprioritize(compile.code, compile.priority);
+                  return;
+               }
                if(fds.size() != 1) {
                   connection_dead_signal();
                   return;
                }
-               kick_compile_off(compile.code, std::move(fds[0]));
+               _pending_compiles.push({compile.code, compile.priority, std::move(fds[0]), compile_clock::now(), 0});
+            },
+            [&](const cancel_compile_message& cancel) {
+               cancel_compile(cancel.code);
             },
             [&](const evict_wasms_message& evict) {
                for(const code_descriptor& cd : evict.codes) {
@@ -86,11 +200,218 @@ struct compile_monitor_session {
             }
          }, message);
 
+         start_pending_compiles();
          read_message_from_nodeos();
       });
    }
 
-   void kick_compile_off(const code_tuple& code_id, wrapped_fd&& wasm_code) {
+   void start_pending_compiles() {
+      while(!_pending_compiles.empty() && current_compiles.size() < _max_concurrent_compiles)
+         kick_compile_off(_pending_compiles.pop());
+   }
+
+   void cancel_compile(const code_tuple& code) {
+      auto reply_cancelled = [&](const pending_compile& pc) {
+         wasm_compilation_result_message reply{code, compilation_result_cancelled{}, _allocator->get_free_memory()};
+         reply.queue_time_us = elapsed_us(pc.queued, compile_clock::now());
+         write_message_with_fds(_nodeos_instance_socket, reply);
+      };
+      if(std::optional<pending_compile> pc = _pending_compiles.remove(code)) {
+         //it may have been queued again after taking the lock others wait on
+         _shared_code_locks.erase(code);
+         reply_cancelled(*pc);
+         return;
+      }
+      for(auto it = _shared_code_waits.begin(); it != _shared_code_waits.end(); ++it) {
+         if(it->pc.code == code) {
+            reply_cancelled(it->pc);
+            //its timer's wait completes as aborted
+            _shared_code_waits.erase(it);
+            return;
+         }
+      }
+      //closing the socket the compile replies on ends the compile process and completes the wait on it
+      for(running_compile& rc : current_compiles) {
+         if(rc.code == code && !rc.cancelled) {
+            rc.cancelled = true;
+            boost::system::error_code ec;
+            rc.socket.close(ec);
+         }
+      }
+   }
+
+   std::string shared_code_path(const code_tuple& code_id) const {
+      return (bfs::path(_shared_cache_dir) / (code_id.code_id.str() + "-" + std::to_string(code_id.vm_version) + "-" +
+                                             std::to_string(current_codegen_version))).generic_string();
+   }
+
+   //removes the files of other codegen versions and those no process installed for shared_code_max_age
+   void remove_stale_shared_code() {
+      const std::string codegen_suffix = "-" + std::to_string(current_codegen_version);
+      const auto oldest = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now() - shared_code_max_age);
+      boost::system::error_code ec;
+      for(bfs::directory_iterator it(_shared_cache_dir, ec), end; !ec && it != end; it.increment(ec)) {
+         const bfs::path& p = it->path();
+         const std::string stem = p.filename().generic_string().substr(0, p.filename().generic_string().find('.'));
+         struct stat st;
+         if(::lstat(p.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+         const bool other_codegen = stem.size() < codegen_suffix.size() ||
+                                    stem.compare(stem.size() - codegen_suffix.size(), codegen_suffix.size(), codegen_suffix) != 0;
+         if(other_codegen || st.st_mtime < oldest)
+            ::unlink(p.c_str());
+      }
+   }
+
+   //copies code another process published in to the cache, returns false when it hasn't been published
+   bool install_shared_code(const pending_compile& pc) {
+      const code_tuple& code_id = pc.code;
+      const std::string path = shared_code_path(code_id) + ".oc";
+      shared_code shared;
+      try {
+         const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+         if(fd < 0)
+            return false;
+         wrapped_fd in(fd);
+         struct stat st;
+         if(fstat(in, &st) != 0 || !S_ISREG(st.st_mode) || !owner_only_writable(st)) {
+            elog("ignoring EOS VM OC shared code ${p} which could have been written by another user", ("p", path));
+            return false;
+         }
+         std::vector<char> content(st.st_size);
+         for(size_t read_size = 0; read_size < content.size();) {
+            const ssize_t r = ::read(in, content.data() + read_size, content.size() - read_size);
+            if(r <= 0)
+               return false;
+            read_size += r;
+         }
+         fc::datastream<const char*> ds(content.data(), content.size());
+         fc::raw::unpack(ds, shared);
+         if(shared.magic != shared_code_magic || shared.codegen_version != current_codegen_version)
+            return false;
+         if(shared.checksum != shared_code_checksum(shared)) {
+            //compiled again here and published over it
+            wlog("ignoring corrupt EOS VM OC shared code ${p}", ("p", path));
+            return false;
+         }
+         //keeps it from being removed as stale
+         futimens(in, nullptr);
+      }
+      catch(...) {
+         return false;
+      }
+
+      wasm_compilation_result_message reply{code_id, compilation_result_unknownfailure{}, _allocator->get_free_memory()};
+      void* code_ptr = _allocator->allocate(shared.code.size());
+      void* mem_ptr = _allocator->allocate(shared.initdata.size());
+      if(code_ptr == nullptr || mem_ptr == nullptr) {
+         _allocator->deallocate(code_ptr);
+         _allocator->deallocate(mem_ptr);
+         reply.result = compilation_result_toofull();
+      }
+      else {
+         memcpy(code_ptr, shared.code.data(), shared.code.size());
+         memcpy(mem_ptr, shared.initdata.data(), shared.initdata.size());
+         reply.result = make_code_descriptor(code_id, shared.result, code_ptr, mem_ptr, shared.initdata.size());
+         reply.code_size = shared.code.size() + shared.initdata.size();
+         reply.cache_free_bytes = _allocator->get_free_memory();
+      }
+      reply.queue_time_us = elapsed_us(pc.queued, compile_clock::now());
+      write_message_with_fds(_nodeos_instance_socket, reply);
+      return true;
+   }
+
+   //returns the held lock, or nothing when another process is compiling the code
+   std::optional<wrapped_fd> lock_shared_code(const code_tuple& code_id) {
+      const int fd = ::open((shared_code_path(code_id) + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+      if(fd < 0) //can't lock, e.g. a read only directory: compile without sharing
+         return std::optional<wrapped_fd>(wrapped_fd());
+      wrapped_fd lock_fd(fd);
+      if(flock(lock_fd, LOCK_EX | LOCK_NB) == 0)
+         return std::optional<wrapped_fd>(std::move(lock_fd));
+      return std::nullopt;
+   }
+
+   void publish_shared_code(const code_tuple& code_id, const code_compilation_result_message& result, const wrapped_fd& code, const wrapped_fd& initdata) {
+      const std::string path = shared_code_path(code_id) + ".oc";
+      const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+      try {
+         shared_code shared{shared_code_magic, current_codegen_version, result, vector_for_memfd(code), vector_for_memfd(initdata)};
+         shared.checksum = shared_code_checksum(shared);
+         const std::vector<char> content = fc::raw::pack(shared);
+         {
+            const int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+            FC_ASSERT(fd >= 0, "failed to create ${p}", ("p", tmp_path));
+            wrapped_fd out(fd);
+            for(size_t written = 0; written < content.size();) {
+               const ssize_t w = ::write(out, content.data() + written, content.size() - written);
+               FC_ASSERT(w > 0, "failed to write ${p}", ("p", tmp_path));
+               written += w;
+            }
+            //a crash after the rename must not leave a file with a valid header and lost contents
+            FC_ASSERT(fsync(out) == 0, "failed to sync ${p}", ("p", tmp_path));
+         }
+         //readers only ever see complete files
+         FC_ASSERT(::rename(tmp_path.c_str(), path.c_str()) == 0, "failed to rename ${p}", ("p", tmp_path));
+         const int dir_fd = ::open(_shared_cache_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+         if(dir_fd >= 0) {
+            fsync(dir_fd);
+            ::close(dir_fd);
+         }
+      }
+      catch(...) {
+         ::unlink(tmp_path.c_str());
+      }
+   }
+
+   void wait_for_shared_code(pending_compile&& pc) {
+      auto wait_it = _shared_code_waits.emplace(_shared_code_waits.end(), _ctx, std::move(pc));
+      wait_it->timer.async_wait([this, wait_it](const boost::system::error_code& ec) {
+         //aborted when the compile was cancelled or the session is going away; wait_it is no longer valid
+         if(ec)
+            return;
+         pending_compile pc = std::move(wait_it->pc);
+         _shared_code_waits.erase(wait_it);
+         ++pc.shared_code_waits;
+         if(use_shared_code(pc))
+            return;
+         //compiled here after all, once a compile slot is free
+         if(current_compiles.size() < _max_concurrent_compiles)
+            compile(std::move(pc));
+         else
+            _pending_compiles.push(std::move(pc));
+      });
+   }
+
+   //installs the code when another process published it, or waits for the process compiling it. Returns false when
+   // the code is to be compiled here, holding its lock if other processes are to wait on it
+   bool use_shared_code(pending_compile& pc) {
+      if(_shared_cache_dir.empty() || _shared_code_locks.count(pc.code))
+         return false;
+      if(install_shared_code(pc))
+         return true;
+      if(pc.shared_code_waits >= shared_code_max_waits)
+         return false;
+      std::optional<wrapped_fd> lock = lock_shared_code(pc.code);
+      if(!lock) {
+         wait_for_shared_code(std::move(pc));
+         return true;
+      }
+      //the other process may have published it between the check and taking the lock
+      if(install_shared_code(pc))
+         return true;
+      _shared_code_locks[pc.code] = std::move(*lock);
+      return false;
+   }
+
+   void kick_compile_off(pending_compile&& pc) {
+      if(!use_shared_code(pc))
+         compile(std::move(pc));
+   }
+
+   void compile(pending_compile&& pc) {
+      const code_tuple code_id = pc.code;
+
       //prepare a requst to go out to the trampoline
       int socks[2];
       socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, socks);
@@ -98,32 +419,35 @@ struct compile_monitor_session {
       response_socket.assign(local::datagram_protocol(), socks[0]);
       std::vector<wrapped_fd> fds_pass_to_trampoline;
       fds_pass_to_trampoline.emplace_back(socks[1]);
-      fds_pass_to_trampoline.emplace_back(std::move(wasm_code));
+      fds_pass_to_trampoline.emplace_back(std::move(pc.wasm_code));
 
       eosvmoc_message trampoline_compile_request = compile_wasm_message{code_id};
       if(write_message_with_fds(_trampoline_socket, trampoline_compile_request, fds_pass_to_trampoline) == false) {
          wasm_compilation_result_message reply{code_id, compilation_result_unknownfailure{}, _allocator->get_free_memory()};
          write_message_with_fds(_nodeos_instance_socket, reply);
+         _shared_code_locks.erase(code_id);
          return;
       }
 
-      current_compiles.emplace_front(code_id, std::move(response_socket));
+      current_compiles.emplace_front(code_id, std::move(response_socket), pc.queued);
       read_message_from_compile_task(current_compiles.begin());
    }
 
-   void read_message_from_compile_task(std::list<std::tuple<code_tuple, local::datagram_protocol::socket>>::iterator current_compile_it) {
-      auto& [code, socket] = *current_compile_it;
-      socket.async_wait(local::datagram_protocol::socket::wait_read, [this, current_compile_it](auto ec) {
+   void read_message_from_compile_task(std::list<running_compile>::iterator current_compile_it) {
+      current_compile_it->socket.async_wait(local::datagram_protocol::socket::wait_read, [this, current_compile_it](auto ec) {
          //at this point we only expect 1 of 2 things to happen: we either get a reply (success), or we get no reply (failure)
-         auto& [code, socket] = *current_compile_it;
-         auto [success, message, fds] = read_message_with_fds(socket);
+         running_compile& rc = *current_compile_it;
+         const code_tuple& code = rc.code;
+         auto [success, message, fds] = read_message_with_fds(rc.socket);
          
          wasm_compilation_result_message reply{code, compilation_result_unknownfailure{}, _allocator->get_free_memory()};
+         if(rc.cancelled)
+            reply.result = compilation_result_cancelled{};
          
          void* code_ptr = nullptr;
          void* mem_ptr = nullptr;
          try {
-            if(success && std::holds_alternative<code_compilation_result_message>(message) && fds.size() == 2) {
+            if(!rc.cancelled && success && std::holds_alternative<code_compilation_result_message>(message) && fds.size() == 2) {
                code_compilation_result_message& result = std::get<code_compilation_result_message>(message);
                code_ptr = _allocator->allocate(get_size_of_fd(fds[0]));
                mem_ptr = _allocator->allocate(get_size_of_fd(fds[1]));
@@ -137,18 +461,12 @@ struct compile_monitor_session {
                   copy_memfd_contents_to_pointer(code_ptr, fds[0]);
                   copy_memfd_contents_to_pointer(mem_ptr, fds[1]);
 
-                  reply.result = code_descriptor {
-                     code.code_id,
-                     code.vm_version,
-                     current_codegen_version,
-                     (uintptr_t)code_ptr - (uintptr_t)_code_mapping,
-                     result.start,
-                     result.apply_offset,
-                     result.starting_memory_pages,
-                     (uintptr_t)mem_ptr - (uintptr_t)_code_mapping,
-                     (unsigned)get_size_of_fd(fds[1]),
-                     result.initdata_prologue_size
-                  };
+                  reply.result = make_code_descriptor(code, result, code_ptr, mem_ptr, get_size_of_fd(fds[1]));
+                  reply.code_size = get_size_of_fd(fds[0]) + get_size_of_fd(fds[1]);
+                  reply.cache_free_bytes = _allocator->get_free_memory();
+
+                  if(_shared_code_locks.count(code))
+                     publish_shared_code(code, result, fds[0], fds[1]);
                }
             }
          }
@@ -157,16 +475,38 @@ struct compile_monitor_session {
             _allocator->deallocate(mem_ptr);
          }
 
+         const auto now = compile_clock::now();
+         reply.queue_time_us = elapsed_us(rc.queued, rc.started);
+         reply.compile_time_us = elapsed_us(rc.started, now);
          write_message_with_fds(_nodeos_instance_socket, reply);
+         _shared_code_locks.erase(code);
 
          //either way, we are done
          _ctx.post([this, current_compile_it]() {
             current_compiles.erase(current_compile_it);
+            start_pending_compiles();
          });
       });
 
    }
 
+   code_descriptor make_code_descriptor(const code_tuple& code, const code_compilation_result_message& result, void* code_ptr, void* mem_ptr, size_t initdata_size) const {
+      return code_descriptor {
+         code.code_id,
+         code.vm_version,
+         current_codegen_version,
+         (uintptr_t)code_ptr - (uintptr_t)_code_mapping,
+         result.start,
+         result.apply_offset,
+         result.starting_memory_pages,
+         (uintptr_t)mem_ptr - (uintptr_t)_code_mapping,
+         (unsigned)initdata_size,
+         result.initdata_prologue_size,
+         result.function_table_offset,
+         result.function_count
+      };
+   }
+
    boost::signals2::signal<void()> connection_dead_signal;
 
 private:
@@ -179,7 +519,13 @@ private:
    size_t _code_size;
    allocator_t* _allocator;
 
-   std::list<std::tuple<code_tuple, local::datagram_protocol::socket>> current_compiles;
+   compile_queue<pending_compile> _pending_compiles;
+   uint64_t _max_concurrent_compiles;
+   std::list<running_compile> current_compiles;
+
+   std::string _shared_cache_dir;
+   std::unordered_map<code_tuple, wrapped_fd> _shared_code_locks; //held while compiling code to be shared
+   std::list<shared_code_wait> _shared_code_waits;
 };
 
 struct compile_monitor {
@@ -207,7 +553,8 @@ struct compile_monitor {
          try {
             local::datagram_protocol::socket _socket_for_comm(ctx);
             _socket_for_comm.assign(local::datagram_protocol(), fds[0].release());
-            _compile_sessions.emplace_front(ctx, std::move(_socket_for_comm), std::move(fds[1]), _trampoline_socket);
+            _compile_sessions.emplace_front(ctx, std::move(_socket_for_comm), std::move(fds[1]), _trampoline_socket,
+                                            std::get<initialize_message>(message));
             _compile_sessions.front().connection_dead_signal.connect([&, it = _compile_sessions.begin()]() {
                ctx.post([&]() {
                   _compile_sessions.erase(it);
@@ -303,7 +650,7 @@ extern "C" int __wrap_main(int argc, char* argv[]) {
    return __real_main(argc, argv);
 }
 
-wrapped_fd get_connection_to_compile_monitor(int cache_fd) {
+wrapped_fd get_connection_to_compile_monitor(int cache_fd, const initialize_message& init) {
    FC_ASSERT(the_compile_monitor_trampoline.compile_manager_pid >= 0, "EOS VM oop connection doesn't look active");
 
    int socks[2]; //0: our socket to compile_manager_session, 1: socket we'll give to compile_maanger_session
@@ -320,7 +667,7 @@ wrapped_fd get_connection_to_compile_monitor(int cache_fd) {
    std::vector<wrapped_fd> fds_to_pass; 
    fds_to_pass.emplace_back(std::move(socket_to_hand_to_monitor_session));
    fds_to_pass.emplace_back(std::move(dup_cache_fd));
-   write_message_with_fds(the_compile_monitor_trampoline.compile_manager_fd, initialize_message(), fds_to_pass);
+   write_message_with_fds(the_compile_monitor_trampoline.compile_manager_fd, init, fds_to_pass);
 
    auto [success, message, fds] = read_message_with_fds(the_compile_monitor_trampoline.compile_manager_fd);
    EOS_ASSERT(success, misc_exception, "failed to read response from monitor process");
@@ -7,6 +7,11 @@
 #include <sys/prctl.h>
 #include <signal.h>
 #include <sys/resource.h>
+#include <poll.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <thread>
 
 #include "IR/Module.h"
 #include "IR/Validate.h"
@@ -18,6 +23,13 @@ using namespace IR;
 namespace eosio { namespace chain { namespace eosvmoc {
 
 void run_compile(wrapped_fd&& response_sock, wrapped_fd&& wasm_code) noexcept {  //noexcept; we'll just blow up if anything tries to cross this boundry
+   //the compile monitor hangs up when the compile is cancelled; nobody is waiting on the result any longer
+   std::thread([sock = (int)response_sock]() {
+      struct pollfd pfd = {sock, 0, 0};
+      while(poll(&pfd, 1, -1) == -1 && errno == EINTR) {}
+      _exit(0);
+   }).detach();
+
    std::vector<uint8_t> wasm = vector_for_memfd(wasm_code);
 
    //ideally we catch exceptions and sent them upstream as strings for easier reporting
@@ -27,6 +39,8 @@ void run_compile(wrapped_fd&& response_sock, wrapped_fd&& wasm_code) noexcept {
    WASM::scoped_skip_checks no_check;
    WASM::serialize(stream, module);
    module.userSections.clear();
+   //injection may import more functions, the profiler names functions by their index in the wasm as deployed
+   const size_t deployed_function_imports = module.functions.imports.size();
    wasm_injections::wasm_binary_injection injector(module);
    injector.inject();
 
@@ -130,6 +144,18 @@ void run_compile(wrapped_fd&& response_sock, wrapped_fd&& wasm_code) noexcept {
    std::move(prologue_it, prologue.end(), std::back_inserter(initdata_prep));
    std::move(initial_mem.begin(), initial_mem.end(), std::back_inserter(initdata_prep));
 
+   std::vector<function_table_entry> function_table;
+   for(const auto& [def_index, offset] : function_to_offsets)
+      function_table.push_back({(uint32_t)offset, (uint32_t)(deployed_function_imports + def_index)});
+   std::sort(function_table.begin(), function_table.end(), [](const function_table_entry& a, const function_table_entry& b) {
+      return a.code_offset < b.code_offset;
+   });
+   code.code.resize((code.code.size() + alignof(function_table_entry) - 1) & ~(alignof(function_table_entry) - 1));
+   result_message.function_table_offset = code.code.size();
+   result_message.function_count = function_table.size();
+   const uint8_t* const function_table_bytes = reinterpret_cast<const uint8_t*>(function_table.data());
+   code.code.insert(code.code.end(), function_table_bytes, function_table_bytes + function_table.size()*sizeof(function_table_entry));
+
    std::vector<wrapped_fd> fds_to_send;
    fds_to_send.emplace_back(memfd_for_bytearray(code.code));
    fds_to_send.emplace_back(memfd_for_bytearray(initdata_prep));
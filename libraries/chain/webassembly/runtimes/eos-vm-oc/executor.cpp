@@ -4,6 +4,7 @@
 #include <eosio/chain/webassembly/eos-vm-oc/intrinsic_mapping.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/intrinsic.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/eos-vm-oc.h>
+#include <eosio/chain/webassembly/eos-vm-oc/profile.hpp>
 #include <eosio/chain/wasm_eosio_constraints.hpp>
 #include <eosio/chain/apply_context.hpp>
 #include <eosio/chain/transaction_context.hpp>
@@ -173,10 +174,10 @@ void executor::execute(const code_descriptor& code, memory& mem, apply_context&
                   (code.starting_memory_pages - initial_page_offset) * eosio::chain::wasm_constraints::wasm_page_size, PROT_READ | PROT_WRITE);
       }
       arch_prctl(ARCH_SET_GS, (unsigned long*)(mem.zero_page_memory_base()+initial_page_offset*memory::stride));
-      memset(mem.full_page_memory_base(), 0, 64u*1024u*code.starting_memory_pages);
    }
    else
       arch_prctl(ARCH_SET_GS, (unsigned long*)mem.zero_page_memory_base());
+   mem.reset_linear_memory(code.initdata_size - code.initdata_prologue_size, 64u*1024u*code.starting_memory_pages);
 
    void* globals;
    if(code.initdata_prologue_size > memory::max_prologue_size) {
@@ -222,6 +223,7 @@ void executor::execute(const code_descriptor& code, memory& mem, apply_context&
       cb->is_running = false;
       cb->bounce_buffers->clear();
       tt.set_expiration_callback(nullptr, nullptr);
+      mem.linear_memory_written(cb->current_linear_memory_pages * eosio::chain::wasm_constraints::wasm_page_size);
 
       int64_t base_pages = mem.size_of_memory_slice_mapping()/memory::stride - 1;
       if(cb->current_linear_memory_pages > base_pages) {
@@ -230,6 +232,30 @@ void executor::execute(const code_descriptor& code, memory& mem, apply_context&
       }
    });
 
+   profile_sampler* prof = nullptr;
+   if(context.control.is_profiling(context.get_receiver())) {
+      if(!sampler)
+         sampler = std::make_unique<profile_sampler>();
+      prof = sampler.get();
+   }
+   auto profile_cleanup = fc::make_scoped_exit([this, prof, &code, &context](){
+      if(!prof)
+         return;
+      prof->stop();
+      //the function table is read from the code mapping, which a timeout leaves inaccessible
+      if(mapping_is_executable == false) {
+         mprotect(code_mapping, code_mapping_size, PROT_EXEC|PROT_READ);
+         mapping_is_executable = true;
+      }
+      try {
+         profiles::instance().record(context, code, code_mapping, *prof);
+      } catch(...) {
+         wlog("failed to record EOS VM OC profile samples of ${a}", ("a", context.get_receiver()));
+      }
+   });
+   if(prof)
+      prof->start(code_mapping + code.code_begin, code.function_table_offset);
+
    void(*apply_func)(uint64_t, uint64_t, uint64_t) = (void(*)(uint64_t, uint64_t, uint64_t))(cb->running_code_base + code.apply_offset);
 
    switch(sigsetjmp(*cb->jmp, 0)) {
@@ -249,11 +275,22 @@ void executor::execute(const code_descriptor& code, memory& mem, apply_context&
             apply_func(context.get_receiver().to_uint64_t(), context.get_action().account.to_uint64_t(), context.get_action().name.to_uint64_t());
          });
          break;
-      //case 1: clean eosio_exit
+      case EOSVMOC_EXIT_CLEAN_EXIT:
+         // eosio_exit jumps here directly, without the wrapper which accounts the other host functions
+         if(auto& counters = context.intrinsic_usage) {
+            counters->call_started(find_intrinsic_index("env.eosio_exit"));
+            counters->call_finished();
+         }
+         break;
       case EOSVMOC_EXIT_CHECKTIME_FAIL:
+         if(auto& counters = context.intrinsic_usage)
+            counters->call_finished();
          context.trx_context.checktime();
          break;
       case EOSVMOC_EXIT_SEGV:
+         // a host function faulting on linear memory is left without returning
+         if(auto& counters = context.intrinsic_usage)
+            counters->call_finished();
          EOS_ASSERT(false, wasm_execution_error, "access violation");
          break;
       case EOSVMOC_EXIT_EXCEPTION: //exception
@@ -264,6 +301,8 @@ void executor::execute(const code_descriptor& code, memory& mem, apply_context&
 
 executor::~executor() {
    arch_prctl(ARCH_SET_GS, nullptr);
+   if(sampler)
+      profiles::instance().write();
 }
 
 }}}
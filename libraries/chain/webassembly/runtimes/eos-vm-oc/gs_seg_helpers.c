@@ -20,6 +20,11 @@ int32_t eos_vm_oc_grow_memory(int32_t grow, int32_t max) {
    if(previous_page_count + grow_amount > max_pages)
       return (int32_t)-1;
 
+   //memory given back is zeroed while still accessible; memory past the pages in use at the end of an execution is
+   // expected to be zero when the next one starts
+   if(grow_amount < 0)
+      memset(cb_ptr->full_linear_memory_start + (previous_page_count + grow_amount)*64u*1024u, 0, -grow_amount*64u*1024u);
+
    int64_t max_segments = cb_ptr->execution_thread_memory_length / EOS_VM_OC_MEMORY_STRIDE - 1;
    int was_extended = previous_page_count > max_segments;
    int will_be_extended = previous_page_count + grow_amount > max_segments;
@@ -8,6 +8,12 @@
 #include <sys/syscall.h>
 #include <sys/mman.h>
 #include <linux/memfd.h>
+#include <fcntl.h>
+#include <linux/falloc.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 
 namespace eosio { namespace chain { namespace eosvmoc {
 
@@ -42,6 +48,51 @@ memory::memory(uint64_t max_pages) {
    const intrinsic_map_t& intrinsics = get_intrinsic_map();
    for(const auto& intrinsic : intrinsics)
       intrinsic_jump_table[-intrinsic.second.ordinal] = (uintptr_t)intrinsic.second.function_ptr;
+
+   //kept to find and release the pages of linear memory which were written to
+   cleanup_fd.cancel();
+   memfd = fd;
+}
+
+void memory::reset_linear_memory(uint64_t initial_data_size, uint64_t starting_size) {
+   static constexpr uint64_t page_size = 4096u;
+   const uint64_t end = written_extent;
+   written_extent = initial_data_size;
+   if(end <= initial_data_size)
+      return;
+
+   //the rest of the page the initial data ends in
+   const uint64_t first_full_page = (initial_data_size + page_size - 1) / page_size * page_size;
+   memset(fullpage_base + initial_data_size, 0, std::min(first_full_page, end) - initial_data_size);
+
+   //memory the execution can only reach by growing it is released rather than zeroed; it reads back as zero
+   const uint64_t release_from = std::max(first_full_page, starting_size);
+   if(end > release_from) {
+      int ret = fallocate(memfd, FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE, memory_prologue_size + release_from, end - release_from);
+      FC_ASSERT(!ret, "Failed to release EOS VM OC memory");
+   }
+
+   //pages of the memfd never written to are holes and already zero, only zero the others. Typically that is
+   // far less than the starting memory of the code, which used to be zeroed entirely
+   uint64_t pos = first_full_page;
+   const uint64_t zero_to = std::min(end, release_from);
+   while(pos < zero_to) {
+      off_t data = lseek(memfd, memory_prologue_size + pos, SEEK_DATA);
+      if(data < 0) {
+         if(errno == ENXIO) //nothing but holes left
+            break;
+         //can't tell holes apart, zero all of it
+         memset(fullpage_base + pos, 0, zero_to - pos);
+         break;
+      }
+      const uint64_t data_start = data - memory_prologue_size;
+      if(data_start >= zero_to)
+         break;
+      off_t hole = lseek(memfd, memory_prologue_size + data_start, SEEK_HOLE);
+      const uint64_t data_end = hole < 0 ? zero_to : std::min<uint64_t>(hole - memory_prologue_size, zero_to);
+      memset(fullpage_base + data_start, 0, data_end - data_start);
+      pos = data_end;
+   }
 }
 
 void memory::reset(uint64_t max_pages) {
@@ -52,10 +103,13 @@ void memory::reset(uint64_t max_pages) {
    std::swap(mapsize, new_memory.mapsize);
    std::swap(zeropage_base, new_memory.zeropage_base);
    std::swap(fullpage_base, new_memory.fullpage_base);
+   std::swap(memfd, new_memory.memfd);
+   std::swap(written_extent, new_memory.written_extent);
 }
 
 memory::~memory() {
    munmap(mapbase, mapsize);
+   close(memfd);
 }
 
 }}}
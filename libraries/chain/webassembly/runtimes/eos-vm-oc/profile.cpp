@@ -0,0 +1,231 @@
+#include <eosio/chain/webassembly/eos-vm-oc/profile.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/eos-vm-oc.hpp>
+#include <eosio/chain/apply_context.hpp>
+#include <eosio/chain/account_object.hpp>
+#include <eosio/chain/code_object.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+namespace {
+
+void(*chained_handler)(int,siginfo_t*,void*);
+
+//the sampler whose timer interrupts this thread, between its start() and stop()
+thread_local profile_sampler* running_sampler;
+
+struct wasm_reader {
+   const uint8_t* pos;
+   const uint8_t* end;
+
+   uint8_t byte() {
+      FC_ASSERT(pos < end, "unexpected end of wasm");
+      return *pos++;
+   }
+
+   uint32_t varuint32() {
+      uint32_t result = 0;
+      for(unsigned shift = 0; shift < 35; shift += 7) {
+         const uint8_t b = byte();
+         result |= uint32_t(b & 0x7f) << shift;
+         if(!(b & 0x80))
+            return result;
+      }
+      FC_THROW("invalid LEB128 in wasm");
+   }
+
+   std::string_view bytes(uint32_t size) {
+      FC_ASSERT(size <= static_cast<size_t>(end - pos), "unexpected end of wasm");
+      std::string_view r((const char*)pos, size);
+      pos += size;
+      return r;
+   }
+};
+
+//names of the function name subsection of the "name" custom section, by function index
+std::vector<std::string> function_names_of_wasm(const char* wasm, size_t size) {
+   std::vector<std::string> names;
+   try {
+      wasm_reader r{(const uint8_t*)wasm, (const uint8_t*)wasm + size};
+      r.bytes(8); //magic and version
+      while(r.pos < r.end) {
+         const uint8_t section_id = r.byte();
+         wasm_reader section{nullptr, nullptr};
+         section.pos = (const uint8_t*)r.bytes(r.varuint32()).data();
+         section.end = r.pos;
+         if(section_id != 0 || section.bytes(section.varuint32()) != "name")
+            continue;
+         while(section.pos < section.end) {
+            const uint8_t subsection_id = section.byte();
+            wasm_reader subsection{nullptr, nullptr};
+            subsection.pos = (const uint8_t*)section.bytes(section.varuint32()).data();
+            subsection.end = section.pos;
+            if(subsection_id != 1)
+               continue;
+            for(uint32_t n = subsection.varuint32(); n > 0; --n) {
+               const uint32_t index = subsection.varuint32();
+               const std::string_view function_name = subsection.bytes(subsection.varuint32());
+               if(index >= names.size())
+                  names.resize(index + 1);
+               names[index] = function_name;
+            }
+         }
+      }
+   } catch(const fc::exception& e) {
+      //names are a convenience, keep those found before the malformed part
+      dlog("failed to read the name section of a profiled wasm: ${e}", ("e", e.to_string()));
+   }
+   return names;
+}
+
+}
+
+profile_sampler::profile_sampler() {
+   static bool initialized;
+   static std::mutex initialized_mutex;
+
+   if(std::lock_guard guard(initialized_mutex); !initialized) {
+      struct sigaction act, old_act;
+      sigemptyset(&act.sa_mask);
+      act.sa_sigaction = signal_handler;
+      act.sa_flags = SA_SIGINFO | SA_RESTART;
+      FC_ASSERT(sigaction(SIGPROF, &act, &old_act) == 0, "failed to aquire SIGPROF signal");
+      if(old_act.sa_flags & SA_SIGINFO)
+         chained_handler = old_act.sa_sigaction;
+      else if(old_act.sa_handler != SIG_IGN && old_act.sa_handler != SIG_DFL)
+         chained_handler = (void (*)(int,siginfo_t*,void*))old_act.sa_handler;
+      initialized = true;
+   }
+
+   _samples.resize(max_samples);
+}
+
+profile_sampler::~profile_sampler() {
+   stop();
+}
+
+void profile_sampler::signal_handler(int sig, siginfo_t* info, void* ctx) {
+   //SIGPROF timers of others, and signals from ours arriving after stop(), carry nothing known to be a sampler
+   profile_sampler* self = running_sampler;
+   if(info->si_code != SI_TIMER || !self || info->si_value.sival_ptr != self) {
+      if(chained_handler)
+         chained_handler(sig, info, ctx);
+      return;
+   }
+
+   const uintptr_t pc = ((ucontext_t*)ctx)->uc_mcontext.gregs[REG_RIP];
+   if(pc >= self->_code && pc < self->_code + self->_code_size) {
+      if(self->_sample_count < max_samples)
+         self->_samples[self->_sample_count++] = pc - self->_code;
+   }
+   else
+      ++self->_host_samples;
+}
+
+void profile_sampler::start(const uint8_t* code, size_t code_size) {
+   _code = (uintptr_t)code;
+   _code_size = code_size;
+   _sample_count = 0;
+   _host_samples = 0;
+
+   //only the thread running the code is to be interrupted
+   struct sigevent se = {};
+   se.sigev_notify = SIGEV_THREAD_ID;
+   se.sigev_signo = SIGPROF;
+   se.sigev_value.sival_ptr = (void*)this;
+   se.sigev_notify_thread_id = syscall(SYS_gettid);
+   if(timer_create(CLOCK_MONOTONIC, &se, &_timer) != 0)
+      return;
+
+   _running = true;
+   running_sampler = this;
+   const long interval_ns = sampling_interval_us * 1000l;
+   struct itimerspec enable = {{0, interval_ns}, {0, interval_ns}};
+   if(timer_settime(_timer, 0, &enable, nullptr) != 0)
+      stop();
+}
+
+void profile_sampler::stop() {
+   if(!_running)
+      return;
+   _running = false;
+   running_sampler = nullptr;
+   timer_delete(_timer);
+}
+
+profiles& profiles::instance() {
+   static profiles p;
+   return p;
+}
+
+void profiles::record(apply_context& context, const code_descriptor& code, const uint8_t* code_mapping, const profile_sampler& sampler) {
+   const function_table_entry* const functions_begin = (const function_table_entry*)(code_mapping + code.code_begin + code.function_table_offset);
+   const function_table_entry* const functions_end = functions_begin + code.function_count;
+
+   std::unordered_map<uint32_t, uint64_t> function_samples;
+   for(size_t i = 0; i < sampler.code_sample_count(); ++i) {
+      const uint32_t offset = sampler.code_samples()[i];
+      const function_table_entry* const f = std::upper_bound(functions_begin, functions_end, offset, [](uint32_t o, const function_table_entry& e) {
+         return o < e.code_offset;
+      });
+      ++function_samples[f == functions_begin ? host_function : (f-1)->function_index];
+   }
+   if(sampler.host_samples())
+      function_samples[host_function] += sampler.host_samples();
+   if(function_samples.empty())
+      return;
+
+   const name receiver = context.get_receiver();
+   const name action = context.get_action().name;
+
+   std::lock_guard g(_mtx);
+   auto [it, inserted] = _profiles.try_emplace({receiver, code.code_hash});
+   code_profile& prof = it->second;
+   if(inserted) {
+      const auto& db = context.control.db();
+      const auto code_sequence = db.get<account_metadata_object, by_name>(receiver).code_sequence;
+      prof.basename = receiver.to_string() + "." + std::to_string(code_sequence);
+      const code_object& codeobject = db.get<code_object, by_code_hash>(boost::make_tuple(code.code_hash, 0, code.vm_version));
+      prof.function_names = function_names_of_wasm(codeobject.code.data(), codeobject.code.size());
+   }
+   for(const auto& [function_index, count] : function_samples)
+      prof.samples[{action, function_index}] += count;
+}
+
+void profiles::write() {
+   std::lock_guard g(_mtx);
+   for(const auto& [key, prof] : _profiles) {
+      const std::string file_name = prof.basename + ".oc.folded";
+      std::ofstream out(file_name, std::ofstream::trunc);
+      for(const auto& [action_function, count] : prof.samples) {
+         const auto& [action, function_index] = action_function;
+         out << key.first.to_string() << ';' << action.to_string() << ';';
+         if(function_index == host_function)
+            out << "[host functions]";
+         else if(function_index < prof.function_names.size() && !prof.function_names[function_index].empty())
+            out << prof.function_names[function_index];
+         else
+            out << "function[" << function_index << ']';
+         out << ' ' << count << '\n';
+      }
+      if(!out)
+         elog("failed to write EOS VM OC profile ${f}", ("f", file_name));
+   }
+}
+
+}}}
@@ -288,12 +288,20 @@ template <auto HostFunction, typename... Preconditions>
 struct host_function_registrator {
    template <typename Mod, typename Name>
    constexpr host_function_registrator(Mod mod_name, Name fn_name) {
+      add(mod_name, fn_name, mod_name + BOOST_HANA_STRING(".") + fn_name);
+   }
+
+   template <typename Mod, typename Name, typename FullName>
+   static void add(Mod mod_name, Name fn_name, FullName full_name) {
+      // usage of every host function is accounted under its index in the intrinsic table
+      constexpr std::size_t intrinsic = eosio::chain::eosvmoc::find_intrinsic_index(full_name.c_str());
+      static_assert(intrinsic < eosio::chain::eosvmoc::intrinsic_table_size(), "host function missing from the intrinsic table");
+      using usage_check = typename intrinsic_usage_check<intrinsic>::check;
       using rhf_t = eos_vm_host_functions_t;
-      rhf_t::add<HostFunction, Preconditions...>(mod_name.c_str(), fn_name.c_str());
+      rhf_t::add<HostFunction, usage_check, Preconditions...>(mod_name.c_str(), fn_name.c_str());
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
       constexpr bool is_injected = (Mod() == BOOST_HANA_STRING(EOSIO_INJECTED_MODULE_NAME));
-      eosvmoc::register_eosvm_oc<HostFunction, is_injected, std::tuple<Preconditions...>>(
-          mod_name + BOOST_HANA_STRING(".") + fn_name);
+      eosvmoc::register_eosvm_oc<HostFunction, is_injected, std::tuple<usage_check, Preconditions...>>(full_name);
 #endif
    }
 };
@@ -17,6 +17,7 @@
 #include <eosio/chain/permission_link_object.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/eosio_contract.hpp>
+#include <eosio/chain/metrics.hpp>
 
 #include <eosio/resource_monitor_plugin/resource_monitor_plugin.hpp>
 
@@ -196,6 +197,25 @@ public:
    const producer_plugin* producer_plug;
    std::optional<chain_apis::trx_retry_db>                            _trx_retry_db;
    chain_apis::trx_finality_status_processing_ptr                     _trx_finality_status_processing;
+
+   // updated on the main thread, exposed by the prometheus_plugin
+   struct chain_metrics {
+      using registry = chain::metrics::registry;
+      chain::metrics::gauge&     head_block_num = registry::instance().make_gauge(
+            "nodeos_chain_head_block_num", "Head block number" );
+      chain::metrics::gauge&     last_irreversible_block_num = registry::instance().make_gauge(
+            "nodeos_chain_last_irreversible_block_num", "Last irreversible block number" );
+      chain::metrics::counter&   blocks_accepted = registry::instance().make_counter(
+            "nodeos_chain_blocks_accepted_total", "Blocks applied or produced" );
+      chain::metrics::counter&   block_transactions = registry::instance().make_counter(
+            "nodeos_chain_block_transactions_total", "Transaction receipts in blocks applied or produced" );
+      chain::metrics::counter&   applied_transactions = registry::instance().make_counter(
+            "nodeos_chain_applied_transactions_total", "Transactions applied, including speculative execution" );
+      chain::metrics::histogram& block_apply_time = registry::instance().make_histogram(
+            "nodeos_chain_block_apply_time_seconds", "Time from the start to the acceptance of blocks which were not produced by this node" );
+      fc::time_point             block_start_time;
+      registry::collector_handle collector = 0;
+   } _metrics;
 };
 
 chain_plugin::chain_plugin()
@@ -260,6 +280,19 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "Percentage of actual signature recovery cpu to bill. Whole number percentages, e.g. 50 for 50%")
          ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
           "Number of worker threads in controller thread pool")
+         ("phase-timing", bpo::bool_switch()->default_value(false),
+          "Record histograms of the time spent in each phase of block and transaction processing, available from /v1/chain/get_phase_timings")
+         ("recovered-key-cache-size", bpo::value<uint32_t>()->default_value(config::default_recovered_key_cache_size),
+          "Maximum number of public keys recovered from transaction and contract signatures cached for reuse, 0 to disable the cache")
+         ("wasm-module-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_wasm_module_cache_size / (1024 * 1024)),
+          "Maximum size (in MiB) of the file in the state directory recording the modules parsed for instantiation, so that they are "
+          "not parsed again after a restart. When full, the least recently used modules are dropped. 0 to disable the cache")
+         ("replay-read-ahead-blocks", bpo::value<uint32_t>()->default_value(config::default_replay_read_ahead_blocks),
+          "Number of blocks read from the block log, unpacked and prepared on other threads ahead of the block being replayed. "
+          "0 reads each block on the main thread when it is replayed.")
+         ("parallel-auth-validation", bpo::bool_switch()->default_value(false),
+          "Check the authorizations of a received block's transactions in parallel on the controller thread pool before applying them. "
+          "Transactions whose authorities are modified earlier in the block are checked again when applied.")
          ("contracts-console", bpo::bool_switch()->default_value(false),
           "print contract's output to console")
          ("deep-mind", bpo::bool_switch()->default_value(false),
@@ -316,6 +349,12 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
                   EOS_ASSERT(false, plugin_exception, "");
                }
          }), "Number of threads to use for EOS VM OC tier-up")
+         ("eos-vm-oc-warmup-compiles", bpo::value<uint64_t>()->default_value(eosvmoc::config().warmup_compiles),
+          "Number of the most executed contracts of previous runs to compile in the background when EOS VM OC tier-up starts, when not already in the code cache")
+         ("eos-vm-oc-shared-cache-dir", bpo::value<bfs::path>(),
+          "Directory through which nodeos instances of this host share the code compiled by EOS VM OC, so that each contract is only compiled once per host "
+          "(absolute path or relative to application data dir). Must be owned by the user running nodeos and not be writable by others, it is created so. "
+          "Files of other EOS VM OC versions and files unused for a week are removed when nodeos starts.")
          ("eos-vm-oc-enable", bpo::bool_switch(), "Enable EOS VM OC tier-up runtime")
 #endif
          ("enable-account-queries", bpo::value<bool>()->default_value(false), "enable queries to find accounts by various metadata.")
@@ -337,6 +376,17 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
 
     cfg.add_options()("block-log-retain-blocks", bpo::value<uint32_t>(), "If set to greater than 0, periodically prune the block log to store only configured number of most recent blocks.\n"
         "If set to 0, no blocks are be written to the block log; block log file is removed after startup.");
+    cfg.add_options()("blocks-log-stride", bpo::value<uint32_t>(),
+        "Split the block log into files of this many blocks: whenever the head block number is a multiple of the stride, blocks.log and blocks.index are renamed to blocks-<first>-<last>.log and .index and a new blocks.log is begun.")
+        ("max-retained-block-files", bpo::value<uint32_t>()->default_value(10),
+         "Maximum number of split block log files kept in blocks-dir, older ones are moved to blocks-archive-dir.")
+        ("blocks-archive-dir", bpo::value<bfs::path>()->default_value("archive"),
+         "The location of the split block log files moved out of blocks-dir, where they remain readable (absolute path or relative to blocks-dir).\n"
+         "If set to an empty string, they are deleted instead.")
+        ("block-log-queue-size", bpo::value<uint32_t>()->default_value(0),
+         "Number of irreversible blocks which may wait to be written to the block log by a thread of its own, so that the main thread does not write them. "
+         "nodeos shuts down if the thread fails to write blocks, writing them once more on the way.\n"
+         "If set to 0, blocks are written by the main thread as they become irreversible.");
 
 
 // TODO: rate limiting
@@ -800,6 +850,11 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
                      "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size) );
       }
 
+      my->chain_config->replay_read_ahead_blocks = options.at( "replay-read-ahead-blocks" ).as<uint32_t>();
+      my->chain_config->wasm_module_cache_size = options.at( "wasm-module-cache-size-mb" ).as<uint64_t>() * 1024 * 1024;
+      recovered_key_cache::instance().set_capacity( options.at( "recovered-key-cache-size" ).as<uint32_t>() );
+      phase_timings::instance().set_enabled( options.at( "phase-timing" ).as<bool>() );
+
       my->chain_config->sig_cpu_bill_pct = options.at("signature-cpu-billable-pct").as<uint32_t>();
       EOS_ASSERT( my->chain_config->sig_cpu_bill_pct >= 0 && my->chain_config->sig_cpu_bill_pct <= 100, plugin_config_exception,
                   "signature-cpu-billable-pct must be 0 - 100, ${pct}", ("pct", my->chain_config->sig_cpu_bill_pct) );
@@ -809,6 +864,7 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          my->chain_config->wasm_runtime = *my->wasm_runtime;
 
       my->chain_config->force_all_checks = options.at( "force-all-checks" ).as<bool>();
+      my->chain_config->parallel_auth_validation = options.at( "parallel-auth-validation" ).as<bool>();
       my->chain_config->disable_replay_opts = options.at( "disable-replay-opts" ).as<bool>();
       my->chain_config->contracts_console = options.at( "contracts-console" ).as<bool>();
       my->chain_config->allow_ram_billing_in_notify = options.at( "disable-ram-billing-notify-checks" ).as<bool>();
@@ -880,6 +936,19 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          }
       }
 
+      if(options.count( "blocks-log-stride" )) {
+         EOS_ASSERT( !my->chain_config->prune_config, plugin_config_exception,
+                     "blocks-log-stride cannot be used together with block-log-retain-blocks" );
+         my->chain_config->split_config.emplace();
+         my->chain_config->split_config->stride = options.at( "blocks-log-stride" ).as<uint32_t>();
+         EOS_ASSERT( my->chain_config->split_config->stride > 0, plugin_config_exception, "blocks-log-stride must be greater than 0" );
+         my->chain_config->split_config->max_retained_files = options.at( "max-retained-block-files" ).as<uint32_t>();
+         // relative to blocks-dir, as resolved by the block log
+         my->chain_config->split_config->archive_dir = options.at( "blocks-archive-dir" ).as<bfs::path>();
+      }
+
+      my->chain_config->block_log_queue_size = options.at( "block-log-queue-size" ).as<uint32_t>();
+
       if( options.at( "delete-all-blocks" ).as<bool>()) {
          ilog( "Deleting state database and blocks" );
          if( options.at( "truncate-at-block" ).as<uint32_t>() > 0 )
@@ -1084,6 +1153,14 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          my->chain_config->eosvmoc_config.cache_size = options.at( "eos-vm-oc-cache-size-mb" ).as<uint64_t>() * 1024u * 1024u;
       if( options.count("eos-vm-oc-compile-threads") )
          my->chain_config->eosvmoc_config.threads = options.at("eos-vm-oc-compile-threads").as<uint64_t>();
+      if( options.count("eos-vm-oc-warmup-compiles") )
+         my->chain_config->eosvmoc_config.warmup_compiles = options.at("eos-vm-oc-warmup-compiles").as<uint64_t>();
+      if( options.count("eos-vm-oc-shared-cache-dir") ) {
+         auto dir = options.at("eos-vm-oc-shared-cache-dir").as<bfs::path>();
+         if( dir.is_relative() )
+            dir = app().data_dir() / dir;
+         my->chain_config->eosvmoc_config.shared_cache_dir = dir;
+      }
       if( options["eos-vm-oc-enable"].as<bool>() )
          my->chain_config->eosvmoc_tierup = true;
 #endif
@@ -1184,6 +1261,14 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
             } );
 
       my->accepted_block_connection = my->chain->accepted_block.connect( [this]( const block_state_ptr& blk ) {
+         auto& m = my->_metrics;
+         if( !my->chain->is_producing_block() && m.block_start_time != fc::time_point() )
+            m.block_apply_time.observe_us( (fc::time_point::now() - m.block_start_time).count() );
+         m.block_start_time = fc::time_point();
+         m.head_block_num.set( blk->block_num );
+         m.blocks_accepted.inc();
+         m.block_transactions.inc( blk->block->transactions.size() );
+
          if (my->_account_query_db) {
             my->_account_query_db->commit_block(blk);
          }
@@ -1200,6 +1285,8 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       } );
 
       my->irreversible_block_connection = my->chain->irreversible_block.connect( [this]( const block_state_ptr& blk ) {
+         my->_metrics.last_irreversible_block_num.set( blk->block_num );
+
          if (my->_trx_retry_db) {
             my->_trx_retry_db->on_irreversible_block(blk);
          }
@@ -1218,6 +1305,8 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 
       my->applied_transaction_connection = my->chain->applied_transaction.connect(
             [this]( std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t ) {
+               my->_metrics.applied_transactions.inc();
+
                if (my->_account_query_db) {
                   my->_account_query_db->cache_transaction_trace(std::get<0>(t));
                }
@@ -1233,17 +1322,16 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
                my->applied_transaction_channel.publish( priority::low, std::get<0>(t) );
             } );
 
-      if (my->_trx_finality_status_processing || my->_trx_retry_db) {
-         my->block_start_connection = my->chain->block_start.connect(
-            [this]( uint32_t block_num ) {
-               if (my->_trx_retry_db) {
-                  my->_trx_retry_db->on_block_start(block_num);
-               }
-               if (my->_trx_finality_status_processing) {
-                  my->_trx_finality_status_processing->signal_block_start( block_num );
-               }
-            } );
-      }
+      my->block_start_connection = my->chain->block_start.connect(
+         [this]( uint32_t block_num ) {
+            my->_metrics.block_start_time = fc::time_point::now();
+            if (my->_trx_retry_db) {
+               my->_trx_retry_db->on_block_start(block_num);
+            }
+            if (my->_trx_finality_status_processing) {
+               my->_trx_finality_status_processing->signal_block_start( block_num );
+            }
+         } );
       my->chain->add_indices();
    } FC_LOG_AND_RETHROW()
 
@@ -1292,6 +1380,15 @@ void chain_plugin::plugin_startup()
 
    my->chain_config.reset();
 
+   my->_metrics.head_block_num.set( my->chain->head_block_num() );
+   my->_metrics.last_irreversible_block_num.set( my->chain->last_irreversible_block_num() );
+   my->_metrics.collector = chain::metrics::registry::instance().add_collector( []( chain::metrics::sample_writer& w ) {
+      const auto stats = recovered_key_cache::instance().get_stats();
+      w.write_counter( "nodeos_chain_recovered_key_cache_hits_total", "Signature recoveries served by the recovered key cache", stats.hits );
+      w.write_counter( "nodeos_chain_recovered_key_cache_misses_total", "Signature recoveries not found in the recovered key cache", stats.misses );
+      w.write_gauge( "nodeos_chain_recovered_key_cache_size", "Keys in the recovered key cache", stats.size );
+   } );
+
    if (my->account_queries_enabled) {
       my->account_queries_enabled = false;
       try {
@@ -1304,6 +1401,10 @@ void chain_plugin::plugin_startup()
 } FC_CAPTURE_AND_RETHROW() }
 
 void chain_plugin::plugin_shutdown() {
+   if( my->_metrics.collector ) {
+      chain::metrics::registry::instance().remove_collector( my->_metrics.collector );
+      my->_metrics.collector = 0;
+   }
    my->pre_accepted_block_connection.reset();
    my->accepted_block_header_connection.reset();
    my->accepted_block_connection.reset();
@@ -2112,6 +2213,53 @@ fc::variant read_only::get_block(const read_only::get_block_params& params, cons
            ("ref_block_prefix", ref_block_prefix);
 }
 
+read_only::get_raw_block_results read_only::get_raw_block(const read_only::get_raw_block_params& params, const fc::time_point& deadline) const {
+   std::optional<uint64_t> block_num;
+   std::optional<block_id_type> block_id;
+
+   EOS_ASSERT( !params.block_num_or_id.empty() && params.block_num_or_id.size() <= 64,
+               chain::block_id_type_exception,
+               "Invalid Block number or ID, must be greater than 0 and less than 64 characters"
+   );
+
+   try {
+      block_num = fc::to_uint64(params.block_num_or_id);
+   } catch( ... ) {}
+
+   if( !block_num ) {
+      try {
+         block_id = fc::variant(params.block_num_or_id).as<block_id_type>();
+      } EOS_RETHROW_EXCEPTIONS(chain::block_id_type_exception, "Invalid block ID: ${block_num_or_id}", ("block_num_or_id", params.block_num_or_id))
+      block_num = block_header::num_from_id( *block_id );
+   }
+
+   // served as serialized, without unpacking the block
+   get_raw_block_results result;
+   serialized_block_view block = db.fetch_serialized_block_by_number( *block_num );
+   if( block ) {
+      block_header header;
+      fc::datastream<const char*> ds( block.data.data(), block.data.size() );
+      fc::raw::unpack( ds, header );
+      result.id = header.calculate_id();
+      result.block_num = header.block_num();
+   }
+   if( block_id && (!block || result.id != *block_id) ) {
+      // a block of a fork other than the current branch
+      block = {};
+      if( auto b = db.fetch_block_by_id( *block_id ) ) {
+         result.id = *block_id;
+         result.block_num = b->block_num();
+         result.block = blob{fc::raw::pack( *b )};
+         return result;
+      }
+   }
+
+   EOS_ASSERT( block, unknown_block_exception, "Could not find block: ${block}", ("block", params.block_num_or_id));
+
+   result.block = blob{{block.data.begin(), block.data.end()}};
+   return result;
+}
+
 fc::variant read_only::get_block_info(const read_only::get_block_info_params& params, const fc::time_point& deadline) const {
 
    signed_block_ptr block;
@@ -2786,6 +2934,22 @@ read_only::get_consensus_parameters(const get_consensus_parameters_params&, cons
    return results;
 }
 
+read_only::get_recovered_key_cache_stats_results
+read_only::get_recovered_key_cache_stats(const get_recovered_key_cache_stats_params&, const fc::time_point& deadline ) const {
+   return recovered_key_cache::instance().get_stats();
+}
+
+read_only::get_phase_timings_results
+read_only::get_phase_timings(const get_phase_timings_params& params, const fc::time_point& deadline ) const {
+   auto& timings = phase_timings::instance();
+   get_phase_timings_results results;
+   results.enabled = timings.enabled();
+   results.phases = timings.get_stats();
+   if( params.reset )
+      timings.reset();
+   return results;
+}
+
 } // namespace chain_apis
 
 fc::variant chain_plugin::get_log_trx_trace(const transaction_trace_ptr& trx_trace ) const {
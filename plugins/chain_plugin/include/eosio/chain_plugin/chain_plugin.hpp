@@ -12,6 +12,8 @@
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/fixed_bytes.hpp>
+#include <eosio/chain/phase_timing.hpp>
+#include <eosio/chain/recovered_key_cache.hpp>
 
 #include <boost/container/flat_set.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
@@ -356,6 +358,16 @@ public:
 
    fc::variant get_block(const get_block_params& params, const fc::time_point& deadline) const;
 
+   using get_raw_block_params = get_block_params;
+
+   struct get_raw_block_results {
+      block_id_type          id;
+      uint32_t               block_num = 0;
+      chain::blob            block; ///< the serialized signed_block
+   };
+
+   get_raw_block_results get_raw_block(const get_raw_block_params& params, const fc::time_point& deadline) const;
+
    struct get_block_info_params {
       uint32_t block_num = 0;
    };
@@ -711,6 +723,19 @@ public:
      chain::wasm_config         wasm_config;
    };
    get_consensus_parameters_results get_consensus_parameters(const get_consensus_parameters_params&, const fc::time_point& deadline) const;
+
+   using get_recovered_key_cache_stats_params = empty;
+   using get_recovered_key_cache_stats_results = chain::recovered_key_cache::stats;
+   get_recovered_key_cache_stats_results get_recovered_key_cache_stats(const get_recovered_key_cache_stats_params&, const fc::time_point& deadline) const;
+
+   struct get_phase_timings_params {
+      bool reset = false; ///< clear the histograms after reading them
+   };
+   struct get_phase_timings_results {
+      bool                                             enabled = false;
+      std::vector<chain::phase_timings::phase_stats>   phases;
+   };
+   get_phase_timings_results get_phase_timings(const get_phase_timings_params&, const fc::time_point& deadline) const;
 };
 
 class read_write {
@@ -901,6 +926,7 @@ FC_REFLECT(eosio::chain_apis::read_only::get_transaction_status_results, (state)
 FC_REFLECT(eosio::chain_apis::read_only::get_activated_protocol_features_params, (lower_bound)(upper_bound)(limit)(search_by_block_num)(reverse)(time_limit_ms) )
 FC_REFLECT(eosio::chain_apis::read_only::get_activated_protocol_features_results, (activated_protocol_features)(more) )
 FC_REFLECT(eosio::chain_apis::read_only::get_block_params, (block_num_or_id))
+FC_REFLECT(eosio::chain_apis::read_only::get_raw_block_results, (id)(block_num)(block))
 FC_REFLECT(eosio::chain_apis::read_only::get_block_info_params, (block_num))
 FC_REFLECT(eosio::chain_apis::read_only::get_block_header_state_params, (block_num_or_id))
 
@@ -955,3 +981,5 @@ FC_REFLECT( eosio::chain_apis::read_only::get_required_keys_result, (required_ke
 FC_REFLECT( eosio::chain_apis::read_only::compute_transaction_params, (transaction))
 FC_REFLECT( eosio::chain_apis::read_only::compute_transaction_results, (transaction_id)(processed) )
 FC_REFLECT( eosio::chain_apis::read_only::get_consensus_parameters_results, (chain_config)(wasm_config))
+FC_REFLECT( eosio::chain_apis::read_only::get_phase_timings_params, (reset))
+FC_REFLECT( eosio::chain_apis::read_only::get_phase_timings_results, (enabled)(phases))
@@ -2,6 +2,7 @@
 #include <eosio/http_plugin/common.hpp>
 #include <eosio/http_plugin/beast_http_listener.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/event_tracer.hpp>
 
 #include <fc/log/logger_config.hpp>
 #include <fc/reflect/variant.hpp>
@@ -73,7 +74,14 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
          shared_ptr<beast_http_listener<unix_socket_session, stream_protocol, stream_protocol::socket > > beast_unix_server;
 
          shared_ptr<http_plugin_state> plugin_state = std::make_shared<http_plugin_state>(logger());
-         
+
+         // read-only window, see add_read_only_handler
+         std::shared_ptr<read_only_window> read_only_calls = std::make_shared<read_only_window>( logger(),
+               []( int priority, read_only_window::call c ) { app().post( priority, std::move( c ) ); },
+               [this]( read_only_window::call c ) { boost::asio::post( plugin_state->thread_pool->get_executor(), std::move( c ) ); } );
+
+         chain::metrics::registry::collector_handle metrics_collector = 0;
+
          /**
           * Make an internal_url_handler that will run the url_handler on the app() thread and then
           * return to the http thread pool for response processing
@@ -99,7 +107,10 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
 
                // post to the app thread taking shared ownership of next (via std::shared_ptr),
                // sole ownership of the tracked body and the passed in parameters
-               app().post( priority, [next_ptr, conn=std::move(conn), r=std::move(r), tracked_b, wrapped_then=std::move(wrapped_then)]() mutable {
+               auto handoff = chain::event_tracer::instance().start_handoff( "http_request" );
+               app().post( priority, [next_ptr, conn=std::move(conn), r=std::move(r), tracked_b, wrapped_then=std::move(wrapped_then), handoff]() mutable {
+                  chain::event_tracer::instance().end_handoff( handoff, "http_request queued" );
+                  chain::scoped_trace_event trace_event( "http", "http_request" );
                   try {
                      // call the `next` url_handler and wrap the response handler
                      (*next_ptr)( std::move( r ), std::move(tracked_b->obj()), std::move(wrapped_then)) ;
@@ -110,6 +121,40 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
             };
          }
 
+         /**
+          * Make an internal_url_handler that will queue the url_handler for the next read-only window, where it is run
+          * on the http thread pool while the app() thread is parked, and then return to the http thread pool for
+          * response processing
+          *
+          * @pre b.size() has been added to bytes_in_flight by caller
+          * @param priority - priority to post the read-only window to the app thread at
+          * @param next - the next handler for responses
+          * @param my - the http_plugin_impl
+          * @return the constructed internal_url_handler
+          */
+         static detail::internal_url_handler make_read_only_window_url_handler( int priority, url_handler next, http_plugin_impl_ptr my ) {
+            auto next_ptr = std::make_shared<url_handler>(std::move(next));
+            return [my=std::move(my), priority, next_ptr=std::move(next_ptr)]
+                       ( detail::abstract_conn_ptr conn, string r, string b, url_response_callback then ) {
+               auto tracked_b = make_in_flight<string>(std::move(b), my->plugin_state);
+               if (!conn->verify_max_bytes_in_flight()) {
+                  return;
+               }
+
+               url_response_callback wrapped_then = [tracked_b, then=std::move(then)](int code, const fc::time_point& deadline, std::optional<fc::variant> resp) {
+                  then(code, deadline, std::move(resp));
+               };
+
+               my->read_only_calls->queue( priority, [next_ptr, conn=std::move(conn), r=std::move(r), tracked_b, wrapped_then=std::move(wrapped_then)]() mutable {
+                  try {
+                     (*next_ptr)( std::move( r ), std::move(tracked_b->obj()), std::move(wrapped_then)) ;
+                  } catch( ... ) {
+                     conn->handle_exception();
+                  }
+               } );
+            };
+         }
+
          /**
           * Make an internal_url_handler that will run the url_handler directly
           *
@@ -127,6 +172,15 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
              };
          }
 
+         void add_url_handler( const string& url, detail::internal_url_handler fn, http_content_type content_type = http_content_type::json ) {
+            auto& h = plugin_state->url_handlers[url];
+            h.fn = std::move(fn);
+            h.content_type = content_type;
+            h.request_time = &chain::metrics::registry::instance().make_histogram(
+                  "nodeos_http_request_time_seconds", "Time from reading a request until its response is written, by endpoint",
+                  {{"endpoint", url}} );
+         }
+
          void add_aliases_for_endpoint( const tcp::endpoint& ep, const string& host, const string& port ) {
             auto resolved_port_str = std::to_string(ep.port());
             plugin_state->valid_hosts.emplace(host + ":" + port);
@@ -265,6 +319,11 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
              "Number of worker threads in http thread pool")
             ("http-keep-alive", bpo::value<bool>()->default_value(true),
              "If set to false, do not keep HTTP connections alive, even if client requests.")
+            ("http-read-only-parallel-api", bpo::value<std::vector<string>>()->composing(),
+             "URL of a read-only API (e.g. /v1/chain/get_table_rows) to execute in parallel on the http thread pool while the main thread is paused, can be specified multiple times. "
+             "Only APIs registered as read-only are eligible, nodeos fails to start when another API is given.")
+            ("http-read-only-window-time-us", bpo::value<int64_t>()->default_value(my->read_only_calls->window_time().count()),
+             "Maximum time in microseconds the main thread dispatches queued read-only API calls to the http thread pool before resuming other work")
             ;
    }
 
@@ -301,6 +360,16 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
 
          my->plugin_state->keep_alive = options.at("http-keep-alive").as<bool>();
 
+         if( options.count( "http-read-only-parallel-api" )) {
+            const auto& urls = options["http-read-only-parallel-api"].as<vector<string>>();
+            for( const auto& url : urls )
+               my->read_only_calls->add_parallel_url( url );
+         }
+         int64_t read_only_window_us = options.at("http-read-only-window-time-us").as<int64_t>();
+         EOS_ASSERT( read_only_window_us > 0, chain::plugin_config_exception,
+                     "http-read-only-window-time-us must be greater than 0: ${m}", ("m", read_only_window_us) );
+         my->read_only_calls->set_window_time( fc::microseconds( read_only_window_us ) );
+
          tcp::resolver resolver( app().get_io_service());
          if( options.count( "http-server-address" ) && options.at( "http-server-address" ).as<string>().length()) {
             string lipstr = options.at( "http-server-address" ).as<string>();
@@ -367,6 +436,11 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
    void http_plugin::plugin_startup() {
 
       handle_sighup(); // setup logging
+      my->metrics_collector = chain::metrics::registry::instance().add_collector(
+            [plugin_state = my->plugin_state]( chain::metrics::sample_writer& w ) {
+               w.write_gauge( "nodeos_http_requests_in_flight", "Open http sessions", plugin_state->requests_in_flight.load() );
+               w.write_gauge( "nodeos_http_bytes_in_flight", "Bytes of requests and responses being processed", plugin_state->bytes_in_flight.load() );
+            } );
       app().post(appbase::priority::high, [this] ()
       {
          try {
@@ -441,6 +515,20 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
                   }
                }
             }});
+
+            if( my->read_only_calls->has_parallel_urls() ) {
+               add_async_api({{
+                  std::string("/v1/node/get_read_only_window_stats"),
+                  [&](const string&, string body, url_response_callback cb) mutable {
+                     try {
+                        auto result = (*this).get_read_only_window_stats();
+                        cb(200, fc::time_point::maximum(), fc::variant(result));
+                     } catch (...) {
+                        handle_exception("node", "get_read_only_window_stats", body, cb);
+                     }
+                  }
+               }});
+            }
             
          } catch (...) {
             fc_elog(logger(), "http_plugin startup fails, shutting down");
@@ -455,6 +543,11 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
    }
 
    void http_plugin::plugin_shutdown() {
+      if( my->metrics_collector ) {
+         chain::metrics::registry::instance().remove_collector( my->metrics_collector );
+         my->metrics_collector = 0;
+      }
+      my->read_only_calls->shutdown();
       if(my->beast_server)
          my->beast_server->stop_listening();
       if(my->beast_https_server)
@@ -477,13 +570,24 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
    }
 
    void http_plugin::add_handler(const string& url, const url_handler& handler, int priority) {
+      my->read_only_calls->check_main_thread_url( url );
       fc_ilog( logger(), "add api url: ${c}", ("c", url) );
-      my->plugin_state->url_handlers[url] = my->make_app_thread_url_handler(priority, handler, my);
+      my->add_url_handler(url, my->make_app_thread_url_handler(priority, handler, my));
    }
 
-   void http_plugin::add_async_handler(const string& url, const url_handler& handler) {
+   void http_plugin::add_async_handler(const string& url, const url_handler& handler, http_content_type content_type) {
+      my->read_only_calls->check_main_thread_url( url );
       fc_ilog( logger(), "add api url: ${c}", ("c", url) );
-      my->plugin_state->url_handlers[url] = my->make_http_thread_url_handler(handler);
+      my->add_url_handler(url, my->make_http_thread_url_handler(handler), content_type);
+   }
+
+   void http_plugin::add_read_only_handler(const string& url, const url_handler& handler, int priority) {
+      if( my->read_only_calls->is_parallel_url( url ) ) {
+         fc_ilog( logger(), "add read-only parallel api url: ${c}", ("c", url) );
+         my->add_url_handler(url, my->make_read_only_window_url_handler(priority, handler, my));
+      } else {
+         add_handler(url, handler, priority);
+      }
    }
 
    void http_plugin::handle_exception( const char *api_name, const char *call_name, const string& body, const url_response_callback& cb) {
@@ -553,6 +657,10 @@ class http_plugin_impl : public std::enable_shared_from_this<http_plugin_impl> {
       return result;
    }
 
+   http_plugin::get_read_only_window_stats_result http_plugin::get_read_only_window_stats()const {
+      return my->read_only_calls->stats();
+   }
+
    fc::microseconds http_plugin::get_max_response_time()const {
       return my->plugin_state->max_response_time;
    }
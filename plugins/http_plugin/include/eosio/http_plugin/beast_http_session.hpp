@@ -159,11 +159,13 @@ protected:
          if(handler_itr != plugin_state_->url_handlers.end()) {
             if(plugin_state_->logger.is_enabled(fc::log_level::all))
                plugin_state_->logger.log(FC_LOG_MESSAGE(all, "resource: ${ep}", ("ep", resource)));
+            if(handler_itr->second.content_type == http_content_type::plaintext)
+               res_->set(http::field::content_type, "text/plain; charset=utf-8");
             std::string body = req.body();
-            handler_itr->second(derived().shared_from_this(),
-                                std::move(resource),
-                                std::move(body),
-                                make_http_response_handler(plugin_state_, derived().shared_from_this()));
+            handler_itr->second.fn(derived().shared_from_this(),
+                                   std::move(resource),
+                                   std::move(body),
+                                   make_http_response_handler(plugin_state_, derived().shared_from_this(), handler_itr->second, fc::time_point::now()));
          } else {
             fc_dlog(plugin_state_->logger, "404 - not found: ${ep}", ("ep", resource));
             not_found(resource, *this);
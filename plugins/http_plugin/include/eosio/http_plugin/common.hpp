@@ -1,5 +1,6 @@
 #pragma once
 
+#include <eosio/chain/metrics.hpp>
 #include <eosio/chain/thread_utils.hpp>// for thread pool
 #include <eosio/http_plugin/http_plugin.hpp>
 #include <fc/utility.hpp>
@@ -109,8 +110,14 @@ static size_t in_flight_sizeof(const string& s) {
 }
 }// namespace detail
 
-// key -> priority, url_handler
-typedef map<string, detail::internal_url_handler> url_handlers_type;
+struct registered_url_handler {
+   detail::internal_url_handler fn;
+   http_content_type            content_type = http_content_type::json;
+   chain::metrics::histogram*   request_time = nullptr; ///< time from reading the request until the response is written
+};
+
+// key -> handler
+typedef map<string, registered_url_handler> url_handlers_type;
 
 struct http_plugin_state {
    string access_control_allow_origin;
@@ -204,15 +211,21 @@ auto make_in_flight(T&& object, std::shared_ptr<http_plugin_state> plugin_state)
 
 /**
 * Construct a lambda appropriate for url_response_callback that will
-* JSON-stringify the provided response
+* JSON-stringify the provided response, or send it as is for plaintext handlers
 *
 * @param plugin_state - plugin state object, shared state of http_plugin
 * @param session_ptr - beast_http_session object on which to invoke send_response
+* @param handler - the handler of the request, for its content type and request time metric
+* @param request_start - when the request was read
 * @return lambda suitable for url_response_callback
 */
-auto make_http_response_handler(std::shared_ptr<http_plugin_state> plugin_state, detail::abstract_conn_ptr session_ptr) {
+auto make_http_response_handler(std::shared_ptr<http_plugin_state> plugin_state, detail::abstract_conn_ptr session_ptr,
+                                const registered_url_handler& handler, fc::time_point request_start) {
    return [plugin_state{std::move(plugin_state)},
-           session_ptr{std::move(session_ptr)}](int code, fc::time_point deadline, std::optional<fc::variant> response) {
+           session_ptr{std::move(session_ptr)},
+           content_type = handler.content_type,
+           request_time = handler.request_time,
+           request_start](int code, fc::time_point deadline, std::optional<fc::variant> response) {
       auto tracked_response = make_in_flight(std::move(response), plugin_state);
       if(!session_ptr->verify_max_bytes_in_flight()) {
          return;
@@ -225,16 +238,20 @@ auto make_http_response_handler(std::shared_ptr<http_plugin_state> plugin_state,
 
       // post back to an HTTP thread to allow the response handler to be called from any thread
       boost::asio::post(plugin_state->thread_pool->get_executor(),
-                        [plugin_state, session_ptr, code, deadline, start,
+                        [plugin_state, session_ptr, code, deadline, start, content_type, request_time, request_start,
                          tracked_response = std::move(tracked_response)]() {
                            try {
                               if(tracked_response->obj().has_value()) {
-                                 std::string json = fc::json::to_string(*tracked_response->obj(), deadline + (fc::time_point::now() - start));
-                                 auto tracked_json = make_in_flight(std::move(json), plugin_state);
-                                 session_ptr->send_response(std::move(tracked_json->obj()), code);
+                                 std::string body = content_type == http_content_type::plaintext && tracked_response->obj()->is_string()
+                                                       ? tracked_response->obj()->get_string()
+                                                       : fc::json::to_string(*tracked_response->obj(), deadline + (fc::time_point::now() - start));
+                                 auto tracked_body = make_in_flight(std::move(body), plugin_state);
+                                 session_ptr->send_response(std::move(tracked_body->obj()), code);
                               } else {
                                  session_ptr->send_response({}, code);
                               }
+                              if(request_time)
+                                 request_time->observe_us((fc::time_point::now() - request_start).count());
                            } catch(...) {
                               session_ptr->handle_exception();
                            }
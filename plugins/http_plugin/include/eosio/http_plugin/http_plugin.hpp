@@ -4,6 +4,7 @@
 #include <fc/reflect/reflect.hpp>
 #include <fc/io/json.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/http_plugin/read_only_window.hpp>
 
 namespace eosio {
    using namespace appbase;
@@ -37,6 +38,17 @@ namespace eosio {
     */
    using api_description = std::map<string, url_handler>;
 
+   /**
+    * @brief How the response of a URL handler is sent
+    *
+    * json responses are serialized from the fc::variant, plaintext responses must be a string variant which is sent
+    * as is.
+    */
+   enum class http_content_type {
+      json = 1,
+      plaintext = 2
+   };
+
    struct http_plugin_defaults {
       //If empty, unix socket support will be completely disabled. If not empty,
       // unix socket support is enabled with the given default path (treated relative
@@ -57,6 +69,11 @@ namespace eosio {
     *  thread.  The callback can be called from any thread and will
     *  automatically propagate the call to the http thread.
     *
+    *  Handlers added via add_read_only_api() whose URL is listed in
+    *  http-read-only-parallel-api are instead queued and executed concurrently
+    *  on the http thread pool during a read-only window, a period in which the
+    *  appbase application thread is parked so that chain state cannot change.
+    *
     *  The HTTP service will run in its own thread with its own io_service to
     *  make sure that HTTP request processing does not interfer with other
     *  plugins.
@@ -84,12 +101,19 @@ namespace eosio {
               add_handler(call.first, call.second, priority);
         }
 
-        void add_async_handler(const string& url, const url_handler& handler);
+        void add_async_handler(const string& url, const url_handler& handler, http_content_type content_type = http_content_type::json);
         void add_async_api(const api_description& api) {
            for (const auto& call : api)
               add_async_handler(call.first, call.second);
         }
 
+        // handler only reads state; it may be run in parallel on the http thread pool if opted in via http-read-only-parallel-api
+        void add_read_only_handler(const string& url, const url_handler&, int priority = appbase::priority::medium_low);
+        void add_read_only_api(const api_description& api, int priority = appbase::priority::medium_low) {
+           for (const auto& call : api)
+              add_read_only_handler(call.first, call.second, priority);
+        }
+
         // standard exception handling for api handlers
         static void handle_exception( const char *api_name, const char *call_name, const string& body, const url_response_callback& cb );
 
@@ -104,6 +128,10 @@ namespace eosio {
 
         get_supported_apis_result get_supported_apis()const;
 
+        using get_read_only_window_stats_result = read_only_window_stats;
+
+        get_read_only_window_stats_result get_read_only_window_stats()const;
+
         /// @return the configured http-max-response-time-ms
         fc::microseconds get_max_response_time()const;
 
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace eosio {
+
+struct read_only_window_stats {
+   uint64_t windows = 0;          ///< number of read-only windows executed
+   uint64_t calls = 0;            ///< number of calls executed in read-only windows
+   uint64_t total_blocked_us = 0; ///< total time the main thread was parked in read-only windows
+   uint64_t max_blocked_us = 0;   ///< longest single read-only window
+   uint64_t last_blocked_us = 0;  ///< duration of the most recent read-only window
+   uint64_t queued = 0;           ///< calls currently waiting for a read-only window
+};
+
+/**
+ *  Read-only API calls queued to run concurrently while the main thread is parked, so that they observe chain state
+ *  which does not change underneath them.
+ *
+ *  Calls queued from any thread schedule a window on the main thread. The window dispatches the queued calls to the
+ *  worker threads and waits for them to complete. New calls arriving while the window is open are dispatched until
+ *  the window time has elapsed, later ones wait for the next window. Calls already running are always allowed to
+ *  complete.
+ */
+class read_only_window : public std::enable_shared_from_this<read_only_window> {
+public:
+   using call = std::function<void()>;
+   /// posts to the main thread at a priority
+   using post_main_fn = std::function<void(int priority, call)>;
+   /// posts to the worker threads
+   using post_worker_fn = std::function<void(call)>;
+
+   read_only_window( fc::logger& log, post_main_fn post_main, post_worker_fn post_worker );
+
+   void set_window_time( fc::microseconds window_time ) { _window_time = window_time; }
+   fc::microseconds window_time()const { return _window_time; }
+
+   /// URLs, given to http-read-only-parallel-api, whose calls are executed in windows
+   void add_parallel_url( const std::string& url ) { _parallel_urls.insert( url ); }
+   bool is_parallel_url( const std::string& url )const { return _parallel_urls.count( url ); }
+   bool has_parallel_urls()const { return !_parallel_urls.empty(); }
+   /// throws plugin_config_exception if url, of an API which is not read-only, was given as a parallel URL
+   void check_main_thread_url( const std::string& url )const;
+
+   /// called from any thread, schedules a window on the main thread if one is not already pending
+   void queue( int priority, call c );
+
+   /// runs on the main thread
+   void execute();
+
+   /// drops the queued calls, no window is opened afterwards
+   void shutdown();
+
+   read_only_window_stats stats()const;
+
+private:
+   using queued_call = std::pair<int, call>; // priority, call
+
+   fc::logger&                 _log;
+   const post_main_fn          _post_main;
+   const post_worker_fn        _post_worker;
+   fc::microseconds            _window_time{30'000};
+   std::set<std::string>       _parallel_urls;
+
+   mutable std::mutex          _mtx;
+   std::condition_variable     _cv;
+   std::deque<queued_call>     _queue;                // guarded by _mtx
+   uint32_t                    _running = 0;          // guarded by _mtx
+   bool                        _scheduled = false;    // guarded by _mtx
+   bool                        _open = false;         // guarded by _mtx
+   bool                        _shutting_down = false; // guarded by _mtx
+   read_only_window_stats      _stats;                // guarded by _mtx
+};
+
+} // namespace eosio
+
+FC_REFLECT(eosio::read_only_window_stats, (windows)(calls)(total_blocked_us)(max_blocked_us)(last_blocked_us)(queued))
@@ -0,0 +1,101 @@
+#include <eosio/http_plugin/read_only_window.hpp>
+
+#include <algorithm>
+
+namespace eosio {
+
+read_only_window::read_only_window( fc::logger& log, post_main_fn post_main, post_worker_fn post_worker )
+   : _log( log )
+   , _post_main( std::move( post_main ) )
+   , _post_worker( std::move( post_worker ) ) {}
+
+void read_only_window::check_main_thread_url( const std::string& url )const {
+   EOS_ASSERT( !is_parallel_url( url ), chain::plugin_config_exception,
+               "${u} given to http-read-only-parallel-api is not a read-only API", ("u", url) );
+}
+
+void read_only_window::queue( int priority, call c ) {
+   std::unique_lock g( _mtx );
+   if( _shutting_down )
+      return;
+   _queue.emplace_back( priority, std::move( c ) );
+   if( _open ) {
+      g.unlock();
+      _cv.notify_one();
+   } else if( !_scheduled ) {
+      _scheduled = true;
+      g.unlock();
+      _post_main( priority, [self=shared_from_this()]() {
+         self->execute();
+      } );
+   }
+}
+
+void read_only_window::execute() {
+   const auto start = fc::time_point::now();
+   const auto window_end = start + _window_time;
+   uint64_t calls = 0;
+
+   std::unique_lock g( _mtx );
+   if( _shutting_down ) {
+      _queue.clear();
+      _scheduled = false;
+      return;
+   }
+
+   _open = true;
+   while( true ) {
+      while( !_queue.empty() && fc::time_point::now() < window_end ) {
+         auto c = std::move( _queue.front().second );
+         _queue.pop_front();
+         ++_running;
+         ++calls;
+         _post_worker( [self=shared_from_this(), c=std::move( c )]() {
+            c();
+            {
+               std::lock_guard lg( self->_mtx );
+               --self->_running;
+            }
+            self->_cv.notify_one();
+         } );
+      }
+      if( _running == 0 && (_queue.empty() || fc::time_point::now() >= window_end) )
+         break;
+      _cv.wait( g );
+   }
+   _open = false;
+
+   const uint64_t blocked_us = (fc::time_point::now() - start).count();
+   ++_stats.windows;
+   _stats.calls += calls;
+   _stats.total_blocked_us += blocked_us;
+   _stats.max_blocked_us = std::max( _stats.max_blocked_us, blocked_us );
+   _stats.last_blocked_us = blocked_us;
+
+   fc_dlog( _log, "read-only window executed ${c} calls, main thread blocked ${t}us, ${q} calls deferred",
+            ("c", calls)("t", blocked_us)("q", _queue.size()) );
+
+   if( _queue.empty() ) {
+      _scheduled = false;
+   } else {
+      // window time exhausted, let the main thread process other work before opening the next window
+      _post_main( _queue.front().first, [self=shared_from_this()]() {
+         self->execute();
+      } );
+   }
+}
+
+void read_only_window::shutdown() {
+   std::lock_guard g( _mtx );
+   _shutting_down = true;
+   _queue.clear();
+}
+
+read_only_window_stats read_only_window::stats()const {
+   std::lock_guard g( _mtx );
+   read_only_window_stats result = _stats;
+   result.queued = _queue.size();
+   return result;
+}
+
+} // namespace eosio
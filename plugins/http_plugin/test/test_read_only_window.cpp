@@ -0,0 +1,162 @@
+#define BOOST_TEST_MODULE read_only_window
+#include <boost/test/included/unit_test.hpp>
+
+#include <eosio/http_plugin/read_only_window.hpp>
+
+#include <eosio/chain/thread_utils.hpp>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+using namespace eosio;
+
+namespace {
+
+// a single thread standing in for the main thread, and the http thread pool the calls run on
+struct window_fixture {
+   chain::named_thread_pool main{ "main", 1 };
+   chain::named_thread_pool workers{ "http", 4 };
+   std::shared_ptr<read_only_window> window = std::make_shared<read_only_window>( fc::logger::get( DEFAULT_LOGGER ),
+         [this]( int, read_only_window::call c ) { boost::asio::post( main.get_executor(), std::move( c ) ); },
+         [this]( read_only_window::call c ) { boost::asio::post( workers.get_executor(), std::move( c ) ); } );
+
+   ~window_fixture() {
+      workers.stop();
+      main.stop();
+   }
+
+   // returns once the main thread is done with what was posted to it before
+   void sync_main() {
+      std::promise<void> done;
+      boost::asio::post( main.get_executor(), [&]() { done.set_value(); } );
+      done.get_future().wait();
+   }
+};
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(read_only_window_tests)
+
+// calls queued while the main thread is writing wait for it, then run together in one window
+BOOST_FIXTURE_TEST_CASE(queued_while_main_thread_writes, window_fixture) {
+   std::promise<void> write_started, finish_write;
+   std::atomic<bool> written = false;
+   boost::asio::post( main.get_executor(), [&]() {
+      write_started.set_value();
+      finish_write.get_future().wait();
+      written = true;
+   } );
+   write_started.get_future().wait();
+
+   constexpr uint32_t num_calls = 8;
+   std::atomic<uint32_t> calls_run = 0, calls_after_write = 0;
+   std::promise<void> all_run;
+   for( uint32_t i = 0; i < num_calls; ++i ) {
+      window->queue( 0, [&]() {
+         if( written )
+            ++calls_after_write;
+         if( ++calls_run == num_calls )
+            all_run.set_value();
+      } );
+   }
+   std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+   BOOST_CHECK_EQUAL( calls_run, 0u );
+   BOOST_CHECK_EQUAL( window->stats().queued, num_calls );
+
+   finish_write.set_value();
+   BOOST_REQUIRE( all_run.get_future().wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready );
+   sync_main();
+   BOOST_CHECK_EQUAL( calls_after_write, num_calls );
+   const auto stats = window->stats();
+   BOOST_CHECK_EQUAL( stats.windows, 1u );
+   BOOST_CHECK_EQUAL( stats.calls, num_calls );
+   BOOST_CHECK_EQUAL( stats.queued, 0u );
+}
+
+// the main thread is parked while calls run, it writes again only once they completed
+BOOST_FIXTURE_TEST_CASE(main_thread_parked_during_window, window_fixture) {
+   std::promise<void> call_started, finish_call;
+   std::atomic<bool> call_done = false, written = false, written_after_call = false;
+   window->queue( 0, [&]() {
+      call_started.set_value();
+      finish_call.get_future().wait();
+      call_done = true;
+   } );
+   call_started.get_future().wait();
+
+   std::promise<void> write_done;
+   boost::asio::post( main.get_executor(), [&]() {
+      written_after_call = call_done.load();
+      written = true;
+      write_done.set_value();
+   } );
+   std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+   BOOST_CHECK( !written );
+
+   finish_call.set_value();
+   BOOST_REQUIRE( write_done.get_future().wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready );
+   BOOST_CHECK( written_after_call );
+}
+
+// past the window time no more calls are dispatched, the window waits for those running and later ones get a new window
+BOOST_FIXTURE_TEST_CASE(drains_at_window_end, window_fixture) {
+   window->set_window_time( fc::milliseconds( 1 ) );
+
+   std::promise<void> second_run;
+   std::atomic<bool> first_done = false, second_after_first = false;
+   window->queue( 0, [&]() {
+      std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+      // queued while the window is open but past its end
+      window->queue( 0, [&]() {
+         second_after_first = first_done.load();
+         second_run.set_value();
+      } );
+      first_done = true;
+   } );
+
+   BOOST_REQUIRE( second_run.get_future().wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready );
+   sync_main();
+   BOOST_CHECK( second_after_first );
+   const auto stats = window->stats();
+   BOOST_CHECK_EQUAL( stats.windows, 2u );
+   BOOST_CHECK_EQUAL( stats.calls, 2u );
+   BOOST_CHECK_EQUAL( stats.queued, 0u );
+   // the first window lasted until its call completed
+   BOOST_CHECK_GE( stats.max_blocked_us, 20'000u );
+}
+
+// an API which is not read-only cannot be executed in a window
+BOOST_FIXTURE_TEST_CASE(rejects_write_endpoints, window_fixture) {
+   window->add_parallel_url( "/v1/chain/get_table_rows" );
+   window->add_parallel_url( "/v1/chain/push_transaction" );
+   BOOST_CHECK( window->is_parallel_url( "/v1/chain/get_table_rows" ) );
+   BOOST_CHECK_THROW( window->check_main_thread_url( "/v1/chain/push_transaction" ), chain::plugin_config_exception );
+   BOOST_CHECK_NO_THROW( window->check_main_thread_url( "/v1/chain/push_block" ) );
+}
+
+// calls queued after shutdown are dropped
+BOOST_FIXTURE_TEST_CASE(shutdown_drops_calls, window_fixture) {
+   std::promise<void> write_started, finish_write;
+   boost::asio::post( main.get_executor(), [&]() {
+      write_started.set_value();
+      finish_write.get_future().wait();
+   } );
+   write_started.get_future().wait();
+
+   std::atomic<uint32_t> calls_run = 0;
+   window->queue( 0, [&]() { ++calls_run; } );
+   window->shutdown();
+   window->queue( 0, [&]() { ++calls_run; } );
+   BOOST_CHECK_EQUAL( window->stats().queued, 0u );
+
+   finish_write.set_value();
+   sync_main();
+   BOOST_CHECK_EQUAL( calls_run, 0u );
+   BOOST_CHECK_EQUAL( window->stats().windows, 0u );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
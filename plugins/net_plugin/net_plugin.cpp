@@ -9,6 +9,8 @@
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/producer_plugin/producer_plugin.hpp>
 #include <eosio/chain/contract_types.hpp>
+#include <eosio/chain/metrics.hpp>
+#include <eosio/chain/event_tracer.hpp>
 
 #include <fc/network/message_buffer.hpp>
 #include <fc/network/ip.hpp>
@@ -154,6 +156,8 @@ namespace eosio {
       void sync_update_expected( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied );
       void recv_handshake( const connection_ptr& c, const handshake_message& msg );
       void sync_recv_notice( const connection_ptr& c, const notice_message& msg );
+      /// writes the current sync state, thread safe
+      void write_metrics( chain::metrics::sample_writer& w ) const;
       inline std::unique_lock<std::mutex> locked_sync_mutex() {
          return std::unique_lock<std::mutex>(sync_mtx);
       }
@@ -302,6 +306,10 @@ namespace eosio {
 
       void start_listen_loop();
 
+      /// registry collector for per connection and sync statistics, called from the rendering thread
+      void write_metrics( chain::metrics::sample_writer& w ) const;
+      chain::metrics::registry::collector_handle metrics_collector = 0;
+
       void on_accepted_block( const block_state_ptr& bs );
       void on_pre_accepted_block( const signed_block_ptr& bs );
       void transaction_ack(const std::pair<fc::exception_ptr, packed_transaction_ptr>&);
@@ -463,6 +471,18 @@ namespace eosio {
          return _write_queue_size;
       }
 
+      struct queue_sizes {
+         uint32_t write_queue_bytes = 0;
+         size_t   write_queue = 0;
+         size_t   sync_write_queue = 0;
+         size_t   out_queue = 0;
+      };
+
+      queue_sizes get_queue_sizes() const {
+         std::lock_guard<std::mutex> g( _mtx );
+         return { _write_queue_size, _write_queue.size(), _sync_write_queue.size(), _out_queue.size() };
+      }
+
       bool is_out_queue_empty() const {
          std::lock_guard<std::mutex> g( _mtx );
          return _out_queue.empty();
@@ -475,16 +495,18 @@ namespace eosio {
       }
 
       // @param callback must not callback into queued_buffer
+      // @param body if set, sent right after buff without being copied
       bool add_write_queue( const std::shared_ptr<vector<char>>& buff,
                             std::function<void( boost::system::error_code, std::size_t )> callback,
-                            bool to_sync_queue ) {
+                            bool to_sync_queue,
+                            const serialized_block_view& body = {} ) {
          std::lock_guard<std::mutex> g( _mtx );
          if( to_sync_queue ) {
-            _sync_write_queue.push_back( {buff, callback} );
+            _sync_write_queue.push_back( {buff, body, callback} );
          } else {
-            _write_queue.push_back( {buff, callback} );
+            _write_queue.push_back( {buff, body, callback} );
          }
-         _write_queue_size += buff->size();
+         _write_queue_size += buff->size() + body.data.size();
          if( _write_queue_size > 2 * def_max_write_queue_size ) {
             return false;
          }
@@ -515,7 +537,9 @@ namespace eosio {
          while ( w_queue.size() > 0 ) {
             auto& m = w_queue.front();
             bufs.push_back( boost::asio::buffer( *m.buff ));
-            _write_queue_size -= m.buff->size();
+            if( m.body )
+               bufs.push_back( boost::asio::buffer( m.body.data.data(), m.body.data.size() ));
+            _write_queue_size -= m.buff->size() + m.body.data.size();
             _out_queue.emplace_back( m );
             w_queue.pop_front();
          }
@@ -524,6 +548,7 @@ namespace eosio {
    private:
       struct queued_write {
          std::shared_ptr<vector<char>> buff;
+         serialized_block_view         body; // kept until written
          std::function<void( boost::system::error_code, std::size_t )> callback;
       };
 
@@ -631,6 +656,8 @@ namespace eosio {
       string                  local_endpoint_port;
 
       std::atomic<uint32_t>   trx_in_progress_size{0};
+      std::atomic<uint64_t>   bytes_sent{0};
+      std::atomic<uint64_t>   bytes_received{0};
       const uint32_t          connection_id;
       int16_t                 sent_handshake_count = 0;
       std::atomic<bool>       connecting{true};
@@ -734,6 +761,7 @@ namespace eosio {
 
       void enqueue( const net_message &msg );
       void enqueue_block( const signed_block_ptr& sb, bool to_sync_queue = false);
+      void enqueue_serialized_block( uint32_t block_num, const serialized_block_view& sb );
       void enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
                            go_away_reason close_after_send,
                            bool to_sync_queue = false);
@@ -750,7 +778,8 @@ namespace eosio {
 
       void queue_write(const std::shared_ptr<vector<char>>& buff,
                        std::function<void(boost::system::error_code, std::size_t)> callback,
-                       bool to_sync_queue = false);
+                       bool to_sync_queue = false,
+                       const serialized_block_view& body = {});
       void do_queue_write();
 
       bool is_valid( const handshake_message& msg ) const;
@@ -1195,8 +1224,9 @@ namespace eosio {
    // called from connection strand
    void connection::queue_write(const std::shared_ptr<vector<char>>& buff,
                                 std::function<void(boost::system::error_code, std::size_t)> callback,
-                                bool to_sync_queue) {
-      if( !buffer_queue.add_write_queue( buff, callback, to_sync_queue )) {
+                                bool to_sync_queue,
+                                const serialized_block_view& body) {
+      if( !buffer_queue.add_write_queue( buff, callback, to_sync_queue, body )) {
          peer_wlog( this, "write_queue full ${s} bytes, giving up on connection", ("s", buffer_queue.write_queue_size()) );
          close();
          return;
@@ -1235,6 +1265,7 @@ namespace eosio {
                   return;
                }
 
+               c->bytes_sent.fetch_add( w, std::memory_order_relaxed );
                c->buffer_queue.out_callback( ec, w );
 
                c->enqueue_sync_block();
@@ -1290,13 +1321,13 @@ namespace eosio {
          connection_ptr c = weak.lock();
          if( !c ) return;
          controller& cc = my_impl->chain_plug->chain();
-         signed_block_ptr sb;
+         serialized_block_view sb;
          try {
-            sb = cc.fetch_block_by_number( num );
+            sb = cc.fetch_serialized_block_by_number( num );
          } FC_LOG_AND_DROP();
          if( sb ) {
-            c->strand.post( [c, sb{std::move(sb)}]() {
-               c->enqueue_block( sb, true );
+            c->strand.post( [c, num, sb{std::move(sb)}]() {
+               c->enqueue_serialized_block( num, sb );
             });
          } else {
             c->strand.post( [c, num]() {
@@ -1382,6 +1413,25 @@ namespace eosio {
          fc_dlog( logger, "sending block ${bn}", ("bn", sb->block_num()) );
          return buffer_factory::create_send_buffer( signed_block_which, *sb );
       }
+
+   public:
+      /// header of a signed_block net_message, to be followed by the serialized block
+      static send_buffer_type create_send_header( const serialized_block_view& sb ) {
+         static_assert( signed_block_which == fc::get_index<net_message, signed_block>() );
+         // matches which of net_message for signed_block
+         const uint32_t which_size = fc::raw::pack_size( unsigned_int( signed_block_which ) );
+         const uint32_t payload_size = which_size + sb.data.size();
+
+         const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
+         const size_t buffer_size = message_header_size + which_size;
+
+         auto send_buffer = std::make_shared<vector<char>>( buffer_size );
+         fc::datastream<char*> ds( send_buffer->data(), buffer_size );
+         ds.write( header, message_header_size );
+         fc::raw::pack( ds, unsigned_int( signed_block_which ) );
+
+         return send_buffer;
+      }
    };
 
    struct trx_buffer_factory : public buffer_factory {
@@ -1430,6 +1480,18 @@ namespace eosio {
       enqueue_buffer( sb, no_reason, to_sync_queue);
    }
 
+   // called from connection strand
+   void connection::enqueue_serialized_block( uint32_t block_num, const serialized_block_view& sb ) {
+      peer_dlog( this, "enqueue block ${num}", ("num", block_num) );
+      verify_strand_in_this_thread( strand, __func__, __LINE__ );
+
+      // the block is sent straight from the block log after a header of its own
+      auto header = block_buffer_factory::create_send_header( sb );
+      latest_blk_time = get_time();
+      connection_ptr self = shared_from_this();
+      queue_write( header, [conn{std::move(self)}]( boost::system::error_code, std::size_t ) {}, true, sb );
+   }
+
    // called from connection strand
    void connection::enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
                                     go_away_reason close_after_send,
@@ -1549,6 +1611,14 @@ namespace eosio {
     }
   }
 
+   void sync_manager::write_metrics( chain::metrics::sample_writer& w ) const {
+      const stages state = sync_state;
+      for( auto s : { lib_catchup, head_catchup, in_sync } ) {
+         w.write_gauge( "nodeos_net_sync_state", "1 for the current sync state of the node, 0 for the others",
+                        s == state ? 1 : 0, {{"state", stage_str( s )}} );
+      }
+   }
+
    bool sync_manager::set_state(stages newstate) {
       if( sync_state == newstate ) {
          return false;
@@ -2480,6 +2550,7 @@ namespace eosio {
                                    ("bt",bytes_transferred)("btw",conn->pending_message_buffer.bytes_to_write()) );
                      }
                      EOS_ASSERT(bytes_transferred <= conn->pending_message_buffer.bytes_to_write(), plugin_exception, "");
+                     conn->bytes_received.fetch_add( bytes_transferred, std::memory_order_relaxed );
                      conn->pending_message_buffer.advance_write_ptr(bytes_transferred);
                      while (conn->pending_message_buffer.bytes_to_read() > 0) {
                         uint32_t bytes_in_buffer = conn->pending_message_buffer.bytes_to_read();
@@ -2718,6 +2789,33 @@ namespace eosio {
             chain_lib_id, chain_head_blk_id, chain_fork_head_blk_id );
    }
 
+   // called from the metrics rendering thread
+   void net_plugin_impl::write_metrics( chain::metrics::sample_writer& w ) const {
+      if( sync_master )
+         sync_master->write_metrics( w );
+
+      std::shared_lock<std::shared_mutex> g( connections_mtx );
+      w.write_gauge( "nodeos_net_connections", "Number of peer connections, including ones not currently connected",
+                     connections.size() );
+      for( const auto& c : connections ) {
+         string peer = c->peer_address();
+         if( peer.empty() ) {
+            std::lock_guard<std::mutex> g_conn( c->conn_mtx );
+            peer = c->remote_endpoint_ip;
+         }
+         const chain::metrics::labels l{ {"connection_id", std::to_string( c->connection_id )}, {"peer", std::move( peer )} };
+         const auto q = c->buffer_queue.get_queue_sizes();
+         w.write_counter( "nodeos_net_connection_sent_bytes_total", "Bytes written to the peer", c->bytes_sent.load( std::memory_order_relaxed ), l );
+         w.write_counter( "nodeos_net_connection_received_bytes_total", "Bytes read from the peer", c->bytes_received.load( std::memory_order_relaxed ), l );
+         w.write_gauge( "nodeos_net_connection_write_queue_bytes", "Bytes queued for writing to the peer", q.write_queue_bytes, l );
+         w.write_gauge( "nodeos_net_connection_write_queue_messages", "Messages queued for writing to the peer", q.write_queue, l );
+         w.write_gauge( "nodeos_net_connection_sync_write_queue_messages", "Sync messages queued for writing to the peer", q.sync_write_queue, l );
+         w.write_gauge( "nodeos_net_connection_out_queue_messages", "Messages being written to the peer", q.out_queue, l );
+         w.write_gauge( "nodeos_net_connection_connected", "1 if the socket to the peer is open", c->socket_is_open() ? 1 : 0, l );
+         w.write_gauge( "nodeos_net_connection_syncing", "1 if syncing from the peer", c->syncing ? 1 : 0, l );
+      }
+   }
+
    bool connection::is_valid( const handshake_message& msg ) const {
       // Do some basic validation of an incoming handshake_message, so things
       // that really aren't handshake messages can be quickly discarded without
@@ -3136,7 +3234,9 @@ namespace eosio {
    // called from connection strand
    void connection::handle_message( const block_id_type& id, signed_block_ptr ptr ) {
       peer_dlog( this, "received signed_block ${num}, id ${id}", ("num", ptr->block_num())("id", id) );
-      app().post(priority::medium, [ptr{std::move(ptr)}, id, c = shared_from_this()]() mutable {
+      auto handoff = chain::event_tracer::instance().start_handoff( "net_block" );
+      app().post(priority::medium, [ptr{std::move(ptr)}, id, c = shared_from_this(), handoff]() mutable {
+         chain::event_tracer::instance().end_handoff( handoff, "net_block queued" );
          c->process_signed_block( id, std::move( ptr ) );
       });
    }
@@ -3738,6 +3838,9 @@ namespace eosio {
       my->incoming_transaction_ack_subscription = app().get_channel<compat::channels::transaction_ack>().subscribe(
             std::bind(&net_plugin_impl::transaction_ack, my.get(), std::placeholders::_1));
 
+      my->metrics_collector = chain::metrics::registry::instance().add_collector(
+            [my = my]( chain::metrics::sample_writer& w ) { my->write_metrics( w ); } );
+
       app().post(priority::highest, [my=my, listen_endpoint](){
          if( my->acceptor ) {
             try {
@@ -3778,6 +3881,10 @@ namespace eosio {
       try {
          fc_ilog( logger, "shutdown.." );
          my->in_shutdown = true;
+         if( my->metrics_collector ) {
+            chain::metrics::registry::instance().remove_collector( my->metrics_collector );
+            my->metrics_collector = 0;
+         }
          {
             std::lock_guard<std::mutex> g( my->connector_check_timer_mtx );
             if( my->connector_check_timer )
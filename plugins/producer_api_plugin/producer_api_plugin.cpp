@@ -123,6 +123,15 @@ void producer_api_plugin::plugin_startup() {
        CALL_WITH_400(producer, producer, get_account_ram_corrections,
             INVOKE_R_R(producer, get_account_ram_corrections, producer_plugin::get_account_ram_corrections_params), 201),
    }, appbase::priority::medium_high);
+
+   // the event tracer and the intrinsic usage tracker are thread safe, dump them on the http threads to keep them out
+   // of the main thread
+   app().get_plugin<http_plugin>().add_async_api({
+       CALL_WITH_400(producer, producer, get_event_trace,
+            INVOKE_R_R_II(producer, get_event_trace, producer_plugin::get_event_trace_params), 201),
+       CALL_WITH_400(producer, producer, get_intrinsic_usage,
+            INVOKE_R_R_II(producer, get_intrinsic_usage, producer_plugin::get_intrinsic_usage_params), 201),
+   });
 }
 
 void producer_api_plugin::plugin_initialize(const variables_map& options) {
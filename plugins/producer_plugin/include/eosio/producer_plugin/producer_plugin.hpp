@@ -1,6 +1,7 @@
 #pragma once
 
 #include <eosio/chain_plugin/chain_plugin.hpp>
+#include <eosio/chain/intrinsic_usage.hpp>
 #include <eosio/signature_provider_plugin/signature_provider_plugin.hpp>
 
 #include <appbase/application.hpp>
@@ -22,6 +23,8 @@ public:
       std::optional<int32_t>   subjective_cpu_leeway_us;
       std::optional<double>    incoming_defer_ratio;
       std::optional<uint32_t>  greylist_limit;
+      std::optional<uint32_t>  event_trace_buffer_size;
+      std::optional<uint32_t>  intrinsic_usage_window_sec;
    };
 
    struct whitelist_blacklist {
@@ -66,6 +69,20 @@ public:
       bool                         reverse = false;
    };
 
+   struct get_event_trace_params {
+      bool clear = false;
+   };
+
+   struct get_intrinsic_usage_params {
+      std::optional<account_name>  account;
+      uint32_t                     limit = 100;
+   };
+
+   struct get_intrinsic_usage_result {
+      uint32_t                                                 window_sec = 0;
+      std::vector<chain::intrinsic_usage_tracker::account_usage> accounts;
+   };
+
    struct get_account_ram_corrections_result {
       std::vector<fc::variant>     rows;
       std::optional<account_name>  more;
@@ -114,6 +131,10 @@ public:
 
    get_account_ram_corrections_result  get_account_ram_corrections( const get_account_ram_corrections_params& params ) const;
 
+   fc::variant get_event_trace( const get_event_trace_params& params ) const;
+
+   get_intrinsic_usage_result get_intrinsic_usage( const get_intrinsic_usage_params& params ) const;
+
     void log_failed_transaction(const transaction_id_type& trx_id, const chain::packed_transaction_ptr& packed_trx_ptr, const char* reason) const;
 
  private:
@@ -122,7 +143,7 @@ public:
 
 } //eosio
 
-FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(max_scheduled_transaction_time_per_block_ms)(subjective_cpu_leeway_us)(incoming_defer_ratio)(greylist_limit));
+FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(max_scheduled_transaction_time_per_block_ms)(subjective_cpu_leeway_us)(incoming_defer_ratio)(greylist_limit)(event_trace_buffer_size)(intrinsic_usage_window_sec));
 FC_REFLECT(eosio::producer_plugin::greylist_params, (accounts));
 FC_REFLECT(eosio::producer_plugin::whitelist_blacklist, (actor_whitelist)(actor_blacklist)(contract_whitelist)(contract_blacklist)(action_blacklist)(key_blacklist) )
 FC_REFLECT(eosio::producer_plugin::integrity_hash_information, (head_block_id)(integrity_hash))
@@ -131,3 +152,6 @@ FC_REFLECT(eosio::producer_plugin::scheduled_protocol_feature_activations, (prot
 FC_REFLECT(eosio::producer_plugin::get_supported_protocol_features_params, (exclude_disabled)(exclude_unactivatable))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_params, (lower_bound)(upper_bound)(limit)(reverse))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_result, (rows)(more))
+FC_REFLECT(eosio::producer_plugin::get_event_trace_params, (clear))
+FC_REFLECT(eosio::producer_plugin::get_intrinsic_usage_params, (account)(limit))
+FC_REFLECT(eosio::producer_plugin::get_intrinsic_usage_result, (window_sec)(accounts))
@@ -4,6 +4,9 @@
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/event_tracer.hpp>
+#include <eosio/chain/intrinsic_usage.hpp>
+#include <eosio/chain/metrics.hpp>
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/transaction_object.hpp>
 #include <eosio/chain/thread_utils.hpp>
@@ -19,6 +22,8 @@
 
 #include <iostream>
 #include <algorithm>
+#include <deque>
+#include <mutex>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/range/adaptor/map.hpp>
 #include <boost/multi_index_container.hpp>
@@ -266,6 +271,15 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       void log_trx_results( const packed_transaction_ptr& trx, const transaction_trace_ptr& trace,
                             const fc::exception_ptr& except_ptr, uint32_t billed_cpu_us, const fc::time_point& start );
 
+      struct read_only_trx {
+         transaction_metadata_ptr             trx;
+         bool                                 return_failure_trace = false;
+         next_function<transaction_trace_ptr> next;
+      };
+      void queue_read_only_trx( transaction_metadata_ptr trx, bool return_failure_trace, next_function<transaction_trace_ptr> next );
+      void execute_read_only_window();
+      void run_read_only_trxs( const fc::time_point& window_end, std::deque<read_only_trx>& retry_on_main, std::mutex& retry_mtx );
+
       boost::program_options::variables_map _options;
       bool     _production_enabled                 = false;
       bool     _pause_production                   = false;
@@ -280,6 +294,15 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       unapplied_transaction_queue                               _unapplied_transactions;
       std::optional<named_thread_pool>                          _thread_pool;
 
+      // read-only transactions are executed by _ro_thread_pool while the main thread waits, see execute_read_only_window()
+      uint16_t                                                  _ro_thread_pool_size = 0;
+      std::optional<named_thread_pool>                          _ro_thread_pool;
+      fc::microseconds                                          _ro_max_trx_time_us;
+      fc::microseconds                                          _ro_window_time_us;
+      std::mutex                                                _ro_trx_queue_mtx;
+      std::deque<read_only_trx>                                 _ro_trx_queue;               // protected by _ro_trx_queue_mtx
+      bool                                                      _ro_window_scheduled = false; // protected by _ro_trx_queue_mtx
+
       std::atomic<int32_t>                                      _max_transaction_time_ms; // modified by app thread, read by net_plugin thread pool
       fc::microseconds                                          _max_irreversible_block_age_us;
       int32_t                                                   _produce_time_offset_us = 0;
@@ -308,6 +331,25 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       transaction_id_with_expiry_index                         _blacklisted_transactions;
       pending_snapshot_index                                   _pending_snapshot_index;
+
+      // updated on the main thread, exposed by the prometheus_plugin
+      struct producer_metrics {
+         using registry = chain::metrics::registry;
+         chain::metrics::gauge&   unapplied_transactions = registry::instance().make_gauge(
+               "nodeos_producer_unapplied_transactions", "Transactions in the unapplied transaction queue" );
+         chain::metrics::counter& failure_limit_drops = registry::instance().make_counter(
+               "nodeos_producer_subjective_billing_drops_total", "Transactions dropped by subjective billing",
+               {{"reason", "account_failure_limit"}} );
+         chain::metrics::counter& cpu_exceeded_drops = registry::instance().make_counter(
+               "nodeos_producer_subjective_billing_drops_total", "Transactions dropped by subjective billing",
+               {{"reason", "subjective_cpu_exceeded"}} );
+         chain::metrics::counter& blocks_produced = registry::instance().make_counter(
+               "nodeos_producer_blocks_produced_total", "Blocks produced by this node" );
+         chain::metrics::gauge&   block_cpu_fill_ratio = registry::instance().make_gauge(
+               "nodeos_producer_block_cpu_fill_ratio", "CPU usage of the last produced block relative to max_block_cpu_usage" );
+         chain::metrics::gauge&   block_net_fill_ratio = registry::instance().make_gauge(
+               "nodeos_producer_block_net_fill_ratio", "NET usage of the last produced block relative to max_block_net_usage" );
+      } _metrics;
       subjective_billing                                       _subjective_billing;
       account_failures                                         _account_fails{_subjective_billing};
 
@@ -355,6 +397,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          auto before = _unapplied_transactions.size();
          _unapplied_transactions.clear_applied( bsp );
          _subjective_billing.on_block( _log, bsp, fc::time_point::now() );
+         _metrics.unapplied_transactions.set( _unapplied_transactions.size() );
          fc_dlog( _log, "Removed applied transactions before: ${before}, after: ${after}",
                   ("before", before)("after", _unapplied_transactions.size()) );
       }
@@ -400,6 +443,8 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
          const auto& id = block_id ? *block_id : block->calculate_id();
          auto blk_num = block->block_num();
+         scoped_trace_event trace_event( "producer", "on_incoming_block" );
+         trace_event.set_arg( "block_num", blk_num );
 
          fc_dlog(_log, "received incoming block ${n} ${id}", ("n", blk_num)("id", id));
 
@@ -411,7 +456,9 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          if( existing ) { return false; }
 
          // start processing of block
-         auto bsf = chain.create_block_state_future( id, block );
+         auto bsf = chain.create_block_state_future( id, block, [this]( const transaction_id_type& trx_id ) {
+            return _unapplied_transactions.get_trx( trx_id );
+         } );
 
          // abort the pending block
          abort_block();
@@ -516,11 +563,21 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
             };
          }
 
-         boost::asio::post(_thread_pool->get_executor(), [self = this, future{std::move(future)}, persist_until_expired, return_failure_traces,
+         boost::asio::post(_thread_pool->get_executor(), [self = this, future{std::move(future)}, persist_until_expired, read_only, return_failure_traces,
                                                           next{std::move(next)}, trx=trx]() mutable {
             if( future.valid() ) {
                future.wait();
-               app().post( priority::low, [self, future{std::move(future)}, persist_until_expired, next{std::move( next )}, trx{std::move(trx)}, return_failure_traces]() mutable {
+               if( read_only && self->_ro_thread_pool ) {
+                  try {
+                     auto result = future.get();
+                     self->queue_read_only_trx( std::move(result), return_failure_traces, std::move(next) );
+                  } CATCH_AND_CALL(next);
+                  return;
+               }
+               auto handoff = event_tracer::instance().start_handoff( "incoming_transaction" );
+               app().post( priority::low, [self, future{std::move(future)}, persist_until_expired, next{std::move( next )}, trx{std::move(trx)}, return_failure_traces, handoff]() mutable {
+                  event_tracer::instance().end_handoff( handoff, "incoming_transaction queued" );
+                  scoped_trace_event trace_event( "producer", "incoming_transaction" );
                   auto exception_handler = [self, &next, trx{std::move(trx)}](fc::exception_ptr ex) {
                      self->log_trx_results( trx, nullptr, ex, 0, fc::time_point::now() );
                      next( std::move(ex) );
@@ -713,6 +770,13 @@ void producer_plugin::set_program_options(
           "Sets the maximum amount of failures that are allowed for a given account per block.")
          ("subjective-account-decay-time-minutes", bpo::value<uint32_t>()->default_value( config::account_cpu_usage_average_window_ms / 1000 / 60 ),
           "Sets the time to return full subjective cpu for accounts")
+         ("read-only-threads", bpo::value<uint16_t>()->default_value(0),
+          "Number of worker threads executing read-only transactions (e.g. /v1/chain/compute_transaction) in parallel while the main thread waits. "
+          "0 executes them on the main thread. Not supported with the eos-vm-oc wasm runtime or deep-mind logging.")
+         ("max-read-only-transaction-time", bpo::value<uint32_t>()->default_value(150),
+          "Limits the maximum time (in milliseconds) a read-only transaction is allowed to execute on a read-only thread")
+         ("read-only-window-time-us", bpo::value<uint32_t>()->default_value(60000),
+          "Time in microseconds the main thread hands to read-only threads each time queued read-only transactions are executed")
          ("incoming-defer-ratio", bpo::value<double>()->default_value(1.0),
           "ratio between incoming transactions and deferred transactions when both are queued for execution")
          ("incoming-transaction-queue-size-mb", bpo::value<uint16_t>()->default_value( 1024 ),
@@ -731,6 +795,10 @@ void producer_plugin::set_program_options(
           "Number of worker threads in producer thread pool")
          ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
           "the location of the snapshots directory (absolute path or relative to application data dir)")
+         ("event-trace-buffer-size", bpo::value<uint32_t>()->default_value(0),
+          "Number of most recent events kept per thread by the block production event tracer, retrieved with /v1/producer/get_event_trace. 0 disables tracing.")
+         ("intrinsic-usage-window-sec", bpo::value<uint32_t>()->default_value(0),
+          "Account the calls each action makes to each host function and the time spent in them, reported in the action traces and aggregated per account over this many seconds for /v1/producer/get_intrinsic_usage. 0 disables accounting.")
          ;
    config_file_options.add(producer_options);
 }
@@ -898,6 +966,21 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
                "producer-threads ${num} must be greater than 0", ("num", thread_pool_size));
    my->_thread_pool.emplace( "prod", thread_pool_size );
 
+   my->_ro_thread_pool_size = options.at( "read-only-threads" ).as<uint16_t>();
+   my->_ro_max_trx_time_us = fc::milliseconds( options.at( "max-read-only-transaction-time" ).as<uint32_t>() );
+   my->_ro_window_time_us = fc::microseconds( options.at( "read-only-window-time-us" ).as<uint32_t>() );
+   if( my->_ro_thread_pool_size > 0 ) {
+      EOS_ASSERT( !options.count( "wasm-runtime" ) || options.at( "wasm-runtime" ).as<wasm_interface::vm_type>() != wasm_interface::vm_type::eos_vm_oc,
+                  plugin_config_exception, "read-only-threads not supported with the eos-vm-oc wasm runtime" );
+      EOS_ASSERT( chain.get_deep_mind_logger() == nullptr, plugin_config_exception,
+                  "read-only-threads not supported with deep-mind logging" );
+      EOS_ASSERT( my->_ro_max_trx_time_us.count() > 0, plugin_config_exception,
+                  "max-read-only-transaction-time must be greater than 0" );
+      EOS_ASSERT( my->_ro_window_time_us.count() > 0, plugin_config_exception,
+                  "read-only-window-time-us must be greater than 0" );
+      my->_ro_thread_pool.emplace( "rdonly", my->_ro_thread_pool_size );
+   }
+
    if( options.count( "snapshots-dir" )) {
       auto sd = options.at( "snapshots-dir" ).as<bfs::path>();
       if( sd.is_relative()) {
@@ -955,6 +1038,12 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
       chain.set_greylist_limit( greylist_limit );
    }
 
+   if( auto trace_buffer_size = options.at( "event-trace-buffer-size" ).as<uint32_t>(); trace_buffer_size > 0 ) {
+      event_tracer::instance().set_buffer_size( trace_buffer_size );
+   }
+
+   intrinsic_usage_tracker::instance().set_window( options.at( "intrinsic-usage-window-sec" ).as<uint32_t>() );
+
    if( options.count("disable-subjective-account-billing") ) {
       std::vector<std::string> accounts = options["disable-subjective-account-billing"].as<std::vector<std::string>>();
       for( const auto& a : accounts ) {
@@ -1032,6 +1121,13 @@ void producer_plugin::plugin_shutdown() {
    if( my->_thread_pool ) {
       my->_thread_pool->stop();
    }
+   if( my->_ro_thread_pool ) {
+      my->_ro_thread_pool->stop();
+   }
+   {
+      std::lock_guard g( my->_ro_trx_queue_mtx );
+      my->_ro_trx_queue.clear();
+   }
 
    my->_unapplied_transactions.clear();
 
@@ -1111,6 +1207,14 @@ void producer_plugin::update_runtime_options(const runtime_options& options) {
    if (options.greylist_limit) {
       chain.set_greylist_limit(*options.greylist_limit);
    }
+
+   if (options.event_trace_buffer_size) {
+      event_tracer::instance().set_buffer_size(*options.event_trace_buffer_size);
+   }
+
+   if (options.intrinsic_usage_window_sec) {
+      intrinsic_usage_tracker::instance().set_window(*options.intrinsic_usage_window_sec);
+   }
 }
 
 producer_plugin::runtime_options producer_plugin::get_runtime_options() const {
@@ -1124,7 +1228,9 @@ producer_plugin::runtime_options producer_plugin::get_runtime_options() const {
             my->chain_plug->chain().get_subjective_cpu_leeway()->count() :
             std::optional<int32_t>(),
       my->_incoming_defer_ratio,
-      my->chain_plug->chain().get_greylist_limit()
+      my->chain_plug->chain().get_greylist_limit(),
+      static_cast<uint32_t>(event_tracer::instance().buffer_size()),
+      intrinsic_usage_tracker::instance().window()
    };
 }
 
@@ -1395,6 +1501,20 @@ producer_plugin::get_account_ram_corrections( const get_account_ram_corrections_
    return result;
 }
 
+fc::variant producer_plugin::get_event_trace( const get_event_trace_params& params ) const {
+   auto& tracer = event_tracer::instance();
+   EOS_ASSERT( tracer.enabled(), chain::invalid_http_request,
+               "event tracing is disabled, set event-trace-buffer-size or event_trace_buffer_size in update_runtime_options" );
+   return tracer.get_trace( params.clear );
+}
+
+producer_plugin::get_intrinsic_usage_result producer_plugin::get_intrinsic_usage( const get_intrinsic_usage_params& params ) const {
+   auto& tracker = intrinsic_usage_tracker::instance();
+   EOS_ASSERT( tracker.enabled(), chain::invalid_http_request,
+               "intrinsic usage accounting is disabled, set intrinsic-usage-window-sec or intrinsic_usage_window_sec in update_runtime_options" );
+   return { tracker.window(), tracker.get_usage( params.account, params.limit ) };
+}
+
 std::optional<fc::time_point> producer_plugin_impl::calculate_next_block_time(const account_name& producer_name, const block_timestamp_type& current_block_time) const {
    chain::controller& chain = chain_plug->chain();
    const auto& hbs = chain.head_block_state();
@@ -1474,7 +1594,9 @@ fc::time_point producer_plugin_impl::calculate_block_deadline( const fc::time_po
 }
 
 producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
+   scoped_trace_event trace_event( "producer", "start_block" );
    chain::controller& chain = chain_plug->chain();
+   trace_event.set_arg( "block_num", chain.head_block_num() + 1 );
 
    if( !chain_plug->accept_transactions() )
       return start_block_result::waiting_for_block;
@@ -1871,11 +1993,13 @@ producer_plugin_impl::push_transaction( const fc::time_point& block_deadline,
                                         bool return_failure_trace,
                                         next_function<transaction_trace_ptr> next )
 {
+   scoped_trace_event trace_event( "producer", "push_transaction" );
    auto start = fc::time_point::now();
    fc_dlog( _trx_successful_trace_log, "Time since last trx: ${t}us", ("t", start - _idle_trx_time) );
 
    auto first_auth = trx->packed_trx()->get_transaction().first_authorizer();
    if( _pending_block_mode == pending_block_mode::producing && _account_fails.failure_limit( first_auth ) ) {
+      _metrics.failure_limit_drops.inc();
       if( next ) {
          auto except_ptr = std::static_pointer_cast<fc::exception>( std::make_shared<tx_cpu_usage_exceeded>(
                FC_LOG_MESSAGE( error, "transaction ${id} exceeded failure limit for account ${a}",
@@ -1923,6 +2047,8 @@ producer_plugin_impl::push_transaction( const fc::time_point& block_deadline,
          pr.trx_exhausted = true;
       } else {
          pr.failed = true;
+         if( sub_bill > 0 && trace->except->code() == tx_cpu_usage_exceeded::code_value )
+            _metrics.cpu_exceeded_drops.inc();
          fc_dlog( _trx_failed_trace_log, "Subjective bill for failed ${a}: ${b} elapsed ${t}us, time ${r}us",
                   ("a",first_auth)("b",sub_bill)("t",trace->elapsed)("r", fc::time_point::now() - start));
          if (!disable_subjective_billing)
@@ -1970,8 +2096,107 @@ producer_plugin_impl::push_transaction( const fc::time_point& block_deadline,
    return pr;
 }
 
+void producer_plugin_impl::queue_read_only_trx( transaction_metadata_ptr trx, bool return_failure_trace, next_function<transaction_trace_ptr> next ) {
+   std::lock_guard g( _ro_trx_queue_mtx );
+   _ro_trx_queue.push_back( read_only_trx{ std::move(trx), return_failure_trace, std::move(next) } );
+   if( _ro_window_scheduled )
+      return;
+   _ro_window_scheduled = true;
+   app().post( priority::low, [self = this]() {
+      self->execute_read_only_window();
+   } );
+}
+
+// Runs on the main thread, which blocks until the read-only threads are done so that chain state does not change
+// underneath them. Read-only trxs that turn out to modify state are re-executed afterwards on the main thread.
+void producer_plugin_impl::execute_read_only_window() {
+   chain::controller& chain = chain_plug->chain();
+
+   std::deque<read_only_trx> retry_on_main;
+   if( chain.is_building_block() ) {
+      const auto window_end = fc::time_point::now() + _ro_window_time_us;
+      std::mutex retry_mtx;
+      std::vector<std::future<void>> workers;
+      workers.reserve( _ro_thread_pool_size );
+      for( uint16_t i = 0; i < _ro_thread_pool_size; ++i ) {
+         workers.emplace_back( async_thread_pool( _ro_thread_pool->get_executor(), [this, window_end, &retry_on_main, &retry_mtx]() {
+            run_read_only_trxs( window_end, retry_on_main, retry_mtx );
+         } ) );
+      }
+      for( auto& w : workers ) {
+         w.wait();
+      }
+   } else {
+      // nothing to execute against, let the main thread queue them as it does for other incoming trxs
+      std::lock_guard g( _ro_trx_queue_mtx );
+      retry_on_main.swap( _ro_trx_queue );
+   }
+
+   bool exhausted = false;
+   for( auto& ro : retry_on_main ) {
+      if( !process_incoming_transaction_async( ro.trx, false, ro.return_failure_trace, ro.next ) )
+         exhausted = true;
+   }
+   if( exhausted ) {
+      if( _pending_block_mode == pending_block_mode::producing ) {
+         schedule_maybe_produce_block( true );
+      } else {
+         restart_speculative_block();
+      }
+   }
+
+   std::lock_guard g( _ro_trx_queue_mtx );
+   if( _ro_trx_queue.empty() ) {
+      _ro_window_scheduled = false;
+   } else {
+      app().post( priority::low, [self = this]() {
+         self->execute_read_only_window();
+      } );
+   }
+}
+
+// Runs on a read-only thread until the queue is drained or the window ends
+void producer_plugin_impl::run_read_only_trxs( const fc::time_point& window_end, std::deque<read_only_trx>& retry_on_main, std::mutex& retry_mtx ) {
+   chain::controller& chain = chain_plug->chain();
+   try {
+      chain.init_read_only_thread();
+   } catch( const fc::exception& e ) {
+      elog( "Unable to execute read-only transactions on a read-only thread: ${e}", ("e", e.to_detail_string()) );
+      return;
+   }
+
+   while( fc::time_point::now() < window_end ) {
+      read_only_trx ro;
+      {
+         std::lock_guard g( _ro_trx_queue_mtx );
+         if( _ro_trx_queue.empty() )
+            return;
+         ro = std::move( _ro_trx_queue.front() );
+         _ro_trx_queue.pop_front();
+      }
+
+      const auto start = fc::time_point::now();
+      try {
+         auto trace = chain.push_transaction( ro.trx, fc::time_point::maximum(), _ro_max_trx_time_us, 0, false, 0 );
+         if( trace->except && trace->except->code() == read_only_thread_write_exception::code_value ) {
+            std::lock_guard g( retry_mtx );
+            retry_on_main.push_back( std::move(ro) );
+            continue;
+         }
+         log_trx_results( ro.trx, trace, start );
+         if( trace->except && !ro.return_failure_trace ) {
+            ro.next( trace->except->dynamic_copy_exception() );
+         } else {
+            ro.next( trace );
+         }
+      } CATCH_AND_CALL(ro.next);
+   }
+}
+
 bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadline )
 {
+   scoped_trace_event trace_event( "producer", "process_unapplied_trxs" );
+   trace_event.set_arg( "unapplied", _unapplied_transactions.size() );
    bool exhausted = false;
    if( !_unapplied_transactions.empty() ) {
       if( _pending_block_mode != pending_block_mode::producing && _disable_persist_until_expired ) return !exhausted;
@@ -2157,6 +2382,7 @@ void producer_plugin_impl::process_scheduled_and_incoming_trxs( const fc::time_p
 
 bool producer_plugin_impl::process_incoming_trxs( const fc::time_point& deadline, unapplied_transaction_queue::iterator& itr )
 {
+   scoped_trace_event trace_event( "producer", "process_incoming_trxs" );
    bool exhausted = false;
    auto end = _unapplied_transactions.incoming_end();
    if( itr != end ) {
@@ -2210,9 +2436,11 @@ bool producer_plugin_impl::block_is_exhausted() const {
 // -> Idle
 // --> Start block B (block time y.000) at time x.500
 void producer_plugin_impl::schedule_production_loop() {
+   scoped_trace_event trace_event( "producer", "schedule_production_loop" );
    _timer.cancel();
 
    auto result = start_block();
+   _metrics.unapplied_transactions.set( _unapplied_transactions.size() );
 
    if (result == start_block_result::failed) {
       elog("Failed to start a pending block, will try again later");
@@ -2356,6 +2584,7 @@ static auto maybe_make_debug_time_logger() -> std::optional<decltype(make_debug_
 }
 
 void producer_plugin_impl::produce_block() {
+   scoped_trace_event trace_event( "producer", "produce_block" );
    //ilog("produce_block ${t}", ("t", fc::time_point::now())); // for testing _produce_time_offset_us
    EOS_ASSERT(_pending_block_mode == pending_block_mode::producing, producer_exception, "called produce_block while not actually producing");
    chain::controller& chain = chain_plug->chain();
@@ -2405,6 +2634,10 @@ void producer_plugin_impl::produce_block() {
       br.total_cpu_usage_us += r.cpu_usage_us;
       br.total_net_usage += r.net_usage_words * 8;
    }
+   const auto& gpo_config = chain.get_global_properties().configuration;
+   _metrics.blocks_produced.inc();
+   _metrics.block_cpu_fill_ratio.set( gpo_config.max_block_cpu_usage ? double(br.total_cpu_usage_us) / gpo_config.max_block_cpu_usage : 0 );
+   _metrics.block_net_fill_ratio.set( gpo_config.max_block_net_usage ? double(br.total_net_usage) / gpo_config.max_block_net_usage : 0 );
    ilog("Produced block ${id}... #${n} @ ${t} signed by ${p} "
         "[trxs: ${count}, lib: ${lib}, confirmed: ${confs}, net: ${net}, cpu: ${cpu}]",
         ("p",new_bs->header.producer)("id",new_bs->id.str().substr(8,16))
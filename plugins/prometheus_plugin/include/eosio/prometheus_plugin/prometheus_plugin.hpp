@@ -0,0 +1,34 @@
+#pragma once
+
+#include <eosio/http_plugin/http_plugin.hpp>
+
+#include <appbase/application.hpp>
+
+namespace eosio {
+
+using namespace appbase;
+
+/**
+ *  Exposes the metrics of chain::metrics::registry, which the chain, net, producer and http plugins update as they
+ *  run, at the /metrics endpoint in the Prometheus text exposition format.
+ *
+ *  Scrapes are rendered on the http thread pool and never wait on the main application thread.
+ */
+class prometheus_plugin : public plugin<prometheus_plugin> {
+public:
+   APPBASE_PLUGIN_REQUIRES((http_plugin))
+
+   prometheus_plugin() = default;
+   prometheus_plugin(const prometheus_plugin&) = delete;
+   prometheus_plugin(prometheus_plugin&&) = delete;
+   prometheus_plugin& operator=(const prometheus_plugin&) = delete;
+   prometheus_plugin& operator=(prometheus_plugin&&) = delete;
+   virtual ~prometheus_plugin() override = default;
+
+   virtual void set_program_options(options_description& cli, options_description& cfg) override {}
+   void plugin_initialize(const variables_map& vm) {}
+   void plugin_startup();
+   void plugin_shutdown() {}
+};
+
+}
@@ -0,0 +1,22 @@
+#include <eosio/prometheus_plugin/prometheus_plugin.hpp>
+#include <eosio/chain/metrics.hpp>
+
+#include <fc/variant.hpp>
+
+namespace eosio {
+
+static appbase::abstract_plugin& _prometheus_plugin = app().register_plugin<prometheus_plugin>();
+
+void prometheus_plugin::plugin_startup() {
+   app().get_plugin<http_plugin>().add_async_handler( "/metrics",
+      []( string, string body, url_response_callback cb ) {
+         try {
+            body = parse_params<std::string, http_params_types::no_params>( body );
+            cb( 200, fc::time_point::maximum(), fc::variant( chain::metrics::registry::instance().render() ) );
+         } catch( ... ) {
+            http_plugin::handle_exception( "prometheus", "metrics", body, cb );
+         }
+      }, http_content_type::plaintext );
+}
+
+}
@@ -15,6 +15,7 @@
 #include <boost/filesystem/path.hpp>
 
 #include <chrono>
+#include <thread>
 
 #ifndef _WIN32
 #define FOPEN(p, m) fopen(p, m)
@@ -38,6 +39,7 @@ struct blocklog {
    void set_program_options(options_description& cli);
    void initialize(const variables_map& options);
    void do_vacuum();
+   void validate_blocks();
 
    bfs::path                        blocks_dir;
    bfs::path                        output_file;
@@ -49,7 +51,15 @@ struct blocklog {
    bool                             trim_log = false;
    bool                             extract_blocks = false;
    bool                             smoke_test = false;
+   bool                             validate = false;
    bool                             vacuum = false;
+   bool                             compress = false;
+   bool                             decompress = false;
+   uint32_t                         dictionary_size = 0;
+   bool                             split_blocks = false;
+   bool                             merge_blocks = false;
+   uint32_t                         stride = 0;
+   uint32_t                         num_threads = 0;
    bool                             help = false;
 
    std::optional<block_log_prune_config> blog_keep_prune_conf;
@@ -76,6 +86,65 @@ void blocklog::do_vacuum() {
    ilog("Successfully vacuumed block log");
 }
 
+void blocklog::validate_blocks() {
+   report_time rt("validating blocks");
+   block_log block_logger(blocks_dir, blog_keep_prune_conf);
+   EOS_ASSERT( block_logger.head(), block_log_exception, "No blocks found in block log" );
+   const uint32_t first_num = block_logger.first_block_num();
+   const uint32_t head_num = block_logger.head()->block_num();
+   if (num_threads == 0)
+      num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+   // each thread checks a range of blocks, starting from the id of the block before the range
+   const uint32_t num_blocks = head_num - first_num + 1;
+   const uint32_t num_ranges = std::min(num_blocks, num_threads);
+   std::vector<uint32_t> range_first(num_ranges + 1);
+   std::vector<block_id_type> previous_ids(num_ranges);
+   for (uint32_t i = 0; i < num_ranges; ++i) {
+      range_first[i] = first_num + uint64_t(num_blocks) * i / num_ranges;
+      if (i > 0)
+         previous_ids[i] = block_logger.read_block_id_by_num(range_first[i] - 1);
+   }
+   range_first[num_ranges] = head_num + 1;
+
+   std::vector<std::exception_ptr> excepts(num_ranges);
+   std::vector<std::thread> threads;
+   for (uint32_t i = 0; i < num_ranges; ++i) {
+      threads.emplace_back([&, i]() {
+         try {
+            uint32_t expected = range_first[i];
+            block_id_type previous_id = previous_ids[i];
+            block_logger.read_serialized_blocks(range_first[i], range_first[i + 1] - 1, [&](uint32_t block_num, std::vector<char>&& packed_block) {
+               fc::datastream<const char*> ds(packed_block.data(), packed_block.size());
+               signed_block block;
+               fc::raw::unpack(ds, block);
+               EOS_ASSERT( block.block_num() == block_num && ds.remaining() == 0, block_log_exception,
+                           "blocks.index indicates block ${n} where block ${b} of ${s} bytes is",
+                           ("n", block_num)("b", block.block_num())("s", packed_block.size() - ds.remaining()) );
+               EOS_ASSERT( block_num == first_num || block.previous == previous_id, block_log_exception,
+                           "block ${n} refers to ${p} as its previous block rather than to ${id}",
+                           ("n", block_num)("p", block.previous)("id", previous_id) );
+               previous_id = block.calculate_id();
+               ++expected;
+               return true;
+            });
+            EOS_ASSERT( expected == range_first[i + 1], block_log_exception, "block ${n} was not found", ("n", expected) );
+         } catch (...) {
+            excepts[i] = std::current_exception();
+         }
+      });
+   }
+   for (auto& t : threads)
+      t.join();
+   for (const auto& e : excepts) {
+      if (e)
+         std::rethrow_exception(e);
+   }
+   ilog("blocks ${f} through ${l} are where blocks.index says and each follows the block before it",
+        ("f", first_num)("l", head_num));
+   rt.report();
+}
+
 void blocklog::read_log() {
    report_time rt("reading log");
    block_log block_logger(blocks_dir, blog_keep_prune_conf);
@@ -201,8 +270,24 @@ void blocklog::set_program_options(options_description& cli)
           "the output directory for the block log extracted from blocks-dir")
          ("smoke-test", bpo::bool_switch(&smoke_test)->default_value(false),
           "Quick test that blocks.log and blocks.index are well formed and agree with each other.")
+         ("validate-blocks", bpo::bool_switch(&validate)->default_value(false),
+          "Check that every block is where blocks.index says and refers to the id of the block before it as its previous, on 'threads' threads.")
          ("vacuum", bpo::bool_switch(&vacuum)->default_value(false),
           "Vacuum a pruned blocks.log in to an un-pruned blocks.log")
+         ("compress", bpo::bool_switch(&compress)->default_value(false),
+          "Write a compressed copy of blocks.log and blocks.index to output-dir. blocks.log must not be pruned.")
+         ("decompress", bpo::bool_switch(&decompress)->default_value(false),
+          "Write an uncompressed copy of blocks.log and blocks.index to output-dir. blocks.log must not be pruned.")
+         ("compression-dictionary-size", bpo::value<uint32_t>(&dictionary_size)->default_value(32*1024),
+          "Size in bytes of the dictionary sampled from blocks.log to compress every block with when compress is given, 0 for none.")
+         ("split-blocks", bpo::bool_switch(&split_blocks)->default_value(false),
+          "Split blocks.log and blocks.index into files of blocks-log-stride blocks written to output-dir, the blocks after the last multiple of the stride are left in blocks.log. blocks.log must not be pruned.")
+         ("merge-blocks", bpo::bool_switch(&merge_blocks)->default_value(false),
+          "Merge the split block log files in blocks-dir and the blocks.log following them into a single blocks.log and blocks.index written to output-dir.")
+         ("blocks-log-stride", bpo::value<uint32_t>(&stride),
+          "Number of blocks in each file when split-blocks is given.")
+         ("threads", bpo::value<uint32_t>(&num_threads)->default_value(0),
+          "Number of threads make-index and validate-blocks run on, all cores when 0.")
          ("help,h", bpo::bool_switch(&help)->default_value(false), "Print this help message and exit.")
          ;
 }
@@ -273,6 +358,29 @@ bool extract_block_range(bfs::path block_dir, bfs::path output_dir, uint32_t sta
 }
 
 
+void convert_blocklog(bfs::path block_dir, bfs::path output_dir, bool compress, uint32_t dictionary_size) {
+   report_time rt(compress ? "compressing blocklog" : "decompressing blocklog");
+   block_log_compression compression;
+   if (compress) {
+      compression.algorithm = block_log_compression::algorithm_type::zlib;
+      compression.dictionary = block_log::sample_compression_dictionary(block_dir, dictionary_size);
+   }
+   block_log::convert_log(block_dir, output_dir, compression);
+   rt.report();
+}
+
+void split_blocklog(bfs::path block_dir, bfs::path output_dir, uint32_t stride) {
+   report_time rt("splitting blocklog");
+   block_log::split_log(block_dir, output_dir, stride);
+   rt.report();
+}
+
+void merge_blocklog(bfs::path block_dir, bfs::path output_dir) {
+   report_time rt("merging blocklog");
+   block_log::merge_logs(block_dir, output_dir);
+   rt.report();
+}
+
 void smoke_test(bfs::path block_dir) {
    using namespace std;
    cout << "\nSmoke test of blocks.log and blocks.index in directory " << block_dir << '\n';
@@ -320,6 +428,11 @@ int main(int argc, char** argv) {
          smoke_test(vmap.at("blocks-dir").as<bfs::path>());
          return 0;
       }
+      if (blog.validate) {
+         blog.initialize(vmap);
+         blog.validate_blocks();
+         return 0;
+      }
       if (blog.trim_log) {
          if (blog.first_block == 0 && blog.last_block == std::numeric_limits<uint32_t>::max()) {
             std::cerr << "trim-blocklog does nothing unless first and/or last block are specified.";
@@ -344,6 +457,30 @@ int main(int argc, char** argv) {
             return -1;
          return 0;
       }
+      if (blog.compress || blog.decompress) {
+         if (blog.compress == blog.decompress || !vmap.count("output-dir")) {
+            std::cerr << "either compress or decompress must be given, with output-dir.";
+            return -1;
+         }
+         convert_blocklog(vmap.at("blocks-dir").as<bfs::path>(), vmap.at("output-dir").as<bfs::path>(), blog.compress, blog.dictionary_size);
+         return 0;
+      }
+      if (blog.split_blocks) {
+         if (blog.stride == 0 || !vmap.count("output-dir")) {
+            std::cerr << "split-blocks needs blocks-log-stride greater than 0 and output-dir.";
+            return -1;
+         }
+         split_blocklog(vmap.at("blocks-dir").as<bfs::path>(), vmap.at("output-dir").as<bfs::path>(), blog.stride);
+         return 0;
+      }
+      if (blog.merge_blocks) {
+         if (!vmap.count("output-dir")) {
+            std::cerr << "merge-blocks needs output-dir.";
+            return -1;
+         }
+         merge_blocklog(vmap.at("blocks-dir").as<bfs::path>(), vmap.at("output-dir").as<bfs::path>());
+         return 0;
+      }
       if (blog.vacuum) {
          blog.initialize(vmap);
          blog.do_vacuum();
@@ -360,7 +497,7 @@ int main(int argc, char** argv) {
          report_time rt("making index");
          const auto log_level = fc::logger::get(DEFAULT_LOGGER).get_log_level();
          fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::debug);
-         block_log::construct_index(block_file.generic_string(), out_file.generic_string());
+         block_log::construct_index(block_file.generic_string(), out_file.generic_string(), blog.num_threads);
          fc::logger::get(DEFAULT_LOGGER).set_log_level(log_level);
          rt.report();
          return 0;
@@ -0,0 +1,418 @@
+#include <eosio/chain/block_log.hpp>
+#include <eosio/chain/config.hpp>
+#include <eosio/chain/controller.hpp>
+#include <eosio/chain/genesis_state.hpp>
+#include <eosio/chain/protocol_feature_manager.hpp>
+#include <eosio/chain/snapshot.hpp>
+#include <eosio/chain/state_access_tracer.hpp>
+#include <eosio/chain/trace.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/variant_object.hpp>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <queue>
+
+using namespace eosio::chain;
+namespace bfs = boost::filesystem;
+namespace bpo = boost::program_options;
+using bpo::options_description;
+using bpo::variables_map;
+
+/**
+ *  Replays a block log on a scratch chain with a state_access_tracer installed and, for every block, builds the
+ *  dependency graph of its transactions from their read/write sets. Reports how many transactions could run
+ *  concurrently, the critical path and the makespan of a simple list schedule on N threads, along with the state
+ *  keys responsible for most of the dependencies.
+ *
+ *  The result is an upper bound: accesses are tracked per table rather than per row, and the sequence counters and
+ *  block resource totals every transaction touches are assumed to be assigned in block order at commit time.
+ */
+struct parallelism_analyzer {
+   void set_program_options(options_description& cli);
+   void initialize(const variables_map& options);
+   void run();
+
+   bfs::path                 blocks_dir;
+   bfs::path                 snapshot;
+   bfs::path                 data_dir;
+   bfs::path                 output_file;
+   uint32_t                  first_block = 0;
+   uint32_t                  last_block = std::numeric_limits<uint32_t>::max();
+   std::vector<uint32_t>     thread_counts;
+   uint64_t                  state_size_mb = config::default_state_size / (1024 * 1024);
+   uint32_t                  top_keys = 20;
+   bool                      help = false;
+
+private:
+   struct trx_record {
+      uint64_t                           cpu_us = 0;
+      state_access_tracer::access_set    accesses;
+   };
+
+   struct block_result {
+      uint32_t                           trxs = 0;
+      uint32_t                           dependencies = 0;
+      uint32_t                           width = 0;
+      uint32_t                           critical_path_trxs = 0;
+      uint64_t                           total_cpu_us = 0;
+      uint64_t                           critical_path_cpu_us = 0;
+      std::vector<uint64_t>              makespan_us; // one per entry of thread_counts
+   };
+
+   block_result analyze_block( const std::vector<trx_record>& trxs );
+   static uint64_t simulate( const std::vector<trx_record>& trxs, const std::vector<std::vector<size_t>>& deps, uint32_t threads );
+
+   std::map<state_access_tracer::state_key, uint64_t> conflicts; // number of dependencies introduced by each key
+};
+
+namespace {
+
+protocol_feature_set make_builtin_protocol_feature_set() {
+   protocol_feature_set pfs;
+   map< builtin_protocol_feature_t, std::optional<digest_type> > visited_builtins;
+
+   std::function<digest_type(builtin_protocol_feature_t)> add_builtins =
+   [&pfs, &visited_builtins, &add_builtins]( builtin_protocol_feature_t codename ) -> digest_type {
+      auto res = visited_builtins.emplace( codename, std::optional<digest_type>() );
+      if( !res.second ) {
+         EOS_ASSERT( res.first->second, protocol_feature_exception,
+                     "invariant failure: cycle found in builtin protocol feature dependencies" );
+         return *res.first->second;
+      }
+
+      auto f = protocol_feature_set::make_default_builtin_protocol_feature( codename,
+      [&add_builtins]( builtin_protocol_feature_t d ) {
+         return add_builtins( d );
+      } );
+
+      const auto& pf = pfs.add_feature( f );
+      res.first->second = pf.feature_digest;
+      return pf.feature_digest;
+   };
+
+   for( const auto& p : builtin_protocol_feature_codenames ) {
+      add_builtins( p.first );
+   }
+   return pfs;
+}
+
+} // anonymous namespace
+
+uint64_t parallelism_analyzer::simulate( const std::vector<trx_record>& trxs, const std::vector<std::vector<size_t>>& deps, uint32_t threads ) {
+   // transactions are dispatched in block order to whichever thread frees up first, waiting for their dependencies
+   std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> thread_free;
+   for( uint32_t i = 0; i < threads; ++i )
+      thread_free.push( 0 );
+
+   std::vector<uint64_t> finish( trxs.size() );
+   uint64_t makespan = 0;
+   for( size_t i = 0; i < trxs.size(); ++i ) {
+      uint64_t ready = 0;
+      for( auto d : deps[i] )
+         ready = std::max( ready, finish[d] );
+      const uint64_t start = std::max( ready, thread_free.top() );
+      thread_free.pop();
+      finish[i] = start + trxs[i].cpu_us;
+      thread_free.push( finish[i] );
+      makespan = std::max( makespan, finish[i] );
+   }
+   return makespan;
+}
+
+parallelism_analyzer::block_result parallelism_analyzer::analyze_block( const std::vector<trx_record>& trxs ) {
+   struct key_state {
+      std::optional<size_t> last_writer;
+      std::vector<size_t>   readers_since_write;
+   };
+   std::map<state_access_tracer::state_key, key_state> keys;
+   std::vector<std::vector<size_t>> deps( trxs.size() );
+
+   auto add_dep = [&]( size_t trx, size_t dep, const state_access_tracer::state_key& k ) {
+      auto& d = deps[trx];
+      if( std::find( d.begin(), d.end(), dep ) != d.end() ) return;
+      d.push_back( dep );
+      ++conflicts[k];
+   };
+
+   for( size_t i = 0; i < trxs.size(); ++i ) {
+      const auto& accesses = trxs[i].accesses;
+      for( const auto& k : accesses.reads ) {
+         auto itr = keys.find( k );
+         if( itr != keys.end() && itr->second.last_writer )
+            add_dep( i, *itr->second.last_writer, k );
+      }
+      for( const auto& k : accesses.writes ) {
+         auto itr = keys.find( k );
+         if( itr == keys.end() ) continue;
+         if( itr->second.last_writer )
+            add_dep( i, *itr->second.last_writer, k );
+         for( auto r : itr->second.readers_since_write )
+            add_dep( i, r, k );
+      }
+      for( const auto& k : accesses.reads )
+         keys[k].readers_since_write.push_back( i );
+      for( const auto& k : accesses.writes ) {
+         auto& ks = keys[k];
+         ks.last_writer = i;
+         ks.readers_since_write.clear();
+      }
+   }
+
+   block_result result;
+   result.trxs = trxs.size();
+   std::vector<uint32_t> level( trxs.size() );
+   std::vector<uint64_t> path_cpu( trxs.size() );
+   std::map<uint32_t, uint32_t> level_width;
+   for( size_t i = 0; i < trxs.size(); ++i ) {
+      uint32_t lvl = 1;
+      uint64_t cpu = 0;
+      for( auto d : deps[i] ) {
+         lvl = std::max( lvl, level[d] + 1 );
+         cpu = std::max( cpu, path_cpu[d] );
+      }
+      level[i] = lvl;
+      path_cpu[i] = cpu + trxs[i].cpu_us;
+      result.dependencies += deps[i].size();
+      result.total_cpu_us += trxs[i].cpu_us;
+      result.critical_path_trxs = std::max( result.critical_path_trxs, lvl );
+      result.critical_path_cpu_us = std::max( result.critical_path_cpu_us, path_cpu[i] );
+      result.width = std::max( result.width, ++level_width[lvl] );
+   }
+
+   for( auto n : thread_counts )
+      result.makespan_us.push_back( simulate( trxs, deps, n ) );
+   return result;
+}
+
+void parallelism_analyzer::run() {
+   block_log source_log( blocks_dir, std::optional<block_log_prune_config>() );
+   const auto end = source_log.read_head();
+   EOS_ASSERT( end, block_log_exception, "No blocks found in block log" );
+
+   bool remove_data_dir = false;
+   if( data_dir.empty() ) {
+      data_dir = bfs::temp_directory_path() / bfs::unique_path( "eosio-parallelism-analyzer-%%%%-%%%%" );
+      remove_data_dir = true;
+   }
+   EOS_ASSERT( !bfs::exists( data_dir / config::default_state_dir_name ) && !bfs::exists( data_dir / config::default_blocks_dir_name ),
+               misc_exception, "data-dir ${d} must not contain a previous chain state", ("d", data_dir.generic_string()) );
+
+   controller::config cfg;
+   cfg.blocks_dir = data_dir / config::default_blocks_dir_name;
+   cfg.state_dir  = data_dir / config::default_state_dir_name;
+   cfg.state_size = state_size_mb * 1024 * 1024;
+   cfg.disable_replay_opts = true;
+
+   std::unique_ptr<controller> chain;
+   std::ifstream snapshot_file;
+   snapshot_reader_ptr snapshot_reader;
+   std::optional<genesis_state> genesis;
+   chain_id_type chain_id = chain_id_type::empty_chain_id();
+   if( !snapshot.empty() ) {
+      snapshot_file.open( snapshot.generic_string(), std::ios::in | std::ios::binary );
+      EOS_ASSERT( snapshot_file.good(), snapshot_exception, "Unable to open snapshot ${s}", ("s", snapshot.generic_string()) );
+      snapshot_reader = std::make_shared<istream_snapshot_reader>( snapshot_file );
+      snapshot_reader->validate();
+      chain_id = controller::extract_chain_id( *snapshot_reader );
+   } else {
+      genesis = block_log::extract_genesis_state( blocks_dir );
+      EOS_ASSERT( genesis, block_log_exception,
+                  "Block log does not start with a genesis state, a snapshot of the block preceding the log is required" );
+      chain_id = genesis->compute_chain_id();
+   }
+
+   chain = std::make_unique<controller>( cfg, make_builtin_protocol_feature_set(), chain_id );
+   chain->add_indices();
+   auto shutdown = []() { FC_THROW( "shutdown requested while analyzing the block log" ); };
+   auto check_shutdown = []() { return false; };
+   if( snapshot_reader )
+      chain->startup( shutdown, check_shutdown, snapshot_reader );
+   else
+      chain->startup( shutdown, check_shutdown, *genesis );
+
+   state_access_tracer tracer;
+   std::vector<trx_record> block_trxs;
+   chain->block_start.connect( [&]( uint32_t ) {
+      tracer.reset();
+      block_trxs.clear();
+   } );
+   chain->applied_transaction.connect( [&]( std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t ) {
+      const auto& trace = std::get<0>( t );
+      if( !trace->receipt ) return;
+      trx_record r;
+      r.cpu_us = std::max<uint64_t>( trace->receipt->cpu_usage_us, 1 );
+      r.accesses = tracer.take_accesses();
+      block_trxs.emplace_back( std::move( r ) );
+   } );
+
+   std::ofstream output;
+   std::ostream* out = &std::cout;
+   if( !output_file.empty() ) {
+      output.open( output_file.generic_string() );
+      EOS_ASSERT( !output.fail(), misc_exception, "Unable to open file '${f}'", ("f", output_file.generic_string()) );
+      out = &output;
+   }
+
+   const auto start_time = std::chrono::steady_clock::now();
+   const uint32_t start_block = chain->head_block_num() + 1;
+   EOS_ASSERT( start_block >= source_log.first_block_num(), block_log_exception,
+               "Block log starts at block ${f} but chain state is at block ${h}",
+               ("f", source_log.first_block_num())("h", start_block - 1) );
+   ilog( "replaying blocks ${s} through ${e}, analyzing from block ${a}",
+         ("s", start_block)("e", std::min( last_block, end->block_num() ))("a", std::max( first_block, start_block )) );
+
+   uint64_t blocks_analyzed = 0, total_trxs = 0, total_cpu_us = 0, critical_path_cpu_us = 0;
+   std::vector<uint64_t> total_makespan_us( thread_counts.size() );
+   signed_block_ptr next;
+   for( uint32_t block_num = start_block;
+        block_num <= last_block && (next = source_log.read_block_by_num( block_num )); ++block_num ) {
+      const bool analyze = block_num >= first_block;
+      chain->set_state_access_tracer( analyze ? &tracer : nullptr );
+
+      auto bsf = chain->create_block_state_future( next->calculate_id(), next );
+      controller::block_report br;
+      chain->push_block( br, bsf, forked_branch_callback{}, trx_meta_cache_lookup{} );
+      if( !analyze ) continue;
+
+      const auto result = analyze_block( block_trxs );
+      ++blocks_analyzed;
+      total_trxs += result.trxs;
+      total_cpu_us += result.total_cpu_us;
+      critical_path_cpu_us += result.critical_path_cpu_us;
+
+      fc::mutable_variant_object speedup;
+      for( size_t i = 0; i < thread_counts.size(); ++i ) {
+         total_makespan_us[i] += result.makespan_us[i];
+         speedup( std::to_string( thread_counts[i] ),
+                  result.makespan_us[i] ? double( result.total_cpu_us ) / result.makespan_us[i] : 1.0 );
+      }
+      *out << fc::json::to_string( fc::mutable_variant_object()
+                                      ("block_num", block_num)
+                                      ("trxs", result.trxs)
+                                      ("dependencies", result.dependencies)
+                                      ("width", result.width)
+                                      ("critical_path_trxs", result.critical_path_trxs)
+                                      ("total_cpu_us", result.total_cpu_us)
+                                      ("critical_path_cpu_us", result.critical_path_cpu_us)
+                                      ("speedup", std::move( speedup )),
+                                   fc::time_point::maximum() ) << "\n";
+
+      if( blocks_analyzed % 10000 == 0 )
+         ilog( "analyzed ${n} blocks, at block ${b}", ("n", blocks_analyzed)("b", block_num) );
+   }
+   chain->set_state_access_tracer( nullptr );
+
+   std::vector<std::pair<state_access_tracer::state_key, uint64_t>> sorted_conflicts( conflicts.begin(), conflicts.end() );
+   std::sort( sorted_conflicts.begin(), sorted_conflicts.end(), []( const auto& a, const auto& b ) { return a.second > b.second; } );
+   if( sorted_conflicts.size() > top_keys )
+      sorted_conflicts.resize( top_keys );
+   fc::variants top;
+   for( const auto& c : sorted_conflicts ) {
+      top.emplace_back( fc::mutable_variant_object()( "key", c.first )( "dependencies", c.second ) );
+   }
+   fc::mutable_variant_object speedup;
+   for( size_t i = 0; i < thread_counts.size(); ++i ) {
+      speedup( std::to_string( thread_counts[i] ),
+               total_makespan_us[i] ? double( total_cpu_us ) / total_makespan_us[i] : 1.0 );
+   }
+   *out << fc::json::to_string( fc::mutable_variant_object()( "summary", fc::mutable_variant_object()
+                                   ("blocks", blocks_analyzed)
+                                   ("trxs", total_trxs)
+                                   ("total_cpu_us", total_cpu_us)
+                                   ("critical_path_cpu_us", critical_path_cpu_us)
+                                   ("speedup", std::move( speedup ))
+                                   ("top_conflicts", std::move( top )) ),
+                                fc::time_point::maximum() ) << "\n";
+
+   const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - start_time ).count();
+   ilog( "eosio-parallelism-analyzer - analyzed ${n} blocks in ${t} msec", ("n", blocks_analyzed)("t", duration) );
+
+   chain.reset();
+   if( remove_data_dir )
+      bfs::remove_all( data_dir );
+}
+
+void parallelism_analyzer::set_program_options(options_description& cli)
+{
+   cli.add_options()
+         ("blocks-dir", bpo::value<bfs::path>()->default_value("blocks"),
+          "the location of the blocks directory containing the block log to analyze (absolute path or relative to the current directory)")
+         ("snapshot", bpo::value<bfs::path>(),
+          "snapshot of the chain state preceding the first block of the block log. Required if the block log does not start with a genesis state.")
+         ("data-dir", bpo::value<bfs::path>(),
+          "scratch directory for the chain state the block log is replayed onto. If not specified a temporary directory is used and removed on exit.")
+         ("output-file,o", bpo::value<bfs::path>(),
+          "the file to write the per block JSON results to (absolute or relative path).  If not specified then output is to stdout.")
+         ("first,f", bpo::value<uint32_t>(&first_block)->default_value(0),
+          "the first block number to analyze, earlier blocks are only replayed")
+         ("last,l", bpo::value<uint32_t>(&last_block)->default_value(std::numeric_limits<uint32_t>::max()),
+          "the last block number to analyze")
+         ("threads", bpo::value<std::vector<uint32_t>>()->multitoken()->default_value(std::vector<uint32_t>{2, 4, 8, 16}, "2 4 8 16"),
+          "thread counts to simulate scheduling the transactions of each block on")
+         ("chain-state-db-size-mb", bpo::value<uint64_t>(&state_size_mb)->default_value(state_size_mb),
+          "maximum size (in MiB) of the scratch chain state database")
+         ("top", bpo::value<uint32_t>(&top_keys)->default_value(top_keys),
+          "number of state keys responsible for the most dependencies to include in the summary")
+         ("help,h", bpo::bool_switch(&help)->default_value(false), "Print this help message and exit.")
+         ;
+}
+
+void parallelism_analyzer::initialize(const variables_map& options) {
+   try {
+      blocks_dir = options.at( "blocks-dir" ).as<bfs::path>();
+      if( blocks_dir.is_relative() )
+         blocks_dir = bfs::current_path() / blocks_dir;
+
+      if( options.count( "snapshot" ) )
+         snapshot = options.at( "snapshot" ).as<bfs::path>();
+      if( options.count( "data-dir" ) )
+         data_dir = options.at( "data-dir" ).as<bfs::path>();
+      if( options.count( "output-file" ) )
+         output_file = options.at( "output-file" ).as<bfs::path>();
+
+      thread_counts = options.at( "threads" ).as<std::vector<uint32_t>>();
+      EOS_ASSERT( !thread_counts.empty(), plugin_config_exception, "at least one thread count is required" );
+      for( auto n : thread_counts )
+         EOS_ASSERT( n > 0, plugin_config_exception, "thread counts must be greater than 0" );
+      EOS_ASSERT( first_block <= last_block, plugin_config_exception, "first must not be greater than last" );
+   } FC_LOG_AND_RETHROW()
+}
+
+int main(int argc, char** argv) {
+   options_description cli ("eosio-parallelism-analyzer command line options");
+   try {
+      parallelism_analyzer analyzer;
+      analyzer.set_program_options(cli);
+      variables_map vmap;
+      bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+      bpo::notify(vmap);
+      if (analyzer.help) {
+         cli.print(std::cerr);
+         return 0;
+      }
+      analyzer.initialize(vmap);
+      analyzer.run();
+   } catch( const fc::exception& e ) {
+      elog( "${e}", ("e", e.to_detail_string()));
+      return -1;
+   } catch( const boost::exception& e ) {
+      elog("${e}", ("e",boost::diagnostic_information(e)));
+      return -1;
+   } catch( const std::exception& e ) {
+      elog("${e}", ("e",e.what()));
+      return -1;
+   } catch( ... ) {
+      elog("unknown exception");
+      return -1;
+   }
+
+   return 0;
+}
@@ -555,5 +555,115 @@ BOOST_AUTO_TEST_CASE( linkauth_special ) { try {
 
 } FC_LOG_AND_RETHROW() }
 
+namespace {
+
+// pushes b to the validating node, returns how many of its transactions were applied without a serial authorization check
+size_t validate_block( validating_tester& chain, const signed_block_ptr& b ) {
+   auto bsf = chain.validating_node->create_block_state_future( b->calculate_id(), b );
+   controller::block_report br;
+   chain.validating_node->push_block( br, bsf, forked_branch_callback{}, trx_meta_cache_lookup{} );
+   return br.total_auth_prechecked_trxs;
+}
+
+// copy of b, the head block of chain, with its trx_idx transaction signed by keys instead, re-signed by its producer
+signed_block_ptr resign_trx( validating_tester& chain, const signed_block_ptr& b, size_t trx_idx, const vector<private_key_type>& keys ) {
+   auto copy_b = std::make_shared<signed_block>( b->clone() );
+   auto& receipt = copy_b->transactions.at( trx_idx );
+   const auto compression = std::get<packed_transaction>( receipt.trx ).get_compression();
+   auto signed_tx = std::get<packed_transaction>( receipt.trx ).get_signed_transaction();
+   signed_tx.signatures.clear();
+   for( const auto& key : keys )
+      signed_tx.sign( key, chain.control->get_chain_id() );
+   receipt.trx = packed_transaction( std::move( signed_tx ), compression );
+
+   deque<digest_type> trx_digests;
+   for( const auto& r : copy_b->transactions )
+      trx_digests.emplace_back( r.digest() );
+   copy_b->transaction_mroot = merkle( std::move( trx_digests ) );
+
+   auto header_bmroot = digest_type::hash( std::make_pair( copy_b->digest(), chain.control->head_block_state()->blockroot_merkle.get_root() ) );
+   auto sig_digest = digest_type::hash( std::make_pair( header_bmroot, chain.control->head_block_state()->pending_schedule.schedule_hash ) );
+   copy_b->producer_signature = chain.get_private_key( b->producer, "active" ).sign( sig_digest );
+   return copy_b;
+}
+
+// an action to an account without a contract, only its authorization is checked
+void push_noop( validating_tester& chain, const vector<permission_level>& auths, const vector<private_key_type>& keys ) {
+   signed_transaction trx;
+   trx.actions.emplace_back( auths, auths.at( 0 ).actor, "noop"_n, bytes() );
+   chain.set_transaction_headers( trx );
+   for( const auto& key : keys )
+      trx.sign( key, chain.control->get_chain_id() );
+   chain.push_transaction( trx );
+}
+
+bool is_unsatisfied_authorization( const fc::exception& e ) {
+   return e.code() == unsatisfied_authorization::code_value;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( parallel_auth_validation ) { try {
+   fc::temp_directory tempdir;
+   validating_tester chain( tempdir, []( controller::config& cfg ) { cfg.parallel_auth_validation = true; }, true );
+
+   chain.create_accounts( {"alice"_n, "bob"_n, "carol"_n} );
+   chain.produce_block();
+
+   const permission_level alice_active{"alice"_n, config::active_name};
+   const permission_level bob_active{"bob"_n, config::active_name};
+   const auto alice_key = chain.get_private_key( "alice"_n, "active" );
+   const auto bob_key = chain.get_private_key( "bob"_n, "active" );
+
+   // no permission is modified, the serial check of every transaction is skipped
+   push_noop( chain, { alice_active }, { alice_key } );
+   push_noop( chain, { bob_active }, { bob_key } );
+   push_noop( chain, { {"carol"_n, config::active_name} }, { chain.get_private_key( "carol"_n, "active" ) } );
+   BOOST_CHECK_EQUAL( validate_block( chain, chain.produce_block_no_validation() ), 3u );
+   BOOST_REQUIRE_EQUAL( true, chain.validate() );
+
+   // the first transaction's check holds; it creates a permission so the following ones are checked again when applied
+   chain.push_action( config::system_account_name, updateauth::get_name(), "alice"_n, fc::mutable_variant_object()
+           ("account", "alice")("permission", "first")("parent", "active")
+           ("auth", authority(chain.get_public_key("alice"_n, "first"))) );
+   chain.push_action( config::system_account_name, updateauth::get_name(), "bob"_n, fc::mutable_variant_object()
+           ("account", "bob")("permission", "first")("parent", "active")
+           ("auth", authority(chain.get_public_key("bob"_n, "first"))) );
+   BOOST_CHECK_EQUAL( validate_block( chain, chain.produce_block_no_validation() ), 1u );
+   BOOST_REQUIRE_EQUAL( true, chain.validate() );
+
+   // permissions created in the previous block are used for authorization while others are modified in this one
+   chain.set_authority( "carol"_n, "first"_n, authority(chain.get_public_key("carol"_n, "first")), "active"_n );
+   chain.set_authority( "alice"_n, "second"_n, authority(chain.get_public_key("alice"_n, "second")), "first"_n,
+                        { permission_level{"alice"_n, "first"_n} }, { chain.get_private_key("alice"_n, "first") } );
+   chain.set_authority( "bob"_n, "second"_n, authority(chain.get_public_key("bob"_n, "second")), "first"_n,
+                        { permission_level{"bob"_n, "first"_n} }, { chain.get_private_key("bob"_n, "first") } );
+   BOOST_CHECK_EQUAL( validate_block( chain, chain.produce_block_no_validation() ), 1u );
+   BOOST_REQUIRE_EQUAL( true, chain.validate() );
+
+   // a bad signature and a missing authority are still rejected
+   push_noop( chain, { alice_active }, { alice_key } );
+   push_noop( chain, { alice_active, bob_active }, { alice_key, bob_key } );
+   auto b = chain.produce_block_no_validation();
+   BOOST_REQUIRE_EXCEPTION( validate_block( chain, resign_trx( chain, b, 0, { bob_key } ) ),
+                            fc::exception, is_unsatisfied_authorization );
+   BOOST_REQUIRE_EXCEPTION( validate_block( chain, resign_trx( chain, b, 1, { alice_key } ) ),
+                            fc::exception, is_unsatisfied_authorization );
+   BOOST_CHECK_EQUAL( validate_block( chain, b ), 2u );
+   BOOST_REQUIRE_EQUAL( true, chain.validate() );
+
+   // a key replaced earlier in the block no longer satisfies the permission although it did when checked in parallel
+   chain.set_authority( "alice"_n, "first"_n, authority(chain.get_public_key("alice"_n, "first2")), "active"_n,
+                        { alice_active }, { alice_key } );
+   chain.set_authority( "alice"_n, "third"_n, authority(chain.get_public_key("alice"_n, "third")), "first"_n,
+                        { permission_level{"alice"_n, "first"_n} }, { chain.get_private_key("alice"_n, "first2") } );
+   b = chain.produce_block_no_validation();
+   BOOST_REQUIRE_EXCEPTION( validate_block( chain, resign_trx( chain, b, 1, { chain.get_private_key("alice"_n, "first") } ) ),
+                            fc::exception, is_unsatisfied_authorization );
+   BOOST_CHECK_EQUAL( validate_block( chain, b ), 1u );
+   BOOST_REQUIRE_EQUAL( true, chain.validate() );
+
+} FC_LOG_AND_RETHROW() }
+
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -980,6 +980,111 @@ static const char negative_memory_grow_wast[] = R"=====(
 )
 )=====";
 
+// Checks its two starting pages hold nothing but "abc", then dirties its initial data, its starting pages,
+// pages it grows and pages it gives back, and ends with memory past its starting size written.
+static const char memory_reset_dirty_wast[] = R"=====(
+(module
+ (memory 2)
+ (data (i32.const 0) "abc")
+ (func $check_zero (param $from i32) (param $to i32)
+  (block $done
+   (loop $next
+    (br_if $done (i32.ge_u (get_local $from) (get_local $to)))
+    (if (i64.ne (i64.load (get_local $from)) (i64.const 0)) (then (unreachable)))
+    (set_local $from (i32.add (get_local $from) (i32.const 8)))
+    (br $next)
+   )
+  )
+ )
+ (func (export "apply") (param i64 i64 i64)
+  (if (i64.ne (i64.load (i32.const 0)) (i64.const 6513249)) (then (unreachable)))
+  (call $check_zero (i32.const 8) (i32.const 131072))
+  (i64.store (i32.const 0) (i64.const -1))
+  (i64.store (i32.const 4096) (i64.const -1))
+  (i64.store (i32.const 131064) (i64.const -1))
+  (drop (grow_memory (i32.const 3)))
+  (call $check_zero (i32.const 131072) (i32.const 327680))
+  (i64.store (i32.const 200000) (i64.const -1))
+  (i64.store (i32.const 327672) (i64.const -1))
+  (drop (grow_memory (i32.const -2)))
+  (drop (grow_memory (i32.const 2)))
+  (call $check_zero (i32.const 196608) (i32.const 327680))
+  (if (i64.ne (i64.load (i32.const 131064)) (i64.const -1)) (then (unreachable)))
+  (i64.store (i32.const 250000) (i64.const -1))
+  (i64.store (i32.const 327672) (i64.const -1))
+  (drop (grow_memory (i32.const -1)))
+ )
+)
+)=====";
+
+// A second code with a smaller starting memory and different initial data: checks it sees nothing the
+// other code (or its own previous execution) wrote, then dirties pages inside and past both starting sizes.
+static const char memory_reset_check_wast[] = R"=====(
+(module
+ (memory 1)
+ (data (i32.const 16) "zz")
+ (func $check_zero (param $from i32) (param $to i32)
+  (block $done
+   (loop $next
+    (br_if $done (i32.ge_u (get_local $from) (get_local $to)))
+    (if (i64.ne (i64.load (get_local $from)) (i64.const 0)) (then (unreachable)))
+    (set_local $from (i32.add (get_local $from) (i32.const 8)))
+    (br $next)
+   )
+  )
+ )
+ (func (export "apply") (param i64 i64 i64)
+  (if (i64.ne (i64.load (i32.const 16)) (i64.const 31354)) (then (unreachable)))
+  (call $check_zero (i32.const 0) (i32.const 16))
+  (call $check_zero (i32.const 24) (i32.const 65536))
+  (drop (grow_memory (i32.const 6)))
+  (call $check_zero (i32.const 65536) (i32.const 458752))
+  (i64.store (i32.const 16) (i64.const -1))
+  (i64.store (i32.const 40000) (i64.const -1))
+  (i64.store (i32.const 100000) (i64.const -1))
+  (i64.store (i32.const 400000) (i64.const -1))
+ )
+)
+)=====";
+
+static const char intrinsic_usage_wast[] = R"=====(
+(module
+ (import "env" "read_action_data" (func $read_action_data (param i32 i32) (result i32)))
+ (import "env" "eosio_assert" (func $eosio_assert (param i32 i32)))
+ (import "env" "eosio_exit" (func $eosio_exit (param i32)))
+ (memory 1)
+ (data (i32.const 16) "asked to fail")
+ (func (export "apply") (param i64 i64 i64)
+  (drop (call $read_action_data (i32.const 0) (i32.const 4)))
+  (drop (call $read_action_data (i32.const 0) (i32.const 4)))
+  (call $eosio_assert (i32.eqz (i32.load (i32.const 0))) (i32.const 16))
+  (call $eosio_exit (i32.const 0))
+  (unreachable)
+ )
+)
+)=====";
+
+static const char profiled_spin_wast[] = R"=====(
+(module
+ (memory 1)
+ (func $spin (param $n i32) (result i32)
+  (local $acc i32)
+  (block $done
+   (loop $next
+    (br_if $done (i32.eqz (get_local $n)))
+    (set_local $acc (i32.rotl (i32.xor (i32.mul (get_local $acc) (i32.const 3)) (get_local $n)) (i32.const 5)))
+    (set_local $n (i32.sub (get_local $n) (i32.const 1)))
+    (br $next)
+   )
+  )
+  (get_local $acc)
+ )
+ (func (export "apply") (param i64 i64 i64)
+  (i32.store (i32.const 0) (call $spin (i32.const 10000000)))
+ )
+)
+)=====";
+
 static const char negative_memory_grow_trap_wast[] = R"=====(
 (module
  (memory 1)
@@ -1,6 +1,9 @@
 #include <eosio/chain/abi_serializer.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/merkle.hpp>
+#include <eosio/chain/multi_sha256.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/testing/tester.hpp>
 #include <eosio/chain/webassembly/return_codes.hpp>
 
@@ -797,4 +800,81 @@ BOOST_AUTO_TEST_CASE( k1_recover_test ) { try {
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( multi_sha256_test ) { try {
+   // lengths around the block and padding boundaries, then mixed lengths so lanes refill at different times
+   std::vector<std::string> inputs;
+   for( size_t len = 0; len < 200; ++len )
+      inputs.emplace_back( len, char( 'a' + len % 26 ) );
+   for( size_t i = 0; i < 50; ++i )
+      inputs.emplace_back( ( i * 7919 ) % 1000, char( i ) );
+   std::vector<std::string_view> messages( inputs.begin(), inputs.end() );
+
+   for( auto kernel : { sha256_kernel::sha_ni, sha256_kernel::avx512, sha256_kernel::avx2, sha256_kernel::sse2, sha256_kernel::scalar } ) {
+      if( !is_supported( kernel ) ) {
+         BOOST_TEST_MESSAGE( "skipping unsupported SHA-256 kernel " << to_string( kernel ) );
+         continue;
+      }
+      BOOST_TEST_CONTEXT( to_string( kernel ) ) {
+         std::vector<digest_type> digests( messages.size() );
+         multi_sha256( messages.data(), messages.size(), digests.data(), kernel );
+         for( size_t i = 0; i < messages.size(); ++i )
+            BOOST_CHECK_EQUAL( digests[i], fc::sha256::hash( inputs[i] ) );
+      }
+   }
+   BOOST_CHECK( is_supported( default_sha256_kernel() ) );
+
+   // merkle() hashes levels many at once, as one pair at a time did
+   const auto single_merkle = []( deque<digest_type> ids ) {
+      while( ids.size() > 1 ) {
+         if( ids.size() % 2 )
+            ids.push_back( ids.back() );
+         for( size_t i = 0; i < ids.size() / 2; ++i )
+            ids[i] = digest_type::hash( make_canonical_pair( ids[2 * i], ids[2 * i + 1] ) );
+         ids.resize( ids.size() / 2 );
+      }
+      return ids.front();
+   };
+   deque<digest_type> ids;
+   for( size_t n = 1; n <= 37; ++n ) {
+      ids.push_back( fc::sha256::hash( std::to_string( n ) ) );
+      BOOST_CHECK_EQUAL( merkle( ids ), single_merkle( ids ) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( receipt_digest_input_test ) { try {
+   // what controller hashes many at once is what digest() hashes, for both kinds of receipts
+   signed_transaction trx;
+   trx.expiration = fc::time_point_sec( 1000 );
+   trx.context_free_actions.emplace_back( vector<permission_level>{}, "cfa"_n, "cfa"_n, bytes{ 'a', 'b' } );
+   trx.context_free_data.emplace_back( bytes{ 'c' } );
+   transaction_receipt packed_receipt{ packed_transaction( signed_transaction( trx ), packed_transaction::compression_type::none ) };
+   packed_receipt.cpu_usage_us = 1234;
+   packed_receipt.net_usage_words = 1u << 30;
+   transaction_receipt id_receipt{ trx.id() };
+   id_receipt.status = transaction_receipt::soft_fail;
+   id_receipt.net_usage_words = 7;
+
+   for( const transaction_receipt* receipt : { &packed_receipt, &id_receipt } ) {
+      const vector<char> input = receipt->digest_input();
+      BOOST_CHECK_EQUAL( fc::sha256::hash( input.data(), input.size() ), receipt->digest() );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( parallel_merkle_test ) { try {
+   named_thread_pool thread_pool( "merkle", 2 );
+   deque<digest_type> ids;
+   // around the chunk boundaries, and the last id duplicated on odd levels
+   for( size_t n : { 0, 1, 2047, 2048, 2049, 4096, 5001, 33333 } ) {
+      while( ids.size() < n )
+         ids.push_back( fc::sha256::hash( std::to_string( ids.size() ) ) );
+      BOOST_CHECK_EQUAL( merkle( ids, thread_pool.get_executor() ), merkle( ids ) );
+   }
+
+   // run from a thread of the pool, as controller does, the calling thread takes the chunks the pool does not
+   auto root = async_thread_pool( thread_pool.get_executor(), [&]() {
+      return merkle( ids, thread_pool.get_executor() );
+   } );
+   BOOST_CHECK_EQUAL( root.get(), merkle( ids ) );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
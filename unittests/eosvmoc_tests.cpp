@@ -0,0 +1,227 @@
+#include <eosio/chain/webassembly/eos-vm-oc/code_cache.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/compile_monitor.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/filesystem.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+
+#include <sys/socket.h>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::chain::eosvmoc;
+
+namespace {
+   code_tuple make_code( const std::string& s ) {
+      return code_tuple{ fc::sha256::hash( s ), 0 };
+   }
+
+   struct test_pending {
+      code_tuple code;
+      uint64_t   priority = 0;
+      int        id = 0;
+   };
+}
+
+BOOST_AUTO_TEST_SUITE(eosvmoc_tests)
+
+BOOST_AUTO_TEST_CASE(compile_queue_priority_order) {
+   compile_queue<test_pending> queue;
+   BOOST_CHECK( queue.empty() );
+
+   queue.push( { make_code( "a" ), 5, 1 } );
+   queue.push( { make_code( "b" ), 10, 2 } );
+   queue.push( { make_code( "c" ), 5, 3 } );
+   queue.push( { make_code( "d" ), 0, 4 } );
+   queue.push( { make_code( "e" ), 10, 5 } );
+   BOOST_CHECK_EQUAL( queue.size(), 5u );
+
+   // highest priority first, the first queued of equal priorities first
+   std::vector<int> order;
+   while( !queue.empty() )
+      order.push_back( queue.pop().id );
+   BOOST_CHECK( order == std::vector<int>({ 2, 5, 1, 3, 4 }) );
+}
+
+BOOST_AUTO_TEST_CASE(compile_queue_reprioritize) {
+   compile_queue<test_pending> queue;
+   queue.push( { make_code( "a" ), 5, 1 } );
+   queue.push( { make_code( "b" ), 10, 2 } );
+   queue.push( { make_code( "c" ), 1, 3 } );
+
+   // a code which got hotter while queued moves up
+   BOOST_CHECK( queue.reprioritize( make_code( "c" ), 20 ) );
+   BOOST_CHECK( !queue.reprioritize( make_code( "x" ), 20 ) );
+   BOOST_CHECK_EQUAL( queue.pop().id, 3 );
+   BOOST_CHECK_EQUAL( queue.pop().id, 2 );
+   BOOST_CHECK_EQUAL( queue.pop().id, 1 );
+}
+
+BOOST_AUTO_TEST_CASE(compile_queue_cancel) {
+   compile_queue<test_pending> queue;
+   queue.push( { make_code( "a" ), 5, 1 } );
+   queue.push( { make_code( "b" ), 10, 2 } );
+   queue.push( { make_code( "c" ), 1, 3 } );
+
+   // a cancelled compile is dropped from the queue and never started
+   auto cancelled = queue.remove( make_code( "b" ) );
+   BOOST_REQUIRE( cancelled );
+   BOOST_CHECK_EQUAL( cancelled->id, 2 );
+   BOOST_CHECK( !queue.remove( make_code( "b" ) ) );
+   BOOST_CHECK( !queue.remove( make_code( "x" ) ) );
+   BOOST_CHECK_EQUAL( queue.size(), 2u );
+   BOOST_CHECK_EQUAL( queue.pop().id, 1 );
+   BOOST_CHECK_EQUAL( queue.pop().id, 3 );
+   BOOST_CHECK( queue.empty() );
+}
+
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+
+BOOST_AUTO_TEST_CASE(cancel_compile_message_roundtrip) {
+   int socks[2];
+   BOOST_REQUIRE_EQUAL( socketpair( AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, socks ), 0 );
+   wrapped_fd writer( socks[0] ), reader( socks[1] );
+
+   const code_tuple code{ fc::sha256::hash( std::string( "cancelled" ) ), 1 };
+   BOOST_REQUIRE( write_message_with_fds( writer, cancel_compile_message{ code } ) );
+   auto [success, message, fds] = read_message_with_fds( reader );
+   BOOST_REQUIRE( success );
+   BOOST_REQUIRE( std::holds_alternative<cancel_compile_message>( message ) );
+   BOOST_CHECK( std::get<cancel_compile_message>( message ).code == code );
+   BOOST_CHECK( fds.empty() );
+
+   // the reply to a cancelled compile
+   wasm_compilation_result_message reply{ code, compilation_result_cancelled{}, 1234 };
+   reply.queue_time_us = 42;
+   BOOST_REQUIRE( write_message_with_fds( writer, reply ) );
+   auto [reply_success, reply_message, reply_fds] = read_message_with_fds( reader );
+   BOOST_REQUIRE( reply_success );
+   BOOST_REQUIRE( std::holds_alternative<wasm_compilation_result_message>( reply_message ) );
+   const auto& result = std::get<wasm_compilation_result_message>( reply_message );
+   BOOST_CHECK( result.code == code );
+   BOOST_CHECK( std::holds_alternative<compilation_result_cancelled>( result.result ) );
+   BOOST_CHECK_EQUAL( result.cache_free_bytes, 1234u );
+   BOOST_CHECK_EQUAL( result.queue_time_us, 42u );
+}
+
+BOOST_AUTO_TEST_CASE(code_hotness_roundtrip) {
+   fc::temp_directory tmp;
+   const bfs::path file = tmp.path() / "code_cache_hotness.bin";
+
+   // nothing recorded yet
+   BOOST_CHECK( load_code_hotness( file ).empty() );
+
+   code_hotness_map hotness;
+   hotness[make_code( "a" )] = code_hotness{ 10, 1000 };
+   hotness[make_code( "b" )] = code_hotness{ 7, 3 };
+   hotness[make_code( "c" )] = code_hotness{ 1, 1 };
+   save_code_hotness( file, hotness, 10 );
+
+   // what previous runs recorded is halved, so codes no longer executed age out over restarts
+   code_hotness_map loaded = load_code_hotness( file );
+   BOOST_REQUIRE_EQUAL( loaded.size(), 3u );
+   BOOST_CHECK_EQUAL( loaded[make_code( "a" )].executions, 5u );
+   BOOST_CHECK_EQUAL( loaded[make_code( "a" )].cpu_us, 500u );
+   BOOST_CHECK_EQUAL( loaded[make_code( "b" )].executions, 3u );
+   BOOST_CHECK_EQUAL( loaded[make_code( "b" )].cpu_us, 1u );
+   BOOST_CHECK_EQUAL( loaded[make_code( "c" )].executions, 0u );
+   BOOST_CHECK_EQUAL( loaded[make_code( "c" )].cpu_us, 0u );
+
+   save_code_hotness( file, loaded, 10 );
+   loaded = load_code_hotness( file );
+   BOOST_CHECK_EQUAL( loaded[make_code( "a" )].cpu_us, 250u );
+
+   // only the hottest are kept
+   save_code_hotness( file, hotness, 2 );
+   loaded = load_code_hotness( file );
+   BOOST_CHECK_EQUAL( loaded.size(), 2u );
+   BOOST_CHECK( loaded.count( make_code( "a" ) ) );
+   BOOST_CHECK( loaded.count( make_code( "b" ) ) );
+
+   // a file of an unknown format is ignored
+   {
+      std::ofstream out( file.generic_string(), std::ios::binary | std::ios::trunc );
+      out << "not a hotness file";
+   }
+   BOOST_CHECK( load_code_hotness( file ).empty() );
+}
+
+BOOST_AUTO_TEST_CASE(warmup_hottest_codes) {
+   code_hotness_map hotness;
+   hotness[make_code( "cold" )]     = code_hotness{ 1, 1 };
+   hotness[make_code( "warm" )]     = code_hotness{ 100, 50 };
+   hotness[make_code( "hot" )]      = code_hotness{ 10, 5000 };
+   hotness[make_code( "hottest" )]  = code_hotness{ 1, 9000 };
+   hotness[make_code( "busy" )]     = code_hotness{ 1000, 50 }; // executed more, but for as little time as warm
+   hotness[make_code( "cached" )]   = code_hotness{ 1, 100000 };
+   const auto all = []( const code_tuple& ) { return true; };
+
+   // hottest first, capped by the number of warmup compiles
+   BOOST_CHECK( hottest_codes( hotness, 3, all ) ==
+                std::vector<code_tuple>({ make_code( "cached" ), make_code( "hottest" ), make_code( "hot" ) }) );
+   BOOST_CHECK( hottest_codes( hotness, 0, all ).empty() );
+   BOOST_CHECK_EQUAL( hottest_codes( hotness, 100, all ).size(), hotness.size() );
+
+   // codes already in the cache, or failing to compile, are skipped
+   const auto not_cached = []( const code_tuple& ct ) { return !( ct == make_code( "cached" ) ); };
+   BOOST_CHECK( hottest_codes( hotness, 100, not_cached ) ==
+                std::vector<code_tuple>({ make_code( "hottest" ), make_code( "hot" ), make_code( "busy" ),
+                                          make_code( "warm" ), make_code( "cold" ) }) );
+}
+
+BOOST_AUTO_TEST_CASE(gdsf_eviction_order) {
+   gdsf_eviction_policy policy;
+   const auto evicted_codes = []( const std::vector<std::pair<code_tuple, size_t>>& evicted ) {
+      std::vector<code_tuple> codes;
+      for( const auto& e : evicted )
+         codes.push_back( e.first );
+      return codes;
+   };
+
+   policy.insert( make_code( "hit" ), 100 );
+   policy.insert( make_code( "once" ), 100 );
+   policy.insert( make_code( "large" ), 1000 );
+   policy.insert( make_code( "small" ), 10 );
+   for( int i = 0; i < 4; ++i )
+      policy.hit( make_code( "hit" ) );
+   BOOST_CHECK_EQUAL( policy.size(), 4u );
+
+   // the lowest hits per byte first: large code executed once, then code of the same size hit less often
+   auto evicted = policy.evict( 1 );
+   BOOST_CHECK( evicted_codes( evicted ) == std::vector<code_tuple>({ make_code( "large" ) }) );
+   BOOST_CHECK_EQUAL( evicted[0].second, 1000u );
+   BOOST_CHECK( evicted_codes( policy.evict( 100 ) ) == std::vector<code_tuple>({ make_code( "once" ) }) );
+
+   // code inserted after evictions starts above what was evicted, a recent run of hits keeps it over older entries
+   policy.insert( make_code( "recent" ), 100 );
+   for( int i = 0; i < 9; ++i )
+      policy.hit( make_code( "recent" ) );
+   BOOST_CHECK( evicted_codes( policy.evict( 1 ) ) == std::vector<code_tuple>({ make_code( "hit" ) }) );
+
+   // as much as asked for is freed, but the last entry is kept
+   BOOST_CHECK( evicted_codes( policy.evict( 1000000 ) ) == std::vector<code_tuple>({ make_code( "small" ) }) );
+   BOOST_CHECK_EQUAL( policy.size(), 1u );
+   BOOST_CHECK( policy.evict( 1000000 ).empty() );
+
+   // freed code is no longer a candidate
+   policy.insert( make_code( "freed" ), 1 );
+   policy.erase( make_code( "freed" ) );
+   BOOST_CHECK_EQUAL( policy.size(), 1u );
+}
+
+BOOST_AUTO_TEST_CASE(gdsf_eviction_frees_enough) {
+   gdsf_eviction_policy policy;
+   for( int i = 0; i < 10; ++i )
+      policy.insert( make_code( std::to_string( i ) ), 100 );
+   // entries of the same priority are all candidates, enough of them are evicted to free the bytes asked for
+   const auto evicted = policy.evict( 250 );
+   BOOST_CHECK_EQUAL( evicted.size(), 3u );
+   BOOST_CHECK_EQUAL( policy.size(), 7u );
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,15 +1,25 @@
 #include <eosio/chain/asset.hpp>
 #include <eosio/chain/authority.hpp>
 #include <eosio/chain/authority_checker.hpp>
+#include <eosio/chain/event_tracer.hpp>
+#include <eosio/chain/intrinsic_usage.hpp>
+#include <eosio/chain/metrics.hpp>
+#include <eosio/chain/phase_timing.hpp>
+#include <eosio/chain/recovered_key_cache.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/thread_utils.hpp>
+#include <eosio/chain/wasm_module_cache.hpp>
 #include <eosio/testing/tester.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/log/logger_config.hpp>
 #include <appbase/execution_priority_queue.hpp>
 #include <fc/bitutil.hpp>
+#include <fc/scoped_exit.hpp>
+#include <fc/filesystem.hpp>
 
+#include <atomic>
+#include <fstream>
 #include <thread>
 
 #include <boost/test/unit_test.hpp>
@@ -1219,6 +1229,408 @@ BOOST_AUTO_TEST_CASE(public_key_from_hash) {
    ilog( "public key with no known private key: ${k}", ("k", eos_unknown_pk) );
 }
 
+BOOST_AUTO_TEST_CASE(recovered_key_cache_test) { try {
+   auto priv = fc::crypto::private_key::regenerate<fc::ecc::private_key_shim>( fc::sha256::hash( std::string("recovered_key_cache") ) );
+   std::vector<std::pair<digest_type, signature_type>> sigs;
+   for( int i = 0; i < 64; ++i ) {
+      auto digest = fc::sha256::hash( std::to_string( i ) );
+      sigs.emplace_back( digest, priv.sign( digest ) );
+   }
+
+   recovered_key_cache cache( 2 * recovered_key_cache::num_shards );
+   for( const auto& [digest, sig] : sigs ) {
+      BOOST_CHECK( cache.recover( sig, digest, true ) == priv.get_public_key() );
+   }
+   auto stats = cache.get_stats();
+   BOOST_CHECK_EQUAL( stats.hits, 0u );
+   BOOST_CHECK_EQUAL( stats.misses, sigs.size() );
+   BOOST_CHECK_EQUAL( stats.capacity, 2 * recovered_key_cache::num_shards );
+   BOOST_CHECK_LE( stats.size, stats.capacity );
+   BOOST_CHECK_EQUAL( stats.size + stats.evictions, sigs.size() );
+
+   // the most recently recovered key is always still cached
+   const auto& [last_digest, last_sig] = sigs.back();
+   BOOST_CHECK( cache.recover( last_sig, last_digest, false ) == priv.get_public_key() );
+   BOOST_CHECK( cache.recover( last_sig, last_digest, true ) == priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.get_stats().hits, 2u );
+
+   // a key recovered without the canonical check is recovered again when the check is requested
+   cache.clear();
+   cache.recover( last_sig, last_digest, false );
+   cache.recover( last_sig, last_digest, true );
+   cache.recover( last_sig, last_digest, true );
+   BOOST_CHECK_EQUAL( cache.get_stats().misses, sigs.size() + 2 );
+   BOOST_CHECK_EQUAL( cache.get_stats().hits, 3u );
+
+   cache.set_capacity( 0 );
+   BOOST_CHECK_EQUAL( cache.get_stats().size, 0u );
+   BOOST_CHECK( cache.recover( last_sig, last_digest, true ) == priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.get_stats().size, 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(phase_timings_test) { try {
+   auto& timings = phase_timings::instance();
+   timings.reset();
+   timings.set_enabled( true );
+   auto restore = fc::make_scoped_exit( [&timings]() {
+      timings.set_enabled( false );
+      timings.reset();
+   } );
+
+   timings.record( timing_phase::authorization, std::chrono::nanoseconds( 500 ) );
+   timings.record( timing_phase::authorization, std::chrono::microseconds( 3 ) );
+   timings.record( timing_phase::authorization, std::chrono::microseconds( 3 ) );
+   { scoped_phase_timer timer( timing_phase::fork_db_insert ); }
+
+   auto stats = timings.get_stats();
+   BOOST_REQUIRE_EQUAL( stats.size(), static_cast<size_t>( timing_phase::num_phases ) );
+   const auto& auth = stats[static_cast<size_t>( timing_phase::authorization )];
+   BOOST_CHECK_EQUAL( auth.phase, "authorization" );
+   BOOST_CHECK_EQUAL( auth.count, 3u );
+   BOOST_CHECK_EQUAL( auth.total_us, 6u );
+   BOOST_REQUIRE_EQUAL( auth.buckets.size(), 2u );
+   BOOST_CHECK_EQUAL( auth.buckets[0].below_us, 1u );
+   BOOST_CHECK_EQUAL( auth.buckets[0].count, 1u );
+   BOOST_CHECK_EQUAL( auth.buckets[1].below_us, 4u );
+   BOOST_CHECK_EQUAL( auth.buckets[1].count, 2u );
+   BOOST_CHECK_EQUAL( stats[static_cast<size_t>( timing_phase::fork_db_insert )].count, 1u );
+
+   // nothing is recorded while disabled
+   timings.set_enabled( false );
+   { scoped_phase_timer timer( timing_phase::fork_db_insert ); }
+   BOOST_CHECK_EQUAL( timings.get_stats()[static_cast<size_t>( timing_phase::fork_db_insert )].count, 1u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(metrics_registry_test) { try {
+   auto& reg = metrics::registry::instance();
+   auto& requests = reg.make_counter( "test_metrics_requests_total", "Requests", {{"kind", "a\"b"}} );
+   auto& level = reg.make_gauge( "test_metrics_level", "Level" );
+   auto& latency = reg.make_histogram( "test_metrics_latency_seconds", "Latency" );
+
+   // same name and labels is the same metric, same name as another type is an error
+   BOOST_CHECK_EQUAL( &requests, &reg.make_counter( "test_metrics_requests_total", "Requests", {{"kind", "a\"b"}} ) );
+   BOOST_CHECK_THROW( reg.make_gauge( "test_metrics_requests_total", "Requests" ), misc_exception );
+
+   requests.inc( 3 );
+   level.set( 1.5 );
+   latency.observe_us( 1 );
+   latency.observe_us( 3 );
+   latency.observe_us( 3'000'000 );
+
+   auto handle = reg.add_collector( []( metrics::sample_writer& w ) {
+      w.write_gauge( "test_metrics_collected", "Collected", 7, {{"peer", "x"}} );
+   } );
+
+   const auto contains = []( const std::string& text, const std::string& line ) {
+      return text.find( line + "\n" ) != std::string::npos;
+   };
+
+   auto text = reg.render();
+   BOOST_CHECK( contains( text, "# HELP test_metrics_requests_total Requests" ) );
+   BOOST_CHECK( contains( text, "# TYPE test_metrics_requests_total counter" ) );
+   BOOST_CHECK( contains( text, "test_metrics_requests_total{kind=\"a\\\"b\"} 3" ) );
+   BOOST_CHECK( contains( text, "# TYPE test_metrics_level gauge" ) );
+   BOOST_CHECK( contains( text, "test_metrics_level 1.5" ) );
+   BOOST_CHECK( contains( text, "# TYPE test_metrics_latency_seconds histogram" ) );
+   BOOST_CHECK( contains( text, "test_metrics_latency_seconds_bucket{le=\"0.000001\"} 1" ) );
+   BOOST_CHECK( contains( text, "test_metrics_latency_seconds_bucket{le=\"0.000002\"} 1" ) );
+   BOOST_CHECK( contains( text, "test_metrics_latency_seconds_bucket{le=\"0.000004\"} 2" ) );
+   BOOST_CHECK( contains( text, "test_metrics_latency_seconds_bucket{le=\"4.194304\"} 3" ) );
+   BOOST_CHECK( contains( text, "test_metrics_latency_seconds_bucket{le=\"+Inf\"} 3" ) );
+   BOOST_CHECK( contains( text, "test_metrics_latency_seconds_sum 3.000004" ) );
+   BOOST_CHECK( contains( text, "test_metrics_latency_seconds_count 3" ) );
+   BOOST_CHECK( contains( text, "# TYPE test_metrics_collected gauge" ) );
+   BOOST_CHECK( contains( text, "test_metrics_collected{peer=\"x\"} 7" ) );
+
+   reg.remove_collector( handle );
+   BOOST_CHECK( reg.render().find( "test_metrics_collected" ) == std::string::npos );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(event_tracer_test) { try {
+   auto& tracer = event_tracer::instance();
+   auto reset = fc::make_scoped_exit( [&]() { tracer.set_buffer_size( 0 ); } );
+   tracer.set_buffer_size( 4 );
+   BOOST_REQUIRE( tracer.enabled() );
+
+   // events other than the thread name metadata
+   const auto recorded = [&]() {
+      fc::variants events;
+      const auto trace = tracer.get_trace();
+      for( const auto& e : trace["traceEvents"].get_array() ) {
+         if( e["ph"].as_string() != "M" )
+            events.push_back( e );
+      }
+      return events;
+   };
+
+   {
+      scoped_trace_event e( "test", "scoped" );
+      e.set_arg( "n", 5 );
+   }
+   auto h = tracer.start_handoff( "test_handoff" );
+   BOOST_REQUIRE( h.id != 0 );
+   std::thread( [&]() { tracer.end_handoff( h, "test_handoff queued" ); } ).join();
+
+   auto events = recorded();
+   BOOST_REQUIRE_EQUAL( events.size(), 4u );
+   BOOST_CHECK_EQUAL( events[0]["name"].as_string(), "scoped" );
+   BOOST_CHECK_EQUAL( events[0]["ph"].as_string(), "X" );
+   BOOST_CHECK_EQUAL( events[0]["args"]["n"].as_int64(), 5 );
+   BOOST_CHECK_EQUAL( events[1]["ph"].as_string(), "s" );
+   BOOST_CHECK_EQUAL( events[1]["id"].as_uint64(), h.id );
+   // the wait and the end of the flow are on the other thread
+   BOOST_CHECK_NE( events[1]["tid"].as_uint64(), events[2]["tid"].as_uint64() );
+   BOOST_CHECK_EQUAL( events[2]["name"].as_string(), "test_handoff queued" );
+   BOOST_CHECK_EQUAL( events[2]["ph"].as_string(), "X" );
+   BOOST_CHECK_EQUAL( events[3]["ph"].as_string(), "f" );
+   BOOST_CHECK_EQUAL( events[3]["bp"].as_string(), "e" );
+   BOOST_CHECK_EQUAL( events[3]["id"].as_uint64(), h.id );
+
+   // only the last buffer size events of a thread are kept, oldest first
+   tracer.clear();
+   BOOST_CHECK_EQUAL( recorded().size(), 0u );
+   const char* names[] = { "e0", "e1", "e2", "e3", "e4", "e5" };
+   for( const char* n : names ) {
+      auto now = event_tracer::clock::now();
+      tracer.complete( "test", n, now, now );
+   }
+   events = recorded();
+   BOOST_REQUIRE_EQUAL( events.size(), 4u );
+   for( size_t i = 0; i < events.size(); ++i )
+      BOOST_CHECK_EQUAL( events[i]["name"].as_string(), names[i + 2] );
+
+   tracer.set_buffer_size( 0 );
+   BOOST_CHECK( !tracer.enabled() );
+   BOOST_CHECK_EQUAL( tracer.start_handoff( "test_handoff" ).id, 0u );
+   BOOST_CHECK_EQUAL( recorded().size(), 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(event_tracer_concurrent_dump_test) { try {
+   auto& tracer = event_tracer::instance();
+   auto reset = fc::make_scoped_exit( [&]() { tracer.set_buffer_size( 0 ); } );
+   tracer.set_buffer_size( 64 );
+
+   // a thread keeps recording while the trace is dumped, every dump holds a consistent run of its latest events
+   constexpr int64_t num_events = 200000;
+   std::atomic<bool> done{false};
+   std::thread recorder( [&]() {
+      for( int64_t n = 0; n < num_events; ++n ) {
+         auto now = event_tracer::clock::now();
+         tracer.complete( "test", "concurrent", now, now, "n", n );
+      }
+      done = true;
+   } );
+
+   int64_t last_dumped = -1;
+   uint32_t dumps = 0;
+   for( bool finished = false; !finished; ++dumps ) {
+      finished = done;
+      const bool clear = dumps % 2;
+      const auto trace = tracer.get_trace( clear );
+      int64_t prev = -1;
+      for( const auto& e : trace["traceEvents"].get_array() ) {
+         if( e["name"].as_string() != "concurrent" )
+            continue;
+         const int64_t n = e["args"]["n"].as_int64();
+         if( prev >= 0 )
+            BOOST_REQUIRE_EQUAL( n, prev + 1 );
+         // dumps after a clear only hold events recorded since
+         BOOST_REQUIRE_GT( n, last_dumped );
+         prev = n;
+      }
+      if( clear && prev >= 0 )
+         last_dumped = prev;
+   }
+   recorder.join();
+   BOOST_CHECK_GT( dumps, 1u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(intrinsic_usage_test) { try {
+   const size_t db_find = eosvmoc::find_intrinsic_index( "env.db_find_i64" );
+   const size_t f32_add = eosvmoc::find_intrinsic_index( "eosio_injection._eosio_f32_add" );
+
+   intrinsic_usage_counters counters;
+   for( int i = 0; i < 3; ++i ) {
+      counters.call_started( db_find );
+      counters.call_finished();
+   }
+   counters.call_started( f32_add );
+   std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+   counters.call_finished();
+   // nothing was started
+   counters.call_finished();
+
+   auto usage = counters.usage();
+   BOOST_REQUIRE_EQUAL( usage.size(), 2u );
+   BOOST_CHECK_EQUAL( usage[0].intrinsic, "eosio_injection._eosio_f32_add" );
+   BOOST_CHECK_EQUAL( usage[0].calls, 1u );
+   BOOST_CHECK_GE( usage[0].time_ns, 2'000'000u );
+   BOOST_CHECK_EQUAL( usage[1].intrinsic, "db_find_i64" );
+   BOOST_CHECK_EQUAL( usage[1].calls, 3u );
+
+   auto& tracker = intrinsic_usage_tracker::instance();
+   auto reset = fc::make_scoped_exit( [&]() { tracker.set_window( 0 ); } );
+   tracker.set_window( 60 );
+   BOOST_REQUIRE( tracker.enabled() );
+   tracker.record( "alice"_n, usage );
+   tracker.record( "alice"_n, usage );
+   tracker.record( "bob"_n, { intrinsic_usage_entry{ "db_find_i64", 1, 1 } } );
+
+   auto accounts = tracker.get_usage( {}, 10 );
+   BOOST_REQUIRE_EQUAL( accounts.size(), 2u );
+   BOOST_CHECK_EQUAL( accounts[0].account, "alice"_n );
+   BOOST_CHECK_EQUAL( accounts[0].calls, 8u );
+   BOOST_REQUIRE_EQUAL( accounts[0].intrinsics.size(), 2u );
+   BOOST_CHECK_EQUAL( accounts[0].intrinsics[1].intrinsic, "db_find_i64" );
+   BOOST_CHECK_EQUAL( accounts[0].intrinsics[1].calls, 6u );
+   BOOST_CHECK_EQUAL( accounts[1].account, "bob"_n );
+   BOOST_CHECK_EQUAL( tracker.get_usage( {}, 1 ).size(), 1u );
+   accounts = tracker.get_usage( "bob"_n, 10 );
+   BOOST_REQUIRE_EQUAL( accounts.size(), 1u );
+   BOOST_CHECK_EQUAL( accounts[0].time_ns, 1u );
+
+   tracker.set_window( 0 );
+   BOOST_CHECK( !tracker.enabled() );
+   BOOST_CHECK_EQUAL( tracker.get_usage( {}, 10 ).size(), 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(wasm_module_cache_test) { try {
+   fc::temp_directory dir;
+   const fc::path file = dir.path() / "wasm_module_cache.bin";
+   const digest_type h1 = fc::sha256::hash( std::string( "code1" ) );
+   const digest_type h2 = fc::sha256::hash( std::string( "code2" ) );
+   const std::vector<uint8_t> mem1 = { 1, 2, 3 };
+   const std::vector<uint8_t> mem2( 1000, 7 );
+
+   {
+      wasm_module_cache cache( file, 1024 );
+      BOOST_CHECK( !cache.find( h1, 0, 0 ) );
+      cache.insert( h1, 0, 0, mem1 );
+      cache.insert( h1, 0, 1, {} );
+      BOOST_REQUIRE( cache.find( h1, 0, 0 ) );
+      BOOST_CHECK( *cache.find( h1, 0, 0 ) == mem1 );
+      BOOST_REQUIRE( cache.find( h1, 0, 1 ) );
+      BOOST_CHECK( cache.find( h1, 0, 1 )->empty() );
+      BOOST_CHECK( !cache.find( h1, 1, 0 ) );
+      // the file would grow past its maximum size
+      cache.insert( h2, 0, 0, std::vector<uint8_t>( 2000, 7 ) );
+      BOOST_CHECK( !cache.find( h2, 0, 0 ) );
+      BOOST_CHECK_EQUAL( cache.size(), 2u );
+   }
+
+   // entries survive a restart, and more can be added
+   {
+      wasm_module_cache cache( file, 4096 );
+      BOOST_CHECK_EQUAL( cache.size(), 2u );
+      BOOST_REQUIRE( cache.find( h1, 0, 0 ) );
+      BOOST_CHECK( *cache.find( h1, 0, 0 ) == mem1 );
+      cache.insert( h2, 0, 0, mem2 );
+   }
+
+   // a partially written last entry is dropped
+   fc::resize_file( file, fc::file_size( file ) - 10 );
+   {
+      wasm_module_cache cache( file, 4096 );
+      BOOST_CHECK_EQUAL( cache.size(), 2u );
+      BOOST_CHECK( !cache.find( h2, 0, 0 ) );
+      cache.insert( h2, 0, 0, mem2 );
+   }
+   {
+      wasm_module_cache cache( file, 4096 );
+      BOOST_CHECK_EQUAL( cache.size(), 3u );
+      BOOST_REQUIRE( cache.find( h2, 0, 0 ) );
+      BOOST_CHECK( *cache.find( h2, 0, 0 ) == mem2 );
+   }
+
+   // an entry whose contents were lost is dropped although its length is right, and can be recorded again
+   {
+      std::fstream f( file.generic_string(), std::ios::binary | std::ios::in | std::ios::out );
+      f.seekp( fc::file_size( file ) - mem2.size() / 2 );
+      const std::vector<char> zeros( 16 );
+      f.write( zeros.data(), zeros.size() );
+   }
+   {
+      wasm_module_cache cache( file, 8192 );
+      BOOST_CHECK_EQUAL( cache.size(), 3u );
+      BOOST_REQUIRE( cache.find( h1, 0, 0 ) );
+      BOOST_CHECK( *cache.find( h1, 0, 0 ) == mem1 );
+      BOOST_CHECK( !cache.find( h2, 0, 0 ) );
+      BOOST_CHECK_EQUAL( cache.size(), 2u );
+      cache.insert( h2, 0, 0, mem2 );
+      BOOST_REQUIRE( cache.find( h2, 0, 0 ) );
+      BOOST_CHECK( *cache.find( h2, 0, 0 ) == mem2 );
+   }
+   {
+      wasm_module_cache cache( file, 8192 );
+      BOOST_REQUIRE( cache.find( h2, 0, 0 ) );
+      BOOST_CHECK( *cache.find( h2, 0, 0 ) == mem2 );
+   }
+
+   // a file of another format is replaced
+   {
+      std::ofstream out( file.generic_string(), std::ios::binary | std::ios::trunc );
+      out << "not a wasm module cache";
+   }
+   {
+      wasm_module_cache cache( file, 4096 );
+      BOOST_CHECK_EQUAL( cache.size(), 0u );
+      cache.insert( h1, 0, 0, mem1 );
+   }
+   wasm_module_cache cache( file, 4096 );
+   BOOST_CHECK_EQUAL( cache.size(), 1u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(wasm_module_cache_compaction_test) { try {
+   fc::temp_directory dir;
+   const fc::path file = dir.path() / "wasm_module_cache.bin";
+   std::vector<digest_type> h;
+   for( int i = 0; i < 6; ++i )
+      h.push_back( fc::sha256::hash( "code" + std::to_string( i ) ) );
+   // 170 bytes per record, two fit in half of the max size
+   const std::vector<uint8_t> mem( 100, 7 );
+
+   {
+      wasm_module_cache cache( file, 1000 );
+      for( int i = 0; i < 5; ++i )
+         cache.insert( h[i], 0, 0, mem );
+      BOOST_CHECK_EQUAL( cache.size(), 5u );
+      BOOST_CHECK( cache.find( h[1], 0, 0 ) );
+      BOOST_CHECK( cache.find( h[3], 0, 0 ) );
+
+      // the file would grow past its maximum size, only the most recently used entries are kept
+      cache.insert( h[5], 0, 0, mem );
+      BOOST_CHECK_EQUAL( cache.size(), 3u );
+      BOOST_CHECK( !cache.find( h[0], 0, 0 ) );
+      BOOST_CHECK( !cache.find( h[2], 0, 0 ) );
+      BOOST_CHECK( !cache.find( h[4], 0, 0 ) );
+      for( int i : { 1, 3, 5 } ) {
+         BOOST_REQUIRE( cache.find( h[i], 0, 0 ) );
+         BOOST_CHECK( *cache.find( h[i], 0, 0 ) == mem );
+      }
+   }
+   BOOST_CHECK_LE( fc::file_size( file ), 1000u );
+   BOOST_CHECK( !fc::exists( file.generic_string() + ".tmp" ) );
+
+   // the compacted file survives a restart
+   {
+      wasm_module_cache cache( file, 1000 );
+      BOOST_CHECK_EQUAL( cache.size(), 3u );
+      for( int i : { 1, 3, 5 } ) {
+         BOOST_REQUIRE( cache.find( h[i], 0, 0 ) );
+         BOOST_CHECK( *cache.find( h[i], 0, 0 ) == mem );
+      }
+   }
+
+   // a lowered max size compacts on load, keeping the entries last in the file
+   {
+      wasm_module_cache cache( file, 400 );
+      BOOST_CHECK_EQUAL( cache.size(), 1u );
+      BOOST_REQUIRE( cache.find( h[5], 0, 0 ) );
+      BOOST_CHECK( *cache.find( h[5], 0, 0 ) == mem );
+   }
+   BOOST_CHECK_LE( fc::file_size( file ), 400u );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace eosio
@@ -0,0 +1,133 @@
+#include <eosio/chain/global_property_object.hpp>
+#include <eosio/chain/thread_utils.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#ifdef NON_VALIDATING_TEST
+#define TESTER tester
+#else
+#define TESTER validating_tester
+#endif
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+namespace {
+
+transaction_metadata_ptr make_trx( TESTER& t, action act, transaction_metadata::trx_type type ) {
+   signed_transaction trx;
+   trx.actions.emplace_back( std::move(act) );
+   t.set_transaction_headers( trx );
+   return transaction_metadata::create_no_recover_keys( std::make_shared<packed_transaction>( std::move(trx) ), type );
+}
+
+transaction_trace_ptr push_on_read_only_thread( controller& control, const transaction_metadata_ptr& trx ) {
+   named_thread_pool pool( "rdonly", 1 );
+   auto f = async_thread_pool( pool.get_executor(), [&]() {
+      control.init_read_only_thread();
+      return control.push_transaction( trx, fc::time_point::maximum(), fc::milliseconds(150), 0, false, 0 );
+   } );
+   auto trace = f.get();
+   pool.stop();
+   return trace;
+}
+
+static const char noop_wast[] = R"=====(
+(module
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64))
+)
+)=====";
+
+static const char other_noop_wast[] = R"=====(
+(module
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64) (drop (i64.const 0)))
+)
+)=====";
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(read_only_thread_tests)
+
+BOOST_AUTO_TEST_CASE(read_only_thread_execution) { try {
+   TESTER t;
+   if( t.get_config().wasm_runtime == wasm_interface::vm_type::eos_vm_oc ) {
+      // read-only threads are not supported with eos-vm-oc
+      return;
+   }
+   t.create_accounts( {"alice"_n} );
+   t.produce_block();
+
+   const auto global_action_sequence = t.control->get_dynamic_global_properties().global_action_sequence;
+
+   // no contract and no native handler, nothing is written
+   auto trace = push_on_read_only_thread( *t.control, make_trx( t, action( {}, "alice"_n, "noop"_n, bytes() ),
+                                                                transaction_metadata::trx_type::read_only ) );
+   BOOST_REQUIRE( !trace->except );
+   BOOST_REQUIRE( trace->receipt );
+   BOOST_REQUIRE_EQUAL( trace->action_traces.size(), 1u );
+   BOOST_CHECK_EQUAL( trace->action_traces[0].receipt->global_sequence, global_action_sequence + 1 );
+   BOOST_CHECK_EQUAL( t.control->get_dynamic_global_properties().global_action_sequence, global_action_sequence );
+
+   // native handlers modify state and must be executed on the main thread
+   trace = push_on_read_only_thread( *t.control, make_trx( t, action( {}, config::system_account_name, "newaccount"_n, bytes() ),
+                                                           transaction_metadata::trx_type::read_only ) );
+   BOOST_REQUIRE( trace->except );
+   BOOST_CHECK_EQUAL( trace->except->code(), read_only_thread_write_exception::code_value );
+
+   // only read-only transactions can be pushed from a read-only thread
+   BOOST_CHECK_THROW( push_on_read_only_thread( *t.control, make_trx( t, action( {{"alice"_n, config::active_name}}, "alice"_n, "noop"_n, bytes() ),
+                                                                      transaction_metadata::trx_type::input ) ),
+                      transaction_exception );
+
+   t.produce_block();
+} FC_LOG_AND_RETHROW() }
+
+// modules cached by a read-only thread are evicted once their code is replaced and that is irreversible
+BOOST_AUTO_TEST_CASE(read_only_thread_module_eviction) { try {
+   TESTER t;
+   if( t.get_config().wasm_runtime == wasm_interface::vm_type::eos_vm_oc ) {
+      // read-only threads are not supported with eos-vm-oc
+      return;
+   }
+   t.create_accounts( {"alice"_n} );
+   t.set_code( "alice"_n, noop_wast );
+   t.produce_block();
+
+   // the same read-only thread joins each window, the main thread waits meanwhile
+   named_thread_pool pool( "rdonly", 1 );
+   const auto on_read_only_thread = [&]( auto f ) {
+      return async_thread_pool( pool.get_executor(), [&]() {
+         t.control->init_read_only_thread();
+         return f();
+      } ).get();
+   };
+   const auto cached_modules = [&]() { return t.control->get_wasm_interface().cached_modules(); };
+
+   const auto trx = make_trx( t, action( {}, "alice"_n, "noop"_n, bytes() ), transaction_metadata::trx_type::read_only );
+   auto trace = on_read_only_thread( [&]() {
+      return t.control->push_transaction( trx, fc::time_point::maximum(), fc::milliseconds(150), 0, false, 0 );
+   } );
+   BOOST_REQUIRE( !trace->except );
+   BOOST_CHECK_EQUAL( on_read_only_thread( cached_modules ), 1u );
+
+   // the code is replaced on the main thread, the read-only thread notices once the LIB moves
+   t.set_code( "alice"_n, other_noop_wast );
+   const auto lib = t.control->last_irreversible_block_num();
+   while( t.control->last_irreversible_block_num() == lib )
+      t.produce_block();
+   const auto removed_at = t.control->head_block_num();
+   // kept until the setcode is irreversible
+   BOOST_CHECK_EQUAL( on_read_only_thread( cached_modules ), 1u );
+
+   while( t.control->last_irreversible_block_num() <= removed_at )
+      t.produce_block();
+   BOOST_CHECK_EQUAL( on_read_only_thread( cached_modules ), 0u );
+
+   pool.stop();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,5 +1,9 @@
+#include <fstream>
 #include <sstream>
 
+#include <signal.h>
+#include <sys/resource.h>
+
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/snapshot.hpp>
@@ -23,6 +27,25 @@ void remove_existing_blocks(controller::config& config) {
 }
 
 void block_log_set_buff_len(uint64_t len);
+void block_log_set_index_chunk_len(uint64_t len);
+
+// files cannot grow past limit bytes while it lives, as if the disk was full
+struct file_size_limit {
+   explicit file_size_limit(rlim_t limit) {
+      prev_handler = signal(SIGXFSZ, SIG_IGN);
+      getrlimit(RLIMIT_FSIZE, &prev_limit);
+      rlimit l = prev_limit;
+      l.rlim_cur = limit;
+      setrlimit(RLIMIT_FSIZE, &l);
+   }
+   ~file_size_limit() {
+      setrlimit(RLIMIT_FSIZE, &prev_limit);
+      signal(SIGXFSZ, prev_handler);
+   }
+
+   rlimit       prev_limit;
+   sighandler_t prev_handler;
+};
 
 void remove_existing_states(controller::config& config) {
    auto state_path = config.state_dir;
@@ -166,6 +189,467 @@ BOOST_AUTO_TEST_CASE(test_restart_from_block_log) {
    BOOST_REQUIRE_NO_THROW(from_block_log_chain.control->get_account("replay3"_n));
 }
 
+BOOST_AUTO_TEST_CASE(test_replay_read_ahead) {
+   tester chain;
+
+   chain.create_account("replay1"_n);
+   chain.produce_blocks(10);
+   chain.create_account("replay2"_n);
+   chain.produce_blocks(1);
+   const auto head_id = chain.control->head_block_id();
+   chain.close();
+
+   controller::config copied_config = chain.get_config();
+   {
+      block_log blog(copied_config.blocks_dir, std::optional<block_log_prune_config>());
+      const uint32_t head_num = blog.head()->block_num();
+      uint32_t expected = 2;
+      blog.read_serialized_blocks(2, head_num, [&](uint32_t block_num, std::vector<char>&& packed_block) {
+         BOOST_CHECK_EQUAL(block_num, expected++);
+         BOOST_CHECK(packed_block == fc::raw::pack(*blog.read_block_by_num(block_num)));
+         return true;
+      });
+      BOOST_CHECK_EQUAL(expected, head_num + 1);
+   }
+
+   auto genesis = chain::block_log::extract_genesis_state(copied_config.blocks_dir);
+   BOOST_REQUIRE(genesis);
+
+   // inline reads, the smallest read-ahead, and read-ahead with key recovery
+   for (auto [read_ahead, force_all_checks] : std::vector<std::pair<uint32_t, bool>>{{0, false}, {1, false}, {1, true}}) {
+      remove_existing_states(copied_config);
+      copied_config.replay_read_ahead_blocks = read_ahead;
+      copied_config.force_all_checks         = force_all_checks;
+      tester from_block_log_chain(copied_config, *genesis);
+
+      BOOST_CHECK_EQUAL(from_block_log_chain.control->head_block_id(), head_id);
+      BOOST_REQUIRE_NO_THROW(from_block_log_chain.control->get_account("replay1"_n));
+      BOOST_REQUIRE_NO_THROW(from_block_log_chain.control->get_account("replay2"_n));
+   }
+}
+
+BOOST_AUTO_TEST_CASE(test_compressed_block_log) {
+   tester chain;
+
+   chain.create_account("replay1"_n);
+   chain.produce_blocks(10);
+   chain.create_account("replay2"_n);
+   chain.produce_blocks(1);
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   fc::temp_directory compressed_dir;
+   fc::temp_directory decompressed_dir;
+
+   block_log_compression compression;
+   compression.algorithm  = block_log_compression::algorithm_type::zlib;
+   compression.dictionary = block_log::sample_compression_dictionary(blocks_dir, 4096);
+   BOOST_CHECK(!compression.dictionary.empty());
+   BOOST_CHECK_LE(compression.dictionary.size(), 4096u);
+   block_log::convert_log(blocks_dir, compressed_dir.path(), compression);
+
+   {
+      block_log original(blocks_dir, std::optional<block_log_prune_config>());
+      block_log compressed(compressed_dir.path(), std::optional<block_log_prune_config>());
+      BOOST_CHECK(compressed.compression().algorithm == block_log_compression::algorithm_type::zlib);
+      BOOST_CHECK(compressed.compression().dictionary == compression.dictionary);
+      BOOST_CHECK(original.compression().algorithm == block_log_compression::algorithm_type::none);
+      BOOST_REQUIRE_EQUAL(compressed.head_id(), original.head_id());
+      BOOST_REQUIRE_EQUAL(compressed.first_block_num(), 1u);
+
+      const uint32_t head_num = original.head()->block_num();
+      for (uint32_t n = 1; n <= head_num; ++n) {
+         BOOST_CHECK(fc::raw::pack(*compressed.read_block_by_num(n)) == fc::raw::pack(*original.read_block_by_num(n)));
+         BOOST_CHECK_EQUAL(compressed.read_block_id_by_num(n), original.read_block_id_by_num(n));
+         BOOST_CHECK(compressed.read_serialized_block_by_num(n).data == original.read_serialized_block_by_num(n).data);
+      }
+      uint32_t expected = 2;
+      compressed.read_serialized_blocks(2, head_num, [&](uint32_t block_num, std::vector<char>&& packed_block) {
+         BOOST_CHECK_EQUAL(block_num, expected++);
+         BOOST_CHECK(packed_block == fc::raw::pack(*original.read_block_by_num(block_num)));
+         return true;
+      });
+      BOOST_CHECK_EQUAL(expected, head_num + 1);
+   }
+
+   // converting back gives the original log
+   block_log::convert_log(compressed_dir.path(), decompressed_dir.path(), block_log_compression());
+   auto read_file = [](const fc::path& p) {
+      std::ifstream f(p.generic_string(), std::ios::binary);
+      return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+   };
+   BOOST_CHECK(read_file(decompressed_dir.path() / "blocks.log") == read_file(blocks_dir / "blocks.log"));
+   BOOST_CHECK(read_file(decompressed_dir.path() / "blocks.index") == read_file(blocks_dir / "blocks.index"));
+
+   // replay from the compressed log and keep appending to it
+   auto genesis = chain::block_log::extract_genesis_state(compressed_dir.path());
+   BOOST_REQUIRE(genesis);
+   controller::config copied_config = chain.get_config();
+   copied_config.blocks_dir = compressed_dir.path();
+   remove_existing_states(copied_config);
+   uint32_t lib_num = 0;
+   {
+      tester from_block_log_chain(copied_config, *genesis);
+      BOOST_REQUIRE_NO_THROW(from_block_log_chain.control->get_account("replay1"_n));
+      BOOST_REQUIRE_NO_THROW(from_block_log_chain.control->get_account("replay2"_n));
+      from_block_log_chain.produce_blocks(3);
+      lib_num = from_block_log_chain.control->last_irreversible_block_num();
+      from_block_log_chain.close();
+   }
+   block_log compressed(compressed_dir.path(), std::optional<block_log_prune_config>());
+   BOOST_CHECK(compressed.compression().algorithm == block_log_compression::algorithm_type::zlib);
+   BOOST_REQUIRE_EQUAL(compressed.head()->block_num(), lib_num);
+   BOOST_CHECK_EQUAL(compressed.read_block_by_num(lib_num)->calculate_id(), compressed.head_id());
+}
+
+BOOST_AUTO_TEST_CASE(test_repair_compressed_block_log) {
+   tester chain;
+
+   chain.create_account("replay1"_n);
+   chain.produce_blocks(10);
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   fc::temp_directory temp_dir;
+   const fc::path compressed_dir = temp_dir.path() / "blocks";
+   block_log_compression compression;
+   compression.algorithm = block_log_compression::algorithm_type::zlib;
+   block_log::convert_log(blocks_dir, compressed_dir, compression);
+
+   uint32_t head_num = 0;
+   uint64_t head_pos = 0;
+   {
+      block_log compressed(compressed_dir, std::optional<block_log_prune_config>());
+      head_num = compressed.head()->block_num();
+      head_pos = compressed.get_block_pos(head_num);
+   }
+
+   // the log ends in the middle of the head block, whose header holds a size far past the end of the log
+   constexpr size_t entry_prefix_size = 46; // header fields of the block kept uncompressed
+   const uint32_t compressed_size = std::numeric_limits<uint32_t>::max() - 100;
+   {
+      std::fstream f((compressed_dir / "blocks.log").generic_string(), std::ios::in | std::ios::out | std::ios::binary);
+      f.seekp(head_pos + entry_prefix_size + sizeof(uint32_t));
+      f.write(reinterpret_cast<const char*>(&compressed_size), sizeof(compressed_size));
+   }
+   fc::resize_file(compressed_dir / "blocks.log", head_pos + entry_prefix_size + 2*sizeof(uint32_t) + 10);
+
+   // the oversized entry is where the log was truncated, the blocks before it are kept
+   block_log::repair_log(compressed_dir);
+   block_log original(blocks_dir, std::optional<block_log_prune_config>());
+   block_log repaired(compressed_dir, std::optional<block_log_prune_config>());
+   BOOST_CHECK(repaired.compression().algorithm == block_log_compression::algorithm_type::zlib);
+   BOOST_REQUIRE_EQUAL(repaired.head()->block_num(), head_num - 1);
+   for (uint32_t n = 1; n < head_num; ++n)
+      BOOST_CHECK(fc::raw::pack(*repaired.read_block_by_num(n)) == fc::raw::pack(*original.read_block_by_num(n)));
+}
+
+BOOST_AUTO_TEST_CASE(test_serialized_block_view) {
+   tester chain;
+
+   chain.create_account("replay1"_n);
+   chain.produce_blocks(10);
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   block_log original(blocks_dir, std::optional<block_log_prune_config>());
+   const uint32_t head_num = original.head()->block_num();
+
+   // the views stay valid while the log grows, which is read through the mapping made ahead of its end
+   fc::temp_directory live_dir;
+   block_log live(live_dir.path(), std::optional<block_log_prune_config>());
+   live.reset(*block_log::extract_genesis_state(blocks_dir), original.read_block_by_num(1));
+   std::vector<serialized_block_view> views{live.read_serialized_block_by_num(1)};
+   for (uint32_t n = 2; n <= head_num; ++n) {
+      auto b = original.read_block_by_num(n);
+      live.append(b, b->calculate_id());
+      views.push_back(live.read_serialized_block_by_num(n));
+   }
+   for (uint32_t n = 1; n <= head_num; ++n) {
+      const auto packed = fc::raw::pack(*original.read_block_by_num(n));
+      BOOST_REQUIRE(views[n - 1]);
+      BOOST_CHECK(views[n - 1].data == std::string_view(packed.data(), packed.size()));
+      BOOST_CHECK(live.read_serialized_block_by_num(n).data == views[n - 1].data);
+      BOOST_CHECK(views[n - 1].owner == views[0].owner);
+   }
+   BOOST_CHECK(!live.read_serialized_block_by_num(head_num + 1));
+   BOOST_CHECK(!live.read_serialized_block_by_num(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_async_block_log_append) {
+   tester chain;
+
+   chain.create_account("replay1"_n);
+   chain.produce_blocks(10);
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   block_log original(blocks_dir, std::optional<block_log_prune_config>());
+   const uint32_t head_num = original.head()->block_num();
+
+   // appended blocks are read back at once, from the queue or from the log once written
+   fc::temp_directory async_dir;
+   {
+      block_log async_log(async_dir.path(), std::optional<block_log_prune_config>());
+      async_log.start_async_append(2);
+      async_log.reset(*block_log::extract_genesis_state(blocks_dir), original.read_block_by_num(1));
+      for (uint32_t n = 2; n <= head_num; ++n) {
+         auto b = original.read_block_by_num(n);
+         async_log.append(b, b->calculate_id());
+         BOOST_CHECK_EQUAL(async_log.head_id(), original.read_block_id_by_num(n));
+         BOOST_CHECK_EQUAL(async_log.read_block_id_by_num(n), original.read_block_id_by_num(n));
+         BOOST_CHECK(fc::raw::pack(*async_log.read_block_by_num(n)) == fc::raw::pack(*b));
+         BOOST_CHECK(async_log.read_serialized_block_by_num(n - 1).data == original.read_serialized_block_by_num(n - 1).data);
+      }
+      async_log.flush();
+      BOOST_CHECK(async_log.read_serialized_block_by_num(head_num).data == original.read_serialized_block_by_num(head_num).data);
+   }
+   auto read_file = [](const fc::path& p) {
+      std::ifstream f(p.generic_string(), std::ios::binary);
+      return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+   };
+   BOOST_CHECK(read_file(async_dir.path() / "blocks.log") == read_file(blocks_dir / "blocks.log"));
+   BOOST_CHECK(read_file(async_dir.path() / "blocks.index") == read_file(blocks_dir / "blocks.index"));
+
+   // a chain queuing its irreversible blocks has written all of them once closed
+   auto genesis = chain::block_log::extract_genesis_state(async_dir.path());
+   BOOST_REQUIRE(genesis);
+   controller::config copied_config = chain.get_config();
+   copied_config.blocks_dir = async_dir.path();
+   copied_config.block_log_queue_size = 4;
+   remove_existing_states(copied_config);
+   uint32_t lib_num = 0;
+   block_id_type lib_id;
+   {
+      tester from_block_log_chain(copied_config, *genesis);
+      BOOST_REQUIRE_NO_THROW(from_block_log_chain.control->get_account("replay1"_n));
+      from_block_log_chain.create_account("replay2"_n);
+      from_block_log_chain.produce_blocks(10);
+      lib_num = from_block_log_chain.control->last_irreversible_block_num();
+      lib_id = from_block_log_chain.control->last_irreversible_block_id();
+      BOOST_REQUIRE(from_block_log_chain.control->fetch_block_by_number(lib_num));
+      from_block_log_chain.close();
+   }
+   block_log async_log(async_dir.path(), std::optional<block_log_prune_config>());
+   BOOST_REQUIRE_EQUAL(async_log.head()->block_num(), lib_num);
+   BOOST_CHECK_EQUAL(async_log.head_id(), lib_id);
+}
+
+BOOST_AUTO_TEST_CASE(test_async_block_log_write_failure) {
+   tester chain;
+
+   chain.create_account("replay1"_n);
+   chain.produce_blocks(10);
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   block_log original(blocks_dir, std::optional<block_log_prune_config>());
+   const uint32_t head_num = original.head()->block_num();
+   const uint32_t written_num = head_num / 2;
+   auto read_file = [](const fc::path& p) {
+      std::ifstream f(p.generic_string(), std::ios::binary);
+      return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+   };
+
+   fc::temp_directory async_dir;
+   const fc::path log_file = async_dir.path() / "blocks.log";
+   const fc::path index_file = async_dir.path() / "blocks.index";
+   {
+      block_log async_log(async_dir.path(), std::optional<block_log_prune_config>());
+      async_log.start_async_append(4);
+      async_log.reset(*block_log::extract_genesis_state(blocks_dir), original.read_block_by_num(1));
+      for (uint32_t n = 2; n <= written_num; ++n) {
+         auto b = original.read_block_by_num(n);
+         async_log.append(b, b->calculate_id());
+      }
+      async_log.flush();
+      const std::string written_log = read_file(log_file);
+      const std::string written_index = read_file(index_file);
+
+      {
+         file_size_limit limit(written_log.size() + 10);
+         auto b = original.read_block_by_num(written_num + 1);
+         async_log.append(b, b->calculate_id());
+         BOOST_CHECK_THROW(async_log.flush(), fc::exception);
+         BOOST_CHECK(async_log.write_failed());
+         // the partially written block is dropped and the head is the last block written
+         BOOST_CHECK(read_file(log_file) == written_log);
+         BOOST_CHECK(read_file(index_file) == written_index);
+         BOOST_CHECK_EQUAL(async_log.head_id(), original.read_block_id_by_num(written_num));
+         BOOST_CHECK(fc::raw::pack(*async_log.read_block_by_num(written_num + 1)) == fc::raw::pack(*b));
+         // nothing is appended after it until it is written
+         auto next = original.read_block_by_num(written_num + 2);
+         BOOST_CHECK_THROW(async_log.append(next, next->calculate_id()), fc::exception);
+         BOOST_CHECK_EQUAL(async_log.head_id(), original.read_block_id_by_num(written_num));
+      }
+
+      // once there is room again, flush writes the failed block
+      async_log.flush();
+      BOOST_CHECK(!async_log.write_failed());
+      BOOST_CHECK_EQUAL(async_log.head_id(), original.read_block_id_by_num(written_num + 1));
+      for (uint32_t n = written_num + 2; n <= head_num; ++n) {
+         auto b = original.read_block_by_num(n);
+         async_log.append(b, b->calculate_id());
+      }
+   }
+   BOOST_CHECK(read_file(log_file) == read_file(blocks_dir / "blocks.log"));
+   BOOST_CHECK(read_file(index_file) == read_file(blocks_dir / "blocks.index"));
+
+   // a chain whose block log writer fails stops making blocks irreversible, and writes them when closed
+   auto genesis = chain::block_log::extract_genesis_state(async_dir.path());
+   BOOST_REQUIRE(genesis);
+   controller::config copied_config = chain.get_config();
+   copied_config.blocks_dir = async_dir.path();
+   copied_config.block_log_queue_size = 4;
+   remove_existing_states(copied_config);
+   uint32_t lib_num = 0;
+   block_id_type lib_id;
+   {
+      tester from_block_log_chain(copied_config, *genesis);
+      from_block_log_chain.produce_blocks(2);
+      bool stopped = false;
+      {
+         file_size_limit limit(fc::file_size(log_file) + 10);
+         for (int i = 0; i < 100 && !stopped; ++i) {
+            try {
+               from_block_log_chain.produce_block();
+            } catch (const fc::exception&) {
+               stopped = true;
+            }
+         }
+      }
+      BOOST_REQUIRE(stopped);
+      lib_num = from_block_log_chain.control->last_irreversible_block_num();
+      lib_id = from_block_log_chain.control->last_irreversible_block_id();
+      from_block_log_chain.close();
+   }
+   {
+      block_log async_log(async_dir.path(), std::optional<block_log_prune_config>());
+      BOOST_REQUIRE_EQUAL(async_log.head()->block_num(), lib_num);
+      BOOST_CHECK_EQUAL(async_log.head_id(), lib_id);
+   }
+   tester restarted_chain(copied_config);
+   BOOST_CHECK_EQUAL(restarted_chain.control->last_irreversible_block_id(), lib_id);
+   restarted_chain.produce_blocks(2);
+}
+
+BOOST_AUTO_TEST_CASE(test_split_block_log) {
+   tester chain;
+
+   chain.create_account("replay1"_n);
+   chain.produce_blocks(10);
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   block_log original(blocks_dir, std::optional<block_log_prune_config>());
+   const uint32_t head_num = original.head()->block_num();
+   BOOST_REQUIRE_GT(head_num, 8u);
+
+   auto check_blocks = [&](const block_log& log) {
+      BOOST_REQUIRE_EQUAL(log.first_block_num(), 1u);
+      BOOST_REQUIRE_EQUAL(log.head()->block_num(), head_num);
+      BOOST_REQUIRE_EQUAL(log.head_id(), original.head_id());
+      for (uint32_t n = 1; n <= head_num; ++n) {
+         BOOST_CHECK(fc::raw::pack(*log.read_block_by_num(n)) == fc::raw::pack(*original.read_block_by_num(n)));
+         BOOST_CHECK_EQUAL(log.read_block_id_by_num(n), original.read_block_id_by_num(n));
+         BOOST_CHECK(log.read_serialized_block_by_num(n).data == original.read_serialized_block_by_num(n).data);
+      }
+      BOOST_CHECK(!log.read_block_by_num(head_num + 1));
+      uint32_t expected = 2;
+      log.read_serialized_blocks(2, head_num, [&](uint32_t block_num, std::vector<char>&& packed_block) {
+         BOOST_CHECK_EQUAL(block_num, expected++);
+         BOOST_CHECK(packed_block == fc::raw::pack(*original.read_block_by_num(block_num)));
+         return true;
+      });
+      BOOST_CHECK_EQUAL(expected, head_num + 1);
+   };
+
+   // appending with a stride of 4 blocks, one part is kept next to blocks.log and older ones are archived
+   fc::temp_directory live_dir;
+   block_log_split_config split_config;
+   split_config.stride             = 4;
+   split_config.max_retained_files = 1;
+   split_config.archive_dir        = "archive";
+   const uint32_t last_split = head_num / 4 * 4;
+   {
+      block_log live(live_dir.path(), std::optional<block_log_prune_config>(), split_config);
+      live.reset(*block_log::extract_genesis_state(blocks_dir), original.read_block_by_num(1));
+      for (uint32_t n = 2; n <= last_split; ++n) {
+         auto b = original.read_block_by_num(n);
+         live.append(b, b->calculate_id());
+      }
+      BOOST_CHECK_EQUAL(live.head_id(), original.read_block_id_by_num(last_split));
+   }
+   BOOST_CHECK(fc::exists(live_dir.path() / ("blocks-" + std::to_string(last_split - 3) + "-" + std::to_string(last_split) + ".log")));
+   BOOST_CHECK(fc::exists(live_dir.path() / "archive" / "blocks-1-4.log"));
+   BOOST_CHECK(fc::exists(live_dir.path() / "archive" / "blocks-1-4.index"));
+   BOOST_CHECK(!fc::exists(live_dir.path() / "blocks-1-4.log"));
+   {
+      // blocks.log holds no block, the head is read from the last part
+      block_log live(live_dir.path(), std::optional<block_log_prune_config>(), split_config);
+      BOOST_REQUIRE_EQUAL(live.head_id(), original.read_block_id_by_num(last_split));
+      for (uint32_t n = last_split + 1; n <= head_num; ++n) {
+         auto b = original.read_block_by_num(n);
+         live.append(b, b->calculate_id());
+      }
+      check_blocks(live);
+   }
+   check_blocks(block_log(live_dir.path(), std::optional<block_log_prune_config>(), split_config));
+
+   // splitting an existing log and merging it back gives the original log
+   fc::temp_directory split_dir;
+   fc::temp_directory merged_dir;
+   block_log::split_log(blocks_dir, split_dir.path(), 4);
+   for (uint32_t first = 1; first + 3 <= head_num; first += 4)
+      BOOST_CHECK(fc::exists(split_dir.path() / ("blocks-" + std::to_string(first) + "-" + std::to_string(first + 3) + ".log")));
+   check_blocks(block_log(split_dir.path(), std::optional<block_log_prune_config>()));
+
+   block_log::merge_logs(split_dir.path(), merged_dir.path());
+   auto read_file = [](const fc::path& p) {
+      std::ifstream f(p.generic_string(), std::ios::binary);
+      return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+   };
+   BOOST_CHECK(read_file(merged_dir.path() / "blocks.log") == read_file(blocks_dir / "blocks.log"));
+   BOOST_CHECK(read_file(merged_dir.path() / "blocks.index") == read_file(blocks_dir / "blocks.index"));
+}
+
+BOOST_AUTO_TEST_CASE(test_construct_index_in_parallel) {
+   tester chain;
+
+   chain.create_account("replay1"_n);
+   chain.produce_blocks(10);
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   auto read_file = [](const fc::path& p) {
+      std::ifstream f(p.generic_string(), std::ios::binary);
+      return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+   };
+   const std::string original_index = read_file(blocks_dir / "blocks.index");
+
+   fc::temp_directory index_dir;
+   const fc::path index_file = index_dir.path() / "blocks.index";
+   const fc::path partial_file = index_dir.path() / "blocks.index.partial";
+   // chunks smaller than a block and chunks holding several blocks
+   for (uint64_t chunk_len : {64, 1024}) {
+      block_log_set_index_chunk_len(chunk_len);
+      fc::remove(index_file);
+      block_log::construct_index(blocks_dir / "blocks.log", index_file, 4);
+      BOOST_CHECK(read_file(index_file) == original_index);
+      BOOST_CHECK(!fc::exists(partial_file));
+
+      // an interrupted construction is resumed, the entries of the ranges not completed are written again
+      std::string partial = original_index;
+      std::fill(partial.begin() + partial.size() / 2, partial.end(), '\0');
+      std::ofstream(partial_file.generic_string(), std::ios::binary | std::ios::trunc) << partial;
+      fc::remove(index_file);
+      block_log::construct_index(blocks_dir / "blocks.log", index_file, 4);
+      BOOST_CHECK(read_file(index_file) == original_index);
+      BOOST_CHECK(!fc::exists(partial_file));
+   }
+   block_log_set_index_chunk_len(1U << 26);
+}
+
 BOOST_AUTO_TEST_CASE(test_light_validation_restart_from_block_log) {
    tester chain(setup_policy::full);
 
@@ -0,0 +1,95 @@
+#include <eosio/chain/state_access_tracer.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <fc/variant_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <contracts.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+using mvo = fc::mutable_variant_object;
+using state_key = state_access_tracer::state_key;
+using access_kind = state_access_tracer::access_kind;
+
+namespace {
+
+state_key table_key( name code, name scope, name table ) { return { access_kind::table, code, scope, table }; }
+state_key account_key( name account )                    { return { access_kind::account, account }; }
+state_key resource_key( name account )                   { return { access_kind::resource, account }; }
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(state_access_tracer_tests)
+
+BOOST_AUTO_TEST_CASE(contract_action_accesses) { try {
+   tester chain;
+   chain.create_accounts( { "alice"_n, "bob"_n, "eosio.token"_n } );
+   chain.set_code( "eosio.token"_n, contracts::eosio_token_wasm() );
+   chain.set_abi( "eosio.token"_n, contracts::eosio_token_abi().data() );
+   chain.push_action( "eosio.token"_n, "create"_n, "eosio.token"_n,
+                      mvo()("issuer", "alice")("maximum_supply", "1000.0000 TOK") );
+   chain.push_action( "eosio.token"_n, "issue"_n, "alice"_n,
+                      mvo()("to", "alice")("quantity", "100.0000 TOK")("memo", "") );
+   chain.produce_block();
+
+   state_access_tracer tracer;
+   chain.control->set_state_access_tracer( &tracer );
+   chain.push_action( "eosio.token"_n, "transfer"_n, "alice"_n,
+                      mvo()("from", "alice")("to", "bob")("quantity", "1.0000 TOK")("memo", "") );
+   chain.control->set_state_access_tracer( nullptr );
+   const auto accesses = tracer.take_accesses();
+
+   const name stat_scope( symbol::from_string( "4,TOK" ).to_symbol_code().value );
+   // the supply is only read, the balances of both accounts are written
+   BOOST_CHECK( accesses.reads.count( table_key( "eosio.token"_n, stat_scope, "stat"_n ) ) );
+   BOOST_CHECK( !accesses.writes.count( table_key( "eosio.token"_n, stat_scope, "stat"_n ) ) );
+   BOOST_CHECK( accesses.writes.count( table_key( "eosio.token"_n, "alice"_n, "accounts"_n ) ) );
+   BOOST_CHECK( accesses.writes.count( table_key( "eosio.token"_n, "bob"_n, "accounts"_n ) ) );
+   BOOST_CHECK( !accesses.reads.count( table_key( "eosio.token"_n, "alice"_n, "accounts"_n ) ) );
+   BOOST_CHECK( !accesses.reads.count( table_key( "eosio.token"_n, "bob"_n, "accounts"_n ) ) );
+   // the authorizer is billed, and pays for the new row of bob
+   BOOST_CHECK( accesses.writes.count( resource_key( "alice"_n ) ) );
+   // no account is modified by a contract action
+   for( const auto& k : accesses.writes )
+      BOOST_CHECK( k.kind != access_kind::account );
+
+   // nothing is recorded once the tracer is removed
+   chain.push_action( "eosio.token"_n, "transfer"_n, "alice"_n,
+                      mvo()("from", "alice")("to", "bob")("quantity", "1.0000 TOK")("memo", "") );
+   const auto untraced = tracer.take_accesses();
+   BOOST_CHECK( untraced.reads.empty() );
+   BOOST_CHECK( untraced.writes.empty() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(native_action_accesses) { try {
+   tester chain;
+   chain.create_accounts( { "alice"_n } );
+   chain.produce_block();
+
+   state_access_tracer tracer;
+   chain.control->set_state_access_tracer( &tracer );
+
+   // newaccount modifies the account created, not its creator
+   chain.create_account( "dave"_n, "alice"_n );
+   auto accesses = tracer.take_accesses();
+   BOOST_CHECK( accesses.writes.count( account_key( "dave"_n ) ) );
+   BOOST_CHECK( !accesses.writes.count( account_key( "alice"_n ) ) );
+   BOOST_CHECK( accesses.reads.count( account_key( "alice"_n ) ) );
+   BOOST_CHECK( accesses.writes.count( resource_key( "dave"_n ) ) );
+   BOOST_CHECK( accesses.writes.count( resource_key( "alice"_n ) ) );
+
+   // updateauth modifies the account whose permission is updated
+   chain.set_authority( "dave"_n, "perm"_n, authority( chain.get_public_key( "dave"_n, "perm" ) ), "active"_n,
+                        { permission_level{ "dave"_n, config::active_name } }, { chain.get_private_key( "dave"_n, "active" ) } );
+   accesses = tracer.take_accesses();
+   BOOST_CHECK( accesses.writes.count( account_key( "dave"_n ) ) );
+   BOOST_CHECK( !accesses.writes.count( account_key( "alice"_n ) ) );
+
+   chain.control->set_state_access_tracer( nullptr );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,9 +1,16 @@
 #include <array>
+#include <chrono>
+#include <set>
 #include <utility>
 
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
 #include <eosio/chain/abi_serializer.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/global_property_object.hpp>
+#include <eosio/chain/intrinsic_usage.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/wasm_eosio_constraints.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
@@ -22,6 +29,7 @@
 #include <fc/io/fstream.hpp>
 #include <fc/io/incbin.h>
 #include <fc/io/json.hpp>
+#include <fc/scoped_exit.hpp>
 #include <fc/variant_object.hpp>
 
 #include "test_wasts.hpp"
@@ -2179,6 +2187,265 @@ BOOST_FIXTURE_TEST_CASE( negative_memory_grow, TESTER ) try {
 
 } FC_LOG_AND_RETHROW()
 
+// every action starts with zeroed linear memory outside its initial data, whatever the previous action
+// (of the same or another code) wrote, grew or gave back
+BOOST_FIXTURE_TEST_CASE( reset_memory_between_actions, TESTER ) try {
+   produce_blocks(2);
+
+   create_accounts( {"dirtier"_n, "checker"_n} );
+   produce_block();
+
+   set_code("dirtier"_n, memory_reset_dirty_wast);
+   set_code("checker"_n, memory_reset_check_wast);
+   produce_block();
+
+   auto make_action = []( name account ) {
+      action act;
+      act.account = account;
+      act.name = name();
+      act.authorization = vector<permission_level>{{account,config::active_name}};
+      return act;
+   };
+   auto push_actions = [&]( const std::vector<name>& accounts ) {
+      signed_transaction trx;
+      for( const auto& account : accounts )
+         trx.actions.push_back( make_action(account) );
+      set_transaction_headers(trx);
+      for( const auto& account : std::set<name>( accounts.begin(), accounts.end() ) )
+         trx.sign(get_private_key( account, "active" ), control->get_chain_id());
+      push_transaction(trx);
+      produce_block();
+   };
+
+   push_actions( {"dirtier"_n} );
+   push_actions( {"dirtier"_n} );
+   push_actions( {"checker"_n} );
+   push_actions( {"dirtier"_n} );
+   push_actions( {"checker"_n} );
+   push_actions( {"checker"_n} );
+   // and between actions of one transaction
+   push_actions( {"dirtier"_n, "dirtier"_n, "checker"_n, "dirtier"_n, "checker"_n} );
+
+} FC_LOG_AND_RETHROW()
+
+// host function calls are accounted whether they return, throw or leave the contract
+BOOST_FIXTURE_TEST_CASE( intrinsic_usage_accounting, TESTER ) try {
+   produce_blocks(2);
+   create_accounts( {"usage"_n} );
+   produce_block();
+   set_code("usage"_n, intrinsic_usage_wast);
+   produce_block();
+
+   auto& tracker = intrinsic_usage_tracker::instance();
+   auto reset = fc::make_scoped_exit( [&]() { tracker.set_window( 0 ); } );
+   tracker.set_window( 60 );
+
+   auto push = [&]( uint32_t fail ) {
+      signed_transaction trx;
+      action act;
+      act.account = "usage"_n;
+      act.name = name();
+      act.authorization = vector<permission_level>{{"usage"_n,config::active_name}};
+      act.data = fc::raw::pack( fail );
+      trx.actions.push_back(act);
+      set_transaction_headers(trx);
+      trx.sign(get_private_key( "usage"_n, "active" ), control->get_chain_id());
+      return push_transaction(trx);
+   };
+   auto calls = []( const std::vector<intrinsic_usage_entry>& usage, const std::string& intrinsic ) -> uint64_t {
+      auto it = std::find_if( usage.begin(), usage.end(), [&]( const auto& e ) { return e.intrinsic == intrinsic; } );
+      return it == usage.end() ? 0 : it->calls;
+   };
+
+   // eosio_exit does not return to the contract
+   auto trace = push( 0 );
+   const auto& usage = trace->action_traces.at(0).intrinsic_usage;
+   BOOST_CHECK_EQUAL( calls( usage, "read_action_data" ), 2u );
+   BOOST_CHECK_EQUAL( calls( usage, "eosio_assert" ), 1u );
+   BOOST_CHECK_EQUAL( calls( usage, "eosio_exit" ), 1u );
+
+   // eosio_assert throws
+   BOOST_CHECK_THROW( push( 1 ), eosio_assert_message_exception );
+   const auto aggregated = tracker.get_usage( "usage"_n, 1 );
+   BOOST_REQUIRE_EQUAL( aggregated.size(), 1u );
+   BOOST_CHECK_EQUAL( calls( aggregated[0].intrinsics, "read_action_data" ), 4u );
+   BOOST_CHECK_EQUAL( calls( aggregated[0].intrinsics, "eosio_assert" ), 2u );
+   BOOST_CHECK_EQUAL( calls( aggregated[0].intrinsics, "eosio_exit" ), 1u );
+} FC_LOG_AND_RETHROW()
+
+// nodeos instances sharing an EOS VM OC directory install the code one of them compiled, unless it was damaged
+BOOST_AUTO_TEST_CASE( eosvmoc_shared_code ) try {
+   fc::temp_directory shared_dir;
+   const fc::path shared_path = shared_dir.path() / "oc";
+   auto share = [&]( controller::config& cfg ) { cfg.eosvmoc_config.shared_cache_dir = shared_path; };
+
+   auto run_contract = [&]( tester& chain ) {
+      chain.produce_blocks(2);
+      chain.create_accounts( {"sharer"_n} );
+      chain.produce_block();
+      chain.set_code( "sharer"_n, negative_memory_grow_wast );
+      chain.produce_block();
+
+      signed_transaction trx;
+      action act;
+      act.account = "sharer"_n;
+      act.name = name();
+      act.authorization = vector<permission_level>{{"sharer"_n,config::active_name}};
+      trx.actions.push_back(act);
+      chain.set_transaction_headers(trx);
+      trx.sign(chain.get_private_key( "sharer"_n, "active" ), chain.control->get_chain_id());
+      chain.push_transaction(trx);
+      chain.produce_block();
+   };
+   auto read_file = []( const fc::path& p ) {
+      std::ifstream f( p.generic_string(), std::ios::binary );
+      return std::string( std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() );
+   };
+
+   fc::temp_directory dir1;
+   tester chain1( dir1, share, true );
+   if( chain1.get_config().wasm_runtime != wasm_interface::vm_type::eos_vm_oc )
+      return;
+   run_contract( chain1 );
+
+   struct stat st;
+   BOOST_REQUIRE_EQUAL( stat( shared_path.generic_string().c_str(), &st ), 0 );
+   BOOST_CHECK_EQUAL( st.st_mode & 0777, 0700u );
+   std::vector<fc::path> published;
+   for( boost::filesystem::directory_iterator it( shared_path ), end; it != end; ++it )
+      if( it->path().extension() == ".oc" )
+         published.push_back( it->path() );
+   BOOST_REQUIRE_EQUAL( published.size(), 1u );
+   const fc::path oc_file = published[0];
+   const fc::path lock_file = oc_file.generic_string().substr( 0, oc_file.generic_string().size() - 3 ) + ".lock";
+   BOOST_REQUIRE_EQUAL( stat( oc_file.generic_string().c_str(), &st ), 0 );
+   BOOST_CHECK_EQUAL( st.st_mode & 0777, 0600u );
+   const std::string original = read_file( oc_file );
+
+   // the lock held here keeps another instance from compiling the code, it would only compile after waiting a minute
+   {
+      const int lock_fd = ::open( lock_file.generic_string().c_str(), O_RDWR );
+      BOOST_REQUIRE_GE( lock_fd, 0 );
+      BOOST_REQUIRE_EQUAL( flock( lock_fd, LOCK_EX | LOCK_NB ), 0 );
+      fc::temp_directory dir2;
+      tester chain2( dir2, share, true );
+      const auto started = std::chrono::steady_clock::now();
+      run_contract( chain2 );
+      BOOST_CHECK( std::chrono::steady_clock::now() - started < std::chrono::seconds(30) );
+      ::close( lock_fd );
+   }
+
+   // damaged code is not installed, it is compiled again and published over the damaged file
+   std::string damaged = original;
+   damaged[damaged.size() / 2] ^= 0xff;
+   {
+      std::ofstream out( oc_file.generic_string(), std::ios::binary | std::ios::trunc );
+      out << damaged;
+   }
+   fc::temp_directory dir3;
+   tester chain3( dir3, share, true );
+   run_contract( chain3 );
+   BOOST_CHECK( read_file( oc_file ) != damaged );
+} FC_LOG_AND_RETHROW()
+
+// the profile of an account run by EOS VM OC attributes its samples to the functions named in the wasm
+BOOST_AUTO_TEST_CASE( eosvmoc_profile_named_functions ) try {
+   // the name section WAVM writes predates the standard one, replace it by a function name subsection
+   auto with_function_names = []( const std::vector<uint8_t>& wasm, const std::vector<std::string>& names ) {
+      auto varuint32 = []( std::vector<uint8_t>& out, uint32_t v ) {
+         do {
+            uint8_t b = v & 0x7f;
+            v >>= 7;
+            out.push_back( v ? b | 0x80 : b );
+         } while( v );
+      };
+      auto read_varuint32 = [&]( size_t& pos ) {
+         uint32_t v = 0;
+         for( unsigned shift = 0; ; shift += 7 ) {
+            const uint8_t b = wasm.at( pos++ );
+            v |= uint32_t( b & 0x7f ) << shift;
+            if( !( b & 0x80 ) )
+               return v;
+         }
+      };
+      std::vector<uint8_t> result( wasm.begin(), wasm.begin() + 8 );
+      for( size_t pos = 8; pos < wasm.size(); ) {
+         const size_t section_start = pos++;
+         const uint32_t size = read_varuint32( pos );
+         const size_t content = pos;
+         pos += size;
+         if( wasm[section_start] == 0 ) {
+            size_t name_pos = content;
+            const uint32_t name_size = read_varuint32( name_pos );
+            if( std::string( wasm.begin() + name_pos, wasm.begin() + name_pos + name_size ) == "name" )
+               continue;
+         }
+         result.insert( result.end(), wasm.begin() + section_start, wasm.begin() + pos );
+      }
+      std::vector<uint8_t> function_names;
+      varuint32( function_names, names.size() );
+      for( uint32_t i = 0; i < names.size(); ++i ) {
+         varuint32( function_names, i );
+         varuint32( function_names, names[i].size() );
+         function_names.insert( function_names.end(), names[i].begin(), names[i].end() );
+      }
+      std::vector<uint8_t> section;
+      varuint32( section, 4 );
+      section.insert( section.end(), { 'n', 'a', 'm', 'e' } );
+      section.push_back( 1 );
+      varuint32( section, function_names.size() );
+      section.insert( section.end(), function_names.begin(), function_names.end() );
+      result.push_back( 0 );
+      varuint32( result, section.size() );
+      result.insert( result.end(), section.begin(), section.end() );
+      return result;
+   };
+
+   // profiles are written to the working directory when the executors of the chain are destroyed
+   fc::temp_directory profile_dir;
+   const boost::filesystem::path original_dir = boost::filesystem::current_path();
+   auto restore_dir = fc::make_scoped_exit( [&]() { boost::filesystem::current_path( original_dir ); } );
+   boost::filesystem::current_path( profile_dir.path() );
+   {
+      fc::temp_directory dir;
+      tester chain( dir, []( controller::config& cfg ) { cfg.profile_accounts.insert( "profiled"_n ); }, true );
+      if( chain.get_config().wasm_runtime != wasm_interface::vm_type::eos_vm_oc )
+         return;
+      chain.produce_blocks(2);
+      chain.create_accounts( {"profiled"_n} );
+      chain.produce_block();
+      chain.set_code( "profiled"_n, with_function_names( wast_to_wasm( profiled_spin_wast ), { "spin", "apply" } ) );
+      chain.produce_block();
+
+      signed_transaction trx;
+      action act;
+      act.account = "profiled"_n;
+      act.name = "run"_n;
+      act.authorization = vector<permission_level>{{"profiled"_n,config::active_name}};
+      trx.actions.push_back(act);
+      chain.set_transaction_headers(trx);
+      trx.sign(chain.get_private_key( "profiled"_n, "active" ), chain.control->get_chain_id());
+      chain.push_transaction(trx);
+      chain.produce_block();
+   }
+
+   std::ifstream folded( ( profile_dir.path() / "profiled.1.oc.folded" ).generic_string() );
+   BOOST_REQUIRE( folded );
+   uint64_t spin_samples = 0;
+   for( std::string line; std::getline( folded, line ); ) {
+      BOOST_TEST_MESSAGE( line );
+      const auto space = line.rfind( ' ' );
+      BOOST_REQUIRE( space != std::string::npos );
+      const std::string stack = line.substr( 0, space );
+      const uint64_t samples = std::stoull( line.substr( space + 1 ) );
+      BOOST_CHECK( stack == "profiled;run;spin" || stack == "profiled;run;apply" || stack == "profiled;run;[host functions]" );
+      if( stack == "profiled;run;spin" )
+         spin_samples = samples;
+   }
+   // nearly all the time is spent in the loop of spin
+   BOOST_CHECK_GT( spin_samples, 0u );
+} FC_LOG_AND_RETHROW()
+
 // TODO: restore net_usage_tests
 #if 0
 BOOST_FIXTURE_TEST_CASE(net_usage_tests, tester ) try {